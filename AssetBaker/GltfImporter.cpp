@@ -0,0 +1,530 @@
+#include "GltfImporter.h"
+#include "Json.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+
+namespace
+{
+	const unsigned int GlbMagic = 0x46546C67;		// "glTF"
+	const unsigned int GlbJsonChunk = 0x4E4F534A;	// "JSON"
+	const unsigned int GlbBinaryChunk = 0x004E4942;	// "BIN\0"
+	const int MaxNodeDepth = 64;
+	const size_t MaxAccessorCount = 1 << 28;
+
+	enum ComponentType
+	{
+		ByteComponent = 5120,
+		UnsignedByteComponent = 5121,
+		ShortComponent = 5122,
+		UnsignedShortComponent = 5123,
+		UnsignedIntComponent = 5125,
+		FloatComponent = 5126
+	};
+
+	// Column-major 4x4, as glTF stores them (column vectors: p' = M * p)
+	struct Matrix
+	{
+		float m[16];
+	};
+
+	Matrix Identity()
+	{
+		Matrix result = {};
+		result.m[0] = result.m[5] = result.m[10] = result.m[15] = 1.0f;
+		return result;
+	}
+
+	Matrix Multiply(const Matrix& a, const Matrix& b)
+	{
+		Matrix result;
+		for (int column = 0; column < 4; column++)
+		{
+			for (int row = 0; row < 4; row++)
+			{
+				float sum = 0.0f;
+				for (int k = 0; k < 4; k++)
+					sum += a.m[k * 4 + row] * b.m[column * 4 + k];
+				result.m[column * 4 + row] = sum;
+			}
+		}
+		return result;
+	}
+
+	float Determinant3x3(const Matrix& a)
+	{
+		return a.m[0] * (a.m[5] * a.m[10] - a.m[9] * a.m[6]) -
+			a.m[4] * (a.m[1] * a.m[10] - a.m[9] * a.m[2]) +
+			a.m[8] * (a.m[1] * a.m[6] - a.m[5] * a.m[2]);
+	}
+
+	// The node's matrix, or translation * rotation * scale
+	Matrix GetLocalMatrix(const JsonValue& node)
+	{
+		Matrix result = Identity();
+		const JsonValue& matrix = node["matrix"];
+		if (matrix.GetSize() == 16)
+		{
+			for (int i = 0; i < 16; i++)
+				result.m[i] = (float)matrix.At(i).GetNumber();
+			return result;
+		}
+
+		const JsonValue& t = node["translation"];
+		const JsonValue& r = node["rotation"];
+		const JsonValue& s = node["scale"];
+		float x = (float)r.At(0).GetNumber(0), y = (float)r.At(1).GetNumber(0), z = (float)r.At(2).GetNumber(0), w = (float)r.At(3).GetNumber(1);
+		float sx = (float)s.At(0).GetNumber(1), sy = (float)s.At(1).GetNumber(1), sz = (float)s.At(2).GetNumber(1);
+
+		result.m[0] = (1 - 2 * (y * y + z * z)) * sx;
+		result.m[1] = (2 * (x * y + z * w)) * sx;
+		result.m[2] = (2 * (x * z - y * w)) * sx;
+		result.m[4] = (2 * (x * y - z * w)) * sy;
+		result.m[5] = (1 - 2 * (x * x + z * z)) * sy;
+		result.m[6] = (2 * (y * z + x * w)) * sy;
+		result.m[8] = (2 * (x * z + y * w)) * sz;
+		result.m[9] = (2 * (y * z - x * w)) * sz;
+		result.m[10] = (1 - 2 * (x * x + y * y)) * sz;
+		result.m[12] = (float)t.At(0).GetNumber(0);
+		result.m[13] = (float)t.At(1).GetNumber(0);
+		result.m[14] = (float)t.At(2).GetNumber(0);
+		return result;
+	}
+
+	// An index property, or an out-of-range one if it's missing or negative
+	size_t GetIndex(const JsonValue& value)
+	{
+		double number = value.GetNumber(-1.0);
+		return number >= 0.0 ? (size_t)number : (size_t)-1;
+	}
+
+	// A count, offset or length property (0 if missing or negative)
+	size_t GetCount(const JsonValue& value)
+	{
+		double number = value.GetNumber(0.0);
+		return number >= 0.0 ? (size_t)number : 0;
+	}
+
+	// URIs are relative paths with %XX escapes
+	std::string DecodeUri(const std::string& uri)
+	{
+		std::string decoded;
+		for (size_t i = 0; i < uri.size(); i++)
+		{
+			if (uri[i] == '%' && i + 2 < uri.size())
+			{
+				decoded += (char)strtol(uri.substr(i + 1, 2).c_str(), 0, 16);
+				i += 2;
+			}
+			else
+				decoded += uri[i];
+		}
+		return decoded;
+	}
+
+	int Base64Value(char c)
+	{
+		if (c >= 'A' && c <= 'Z') return c - 'A';
+		if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+		if (c >= '0' && c <= '9') return c - '0' + 52;
+		if (c == '+' || c == '-') return 62;
+		if (c == '/' || c == '_') return 63;
+		return -1;
+	}
+
+	bool DecodeBase64(const std::string& text, size_t start, std::vector<char>& bytes)
+	{
+		unsigned int bits = 0;
+		int bitCount = 0;
+		for (size_t i = start; i < text.size() && text[i] != '='; i++)
+		{
+			int value = Base64Value(text[i]);
+			if (value < 0)
+				return false;
+			bits = (bits << 6) | (unsigned int)value;
+			bitCount += 6;
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				bytes.push_back((char)((bits >> bitCount) & 0xFF));
+			}
+		}
+		return true;
+	}
+
+	class GltfReader
+	{
+	public:
+		GltfReader(const std::string& path, ImportedMesh& mesh, std::vector<ImportDependency>& dependencies, std::string& error)
+			: path(path), mesh(mesh), dependencies(dependencies), error(error)
+		{
+		}
+
+		bool Read(const std::vector<char>& contents)
+		{
+			const char* jsonText = contents.data();
+			size_t jsonLength = contents.size();
+			const char* binary = 0;
+			size_t binaryLength = 0;
+			if (contents.size() >= 12 && ReadU32(contents.data()) == GlbMagic && !SplitGlb(contents, jsonText, jsonLength, binary, binaryLength))
+				return false;
+
+			std::string parseError;
+			if (!JsonValue::Parse(jsonText, jsonLength, document, parseError))
+				return Fail("bad JSON: " + parseError);
+			if (document["asset"]["version"].GetString().compare(0, 1, "2") != 0)
+				return Fail("only glTF 2.0 is supported");
+			if (!LoadBuffers(binary, binaryLength))
+				return false;
+
+			// The default scene's roots, or failing that every mesh as-is
+			const JsonValue& scenes = document["scenes"];
+			const JsonValue& scene = scenes.At(GetCount(document["scene"]));
+			if (!scene.IsNull())
+			{
+				const JsonValue& roots = scene["nodes"];
+				for (size_t i = 0; i < roots.GetSize(); i++)
+				{
+					if (!AddNode(GetIndex(roots.At(i)), Identity(), 0))
+						return false;
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < document["meshes"].GetSize(); i++)
+				{
+					if (!AddMesh(i, Identity()))
+						return false;
+				}
+			}
+
+			if (mesh.indices.empty())
+				return Fail("no triangles");
+			return true;
+		}
+
+	private:
+		std::string path;
+		ImportedMesh& mesh;
+		std::vector<ImportDependency>& dependencies;
+		std::string& error;
+
+		JsonValue document;
+		std::vector<std::vector<char>> buffers;
+
+		bool Fail(const std::string& message)
+		{
+			error = message;
+			return false;
+		}
+
+		static unsigned int ReadU32(const char* bytes)
+		{
+			unsigned int value;
+			memcpy(&value, bytes, sizeof(value));
+			return value;
+		}
+
+		// Finds the JSON and (optional) binary chunks of a .glb
+		bool SplitGlb(const std::vector<char>& contents, const char*& json, size_t& jsonLength, const char*& binary, size_t& binaryLength)
+		{
+			size_t length = ReadU32(contents.data() + 8);
+			if (ReadU32(contents.data() + 4) != 2 || length > contents.size())
+				return Fail("bad GLB header");
+
+			json = 0;
+			size_t offset = 12;
+			while (offset + 8 <= length)
+			{
+				size_t chunkLength = ReadU32(contents.data() + offset);
+				unsigned int chunkType = ReadU32(contents.data() + offset + 4);
+				offset += 8;
+				if (chunkLength > length - offset)
+					return Fail("bad GLB chunk");
+
+				if (chunkType == GlbJsonChunk && !json)
+				{
+					json = contents.data() + offset;
+					jsonLength = chunkLength;
+				}
+				else if (chunkType == GlbBinaryChunk && !binary)
+				{
+					binary = contents.data() + offset;
+					binaryLength = chunkLength;
+				}
+				offset += (chunkLength + 3) & ~(size_t)3;
+			}
+
+			if (!json)
+				return Fail("GLB has no JSON chunk");
+			return true;
+		}
+
+		bool LoadBuffers(const char* binary, size_t binaryLength)
+		{
+			const JsonValue& bufferList = document["buffers"];
+			buffers.resize(bufferList.GetSize());
+			for (size_t i = 0; i < bufferList.GetSize(); i++)
+			{
+				const std::string& uri = bufferList.At(i)["uri"].GetString();
+				size_t byteLength = GetCount(bufferList.At(i)["byteLength"]);
+
+				if (uri.empty())
+				{
+					if (i != 0 || !binary)
+						return Fail("buffer " + std::to_string(i) + " has no data");
+					buffers[i].assign(binary, binary + binaryLength);
+				}
+				else if (uri.compare(0, 5, "data:") == 0)
+				{
+					size_t comma = uri.find(";base64,");
+					if (comma == std::string::npos || !DecodeBase64(uri, comma + 8, buffers[i]))
+						return Fail("buffer " + std::to_string(i) + " has a bad data URI");
+				}
+				else
+				{
+					std::string bufferPath = (std::filesystem::path(path).parent_path() / std::filesystem::u8path(DecodeUri(uri))).string();
+					if (!ReadDependency(bufferPath, buffers[i], dependencies))
+						return Fail("can't read " + bufferPath);
+				}
+
+				if (buffers[i].size() < byteLength)
+					return Fail("buffer " + std::to_string(i) + " is shorter than its byteLength");
+			}
+			return true;
+		}
+
+		bool AddNode(size_t nodeIndex, const Matrix& parent, int depth)
+		{
+			const JsonValue& node = document["nodes"].At(nodeIndex);
+			if (node.IsNull() || depth > MaxNodeDepth)
+				return Fail("bad node hierarchy");
+
+			Matrix world = Multiply(parent, GetLocalMatrix(node));
+			if (node.Has("mesh") && !AddMesh(GetIndex(node["mesh"]), world))
+				return false;
+
+			const JsonValue& children = node["children"];
+			for (size_t i = 0; i < children.GetSize(); i++)
+			{
+				if (!AddNode(GetIndex(children.At(i)), world, depth + 1))
+					return false;
+			}
+			return true;
+		}
+
+		// --------------------------------------------------------
+		// Reads an accessor as floats, componentCount per element
+		// (missing components stay at their fill value).  Integer
+		// types are normalized when the accessor says so.
+		// --------------------------------------------------------
+		bool ReadAccessor(size_t accessorIndex, int componentCount, float fill, std::vector<float>& values)
+		{
+			const JsonValue& accessor = document["accessors"].At(accessorIndex);
+			if (accessor.IsNull())
+				return Fail("missing accessor");
+			if (accessor.Has("sparse"))
+				return Fail("sparse accessors aren't supported");
+
+			static const char* typeNames[] = { "SCALAR", "VEC2", "VEC3", "VEC4" };
+			int typeComponents = 0;
+			for (int i = 0; i < 4; i++)
+			{
+				if (accessor["type"].GetString() == typeNames[i])
+					typeComponents = i + 1;
+			}
+			int componentType = (int)accessor["componentType"].GetNumber();
+			size_t componentSize =
+				componentType == ByteComponent || componentType == UnsignedByteComponent ? 1 :
+				componentType == ShortComponent || componentType == UnsignedShortComponent ? 2 :
+				componentType == UnsignedIntComponent || componentType == FloatComponent ? 4 : 0;
+			if (typeComponents == 0 || componentSize == 0)
+				return Fail("unsupported accessor type");
+
+			size_t count = GetCount(accessor["count"]);
+			bool normalized = accessor["normalized"].GetBool();
+			if (!accessor.Has("bufferView"))
+			{
+				if (count > MaxAccessorCount)
+					return Fail("accessor too large");
+				values.assign(count * componentCount, 0.0f);	// All zeros, by the spec
+				return true;
+			}
+
+			const JsonValue& view = document["bufferViews"].At(GetIndex(accessor["bufferView"]));
+			size_t bufferIndex = GetIndex(view["buffer"]);
+			if (view.IsNull() || bufferIndex >= buffers.size())
+				return Fail("missing buffer view");
+
+			size_t elementSize = componentSize * typeComponents;
+			size_t stride = GetCount(view["byteStride"]);
+			if (stride == 0)
+				stride = elementSize;
+			size_t start = GetCount(view["byteOffset"]) + GetCount(accessor["byteOffset"]);
+			size_t viewEnd = GetCount(view["byteOffset"]) + GetCount(view["byteLength"]);
+			const std::vector<char>& buffer = buffers[bufferIndex];
+			if (count > 0 && (viewEnd > buffer.size() || start + (count - 1) * stride + elementSize > viewEnd))
+				return Fail("accessor runs past its buffer view");
+
+			values.assign(count * componentCount, fill);
+			int used = typeComponents < componentCount ? typeComponents : componentCount;
+			for (size_t e = 0; e < count; e++)
+			{
+				const char* element = buffer.data() + start + e * stride;
+				for (int c = 0; c < used; c++)
+				{
+					const char* source = element + c * componentSize;
+					float value;
+					switch (componentType)
+					{
+					case ByteComponent: { signed char v; memcpy(&v, source, 1); value = normalized ? fmaxf(v / 127.0f, -1.0f) : v; break; }
+					case UnsignedByteComponent: { unsigned char v; memcpy(&v, source, 1); value = normalized ? v / 255.0f : v; break; }
+					case ShortComponent: { short v; memcpy(&v, source, 2); value = normalized ? fmaxf(v / 32767.0f, -1.0f) : v; break; }
+					case UnsignedShortComponent: { unsigned short v; memcpy(&v, source, 2); value = normalized ? v / 65535.0f : v; break; }
+					case UnsignedIntComponent: { unsigned int v; memcpy(&v, source, 4); value = (float)v; break; }
+					default: memcpy(&value, source, 4); break;
+					}
+					values[e * componentCount + c] = value;
+				}
+			}
+			return true;
+		}
+
+		// Indices are read separately so 32-bit ones don't lose precision as floats
+		bool ReadIndices(size_t accessorIndex, size_t vertexCount, std::vector<unsigned int>& indices)
+		{
+			const JsonValue& accessor = document["accessors"].At(accessorIndex);
+			int componentType = (int)accessor["componentType"].GetNumber();
+			size_t componentSize = componentType == UnsignedByteComponent ? 1 : componentType == UnsignedShortComponent ? 2 : componentType == UnsignedIntComponent ? 4 : 0;
+			const JsonValue& view = document["bufferViews"].At(GetIndex(accessor["bufferView"]));
+			size_t bufferIndex = GetIndex(view["buffer"]);
+			if (componentSize == 0 || view.IsNull() || bufferIndex >= buffers.size() || accessor.Has("sparse"))
+				return Fail("unsupported index accessor");
+
+			size_t count = GetCount(accessor["count"]);
+			size_t start = GetCount(view["byteOffset"]) + GetCount(accessor["byteOffset"]);
+			const std::vector<char>& buffer = buffers[bufferIndex];
+			if (start > buffer.size() || count > (buffer.size() - start) / componentSize)
+				return Fail("indices run past their buffer");
+
+			indices.resize(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				unsigned int index = 0;
+				memcpy(&index, buffer.data() + start + i * componentSize, componentSize);
+				if (index >= vertexCount)
+					return Fail("index out of range");
+				indices[i] = index;
+			}
+			return true;
+		}
+
+		// --------------------------------------------------------
+		// glTF is right-handed with counter-clockwise front faces.
+		// Positions go to world space, then z is negated and the
+		// winding reversed (unless the node transform mirrors it
+		// already) to match the engine.
+		// --------------------------------------------------------
+		bool AddMesh(size_t meshIndex, const Matrix& world)
+		{
+			const JsonValue& primitives = document["meshes"].At(meshIndex)["primitives"];
+			bool mirrored = Determinant3x3(world) < 0.0f;
+
+			std::vector<float> positions;
+			std::vector<float> colors;
+			std::vector<unsigned int> indices;
+			std::vector<unsigned int> triangles;
+			for (size_t p = 0; p < primitives.GetSize(); p++)
+			{
+				const JsonValue& primitive = primitives.At(p);
+				int mode = (int)primitive["mode"].GetNumber(4);
+				if (mode < 4 || mode > 6 || !primitive["attributes"].Has("POSITION"))
+					continue;	// Points and lines have nothing to bake
+
+				if (!ReadAccessor(GetIndex(primitive["attributes"]["POSITION"]), 3, 0.0f, positions))
+					return false;
+				size_t vertexCount = positions.size() / 3;
+
+				if (primitive["attributes"].Has("COLOR_0"))
+				{
+					if (!ReadAccessor(GetIndex(primitive["attributes"]["COLOR_0"]), 4, 1.0f, colors))
+						return false;
+				}
+				else
+					colors.assign(vertexCount * 4, 1.0f);
+
+				const JsonValue& factor = document["materials"].At(GetIndex(primitive["material"]))["pbrMetallicRoughness"]["baseColorFactor"];
+				float tint[4];
+				for (int c = 0; c < 4; c++)
+					tint[c] = (float)factor.At(c).GetNumber(1.0);
+
+				if (primitive.Has("indices"))
+				{
+					if (!ReadIndices(GetIndex(primitive["indices"]), vertexCount, indices))
+						return false;
+				}
+				else
+				{
+					indices.resize(vertexCount);
+					for (size_t i = 0; i < vertexCount; i++)
+						indices[i] = (unsigned int)i;
+				}
+
+				// Strips and fans become a plain triangle list (glTF order, fixed up below)
+				triangles.clear();
+				for (size_t i = 0; i + 2 < indices.size(); i += (mode == 4 ? 3 : 1))
+				{
+					unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+					if (mode == 5 && (i & 1))
+						std::swap(a, b);
+					if (mode == 6)
+						a = indices[0];
+					triangles.push_back(a);
+					triangles.push_back(b);
+					triangles.push_back(c);
+				}
+
+				unsigned int base = (unsigned int)mesh.vertices.size();
+				for (size_t v = 0; v < vertexCount; v++)
+				{
+					const float* position = &positions[v * 3];
+					MeshFileVertex vertex;
+					for (int row = 0; row < 3; row++)
+					{
+						vertex.position[row] = world.m[row] * position[0] + world.m[4 + row] * position[1] +
+							world.m[8 + row] * position[2] + world.m[12 + row];
+					}
+					vertex.position[2] = -vertex.position[2];
+					for (int c = 0; c < 4; c++)
+						vertex.color[c] = colors[v * 4 + c] * tint[c];
+					mesh.vertices.push_back(vertex);
+				}
+
+				for (size_t t = 0; t < triangles.size(); t += 3)
+				{
+					mesh.indices.push_back(base + triangles[t]);
+					if (mirrored)
+					{
+						mesh.indices.push_back(base + triangles[t + 1]);
+						mesh.indices.push_back(base + triangles[t + 2]);
+					}
+					else
+					{
+						mesh.indices.push_back(base + triangles[t + 2]);
+						mesh.indices.push_back(base + triangles[t + 1]);
+					}
+				}
+			}
+			return true;
+		}
+	};
+}
+
+bool ImportGltf(const std::string& path, const std::vector<char>& contents,
+	ImportedMesh& mesh, std::vector<ImportDependency>& dependencies, std::string& error)
+{
+	GltfReader reader(path, mesh, dependencies, error);
+	return reader.Read(contents);
+}
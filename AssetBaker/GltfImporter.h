@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ImportedMesh.h"
+
+// --------------------------------------------------------
+// glTF 2.0, as .gltf (buffers external or in data: URIs) or
+// .glb.  Every triangle primitive (modes 4-6) reachable from
+// the default scene is baked into one mesh, with its node
+// transforms applied.  Vertex colors come from COLOR_0 times
+// the material's base color factor.  Sparse accessors,
+// Draco and other extensions aren't supported.
+// --------------------------------------------------------
+bool ImportGltf(const std::string& path, const std::vector<char>& contents,
+	ImportedMesh& mesh, std::vector<ImportDependency>& dependencies, std::string& error);
@@ -0,0 +1,89 @@
+#include "ImportedMesh.h"
+#include "../ContentHash.h"
+#include <cstring>
+#include <fstream>
+
+bool ReadFileContents(const std::string& path, std::vector<char>& contents)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		return false;
+
+	std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	contents.resize((size_t)size);
+	return size == 0 || (bool)file.read(contents.data(), size);
+}
+
+unsigned long long HashFileContents(const std::string& path)
+{
+	std::vector<char> contents;
+	if (!ReadFileContents(path, contents))
+		return 0;
+
+	// Nudged off 0, which means missing
+	unsigned long long hash = HashContent(contents.data(), contents.size());
+	return hash ? hash : 1;
+}
+
+bool ReadDependency(const std::string& path, std::vector<char>& contents, std::vector<ImportDependency>& dependencies)
+{
+	ImportDependency dependency;
+	dependency.path = path;
+	dependency.hash = 0;
+
+	bool read = ReadFileContents(path, contents);
+	if (read)
+	{
+		dependency.hash = HashContent(contents.data(), contents.size());
+		if (dependency.hash == 0)
+			dependency.hash = 1;
+	}
+	dependencies.push_back(dependency);
+	return read;
+}
+
+// --------------------------------------------------------
+// Open-addressed hash table of unique vertex indices, sized
+// to stay under half full.  Negative zeros are made positive
+// first so they weld with their positive twins.
+// --------------------------------------------------------
+void WeldVertices(ImportedMesh& mesh)
+{
+	std::vector<MeshFileVertex>& vertices = mesh.vertices;
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		for (int c = 0; c < 3; c++)
+			vertices[i].position[c] += 0.0f;
+		for (int c = 0; c < 4; c++)
+			vertices[i].color[c] += 0.0f;
+	}
+
+	size_t tableSize = 16;
+	while (tableSize < vertices.size() * 2)
+		tableSize *= 2;
+	const unsigned int empty = 0xFFFFFFFF;
+	std::vector<unsigned int> table(tableSize, empty);
+
+	std::vector<unsigned int> remap(vertices.size());
+	std::vector<MeshFileVertex> unique;
+	unique.reserve(vertices.size());
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		size_t slot = (size_t)HashContent(&vertices[i], sizeof(MeshFileVertex)) & (tableSize - 1);
+		while (table[slot] != empty && memcmp(&unique[table[slot]], &vertices[i], sizeof(MeshFileVertex)) != 0)
+			slot = (slot + 1) & (tableSize - 1);
+
+		if (table[slot] == empty)
+		{
+			table[slot] = (unsigned int)unique.size();
+			unique.push_back(vertices[i]);
+		}
+		remap[i] = table[slot];
+	}
+
+	for (size_t i = 0; i < mesh.indices.size(); i++)
+		mesh.indices[i] = remap[mesh.indices[i]];
+	vertices.swap(unique);
+}
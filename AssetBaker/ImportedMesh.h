@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "../MeshFileFormat.h"
+
+// --------------------------------------------------------
+// Geometry on its way from a source format to a .mesh file.
+// Importers fill it in engine conventions: left-handed
+// coordinates and clockwise front faces.
+// --------------------------------------------------------
+struct ImportedMesh
+{
+	std::vector<MeshFileVertex> vertices;
+	std::vector<unsigned int> indices;
+};
+
+// A file an importer read besides its input (.mtl, .bin), and the
+// hash of what it held (0 if it couldn't be read)
+struct ImportDependency
+{
+	std::string path;
+	unsigned long long hash;
+};
+
+//false if the file can't be read
+bool ReadFileContents(const std::string& path, std::vector<char>& contents);
+//the hash ImportDependency uses - 0 for a missing file
+unsigned long long HashFileContents(const std::string& path);
+//reads a file the import depends on and records it, even if it's missing
+//(so creating it later triggers a rebake)
+bool ReadDependency(const std::string& path, std::vector<char>& contents, std::vector<ImportDependency>& dependencies);
+
+//merges vertices that are bit-for-bit identical and remaps the indices to match
+void WeldVertices(ImportedMesh& mesh);
@@ -0,0 +1,363 @@
+#include "Json.h"
+#include <cstdlib>
+
+// Returned for anything missing, so chained lookups never fail
+static const JsonValue nullValue;
+static const std::string emptyString;
+
+JsonValue::JsonValue()
+{
+	this->type = NullType;
+	this->boolean = false;
+	this->number = 0.0;
+}
+
+JsonValue::Type JsonValue::GetType() const
+{
+	return type;
+}
+
+bool JsonValue::IsNull() const
+{
+	return type == NullType;
+}
+
+double JsonValue::GetNumber(double fallback) const
+{
+	return type == NumberType ? number : fallback;
+}
+
+bool JsonValue::GetBool(bool fallback) const
+{
+	return type == BoolType ? boolean : fallback;
+}
+
+const std::string& JsonValue::GetString() const
+{
+	return type == StringType ? string : emptyString;
+}
+
+size_t JsonValue::GetSize() const
+{
+	if (type == ArrayType)
+		return elements.size();
+	if (type == ObjectType)
+		return members.size();
+	return 0;
+}
+
+const JsonValue& JsonValue::At(size_t index) const
+{
+	if (type != ArrayType || index >= elements.size())
+		return nullValue;
+	return elements[index];
+}
+
+const JsonValue& JsonValue::operator[](const char* key) const
+{
+	if (type != ObjectType)
+		return nullValue;
+	for (size_t i = 0; i < members.size(); i++)
+	{
+		if (members[i].first == key)
+			return members[i].second;
+	}
+	return nullValue;
+}
+
+bool JsonValue::Has(const char* key) const
+{
+	return !(*this)[key].IsNull();
+}
+
+// --------------------------------------------------------
+// Recursive descent over the text.  Nesting is capped so a
+// hostile file can't overflow the stack.
+// --------------------------------------------------------
+class JsonParser
+{
+public:
+	JsonParser(const char* text, size_t length)
+	{
+		this->position = text;
+		this->end = text + length;
+	}
+
+	bool ParseDocument(JsonValue& result, std::string& error)
+	{
+		SkipWhitespace();
+		if (!ParseValue(result, 0))
+		{
+			error = message;
+			return false;
+		}
+		SkipWhitespace();
+		if (position != end)
+		{
+			error = "unexpected text after the document";
+			return false;
+		}
+		return true;
+	}
+
+private:
+	static const int MaxDepth = 256;
+
+	const char* position;
+	const char* end;
+	std::string message;
+
+	bool Fail(const char* text)
+	{
+		message = text;
+		return false;
+	}
+
+	void SkipWhitespace()
+	{
+		while (position < end && (*position == ' ' || *position == '\t' || *position == '\n' || *position == '\r'))
+			position++;
+	}
+
+	bool Match(const char* literal)
+	{
+		const char* p = position;
+		for (; *literal; literal++, p++)
+		{
+			if (p >= end || *p != *literal)
+				return false;
+		}
+		position = p;
+		return true;
+	}
+
+	bool ParseValue(JsonValue& value, int depth)
+	{
+		if (depth > MaxDepth)
+			return Fail("nesting too deep");
+		if (position >= end)
+			return Fail("unexpected end of input");
+
+		switch (*position)
+		{
+		case '{': return ParseObject(value, depth);
+		case '[': return ParseArray(value, depth);
+		case '"':
+			value.type = JsonValue::StringType;
+			return ParseString(value.string);
+		case 't':
+			if (!Match("true"))
+				return Fail("bad literal");
+			value.type = JsonValue::BoolType;
+			value.boolean = true;
+			return true;
+		case 'f':
+			if (!Match("false"))
+				return Fail("bad literal");
+			value.type = JsonValue::BoolType;
+			value.boolean = false;
+			return true;
+		case 'n':
+			if (!Match("null"))
+				return Fail("bad literal");
+			value.type = JsonValue::NullType;
+			return true;
+		default:
+			return ParseNumber(value);
+		}
+	}
+
+	bool ParseNumber(JsonValue& value)
+	{
+		// strtod needs a terminator, so copy the (short) number out first
+		char text[64];
+		size_t length = 0;
+		while (position < end && length < sizeof(text) - 1 &&
+			((*position >= '0' && *position <= '9') || *position == '-' || *position == '+' ||
+				*position == '.' || *position == 'e' || *position == 'E'))
+			text[length++] = *position++;
+		text[length] = 0;
+
+		char* parsedEnd;
+		value.number = strtod(text, &parsedEnd);
+		if (length == 0 || parsedEnd != text + length)
+			return Fail("bad number");
+		value.type = JsonValue::NumberType;
+		return true;
+	}
+
+	static void AppendUtf8(std::string& text, unsigned int codePoint)
+	{
+		if (codePoint < 0x80)
+			text += (char)codePoint;
+		else if (codePoint < 0x800)
+		{
+			text += (char)(0xC0 | (codePoint >> 6));
+			text += (char)(0x80 | (codePoint & 0x3F));
+		}
+		else if (codePoint < 0x10000)
+		{
+			text += (char)(0xE0 | (codePoint >> 12));
+			text += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+			text += (char)(0x80 | (codePoint & 0x3F));
+		}
+		else
+		{
+			text += (char)(0xF0 | (codePoint >> 18));
+			text += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+			text += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+			text += (char)(0x80 | (codePoint & 0x3F));
+		}
+	}
+
+	bool ParseHex4(unsigned int& result)
+	{
+		if (end - position < 4)
+			return Fail("bad escape");
+		result = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			char c = *position++;
+			result <<= 4;
+			if (c >= '0' && c <= '9') result |= c - '0';
+			else if (c >= 'a' && c <= 'f') result |= c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F') result |= c - 'A' + 10;
+			else return Fail("bad escape");
+		}
+		return true;
+	}
+
+	bool ParseString(std::string& text)
+	{
+		position++;	// Opening quote
+		while (position < end && *position != '"')
+		{
+			if (*position != '\\')
+			{
+				text += *position++;
+				continue;
+			}
+
+			position++;
+			if (position >= end)
+				break;
+			char escape = *position++;
+			switch (escape)
+			{
+			case '"': text += '"'; break;
+			case '\\': text += '\\'; break;
+			case '/': text += '/'; break;
+			case 'b': text += '\b'; break;
+			case 'f': text += '\f'; break;
+			case 'n': text += '\n'; break;
+			case 'r': text += '\r'; break;
+			case 't': text += '\t'; break;
+			case 'u':
+			{
+				unsigned int codePoint;
+				if (!ParseHex4(codePoint))
+					return false;
+				// Surrogate pair
+				if (codePoint >= 0xD800 && codePoint < 0xDC00 && Match("\\u"))
+				{
+					unsigned int low;
+					if (!ParseHex4(low))
+						return false;
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+				}
+				AppendUtf8(text, codePoint);
+				break;
+			}
+			default:
+				return Fail("bad escape");
+			}
+		}
+
+		if (position >= end)
+			return Fail("unterminated string");
+		position++;	// Closing quote
+		return true;
+	}
+
+	bool ParseArray(JsonValue& value, int depth)
+	{
+		value.type = JsonValue::ArrayType;
+		position++;
+		SkipWhitespace();
+		if (position < end && *position == ']')
+		{
+			position++;
+			return true;
+		}
+
+		for (;;)
+		{
+			value.elements.push_back(JsonValue());
+			SkipWhitespace();
+			if (!ParseValue(value.elements.back(), depth + 1))
+				return false;
+			SkipWhitespace();
+			if (position < end && *position == ',')
+			{
+				position++;
+				continue;
+			}
+			if (position < end && *position == ']')
+			{
+				position++;
+				return true;
+			}
+			return Fail("expected ',' or ']'");
+		}
+	}
+
+	bool ParseObject(JsonValue& value, int depth)
+	{
+		value.type = JsonValue::ObjectType;
+		position++;
+		SkipWhitespace();
+		if (position < end && *position == '}')
+		{
+			position++;
+			return true;
+		}
+
+		for (;;)
+		{
+			SkipWhitespace();
+			if (position >= end || *position != '"')
+				return Fail("expected a member name");
+			value.members.push_back(std::make_pair(std::string(), JsonValue()));
+			if (!ParseString(value.members.back().first))
+				return false;
+
+			SkipWhitespace();
+			if (position >= end || *position != ':')
+				return Fail("expected ':'");
+			position++;
+			SkipWhitespace();
+			if (!ParseValue(value.members.back().second, depth + 1))
+				return false;
+
+			SkipWhitespace();
+			if (position < end && *position == ',')
+			{
+				position++;
+				continue;
+			}
+			if (position < end && *position == '}')
+			{
+				position++;
+				return true;
+			}
+			return Fail("expected ',' or '}'");
+		}
+	}
+};
+
+bool JsonValue::Parse(const char* text, size_t length, JsonValue& result, std::string& error)
+{
+	result = JsonValue();
+	JsonParser parser(text, length);
+	return parser.ParseDocument(result, error);
+}
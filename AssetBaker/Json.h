@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// --------------------------------------------------------
+// Just enough JSON for reading glTF: a parsed tree of values
+// with lookups that fall back to defaults, so importers can
+// read optional properties without checking every step
+// --------------------------------------------------------
+class JsonValue
+{
+public:
+	enum Type
+	{
+		NullType,
+		BoolType,
+		NumberType,
+		StringType,
+		ArrayType,
+		ObjectType
+	};
+
+	JsonValue();
+
+	Type GetType() const;
+	bool IsNull() const;
+
+	//these return the fallback when the value is some other type
+	double GetNumber(double fallback = 0.0) const;
+	bool GetBool(bool fallback = false) const;
+	const std::string& GetString() const;	// Empty unless a string
+
+	//arrays and objects - out-of-range or missing members give a shared null value
+	size_t GetSize() const;
+	const JsonValue& At(size_t index) const;
+	const JsonValue& operator[](const char* key) const;
+	bool Has(const char* key) const;
+
+	//parses a whole document; false (with a message) on malformed input
+	static bool Parse(const char* text, size_t length, JsonValue& result, std::string& error);
+
+private:
+	Type type;
+	bool boolean;
+	double number;
+	std::string string;
+	std::vector<JsonValue> elements;
+	std::vector<std::pair<std::string, JsonValue>> members;
+
+	friend class JsonParser;
+};
@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include "../ContentHash.h"
+#include "../MeshOptimizer.h"
+#include "../MeshSimplifier.h"
+#include "../MeshletBuilder.h"
+#include "GltfImporter.h"
+#include "ImportedMesh.h"
+#include "ObjImporter.h"
+
+namespace fs = std::filesystem;
+
+// --------------------------------------------------------
+// AssetBaker - turns OBJ and glTF files into .mesh files
+//
+//   AssetBaker [-o outFolder] [-j threads] [-f] inputs...
+//
+// Inputs can be files or folders (searched recursively).
+// Outputs go next to each input unless -o is given, in which
+// case folder inputs keep their layout under it.  Inputs are
+// baked in parallel, and ones whose content (and that of the
+// files they pull in) hasn't changed since the last bake are
+// skipped, using hashes kept in AssetBaker.cache in the
+// output folder (or the current one).  -f rebakes everything.
+// Meshes are welded, reordered for the vertex cache, overdraw
+// and vertex fetch (see MeshOptimizer.h), and given a chain
+// of simplified LODs (see MeshSimplifier.h).
+// --------------------------------------------------------
+
+// Changing what the baker outputs must change this, so old bakes get redone
+static const char* BakerVersion = "AssetBaker 4";
+
+namespace
+{
+	struct BakeJob
+	{
+		std::string input;
+		std::string output;
+	};
+
+	// What the cache remembers about one input's last bake
+	struct CacheEntry
+	{
+		unsigned long long hash;
+		std::string output;
+		std::vector<std::string> dependencies;
+	};
+
+	struct BakeResult
+	{
+		enum Status { Baked, Skipped, Failed } status;
+		std::string message;
+		CacheEntry entry;
+	};
+
+	bool IsSupported(const fs::path& path)
+	{
+		std::string extension = path.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		return extension == ".obj" || extension == ".gltf" || extension == ".glb";
+	}
+
+	// Folders are searched for every supported file; files are taken as they are
+	bool FindJobs(const std::string& input, const std::string& outFolder, std::vector<BakeJob>& jobs)
+	{
+		std::error_code code;
+		fs::path inputPath = fs::absolute(input, code);
+		if (fs::is_directory(inputPath, code))
+		{
+			for (fs::recursive_directory_iterator it(inputPath, code), end; it != end; it.increment(code))
+			{
+				if (!it->is_regular_file(code) || !IsSupported(it->path()))
+					continue;
+				fs::path relative = fs::relative(it->path(), inputPath, code);
+				fs::path output = (outFolder.empty() ? inputPath : fs::path(outFolder)) / relative;
+				BakeJob job = { it->path().lexically_normal().string(), output.replace_extension(".mesh").lexically_normal().string() };
+				jobs.push_back(job);
+			}
+			return true;
+		}
+
+		if (!fs::is_regular_file(inputPath, code))
+			return false;
+		fs::path output = outFolder.empty() ? inputPath : fs::path(outFolder) / inputPath.filename();
+		BakeJob job = { inputPath.lexically_normal().string(), output.replace_extension(".mesh").lexically_normal().string() };
+		jobs.push_back(job);
+		return true;
+	}
+
+	// The hash a bake is keyed on: baker version, the input, and everything it pulled in
+	unsigned long long CombineHashes(unsigned long long inputHash, const std::vector<unsigned long long>& dependencyHashes)
+	{
+		ContentHasher hasher;
+		hasher.Add(BakerVersion, strlen(BakerVersion));
+		hasher.Add(&MeshFileVersion, sizeof(MeshFileVersion));
+		hasher.Add(&inputHash, sizeof(inputHash));
+		if (!dependencyHashes.empty())
+			hasher.Add(dependencyHashes.data(), dependencyHashes.size() * sizeof(unsigned long long));
+		return hasher.Finish();
+	}
+
+	std::string FormatCacheStats(const MeshOptimizationReport& report)
+	{
+		char text[96];
+		snprintf(text, sizeof(text), "ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+			report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+		return text;
+	}
+
+	// --------------------------------------------------------
+	// One line per input:  hash <tab> input <tab> output <tab> dependencies...
+	// --------------------------------------------------------
+	void LoadCache(const std::string& path, std::map<std::string, CacheEntry>& cache)
+	{
+		std::ifstream file(path);
+		std::string line;
+		while (std::getline(file, line))
+		{
+			std::vector<std::string> fields;
+			std::stringstream stream(line);
+			std::string field;
+			while (std::getline(stream, field, '\t'))
+				fields.push_back(field);
+			if (fields.size() < 3)
+				continue;
+
+			CacheEntry entry;
+			entry.hash = strtoull(fields[0].c_str(), 0, 16);
+			entry.output = fields[2];
+			entry.dependencies.assign(fields.begin() + 3, fields.end());
+			cache[fields[1]] = entry;
+		}
+	}
+
+	bool SaveCache(const std::string& path, const std::map<std::string, CacheEntry>& cache)
+	{
+		std::ofstream file(path, std::ios::trunc);
+		for (std::map<std::string, CacheEntry>::const_iterator it = cache.begin(); it != cache.end(); ++it)
+		{
+			char hash[32];
+			snprintf(hash, sizeof(hash), "%016llx", it->second.hash);
+			file << hash << '\t' << it->first << '\t' << it->second.output;
+			for (size_t i = 0; i < it->second.dependencies.size(); i++)
+				file << '\t' << it->second.dependencies[i];
+			file << '\n';
+		}
+		return (bool)file;
+	}
+
+	// --------------------------------------------------------
+	// Reads, hashes, imports, welds and writes one input.  Skips
+	// it if the cache says the same content made this output.
+	// --------------------------------------------------------
+	BakeResult Bake(const BakeJob& job, const CacheEntry* cached)
+	{
+		BakeResult result;
+		result.status = BakeResult::Failed;
+
+		std::vector<char> contents;
+		if (!ReadFileContents(job.input, contents))
+		{
+			result.message = "can't read the file";
+			return result;
+		}
+		unsigned long long inputHash = HashContent(contents.data(), contents.size());
+
+		std::error_code code;
+		if (cached && cached->output == job.output && fs::exists(job.output, code))
+		{
+			std::vector<unsigned long long> dependencyHashes;
+			for (size_t i = 0; i < cached->dependencies.size(); i++)
+				dependencyHashes.push_back(HashFileContents(cached->dependencies[i]));
+			if (CombineHashes(inputHash, dependencyHashes) == cached->hash)
+			{
+				result.status = BakeResult::Skipped;
+				result.entry = *cached;
+				return result;
+			}
+		}
+
+		ImportedMesh mesh;
+		std::vector<ImportDependency> dependencies;
+		std::string extension = fs::path(job.input).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		bool imported = extension == ".obj" ?
+			ImportObj(job.input, contents, mesh, dependencies, result.message) :
+			ImportGltf(job.input, contents, mesh, dependencies, result.message);
+		if (!imported)
+			return result;
+
+		size_t corners = mesh.vertices.size();
+		WeldVertices(mesh);
+
+		MeshOptimizationReport report;
+		size_t vertexCount = OptimizeMesh(mesh.vertices.data(), mesh.vertices.size(), sizeof(MeshFileVertex),
+			offsetof(MeshFileVertex, position), mesh.indices.data(), mesh.indices.size(), &report);
+		mesh.vertices.resize(vertexCount);
+
+		// Meshlets reorder LOD 0, so they come before the LODs are simplified from it
+		std::vector<Meshlet> meshlets;
+		BuildMeshlets(meshlets, mesh.indices.data(), mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size(),
+			sizeof(MeshFileVertex), offsetof(MeshFileVertex, position));
+		std::vector<MeshFileMeshlet> fileMeshlets(meshlets.size());
+		for (size_t i = 0; i < meshlets.size(); i++)
+		{
+			MeshFileMeshlet& fileMeshlet = fileMeshlets[i];
+			fileMeshlet.firstIndex = meshlets[i].firstIndex;
+			fileMeshlet.indexCount = meshlets[i].indexCount;
+			fileMeshlet.radius = meshlets[i].radius;
+			fileMeshlet.coneCutoff = meshlets[i].coneCutoff;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				fileMeshlet.center[axis] = meshlets[i].center[axis];
+				fileMeshlet.coneApex[axis] = meshlets[i].coneApex[axis];
+				fileMeshlet.coneAxis[axis] = meshlets[i].coneAxis[axis];
+			}
+		}
+
+		size_t fullIndexCount = mesh.indices.size();
+		std::vector<SimplifiedLod> chain;
+		BuildLodChain(mesh.indices, chain, mesh.vertices.data(), mesh.vertices.size(), sizeof(MeshFileVertex),
+			offsetof(MeshFileVertex, position));
+		std::vector<MeshFileLod> lods(chain.size());
+		for (size_t i = 0; i < chain.size(); i++)
+		{
+			lods[i].firstIndex = chain[i].firstIndex;
+			lods[i].indexCount = chain[i].indexCount;
+			lods[i].error = chain[i].error;
+		}
+
+		fs::create_directories(fs::path(job.output).parent_path(), code);
+		if (!WriteMeshFile(job.output, mesh.vertices.data(), (unsigned int)mesh.vertices.size(),
+			mesh.indices.data(), (unsigned int)mesh.indices.size(), lods.data(), (unsigned int)lods.size(),
+			fileMeshlets.data(), (unsigned int)fileMeshlets.size()))
+		{
+			result.message = "can't write " + job.output;
+			return result;
+		}
+
+		std::vector<unsigned long long> dependencyHashes;
+		for (size_t i = 0; i < dependencies.size(); i++)
+		{
+			dependencyHashes.push_back(dependencies[i].hash);
+			result.entry.dependencies.push_back(dependencies[i].path);
+		}
+		result.entry.hash = CombineHashes(inputHash, dependencyHashes);
+		result.entry.output = job.output;
+		result.status = BakeResult::Baked;
+		result.message = std::to_string(fullIndexCount / 3) + " triangles, " +
+			std::to_string(mesh.vertices.size()) + " vertices (welded from " + std::to_string(corners) + "), " +
+			FormatCacheStats(report) + ", " + std::to_string(lods.size()) + " LODs down to " +
+			std::to_string(lods.back().indexCount / 3) + " triangles, " + std::to_string(meshlets.size()) + " meshlets";
+		return result;
+	}
+
+	void PrintUsage()
+	{
+		printf("usage: AssetBaker [-o outFolder] [-j threads] [-f] inputs...\n"
+			"  inputs        .obj, .gltf or .glb files, or folders to search\n"
+			"  -o outFolder  where to write .mesh files (default: next to each input)\n"
+			"  -j threads    worker threads (default: one per core)\n"
+			"  -f            rebake everything, even unchanged inputs\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string outFolder;
+	unsigned int threadCount = std::thread::hardware_concurrency();
+	bool force = false;
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			outFolder = argv[++i];
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+			threadCount = (unsigned int)atoi(argv[++i]);
+		else if (strcmp(argv[i], "-f") == 0)
+			force = true;
+		else if (argv[i][0] == '-')
+		{
+			PrintUsage();
+			return 1;
+		}
+		else
+			inputs.push_back(argv[i]);
+	}
+	if (inputs.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+	if (threadCount == 0)
+		threadCount = 1;
+
+	std::vector<BakeJob> jobs;
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		if (!FindJobs(inputs[i], outFolder, jobs))
+		{
+			fprintf(stderr, "%s: not found\n", inputs[i].c_str());
+			return 1;
+		}
+	}
+
+	std::string cachePath = ((outFolder.empty() ? fs::current_path() : fs::path(outFolder)) / "AssetBaker.cache").string();
+	// Loaded even when forcing, so entries for inputs not baked this time are kept
+	std::map<std::string, CacheEntry> cache;
+	LoadCache(cachePath, cache);
+
+	// Workers pull the next job off a shared counter until none are left
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<BakeResult> results(jobs.size());
+	std::atomic<size_t> nextJob(0);
+	std::mutex printMutex;
+	std::vector<std::thread> workers;
+	for (unsigned int t = 0; t < threadCount && t < jobs.size(); t++)
+	{
+		workers.push_back(std::thread([&]()
+		{
+			for (size_t j = nextJob++; j < jobs.size(); j = nextJob++)
+			{
+				std::map<std::string, CacheEntry>::const_iterator cached = cache.find(jobs[j].input);
+				results[j] = Bake(jobs[j], cached != cache.end() && !force ? &cached->second : 0);
+
+				std::lock_guard<std::mutex> lock(printMutex);
+				if (results[j].status == BakeResult::Baked)
+					printf("baked   %s: %s\n", jobs[j].input.c_str(), results[j].message.c_str());
+				else if (results[j].status == BakeResult::Failed)
+					fprintf(stderr, "FAILED  %s: %s\n", jobs[j].input.c_str(), results[j].message.c_str());
+			}
+		}));
+	}
+	for (size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+
+	unsigned int counts[3] = {};
+	for (size_t j = 0; j < jobs.size(); j++)
+	{
+		counts[results[j].status]++;
+		if (results[j].status == BakeResult::Failed)
+			cache.erase(jobs[j].input);
+		else
+			cache[jobs[j].input] = results[j].entry;
+	}
+	if (!SaveCache(cachePath, cache))
+		fprintf(stderr, "couldn't save %s\n", cachePath.c_str());
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("%u baked, %u unchanged, %u failed in %.2fs on %u threads\n",
+		counts[BakeResult::Baked], counts[BakeResult::Skipped], counts[BakeResult::Failed], seconds, (unsigned int)workers.size());
+	return counts[BakeResult::Failed] ? 1 : 0;
+}
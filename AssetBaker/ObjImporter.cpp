@@ -0,0 +1,179 @@
+#include "ObjImporter.h"
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+
+namespace
+{
+	struct ObjColor
+	{
+		float r, g, b, a;
+	};
+
+	// Splits a line into whitespace-separated tokens (pointers into the line, which is edited in place)
+	void Tokenize(char* line, std::vector<char*>& tokens)
+	{
+		tokens.clear();
+		char* p = line;
+		for (;;)
+		{
+			while (*p == ' ' || *p == '\t' || *p == '\r')
+				*p++ = 0;
+			if (!*p || *p == '#')
+				break;
+			tokens.push_back(p);
+			while (*p && *p != ' ' && *p != '\t' && *p != '\r')
+				p++;
+		}
+		if (*p == '#')
+			*p = 0;
+	}
+
+	float ParseFloat(const char* text)
+	{
+		return strtof(text, 0);
+	}
+
+	// Reads Kd (diffuse color) and d / Tr (opacity) for each material
+	void LoadMaterials(const std::string& path, std::map<std::string, ObjColor>& materials, std::vector<ImportDependency>& dependencies)
+	{
+		std::vector<char> contents;
+		if (!ReadDependency(path, contents, dependencies))
+			return;
+		contents.push_back(0);
+
+		std::vector<char*> tokens;
+		ObjColor* current = 0;
+		char* line = contents.data();
+		while (line)
+		{
+			char* next = strchr(line, '\n');
+			if (next)
+				*next++ = 0;
+			Tokenize(line, tokens);
+			line = next;
+			if (tokens.empty())
+				continue;
+
+			if (strcmp(tokens[0], "newmtl") == 0 && tokens.size() >= 2)
+			{
+				ObjColor white = { 1.0f, 1.0f, 1.0f, 1.0f };
+				current = &(materials[tokens[1]] = white);
+			}
+			else if (current && strcmp(tokens[0], "Kd") == 0 && tokens.size() >= 4)
+			{
+				current->r = ParseFloat(tokens[1]);
+				current->g = ParseFloat(tokens[2]);
+				current->b = ParseFloat(tokens[3]);
+			}
+			else if (current && strcmp(tokens[0], "d") == 0 && tokens.size() >= 2)
+				current->a = ParseFloat(tokens[1]);
+			else if (current && strcmp(tokens[0], "Tr") == 0 && tokens.size() >= 2)
+				current->a = 1.0f - ParseFloat(tokens[1]);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// OBJ is right-handed with counter-clockwise front faces;
+// z is negated and each triangle's winding reversed to get
+// the engine's left-handed, clockwise convention
+// --------------------------------------------------------
+bool ImportObj(const std::string& path, const std::vector<char>& contents,
+	ImportedMesh& mesh, std::vector<ImportDependency>& dependencies, std::string& error)
+{
+	std::vector<char> text(contents);
+	text.push_back(0);
+
+	std::filesystem::path folder = std::filesystem::path(path).parent_path();
+	std::map<std::string, ObjColor> materials;
+	ObjColor white = { 1.0f, 1.0f, 1.0f, 1.0f };
+	ObjColor material = white;
+
+	std::vector<float> positions;	// xyz per v
+	std::vector<float> colors;		// rgb per v (white when not given)
+	std::vector<unsigned int> corners;
+	std::vector<char*> tokens;
+
+	unsigned int lineNumber = 0;
+	char* line = text.data();
+	while (line)
+	{
+		char* next = strchr(line, '\n');
+		if (next)
+			*next++ = 0;
+		lineNumber++;
+		Tokenize(line, tokens);
+		line = next;
+		if (tokens.empty())
+			continue;
+
+		if (strcmp(tokens[0], "v") == 0)
+		{
+			if (tokens.size() < 4)
+			{
+				error = "line " + std::to_string(lineNumber) + ": v needs x y z";
+				return false;
+			}
+			positions.push_back(ParseFloat(tokens[1]));
+			positions.push_back(ParseFloat(tokens[2]));
+			positions.push_back(-ParseFloat(tokens[3]));
+			bool hasColor = tokens.size() >= 7;
+			colors.push_back(hasColor ? ParseFloat(tokens[4]) : 1.0f);
+			colors.push_back(hasColor ? ParseFloat(tokens[5]) : 1.0f);
+			colors.push_back(hasColor ? ParseFloat(tokens[6]) : 1.0f);
+		}
+		else if (strcmp(tokens[0], "f") == 0)
+		{
+			corners.clear();
+			long long vertexCount = (long long)positions.size() / 3;
+			for (size_t t = 1; t < tokens.size(); t++)
+			{
+				// Only the position reference (before any '/') matters
+				long long reference = strtoll(tokens[t], 0, 10);
+				long long index = reference < 0 ? vertexCount + reference : reference - 1;
+				if (reference == 0 || index < 0 || index >= vertexCount)
+				{
+					error = "line " + std::to_string(lineNumber) + ": face references a missing vertex";
+					return false;
+				}
+				corners.push_back((unsigned int)index);
+			}
+
+			for (size_t c = 2; c < corners.size(); c++)
+			{
+				unsigned int triangle[3] = { corners[0], corners[c], corners[c - 1] };
+				for (int k = 0; k < 3; k++)
+				{
+					const float* p = &positions[triangle[k] * 3];
+					const float* color = &colors[triangle[k] * 3];
+					MeshFileVertex vertex =
+					{
+						{ p[0], p[1], p[2] },
+						{ color[0] * material.r, color[1] * material.g, color[2] * material.b, material.a }
+					};
+					mesh.indices.push_back((unsigned int)mesh.vertices.size());
+					mesh.vertices.push_back(vertex);
+				}
+			}
+		}
+		else if (strcmp(tokens[0], "mtllib") == 0)
+		{
+			for (size_t t = 1; t < tokens.size(); t++)
+				LoadMaterials((folder / tokens[t]).string(), materials, dependencies);
+		}
+		else if (strcmp(tokens[0], "usemtl") == 0 && tokens.size() >= 2)
+		{
+			std::map<std::string, ObjColor>::iterator found = materials.find(tokens[1]);
+			material = found != materials.end() ? found->second : white;
+		}
+	}
+
+	if (mesh.indices.empty())
+	{
+		error = "no faces";
+		return false;
+	}
+	return true;
+}
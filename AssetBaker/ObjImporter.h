@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ImportedMesh.h"
+
+// --------------------------------------------------------
+// Wavefront OBJ: v (with optional r g b vertex colors) and
+// f (any polygon, triangulated as a fan; texture/normal
+// references are ignored).  Faces are colored by their
+// material's Kd and d from any mtllib files.  Every corner
+// becomes its own vertex - weld afterwards.
+// --------------------------------------------------------
+bool ImportObj(const std::string& path, const std::vector<char>& contents,
+	ImportedMesh& mesh, std::vector<ImportDependency>& dependencies, std::string& error);
@@ -0,0 +1,183 @@
+#include "AssetLoader.h"
+
+using namespace DirectX;
+
+// A unit cube around the origin, faces wound clockwise from outside
+const Vertex AssetLoader::PlaceholderVertices[8] =
+{
+	{ XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f) },
+	{ XMFLOAT3(+0.5f, -0.5f, -0.5f), XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f) },
+	{ XMFLOAT3(-0.5f, +0.5f, -0.5f), XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f) },
+	{ XMFLOAT3(+0.5f, +0.5f, -0.5f), XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f) },
+	{ XMFLOAT3(-0.5f, -0.5f, +0.5f), XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f) },
+	{ XMFLOAT3(+0.5f, -0.5f, +0.5f), XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f) },
+	{ XMFLOAT3(-0.5f, +0.5f, +0.5f), XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f) },
+	{ XMFLOAT3(+0.5f, +0.5f, +0.5f), XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f) }
+};
+
+const unsigned int AssetLoader::PlaceholderIndices[36] =
+{
+	0, 2, 1, 1, 2, 3,	// -z
+	4, 5, 6, 5, 7, 6,	// +z
+	0, 4, 2, 2, 4, 6,	// -x
+	1, 3, 5, 3, 7, 5,	// +x
+	0, 1, 4, 1, 5, 4,	// -y
+	2, 6, 3, 3, 6, 7	// +y
+};
+
+AssetLoader::AssetLoader(GeometryPool* geometryPool, unsigned int threadCount)
+{
+	this->geometryPool = geometryPool;
+	this->decoding = 0;
+	this->quitting = false;
+	this->loaded = 0;
+	this->failed = 0;
+	this->bytesUploaded = 0;
+
+	if (threadCount == 0)
+	{
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.push_back(std::thread(&AssetLoader::WorkerLoop, this));
+}
+
+// --------------------------------------------------------
+// Workers finish the file they're on; anything still queued
+// is dropped, leaving its placeholder
+// --------------------------------------------------------
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		quitting = true;
+	}
+	jobQueued.notify_all();
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+void AssetLoader::Queue(const std::string& path, const std::shared_ptr<Mesh>& mesh, DecodeFunction decode, SwapFunction swap)
+{
+	std::unique_ptr<Job> job(new Job());
+	job->path = path;
+	job->mesh = mesh;
+	job->decode = decode;
+	job->swap = swap;
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		queue.push_back(std::move(job));
+	}
+	jobQueued.notify_one();
+}
+
+// --------------------------------------------------------
+// Maps and checks the file, then reads a byte from every
+// page, so the disk reads happen here on the worker rather
+// than during the upload on the main thread
+// --------------------------------------------------------
+bool AssetLoader::Open(const std::string& path, DecodedMesh& decoded)
+{
+	if (!OpenMeshFile(path, decoded.file, decoded.contents, decoded.bounds))
+		return false;
+
+	const volatile unsigned char* bytes = (const volatile unsigned char*)decoded.file.GetData();
+	size_t size = decoded.file.GetSize();
+	unsigned char touched = 0;
+	for (size_t i = 0; i < size; i += 4096)
+		touched ^= bytes[i];
+	(void)touched;
+	return true;
+}
+
+void AssetLoader::WorkerLoop()
+{
+	while (true)
+	{
+		std::unique_ptr<Job> job;
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobQueued.wait(lock, [this] { return quitting || !queue.empty(); });
+			if (quitting)
+				return;
+			job = std::move(queue.front());
+			queue.pop_front();
+			decoding++;
+		}
+
+		// Nobody wants it any more - no point reading it
+		if (!job->mesh.expired())
+			job->decoded.reset(job->decode(job->path));
+
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			ready.push_back(std::move(job));
+			decoding--;
+		}
+		jobReady.notify_all();
+	}
+}
+
+// --------------------------------------------------------
+// Meshes are swapped in the order they finished reading.
+// The budget is checked before each one, so the last can go
+// over it - a mesh bigger than the budget still gets in, on
+// a frame of its own.
+// --------------------------------------------------------
+unsigned int AssetLoader::Update(unsigned int uploadBudget)
+{
+	bytesUploaded = 0;
+	unsigned int swapped = 0;
+	while (swapped == 0 || bytesUploaded < uploadBudget)
+	{
+		std::unique_ptr<Job> job;
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			if (ready.empty())
+				break;
+			job = std::move(ready.front());
+			ready.pop_front();
+		}
+
+		std::shared_ptr<Mesh> mesh = job->mesh.lock();
+		if (!mesh)
+			continue;
+		if (!job->decoded || !job->swap(*mesh, *job->decoded, geometryPool, bytesUploaded))
+		{
+			failed++;
+			continue;
+		}
+
+		loaded++;
+		swapped++;
+	}
+	return swapped;
+}
+
+void AssetLoader::Finish()
+{
+	while (true)
+	{
+		Update(0xFFFFFFFF);
+
+		std::unique_lock<std::mutex> lock(jobMutex);
+		if (queue.empty() && decoding == 0 && ready.empty())
+			return;
+		jobReady.wait(lock, [this] { return !ready.empty(); });
+	}
+}
+
+AssetLoaderStats AssetLoader::GetStats()
+{
+	AssetLoaderStats stats;
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		stats.queued = (unsigned int)queue.size() + decoding;
+		stats.ready = (unsigned int)ready.size();
+	}
+	stats.loaded = loaded;
+	stats.failed = failed;
+	stats.bytesUploaded = bytesUploaded;
+	return stats;
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Mesh.h"
+#include "MeshFile.h"
+#include "GeometryPool.h"
+
+// Counters kept by AssetLoader
+struct AssetLoaderStats
+{
+	unsigned int queued;		// Waiting for a worker, or being read by one
+	unsigned int ready;			// Read, waiting for upload budget
+	unsigned int loaded;		// Swapped in (since the loader was made)
+	unsigned int failed;		// Couldn't be read or didn't fit in the pool - their placeholders stay
+	unsigned int bytesUploaded;	// Sent to the GPU by the last Update()
+};
+
+// --------------------------------------------------------
+// Loads mesh files in the background.  LoadMesh() returns
+// at once with a placeholder (a small grey cube) that can be
+// drawn and given to entities straight away.  Worker threads
+// map and check the file, pull its pages in, and pack its
+// vertices into VertexType; the file stays mapped, so its
+// (baked) index, LOD and meshlet streams are never copied.
+// Update() - called once a frame on the main thread, which
+// owns the render device - then only uploads finished meshes
+// and swaps them into their placeholders in place, so every
+// pointer to one now draws the real thing.
+//
+// Update() stops once a frame's upload budget is spent, so a
+// level's worth of meshes arriving together spread over a
+// few frames instead of stalling one.  Finish() ignores the
+// budget and waits for everything, for loading screens.
+//
+// Meshes dropped before they finish loading are skipped.
+// The loader must go before the geometry pool it fills.
+// --------------------------------------------------------
+class AssetLoader
+{
+public:
+	AssetLoader(GeometryPool* geometryPool, unsigned int threadCount = 0);	// 0 = one per hardware thread, less the main one
+	~AssetLoader();
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	//queues a .mesh file, returning its placeholder - packed into VertexType, like LoadMeshFile()
+	template<typename VertexType = Vertex>
+	std::shared_ptr<Mesh> LoadMesh(const std::string& path);
+
+	//swaps in finished meshes until about uploadBudget bytes have gone to the GPU (always
+	//at least one, so big meshes still arrive); returns how many were swapped in
+	unsigned int Update(unsigned int uploadBudget);
+	//waits for every queued mesh and swaps them all in
+	void Finish();
+
+	AssetLoaderStats GetStats();
+
+private:
+	// A checked mesh file, kept mapped until it's uploaded
+	struct DecodedMesh
+	{
+		MappedFile file;
+		MeshFileContents contents;
+		MeshBounds bounds;
+		virtual ~DecodedMesh() {}
+	};
+
+	// ... with its vertices ready for a VertexType vertex buffer
+	template<typename VertexType>
+	struct PackedMesh : DecodedMesh
+	{
+		std::vector<VertexType> storage;	// Empty when no packing is needed (VertexType is Vertex)
+		const VertexType* vertices;			// Into storage, or the mapping
+	};
+
+	// Maps, checks and packs a file on a worker thread; null on failure
+	typedef DecodedMesh* (*DecodeFunction)(const std::string& path);
+	// Builds the real mesh from decoded streams and swaps it into the placeholder, adding what it
+	// uploaded to bytesUploaded; false (keeping the placeholder) if the pool had no room for it
+	typedef bool (*SwapFunction)(Mesh& placeholder, DecodedMesh& decoded, GeometryPool* geometryPool, unsigned int& bytesUploaded);
+
+	struct Job
+	{
+		std::string path;
+		std::weak_ptr<Mesh> mesh;
+		DecodeFunction decode;
+		SwapFunction swap;
+		std::unique_ptr<DecodedMesh> decoded;	// Null until decoded, or if that failed
+	};
+
+	static const Vertex PlaceholderVertices[8];
+	static const unsigned int PlaceholderIndices[36];
+
+	GeometryPool* geometryPool;
+
+	//workers take jobs from the queue and put them on the ready list
+	std::vector<std::thread> workers;
+	std::mutex jobMutex;
+	std::condition_variable jobQueued;
+	std::condition_variable jobReady;
+	std::deque<std::unique_ptr<Job>> queue;
+	std::deque<std::unique_ptr<Job>> ready;
+	unsigned int decoding;
+	bool quitting;
+
+	unsigned int loaded;
+	unsigned int failed;
+	unsigned int bytesUploaded;
+
+	template<typename VertexType>
+	static DecodedMesh* Decode(const std::string& path);
+	template<typename VertexType>
+	static bool SwapIn(Mesh& placeholder, DecodedMesh& decoded, GeometryPool* geometryPool, unsigned int& bytesUploaded);
+	static bool Open(const std::string& path, DecodedMesh& decoded);
+	void Queue(const std::string& path, const std::shared_ptr<Mesh>& mesh, DecodeFunction decode, SwapFunction swap);
+	void WorkerLoop();
+};
+
+template<typename VertexType>
+std::shared_ptr<Mesh> AssetLoader::LoadMesh(const std::string& path)
+{
+	std::shared_ptr<Mesh> placeholder = std::make_shared<VertexMesh<VertexType>>(
+		PlaceholderVertices, 8, PlaceholderIndices, 36, geometryPool);
+	Queue(path, placeholder, &AssetLoader::Decode<VertexType>, &AssetLoader::SwapIn<VertexType>);
+	return placeholder;
+}
+
+template<typename VertexType>
+AssetLoader::DecodedMesh* AssetLoader::Decode(const std::string& path)
+{
+	std::unique_ptr<PackedMesh<VertexType>> decoded(new PackedMesh<VertexType>());
+	if (!Open(path, *decoded))
+		return 0;
+
+	decoded->vertices = PackVertices((const Vertex*)decoded->contents.vertices, decoded->contents.header->vertexCount, decoded->storage);
+	return decoded.release();
+}
+
+template<typename VertexType>
+bool AssetLoader::SwapIn(Mesh& placeholder, DecodedMesh& decoded, GeometryPool* geometryPool, unsigned int& bytesUploaded)
+{
+	// The loaded mesh ends up holding the placeholder's geometry, and frees it on the way out
+	PackedMesh<VertexType>& packed = (PackedMesh<VertexType>&)decoded;
+	const MeshFileHeader* header = packed.contents.header;
+	VertexMesh<VertexType> loadedMesh(packed.vertices, header->vertexCount, packed.contents.indices, GetIndexFormat(*header),
+		header->indexCount, packed.bounds, (const MeshLod*)packed.contents.lods, header->lodCount, geometryPool);
+	if (loadedMesh.IsEmpty())
+		return false;
+	loadedMesh.SetMeshlets((const Meshlet*)packed.contents.meshlets, header->meshletCount);
+	placeholder.Swap(loadedMesh);
+
+	bytesUploaded += header->vertexCount * VertexLayout<VertexType>::Stride + header->indexCount * header->indexSize;
+	return true;
+}
@@ -0,0 +1,926 @@
+#include "BoundingVolumeHierarchy.h"
+#include <algorithm>
+#include <cfloat>
+
+using namespace DirectX;
+
+const unsigned int BoundingVolumeHierarchy::MaxLeafItems;
+const float BoundingVolumeHierarchy::RebuildRatio = 1.5f;
+const unsigned int BoundingVolumeHierarchy::None;
+
+// Centroids are sorted into this many bins per axis when looking for a split
+static const unsigned int SplitBins = 16;
+
+// --------------------------------------------------------
+// Box helpers.  An empty box (min = FLT_MAX, max = -FLT_MAX)
+// fails every test below without special cases, which is
+// how removed items left in leaves drop out of queries.
+// --------------------------------------------------------
+static BvhBounds EmptyBounds()
+{
+	BvhBounds bounds;
+	for (int a = 0; a < 3; a++)
+	{
+		bounds.min[a] = FLT_MAX;
+		bounds.max[a] = -FLT_MAX;
+	}
+	return bounds;
+}
+
+static void GrowBounds(float min[3], float max[3], const float otherMin[3], const float otherMax[3])
+{
+	for (int a = 0; a < 3; a++)
+	{
+		min[a] = std::min(min[a], otherMin[a]);
+		max[a] = std::max(max[a], otherMax[a]);
+	}
+}
+
+// Half the surface area, which is all the heuristic needs (ratios of areas)
+static float GetArea(const float min[3], const float max[3])
+{
+	float x = max[0] - min[0];
+	float y = max[1] - min[1];
+	float z = max[2] - min[2];
+	if (x < 0 || y < 0 || z < 0)
+		return 0;
+	return x * y + y * z + z * x;
+}
+
+static bool SameBounds(const float min[3], const float max[3], const float otherMin[3], const float otherMax[3])
+{
+	return
+		min[0] == otherMin[0] && min[1] == otherMin[1] && min[2] == otherMin[2] &&
+		max[0] == otherMax[0] && max[1] == otherMax[1] && max[2] == otherMax[2];
+}
+
+static bool BoundsOverlap(const float min[3], const float max[3], const BvhBounds& other)
+{
+	return
+		min[0] <= other.max[0] && max[0] >= other.min[0] &&
+		min[1] <= other.max[1] && max[1] >= other.min[1] &&
+		min[2] <= other.max[2] && max[2] >= other.min[2];
+}
+
+static bool BoundsTouchSphere(const float min[3], const float max[3], const float center[3], float radiusSquared)
+{
+	float distanceSquared = 0;
+	for (int a = 0; a < 3; a++)
+	{
+		float outside = 0;
+		if (center[a] < min[a])
+			outside = min[a] - center[a];
+		else if (center[a] > max[a])
+			outside = center[a] - max[a];
+		distanceSquared += outside * outside;
+	}
+	return distanceSquared <= radiusSquared;
+}
+
+// --------------------------------------------------------
+// Tests the box against the planes still set in mask, by its
+// corner furthest along each plane's normal: when that corner
+// is outside, the whole box is.  Planes the nearest corner is
+// inside of hold for everything in the box, so they're taken
+// out of the mask for its children.
+// --------------------------------------------------------
+static bool BoundsInFrustum(const float min[3], const float max[3], const XMFLOAT4 planes[6], unsigned int& mask)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		if (!(mask & (1 << i)))
+			continue;
+
+		const XMFLOAT4& p = planes[i];
+		float furthest =
+			p.x * (p.x >= 0 ? max[0] : min[0]) +
+			p.y * (p.y >= 0 ? max[1] : min[1]) +
+			p.z * (p.z >= 0 ? max[2] : min[2]) + p.w;
+		if (furthest < 0)
+			return false;
+
+		float nearest =
+			p.x * (p.x >= 0 ? min[0] : max[0]) +
+			p.y * (p.y >= 0 ? min[1] : max[1]) +
+			p.z * (p.z >= 0 ? min[2] : max[2]) + p.w;
+		if (nearest >= 0)
+			mask &= ~(1 << i);
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Slab test.  Axes the ray doesn't move along only need the
+// origin inside the slab; the others clip [0, maxT] to where
+// the ray is between the slab's planes (ordered by the sign
+// of the direction, so an empty box always clips to nothing).
+// --------------------------------------------------------
+static bool RayEntersBounds(const float min[3], const float max[3], const float origin[3], const float direction[3],
+	const float inverseDirection[3], float maxT, float& t)
+{
+	float tNear = 0;
+	float tFar = maxT;
+	for (int a = 0; a < 3; a++)
+	{
+		if (direction[a] == 0)
+		{
+			if (origin[a] < min[a] || origin[a] > max[a])
+				return false;
+			continue;
+		}
+
+		float t0 = (min[a] - origin[a]) * inverseDirection[a];
+		float t1 = (max[a] - origin[a]) * inverseDirection[a];
+		if (inverseDirection[a] < 0)
+			std::swap(t0, t1);
+		tNear = std::max(tNear, t0);
+		tFar = std::min(tFar, t1);
+		if (tNear > tFar)
+			return false;
+	}
+	t = tNear;
+	return true;
+}
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+	this->itemCount = 0;
+	this->staleCount = 0;
+	this->costSum = 0;
+	this->buildCost = 0;
+	this->nodesRefit = 0;
+	this->rebuilds = 0;
+	this->rebuildPending = false;
+	this->quitting = false;
+	this->rebuildDone = false;
+	this->rebuilding = false;
+}
+
+// A build in progress is finished (and thrown away) before the worker stops
+BoundingVolumeHierarchy::~BoundingVolumeHierarchy()
+{
+	{
+		std::lock_guard<std::mutex> lock(rebuildMutex);
+		quitting = true;
+	}
+	rebuildRequested.notify_all();
+	if (rebuildThread.joinable())
+		rebuildThread.join();
+}
+
+void BoundingVolumeHierarchy::SetBounds(unsigned int item, const BvhBounds& bounds)
+{
+	if (item >= itemStates.size())
+	{
+		itemBounds.resize(item + 1);
+		itemStates.resize(item + 1, ItemAbsent);
+		itemLeaves.resize(item + 1, None);
+		itemSlots.resize(item + 1, None);
+	}
+
+	BvhBounds& current = itemBounds[item];
+	switch (itemStates[item])
+	{
+	case ItemIndexed:
+		// Most things don't move most frames, and those shouldn't cost a refit
+		if (SameBounds(current.min, current.max, bounds.min, bounds.max))
+			return;
+		current = bounds;
+		orderBounds[itemSlots[item]] = bounds;
+		MarkDirty(item);
+		return;
+
+	case ItemPending:
+		current = bounds;
+		return;
+
+	default:
+		current = bounds;
+		itemCount++;
+		if (itemLeaves[item] != None)
+		{
+			// Removed since the tree was built, and back before it was rebuilt
+			itemStates[item] = ItemIndexed;
+			staleCount--;
+			orderBounds[itemSlots[item]] = bounds;
+			MarkDirty(item);
+		}
+		else
+			AddPending(item);
+		return;
+	}
+}
+
+// --------------------------------------------------------
+// Items in the tree stay in their leaves until the next
+// rebuild, with an empty box so queries pass them by
+// --------------------------------------------------------
+void BoundingVolumeHierarchy::Remove(unsigned int item)
+{
+	if (item >= itemStates.size() || itemStates[item] == ItemAbsent)
+		return;
+
+	itemCount--;
+	if (itemStates[item] == ItemPending)
+	{
+		RemovePending(item);
+		itemStates[item] = ItemAbsent;
+		return;
+	}
+
+	itemStates[item] = ItemAbsent;
+	staleCount++;
+	orderBounds[itemSlots[item]] = EmptyBounds();
+	MarkDirty(item);
+}
+
+// --------------------------------------------------------
+// A few changed leaves are refit by walking up to the root
+// from each, stopping where a box doesn't change.  Past an
+// eighth of the tree, one back-to-front sweep (children are
+// always after their parents) is cheaper than the walks.
+//
+// A rebuild starts when there are new items to take in, when
+// a quarter of the tree is removed items, or when moving
+// items have stretched the boxes so far that the tree costs
+// RebuildRatio times what it did when built.
+// --------------------------------------------------------
+void BoundingVolumeHierarchy::Update()
+{
+	if (rebuilding && rebuildDone)
+		FinishRebuild();
+
+	nodesRefit = 0;
+	if (dirtyLeaves.size() * 8 > nodes.size())
+		RefitAll();
+	else
+	{
+		for (size_t i = 0; i < dirtyLeaves.size(); i++)
+		{
+			if (!RefitLeaf(dirtyLeaves[i]))
+				continue;
+			for (unsigned int node = parents[dirtyLeaves[i]]; node != None && RefitInner(node); node = parents[node]);
+		}
+	}
+	for (size_t i = 0; i < dirtyLeaves.size(); i++)
+		leafDirty[dirtyLeaves[i]] = 0;
+	dirtyLeaves.clear();
+
+	if (rebuilding)
+		return;
+
+	// With nothing in the tree worth searching there's no reason to wait
+	unsigned int indexedCount = itemCount - (unsigned int)pending.size();
+	if (indexedCount == 0)
+	{
+		if (!pending.empty() || !nodes.empty())
+			StartRebuild(false);
+	}
+	else if (!pending.empty() || staleCount * 4 > order.size() || GetCost() > buildCost * RebuildRatio)
+		StartRebuild(true);
+}
+
+void BoundingVolumeHierarchy::FinishRebuild()
+{
+	if (!rebuilding)
+		return;
+
+	{
+		std::unique_lock<std::mutex> lock(rebuildMutex);
+		rebuildFinished.wait(lock, [this] { return rebuildDone.load(); });
+	}
+	rebuilding = false;
+	SwapInRebuild();
+}
+
+// --------------------------------------------------------
+// Snapshots every live item's bounds for the build, which
+// then only touches the rebuild arrays
+// --------------------------------------------------------
+void BoundingVolumeHierarchy::StartRebuild(bool background)
+{
+	rebuildOrder.clear();
+	for (unsigned int item = 0; item < itemStates.size(); item++)
+	{
+		if (itemStates[item] != ItemAbsent)
+			rebuildOrder.push_back(item);
+	}
+	rebuildBounds = itemBounds;
+
+	if (!background)
+	{
+		Build(rebuildBounds, rebuildOrder, rebuildNodes);
+		SwapInRebuild();
+		return;
+	}
+
+	// Trees loosen steadily as things move, so rebuilds keep coming for as
+	// long as anything does - one thread is kept for them all
+	if (!rebuildThread.joinable())
+		rebuildThread = std::thread(&BoundingVolumeHierarchy::RebuildLoop, this);
+
+	{
+		std::lock_guard<std::mutex> lock(rebuildMutex);
+		rebuildDone = false;
+		rebuildPending = true;
+	}
+	rebuilding = true;
+	rebuildRequested.notify_one();
+}
+
+// --------------------------------------------------------
+// The worker: builds from the rebuild arrays each time it's
+// asked, until the hierarchy goes away
+// --------------------------------------------------------
+void BoundingVolumeHierarchy::RebuildLoop()
+{
+	std::unique_lock<std::mutex> lock(rebuildMutex);
+	while (true)
+	{
+		rebuildRequested.wait(lock, [this] { return quitting || rebuildPending; });
+		if (quitting)
+			return;
+		rebuildPending = false;
+
+		lock.unlock();
+		Build(rebuildBounds, rebuildOrder, rebuildNodes);
+		lock.lock();
+
+		rebuildDone = true;
+		rebuildFinished.notify_all();
+	}
+}
+
+// --------------------------------------------------------
+// Items came and went during the build, so each is sorted
+// out against the new tree: pending items it holds are now
+// indexed, removed ones it holds are stale, and any item
+// re-added into the old tree it doesn't hold goes pending.
+// Bounds moved on as well, so the new tree is refit at once.
+// --------------------------------------------------------
+void BoundingVolumeHierarchy::SwapInRebuild()
+{
+	for (size_t i = 0; i < order.size(); i++)
+		itemLeaves[order[i]] = None;
+
+	nodes.swap(rebuildNodes);
+	order.swap(rebuildOrder);
+	orderBounds.resize(order.size());
+	parents.assign(nodes.size(), None);
+	leafDirty.assign(nodes.size(), 0);
+	dirtyLeaves.clear();
+
+	for (unsigned int node = 0; node < nodes.size(); node++)
+	{
+		const BvhNode& n = nodes[node];
+		if (n.count == 0)
+		{
+			parents[node + 1] = node;
+			parents[n.first] = node;
+			continue;
+		}
+		for (unsigned int i = n.first; i < n.first + n.count; i++)
+			itemLeaves[order[i]] = node;
+	}
+
+	// rebuildOrder is the old tree's order now
+	for (size_t i = 0; i < rebuildOrder.size(); i++)
+	{
+		unsigned int item = rebuildOrder[i];
+		if (itemStates[item] == ItemIndexed && itemLeaves[item] == None)
+			AddPending(item);
+	}
+
+	staleCount = 0;
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		unsigned int item = order[i];
+		if (itemStates[item] == ItemPending)
+		{
+			RemovePending(item);
+			itemStates[item] = ItemIndexed;
+		}
+
+		itemSlots[item] = i;
+		if (itemStates[item] == ItemAbsent)
+		{
+			orderBounds[i] = EmptyBounds();
+			staleCount++;
+		}
+		else
+			orderBounds[i] = itemBounds[item];
+	}
+
+	RefitAll();
+	buildCost = GetCost();
+	rebuilds++;
+}
+
+// --------------------------------------------------------
+// Top-down binned SAH build.  Each node's items are binned
+// by centroid along every axis, and the split between bins
+// with the lowest area * count over both sides wins.  Nodes
+// are split until they hold MaxLeafItems or fewer, halving
+// by position where centroids coincide.  A stack of pending
+// ranges lays the nodes out depth first: the left range is
+// popped right after its parent, and the right child's
+// index is patched into the parent once it's reached.
+// --------------------------------------------------------
+void BoundingVolumeHierarchy::Build(const std::vector<BvhBounds>& bounds, std::vector<unsigned int>& order, std::vector<BvhNode>& nodes)
+{
+	struct Range
+	{
+		unsigned int first;
+		unsigned int count;
+		unsigned int parent;	// Node to point at this one as its right child, or None
+	};
+
+	struct Bin
+	{
+		float min[3];
+		float max[3];
+		unsigned int count;
+	};
+
+	nodes.clear();
+	if (order.empty())
+		return;
+	nodes.reserve(order.size() / 2 + 1);
+
+	std::vector<Range> ranges;
+	Range root = { 0, (unsigned int)order.size(), None };
+	ranges.push_back(root);
+	while (!ranges.empty())
+	{
+		Range range = ranges.back();
+		ranges.pop_back();
+
+		unsigned int index = (unsigned int)nodes.size();
+		if (range.parent != None)
+			nodes[range.parent].first = index;
+
+		// Bounds of the items, and of their centroids (doubled, to save a multiply)
+		BvhBounds box = EmptyBounds();
+		BvhBounds centroids = EmptyBounds();
+		for (unsigned int i = range.first; i < range.first + range.count; i++)
+		{
+			const BvhBounds& item = bounds[order[i]];
+			GrowBounds(box.min, box.max, item.min, item.max);
+			for (int a = 0; a < 3; a++)
+			{
+				float centroid = item.min[a] + item.max[a];
+				centroids.min[a] = std::min(centroids.min[a], centroid);
+				centroids.max[a] = std::max(centroids.max[a], centroid);
+			}
+		}
+
+		BvhNode node;
+		for (int a = 0; a < 3; a++)
+		{
+			node.min[a] = box.min[a];
+			node.max[a] = box.max[a];
+		}
+		node.first = range.first;
+		node.count = range.count;
+		nodes.push_back(node);
+		if (range.count <= MaxLeafItems)
+			continue;
+
+		float bestCost = FLT_MAX;
+		int bestAxis = -1;
+		unsigned int bestSplit = 0;
+		for (int a = 0; a < 3; a++)
+		{
+			float extent = centroids.max[a] - centroids.min[a];
+			if (extent <= 0)
+				continue;
+			float scale = SplitBins / extent;
+
+			Bin bins[SplitBins];
+			for (unsigned int b = 0; b < SplitBins; b++)
+			{
+				BvhBounds empty = EmptyBounds();
+				std::copy(empty.min, empty.min + 3, bins[b].min);
+				std::copy(empty.max, empty.max + 3, bins[b].max);
+				bins[b].count = 0;
+			}
+			for (unsigned int i = range.first; i < range.first + range.count; i++)
+			{
+				const BvhBounds& item = bounds[order[i]];
+				unsigned int b = std::min((unsigned int)((item.min[a] + item.max[a] - centroids.min[a]) * scale), SplitBins - 1);
+				GrowBounds(bins[b].min, bins[b].max, item.min, item.max);
+				bins[b].count++;
+			}
+
+			// Right side of each split, swept from the end; then the left side and the cost
+			float rightArea[SplitBins];
+			unsigned int rightCount[SplitBins];
+			BvhBounds side = EmptyBounds();
+			unsigned int count = 0;
+			for (unsigned int b = SplitBins - 1; b > 0; b--)
+			{
+				GrowBounds(side.min, side.max, bins[b].min, bins[b].max);
+				count += bins[b].count;
+				rightArea[b] = GetArea(side.min, side.max);
+				rightCount[b] = count;
+			}
+
+			side = EmptyBounds();
+			count = 0;
+			for (unsigned int b = 0; b < SplitBins - 1; b++)
+			{
+				GrowBounds(side.min, side.max, bins[b].min, bins[b].max);
+				count += bins[b].count;
+				if (count == 0 || rightCount[b + 1] == 0)
+					continue;
+
+				float cost = GetArea(side.min, side.max) * count + rightArea[b + 1] * rightCount[b + 1];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = a;
+					bestSplit = b + 1;
+				}
+			}
+		}
+
+		unsigned int middle = range.first + range.count / 2;
+		if (bestAxis >= 0)
+		{
+			int a = bestAxis;
+			float minimum = centroids.min[a];
+			float scale = SplitBins / (centroids.max[a] - minimum);
+			middle = (unsigned int)(std::partition(order.begin() + range.first, order.begin() + range.first + range.count,
+				[&](unsigned int item)
+				{
+					const BvhBounds& box = bounds[item];
+					return std::min((unsigned int)((box.min[a] + box.max[a] - minimum) * scale), SplitBins - 1) < bestSplit;
+				}) - order.begin());
+			if (middle == range.first || middle == range.first + range.count)
+				middle = range.first + range.count / 2;
+		}
+
+		nodes[index].count = 0;
+		Range right = { middle, range.first + range.count - middle, index };
+		Range left = { range.first, middle - range.first, None };
+		ranges.push_back(right);
+		ranges.push_back(left);
+	}
+}
+
+void BoundingVolumeHierarchy::MarkDirty(unsigned int item)
+{
+	unsigned int leaf = itemLeaves[item];
+	if (leafDirty[leaf])
+		return;
+	leafDirty[leaf] = 1;
+	dirtyLeaves.push_back(leaf);
+}
+
+// --------------------------------------------------------
+// Refits return whether the node's box changed, keeping the
+// cost sum up to date as they go
+// --------------------------------------------------------
+bool BoundingVolumeHierarchy::RefitLeaf(unsigned int node)
+{
+	BvhNode& n = nodes[node];
+	BvhBounds box = EmptyBounds();
+	for (unsigned int i = n.first; i < n.first + n.count; i++)
+		GrowBounds(box.min, box.max, orderBounds[i].min, orderBounds[i].max);
+
+	nodesRefit++;
+	if (SameBounds(n.min, n.max, box.min, box.max))
+		return false;
+
+	costSum += (double)(GetArea(box.min, box.max) - GetArea(n.min, n.max)) * n.count;
+	std::copy(box.min, box.min + 3, n.min);
+	std::copy(box.max, box.max + 3, n.max);
+	return true;
+}
+
+bool BoundingVolumeHierarchy::RefitInner(unsigned int node)
+{
+	BvhNode& n = nodes[node];
+	const BvhNode& left = nodes[node + 1];
+	const BvhNode& right = nodes[n.first];
+	float min[3];
+	float max[3];
+	for (int a = 0; a < 3; a++)
+	{
+		min[a] = std::min(left.min[a], right.min[a]);
+		max[a] = std::max(left.max[a], right.max[a]);
+	}
+
+	nodesRefit++;
+	if (SameBounds(n.min, n.max, min, max))
+		return false;
+
+	costSum += (double)(GetArea(min, max) - GetArea(n.min, n.max));
+	std::copy(min, min + 3, n.min);
+	std::copy(max, max + 3, n.max);
+	return true;
+}
+
+// --------------------------------------------------------
+// Every box is recomputed, so there's nothing to compare -
+// the cost is just summed afresh as the sweep goes
+// --------------------------------------------------------
+void BoundingVolumeHierarchy::RefitAll()
+{
+	costSum = 0;
+	for (size_t node = nodes.size(); node-- > 0;)
+	{
+		BvhNode& n = nodes[node];
+		BvhBounds box = EmptyBounds();
+		if (n.count == 0)
+		{
+			const BvhNode& left = nodes[node + 1];
+			const BvhNode& right = nodes[n.first];
+			GrowBounds(box.min, box.max, left.min, left.max);
+			GrowBounds(box.min, box.max, right.min, right.max);
+		}
+		else
+		{
+			for (unsigned int i = n.first; i < n.first + n.count; i++)
+				GrowBounds(box.min, box.max, orderBounds[i].min, orderBounds[i].max);
+		}
+
+		std::copy(box.min, box.min + 3, n.min);
+		std::copy(box.max, box.max + 3, n.max);
+		costSum += (double)GetArea(box.min, box.max) * (n.count == 0 ? 1 : n.count);
+	}
+	nodesRefit = (unsigned int)nodes.size();
+}
+
+// The expected cost of a query, relative to testing the root box once
+float BoundingVolumeHierarchy::GetCost()
+{
+	if (nodes.empty())
+		return 0;
+	float rootArea = GetArea(nodes[0].min, nodes[0].max);
+	if (rootArea <= 0)
+		return 0;
+	return (float)(costSum / rootArea);
+}
+
+void BoundingVolumeHierarchy::AddPending(unsigned int item)
+{
+	itemStates[item] = ItemPending;
+	itemSlots[item] = (unsigned int)pending.size();
+	pending.push_back(item);
+}
+
+void BoundingVolumeHierarchy::RemovePending(unsigned int item)
+{
+	unsigned int slot = itemSlots[item];
+	unsigned int last = pending.back();
+	pending[slot] = last;
+	itemSlots[last] = slot;
+	pending.pop_back();
+	itemSlots[item] = None;
+}
+
+// --------------------------------------------------------
+// A subtree's items are one run of the order, from its
+// leftmost leaf to its rightmost
+// --------------------------------------------------------
+void BoundingVolumeHierarchy::AddSubtree(unsigned int node, std::vector<unsigned int>& items)
+{
+	unsigned int leftmost = node;
+	while (nodes[leftmost].count == 0)
+		leftmost++;
+	unsigned int rightmost = node;
+	while (nodes[rightmost].count == 0)
+		rightmost = nodes[rightmost].first;
+
+	unsigned int end = nodes[rightmost].first + nodes[rightmost].count;
+	for (unsigned int i = nodes[leftmost].first; i < end; i++)
+	{
+		// Skips removed items
+		if (orderBounds[i].min[0] <= orderBounds[i].max[0])
+			items.push_back(order[i]);
+	}
+}
+
+// --------------------------------------------------------
+// Subtrees entirely inside the frustum are added without
+// testing anything below them
+// --------------------------------------------------------
+unsigned int BoundingVolumeHierarchy::QueryFrustum(Frustum frustum, std::vector<unsigned int>& items)
+{
+	size_t start = items.size();
+	XMFLOAT4 planes[6];
+	for (int i = 0; i < 6; i++)
+		planes[i] = frustum.GetPlane(i);
+
+	stack.clear();
+	if (!nodes.empty())
+	{
+		stack.push_back(0);
+		stack.push_back(0x3F);
+	}
+	while (!stack.empty())
+	{
+		unsigned int mask = stack.back();
+		stack.pop_back();
+		unsigned int node = stack.back();
+		stack.pop_back();
+
+		const BvhNode& n = nodes[node];
+		if (!BoundsInFrustum(n.min, n.max, planes, mask))
+			continue;
+		if (mask == 0)
+		{
+			AddSubtree(node, items);
+			continue;
+		}
+
+		if (n.count == 0)
+		{
+			stack.push_back(n.first);
+			stack.push_back(mask);
+			stack.push_back(node + 1);
+			stack.push_back(mask);
+			continue;
+		}
+		for (unsigned int i = n.first; i < n.first + n.count; i++)
+		{
+			unsigned int itemMask = mask;
+			if (BoundsInFrustum(orderBounds[i].min, orderBounds[i].max, planes, itemMask))
+				items.push_back(order[i]);
+		}
+	}
+
+	for (size_t i = 0; i < pending.size(); i++)
+	{
+		unsigned int mask = 0x3F;
+		const BvhBounds& bounds = itemBounds[pending[i]];
+		if (BoundsInFrustum(bounds.min, bounds.max, planes, mask))
+			items.push_back(pending[i]);
+	}
+	return (unsigned int)(items.size() - start);
+}
+
+unsigned int BoundingVolumeHierarchy::QuerySphere(const float center[3], float radius, std::vector<unsigned int>& items)
+{
+	size_t start = items.size();
+	float radiusSquared = radius * radius;
+
+	stack.clear();
+	if (!nodes.empty())
+		stack.push_back(0);
+	while (!stack.empty())
+	{
+		unsigned int node = stack.back();
+		stack.pop_back();
+
+		const BvhNode& n = nodes[node];
+		if (!BoundsTouchSphere(n.min, n.max, center, radiusSquared))
+			continue;
+
+		if (n.count == 0)
+		{
+			stack.push_back(n.first);
+			stack.push_back(node + 1);
+			continue;
+		}
+		for (unsigned int i = n.first; i < n.first + n.count; i++)
+		{
+			if (BoundsTouchSphere(orderBounds[i].min, orderBounds[i].max, center, radiusSquared))
+				items.push_back(order[i]);
+		}
+	}
+
+	for (size_t i = 0; i < pending.size(); i++)
+	{
+		const BvhBounds& bounds = itemBounds[pending[i]];
+		if (BoundsTouchSphere(bounds.min, bounds.max, center, radiusSquared))
+			items.push_back(pending[i]);
+	}
+	return (unsigned int)(items.size() - start);
+}
+
+unsigned int BoundingVolumeHierarchy::QueryBounds(const BvhBounds& bounds, std::vector<unsigned int>& items)
+{
+	size_t start = items.size();
+
+	stack.clear();
+	if (!nodes.empty())
+		stack.push_back(0);
+	while (!stack.empty())
+	{
+		unsigned int node = stack.back();
+		stack.pop_back();
+
+		const BvhNode& n = nodes[node];
+		if (!BoundsOverlap(n.min, n.max, bounds))
+			continue;
+
+		if (n.count == 0)
+		{
+			stack.push_back(n.first);
+			stack.push_back(node + 1);
+			continue;
+		}
+		for (unsigned int i = n.first; i < n.first + n.count; i++)
+		{
+			if (BoundsOverlap(orderBounds[i].min, orderBounds[i].max, bounds))
+				items.push_back(order[i]);
+		}
+	}
+
+	for (size_t i = 0; i < pending.size(); i++)
+	{
+		const BvhBounds& other = itemBounds[pending[i]];
+		if (BoundsOverlap(other.min, other.max, bounds))
+			items.push_back(pending[i]);
+	}
+	return (unsigned int)(items.size() - start);
+}
+
+// --------------------------------------------------------
+// Visits the nearer child first, so the first hits found are
+// usually the nearest and cut the ray short for the rest -
+// anything entered beyond the nearest hit so far is skipped
+// --------------------------------------------------------
+bool BoundingVolumeHierarchy::Raycast(const float origin[3], const float direction[3], float maxT, unsigned int& item, float& t)
+{
+	float inverseDirection[3];
+	for (int a = 0; a < 3; a++)
+		inverseDirection[a] = direction[a] != 0 ? 1.0f / direction[a] : 0;
+
+	bool hit = false;
+	float nearest = maxT;
+	float entry;
+
+	rayStack.clear();
+	if (!nodes.empty() && RayEntersBounds(nodes[0].min, nodes[0].max, origin, direction, inverseDirection, nearest, entry))
+	{
+		RayEntry root = { 0, entry };
+		rayStack.push_back(root);
+	}
+	while (!rayStack.empty())
+	{
+		RayEntry current = rayStack.back();
+		rayStack.pop_back();
+		if (current.t > nearest)
+			continue;
+
+		const BvhNode& n = nodes[current.node];
+		if (n.count != 0)
+		{
+			for (unsigned int i = n.first; i < n.first + n.count; i++)
+			{
+				if (RayEntersBounds(orderBounds[i].min, orderBounds[i].max, origin, direction, inverseDirection, nearest, entry))
+				{
+					hit = true;
+					nearest = entry;
+					item = order[i];
+				}
+			}
+			continue;
+		}
+
+		RayEntry closer = { current.node + 1, 0 };
+		RayEntry further = { n.first, 0 };
+		bool hitCloser = RayEntersBounds(nodes[closer.node].min, nodes[closer.node].max, origin, direction, inverseDirection, nearest, closer.t);
+		bool hitFurther = RayEntersBounds(nodes[further.node].min, nodes[further.node].max, origin, direction, inverseDirection, nearest, further.t);
+		if (hitCloser && hitFurther && further.t < closer.t)
+			std::swap(closer, further);
+
+		// Last pushed, first visited
+		if (hitFurther)
+			rayStack.push_back(further);
+		if (hitCloser)
+			rayStack.push_back(closer);
+	}
+
+	for (size_t i = 0; i < pending.size(); i++)
+	{
+		const BvhBounds& bounds = itemBounds[pending[i]];
+		if (RayEntersBounds(bounds.min, bounds.max, origin, direction, inverseDirection, nearest, entry))
+		{
+			hit = true;
+			nearest = entry;
+			item = pending[i];
+		}
+	}
+
+	if (hit)
+		t = nearest;
+	return hit;
+}
+
+BvhStats BoundingVolumeHierarchy::GetStats()
+{
+	BvhStats stats;
+	stats.itemCount = itemCount;
+	stats.pendingCount = (unsigned int)pending.size();
+	stats.nodeCount = (unsigned int)nodes.size();
+	stats.nodesRefit = nodesRefit;
+	stats.cost = GetCost();
+	stats.buildCost = buildCost;
+	stats.rebuilds = rebuilds;
+	stats.rebuilding = rebuilding;
+	return stats;
+}
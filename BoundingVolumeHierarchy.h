@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Frustum.h"
+
+// An axis-aligned box (empty when min > max)
+struct BvhBounds
+{
+	float min[3];
+	float max[3];
+};
+
+// 32 bytes, so two share a cache line.  Nodes are stored depth
+// first: an inner node's left child is the next node, and every
+// child comes after its parent
+struct BvhNode
+{
+	float min[3];
+	unsigned int first;		// Leaf: its first item in the item order; inner: the right child's index
+	float max[3];
+	unsigned int count;		// Leaf: how many items; inner: 0
+};
+
+struct BvhStats
+{
+	unsigned int itemCount;		// In the tree or pending
+	unsigned int pendingCount;	// Added since the last build, so searched one by one
+	unsigned int nodeCount;
+	unsigned int nodesRefit;	// By the last Update()
+	float cost;					// Surface area heuristic cost of the tree now...
+	float buildCost;			// ... and when it was built
+	unsigned int rebuilds;		// Finished since the hierarchy was made
+	bool rebuilding;
+};
+
+// --------------------------------------------------------
+// A bounding volume hierarchy over items with boxes - entity
+// world bounds, say - for frustum, ray, sphere and box queries
+// that only visit the parts of the scene they can touch.
+//
+// Trees are built top-down with the binned surface area
+// heuristic, into one flat node array.  As items move,
+// Update() refits the boxes above them (walking up from each
+// changed leaf, or sweeping the whole array back to front
+// when many have), which keeps queries right but lets
+// the tree loosen.  Once its cost has grown by RebuildRatio,
+// or items have come or gone, Update() snapshots the bounds
+// and hands them to a worker thread (started by the first
+// rebuild and kept for the rest) to build a fresh tree,
+// swapped in on a later Update() - meanwhile the old tree is
+// refit as usual, and new items are searched one by one.
+//
+// Items are small integer ids the caller picks (entity
+// indices, here), and the arrays behind them are sized by
+// the largest.  Queries match item bounds only; callers test
+// anything finer themselves.  Use from one thread - the
+// rebuild thread only touches its own copies.
+// --------------------------------------------------------
+class BoundingVolumeHierarchy
+{
+public:
+	static const unsigned int MaxLeafItems = 4;
+	static const float RebuildRatio;
+
+	BoundingVolumeHierarchy();
+	~BoundingVolumeHierarchy();
+	BoundingVolumeHierarchy(const BoundingVolumeHierarchy&) = delete;
+	BoundingVolumeHierarchy& operator=(const BoundingVolumeHierarchy&) = delete;
+
+	//adds an item, or moves one already in
+	void SetBounds(unsigned int item, const BvhBounds& bounds);
+	void Remove(unsigned int item);
+
+	//once per frame, after moving things: refits, swaps in a finished rebuild and starts
+	//another if needed.  The first tree (or one after everything was removed) is built here
+	void Update();
+	//waits for a running rebuild and swaps it in
+	void FinishRebuild();
+
+	//queries append the ids of items whose bounds touch the shape, and return how many
+	unsigned int QueryFrustum(Frustum frustum, std::vector<unsigned int>& items);
+	unsigned int QuerySphere(const float center[3], float radius, std::vector<unsigned int>& items);
+	unsigned int QueryBounds(const BvhBounds& bounds, std::vector<unsigned int>& items);
+	//the nearest item whose bounds origin + t * direction enters for some 0 <= t <= maxT, with that t
+	bool Raycast(const float origin[3], const float direction[3], float maxT, unsigned int& item, float& t);
+
+	BvhStats GetStats();
+
+private:
+	enum ItemState : unsigned char
+	{
+		ItemAbsent,		// Never added, or removed (may still sit in a leaf, with an empty box)
+		ItemPending,	// Added since the tree was built - on the pending list
+		ItemIndexed		// In a leaf of the tree
+	};
+
+	struct RayEntry
+	{
+		unsigned int node;
+		float t;
+	};
+
+	static const unsigned int None = 0xFFFFFFFF;
+
+	//per item id
+	std::vector<BvhBounds> itemBounds;
+	std::vector<unsigned char> itemStates;
+	std::vector<unsigned int> itemLeaves;	// Leaf holding the item, or None
+	std::vector<unsigned int> itemSlots;	// Where the item is in order (if in a leaf) or pending
+
+	//the tree.  Leaves point at runs of order, and orderBounds holds the same items'
+	//boxes in the same order, so a leaf's boxes are read contiguously
+	std::vector<BvhNode> nodes;
+	std::vector<unsigned int> order;
+	std::vector<BvhBounds> orderBounds;
+	std::vector<unsigned int> parents;
+	std::vector<unsigned char> leafDirty;
+	std::vector<unsigned int> dirtyLeaves;
+	std::vector<unsigned int> pending;
+	unsigned int itemCount;
+	unsigned int staleCount;	// Removed items still in leaves
+	double costSum;				// Sum over the nodes of area * (1, or a leaf's item count)
+	float buildCost;
+	unsigned int nodesRefit;
+	unsigned int rebuilds;
+
+	//query scratch, kept around so it doesn't reallocate
+	std::vector<unsigned int> stack;
+	std::vector<RayEntry> rayStack;
+
+	//the background build and its own copies of everything it reads and writes.  The
+	//worker sleeps on rebuildRequested between builds
+	std::thread rebuildThread;
+	std::mutex rebuildMutex;
+	std::condition_variable rebuildRequested;
+	std::condition_variable rebuildFinished;
+	bool rebuildPending;		// Requested, not yet picked up by the worker
+	bool quitting;
+	std::atomic<bool> rebuildDone;
+	bool rebuilding;
+	std::vector<BvhBounds> rebuildBounds;
+	std::vector<unsigned int> rebuildOrder;
+	std::vector<BvhNode> rebuildNodes;
+
+	static void Build(const std::vector<BvhBounds>& bounds, std::vector<unsigned int>& order, std::vector<BvhNode>& nodes);
+	void StartRebuild(bool background);
+	void RebuildLoop();
+	void SwapInRebuild();
+	void MarkDirty(unsigned int item);
+	bool RefitLeaf(unsigned int node);
+	bool RefitInner(unsigned int node);
+	void RefitAll();
+	float GetCost();
+	void AddPending(unsigned int item);
+	void RemovePending(unsigned int item);
+	void AddSubtree(unsigned int node, std::vector<unsigned int>& items);
+};
@@ -1,10 +1,26 @@
 #pragma once
 #include <DirectXMath.h>
 
+// Per-frame camera data (register b0), uploaded and bound once per
+// frame and shared by every vertex shader
+// - view * projection is multiplied on the CPU, so shaders don't
+//   have to rebuild it per vertex
+struct PerFrameVertexShaderData
+{
+	DirectX::XMFLOAT4X4 viewProjection;
+};
+
+// Per-object data (register b1), re-uploaded for each non-instanced draw
 struct VertexShaderExternalData
 {
 	DirectX::XMFLOAT4 colorTint;
 	DirectX::XMFLOAT4X4 worldMatrix;
-	DirectX::XMFLOAT4X4 view;
-	DirectX::XMFLOAT4X4 projection;
+};
+
+// One element of the per-instance vertex buffer (input slot 1)
+// - Must match the WORLD0-3 and TINT inputs of InstancedVertexShader.hlsl
+struct InstanceData
+{
+	DirectX::XMFLOAT4X4 worldMatrix;
+	DirectX::XMFLOAT4 colorTint;
 };
\ No newline at end of file
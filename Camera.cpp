@@ -39,9 +39,11 @@ void Camera::Update(float dt)
 void Camera::UpdateViewMatrix()
 {
     DirectX::XMFLOAT3 pos = transform.GetPosition();
-    DirectX::XMVECTOR forward = DirectX::XMLoadFloat3(&transform.forward);
+    DirectX::XMFLOAT3 forwardDir = transform.GetForward();
+    DirectX::XMFLOAT3 upDir = transform.GetUp();
+    DirectX::XMVECTOR forward = DirectX::XMLoadFloat3(&forwardDir);
 
-    DirectX::XMMATRIX view = DirectX::XMMatrixLookToLH(DirectX::XMLoadFloat3(&pos),forward, DirectX::XMLoadFloat3(&transform.up));
+    DirectX::XMMATRIX view = DirectX::XMMatrixLookToLH(DirectX::XMLoadFloat3(&pos),forward, DirectX::XMLoadFloat3(&upDir));
     DirectX::XMStoreFloat4x4(&viewMatrix, view);
 }
 
@@ -69,3 +71,11 @@ DirectX::XMFLOAT4X4 Camera::GetProjectionMatrix()
 {
     return projectionMatrix;
 }
+
+Frustum Camera::GetFrustum()
+{
+    DirectX::XMFLOAT4X4 viewProjection;
+    DirectX::XMStoreFloat4x4(&viewProjection, DirectX::XMMatrixMultiply(
+        DirectX::XMLoadFloat4x4(&viewMatrix), DirectX::XMLoadFloat4x4(&projectionMatrix)));
+    return Frustum(viewProjection);
+}
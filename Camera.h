@@ -1,6 +1,7 @@
 #pragma once
 #include "Transform.h"
 #include "Input.h"
+#include "Frustum.h"
 #include <DirectXMath.h>
 class Camera
 {
@@ -15,6 +16,7 @@ public:
 	Transform* GetTransform();
 	DirectX::XMFLOAT4X4 GetViewMatrix();
 	DirectX::XMFLOAT4X4 GetProjectionMatrix();
+	Frustum GetFrustum();
 
 private:
 	DirectX::XMFLOAT4X4 viewMatrix;
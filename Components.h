@@ -0,0 +1,57 @@
+#pragma once
+#include <DirectXMath.h>
+#include "TransformSystem.h"
+
+class Mesh;
+
+// --------------------------------------------------------
+// Components for entities in an EntityStore
+// --------------------------------------------------------
+
+// Where an entity is: a handle into a TransformSystem, which
+// keeps every entity's position, rotation, scale and world
+// matrix in its own arrays and rebuilds them in batches.  The
+// transform is made with the component and destroyed with it
+// (the system must outlive the store), so it can't be copied -
+// moves hand the handle over
+struct TransformComponent
+{
+	TransformSystem* system;
+	TransformSystem::Handle handle;
+
+	TransformComponent(TransformSystem* system)
+	{
+		this->system = system;
+		this->handle = system->Create();
+	}
+
+	TransformComponent(TransformComponent&& other)
+	{
+		system = other.system;
+		handle = other.handle;
+		other.handle = TransformSystem::InvalidHandle;
+	}
+
+	~TransformComponent()
+	{
+		if (handle != TransformSystem::InvalidHandle)
+			system->Destroy(handle);
+	}
+
+	TransformComponent(const TransformComponent&) = delete;
+	TransformComponent& operator=(const TransformComponent&) = delete;
+};
+
+// The mesh an entity draws.  A plain pointer, so iterating
+// doesn't touch reference counts - the meshes are owned
+// elsewhere (by Game) and must outlive the entities
+struct MeshComponent
+{
+	Mesh* mesh;
+};
+
+// Multiplied into the mesh's vertex colors
+struct TintComponent
+{
+	DirectX::XMFLOAT4 color;
+};
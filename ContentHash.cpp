@@ -0,0 +1,151 @@
+#include "ContentHash.h"
+#include <cstring>
+
+static const unsigned long long Prime1 = 11400714785074694791ull;
+static const unsigned long long Prime2 = 14029467366897019727ull;
+static const unsigned long long Prime3 = 1609587929392839161ull;
+static const unsigned long long Prime4 = 9650029242287828579ull;
+static const unsigned long long Prime5 = 2870177450012600261ull;
+
+static unsigned long long RotateLeft(unsigned long long value, int bits)
+{
+	return (value << bits) | (value >> (64 - bits));
+}
+
+// Little-endian loads that don't care about alignment
+static unsigned long long Read64(const unsigned char* bytes)
+{
+	unsigned long long value;
+	memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+static unsigned int Read32(const unsigned char* bytes)
+{
+	unsigned int value;
+	memcpy(&value, bytes, sizeof(value));
+	return value;
+}
+
+static unsigned long long Round(unsigned long long lane, unsigned long long input)
+{
+	lane += input * Prime2;
+	lane = RotateLeft(lane, 31);
+	return lane * Prime1;
+}
+
+static unsigned long long MergeRound(unsigned long long hash, unsigned long long lane)
+{
+	hash ^= Round(0, lane);
+	return hash * Prime1 + Prime4;
+}
+
+// Mixes in the last (< 32) bytes and scrambles the result
+static unsigned long long Finalize(unsigned long long hash, const unsigned char* bytes, size_t size)
+{
+	while (size >= 8)
+	{
+		hash ^= Round(0, Read64(bytes));
+		hash = RotateLeft(hash, 27) * Prime1 + Prime4;
+		bytes += 8;
+		size -= 8;
+	}
+	if (size >= 4)
+	{
+		hash ^= Read32(bytes) * Prime1;
+		hash = RotateLeft(hash, 23) * Prime2 + Prime3;
+		bytes += 4;
+		size -= 4;
+	}
+	while (size > 0)
+	{
+		hash ^= *bytes * Prime5;
+		hash = RotateLeft(hash, 11) * Prime1;
+		bytes++;
+		size--;
+	}
+
+	hash ^= hash >> 33;
+	hash *= Prime2;
+	hash ^= hash >> 29;
+	hash *= Prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+unsigned long long HashContent(const void* data, size_t size, unsigned long long seed)
+{
+	ContentHasher hasher(seed);
+	hasher.Add(data, size);
+	return hasher.Finish();
+}
+
+ContentHasher::ContentHasher(unsigned long long seed)
+{
+	this->seed = seed;
+	this->lanes[0] = seed + Prime1 + Prime2;
+	this->lanes[1] = seed + Prime2;
+	this->lanes[2] = seed;
+	this->lanes[3] = seed - Prime1;
+	this->buffered = 0;
+	this->totalSize = 0;
+}
+
+// --------------------------------------------------------
+// Four independent lanes each take 8 bytes of every 32-byte
+// stripe, so the multiplies overlap in the pipeline
+// --------------------------------------------------------
+void ContentHasher::Add(const void* data, size_t size)
+{
+	if (size == 0)
+		return;
+	const unsigned char* bytes = (const unsigned char*)data;
+	totalSize += size;
+
+	// Top up a partial stripe left from last time
+	if (buffered > 0)
+	{
+		size_t take = 32 - buffered;
+		if (take > size)
+			take = size;
+		memcpy(buffer + buffered, bytes, take);
+		buffered += take;
+		bytes += take;
+		size -= take;
+		if (buffered < 32)
+			return;
+
+		for (int lane = 0; lane < 4; lane++)
+			lanes[lane] = Round(lanes[lane], Read64(buffer + lane * 8));
+		buffered = 0;
+	}
+
+	while (size >= 32)
+	{
+		lanes[0] = Round(lanes[0], Read64(bytes));
+		lanes[1] = Round(lanes[1], Read64(bytes + 8));
+		lanes[2] = Round(lanes[2], Read64(bytes + 16));
+		lanes[3] = Round(lanes[3], Read64(bytes + 24));
+		bytes += 32;
+		size -= 32;
+	}
+
+	memcpy(buffer, bytes, size);
+	buffered = size;
+}
+
+unsigned long long ContentHasher::Finish()
+{
+	unsigned long long hash;
+	if (totalSize >= 32)
+	{
+		hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+		for (int lane = 0; lane < 4; lane++)
+			hash = MergeRound(hash, lanes[lane]);
+	}
+	else
+		hash = seed + Prime5;
+
+	hash += totalSize;
+	return Finalize(hash, buffer, buffered);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+// --------------------------------------------------------
+// Fast non-cryptographic 64-bit hash (the XXH64 algorithm)
+// for spotting identical content - asset files, mesh data.
+// Stable across runs and platforms, so hashes can be saved.
+// --------------------------------------------------------
+unsigned long long HashContent(const void* data, size_t size, unsigned long long seed = 0);
+
+// Hashes data that arrives in pieces; gives the same result as
+// HashContent() over all the pieces joined together
+class ContentHasher
+{
+public:
+	ContentHasher(unsigned long long seed = 0);
+
+	void Add(const void* data, size_t size);
+	unsigned long long Finish();
+
+private:
+	unsigned long long lanes[4];
+	unsigned char buffer[32];
+	size_t buffered;
+	unsigned long long totalSize;
+	unsigned long long seed;
+};
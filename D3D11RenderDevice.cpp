@@ -0,0 +1,437 @@
+#include "D3D11RenderDevice.h"
+
+// We can include the correct library files here
+// instead of in Visual Studio settings if we want
+#pragma comment(lib, "d3d11.lib")
+
+// Most buffers bound in one call (D3D11 allows more, we never need them)
+static const unsigned int MaxBindSlots = 8;
+
+D3D11RenderDevice::D3D11RenderDevice()
+{
+	this->dxFeatureLevel = D3D_FEATURE_LEVEL_11_0;
+	this->width = 0;
+	this->height = 0;
+}
+
+// --------------------------------------------------------
+// Initializes DirectX.  With a window this creates a swap
+// chain for it; without one there's just a device that
+// renders into an offscreen back buffer (see Resize())
+// --------------------------------------------------------
+bool D3D11RenderDevice::Initialize(void* windowHandle, unsigned int width, unsigned int height)
+{
+	this->width = width;
+	this->height = height;
+
+	// This will hold options for DirectX initialization
+	unsigned int deviceFlags = 0;
+
+#if defined(DEBUG) || defined(_DEBUG)
+	// If we're in debug mode in visual studio, we also
+	// want to make a "Debug DirectX Device" to see some
+	// errors and warnings in Visual Studio's output window
+	// when things go wrong!
+	deviceFlags |= D3D11_CREATE_DEVICE_DEBUG;
+#endif
+
+	// Result variable for below function calls
+	HRESULT hr = S_OK;
+
+	if (windowHandle == 0)
+	{
+		hr = D3D11CreateDevice(
+			0, D3D_DRIVER_TYPE_HARDWARE, 0, deviceFlags, 0, 0, D3D11_SDK_VERSION,
+			device.GetAddressOf(), &dxFeatureLevel, context.GetAddressOf());
+
+		// No GPU (build servers) - fall back to the WARP software rasterizer
+		if (FAILED(hr))
+			hr = D3D11CreateDevice(
+				0, D3D_DRIVER_TYPE_WARP, 0, deviceFlags, 0, 0, D3D11_SDK_VERSION,
+				device.GetAddressOf(), &dxFeatureLevel, context.GetAddressOf());
+	}
+	else
+	{
+		// Create a description of how our swap
+		// chain should work
+		DXGI_SWAP_CHAIN_DESC swapDesc = {};
+		swapDesc.BufferCount = 2;
+		swapDesc.BufferDesc.Width = width;
+		swapDesc.BufferDesc.Height = height;
+		swapDesc.BufferDesc.RefreshRate.Numerator = 60;
+		swapDesc.BufferDesc.RefreshRate.Denominator = 1;
+		swapDesc.BufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		swapDesc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
+		swapDesc.BufferDesc.Scaling = DXGI_MODE_SCALING_UNSPECIFIED;
+		swapDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+		swapDesc.Flags = 0;
+		swapDesc.OutputWindow = (HWND)windowHandle;
+		swapDesc.SampleDesc.Count = 1;
+		swapDesc.SampleDesc.Quality = 0;
+		swapDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+		swapDesc.Windowed = true;
+
+		// Attempt to initialize DirectX
+		hr = D3D11CreateDeviceAndSwapChain(
+			0,							// Video adapter (physical GPU) to use, or null for default
+			D3D_DRIVER_TYPE_HARDWARE,	// We want to use the hardware (GPU)
+			0,							// Used when doing software rendering
+			deviceFlags,				// Any special options
+			0,							// Optional array of possible verisons we want as fallbacks
+			0,							// The number of fallbacks in the above param
+			D3D11_SDK_VERSION,			// Current version of the SDK
+			&swapDesc,					// Address of swap chain options
+			swapChain.GetAddressOf(),	// Pointer to our Swap Chain pointer
+			device.GetAddressOf(),		// Pointer to our Device pointer
+			&dxFeatureLevel,			// This will hold the actual feature level the app will use
+			context.GetAddressOf());	// Pointer to our Device Context pointer
+	}
+	if (FAILED(hr)) return false;
+
+	// Everything we draw is a triangle list
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	// Back buffer view, depth buffer and viewport
+	Resize(width, height);
+	return true;
+}
+
+// --------------------------------------------------------
+// When the window is resized, the underlying 
+// buffers (textures) must also be resized to match.
+//
+// If we don't do this, the window size and our rendering
+// resolution won't match up.  This can result in odd
+// stretching/skewing.
+// --------------------------------------------------------
+void D3D11RenderDevice::Resize(unsigned int width, unsigned int height)
+{
+	this->width = width;
+	this->height = height;
+
+	// Release the buffers before resizing the swap chain
+	backBufferRTV.Reset();
+	depthStencilView.Reset();
+
+	ID3D11Texture2D* backBufferTexture = 0;
+	if (swapChain)
+	{
+		// Resize the underlying swap chain buffers
+		swapChain->ResizeBuffers(
+			2,
+			width,
+			height,
+			DXGI_FORMAT_R8G8B8A8_UNORM,
+			0);
+
+		// Grab the resized back buffer texture
+		swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&backBufferTexture));
+	}
+	else
+	{
+		// Headless - the "back buffer" is just a texture we render into
+		D3D11_TEXTURE2D_DESC backBufferDesc = {};
+		backBufferDesc.Width				= width;
+		backBufferDesc.Height				= height;
+		backBufferDesc.MipLevels			= 1;
+		backBufferDesc.ArraySize			= 1;
+		backBufferDesc.Format				= DXGI_FORMAT_R8G8B8A8_UNORM;
+		backBufferDesc.Usage				= D3D11_USAGE_DEFAULT;
+		backBufferDesc.BindFlags			= D3D11_BIND_RENDER_TARGET;
+		backBufferDesc.SampleDesc.Count		= 1;
+		device->CreateTexture2D(&backBufferDesc, 0, &backBufferTexture);
+	}
+
+	// Create the render target view for the back buffer
+	// texture, then release our local texture reference
+	if (backBufferTexture != 0)
+	{
+		device->CreateRenderTargetView(
+			backBufferTexture, 
+			0, 
+			backBufferRTV.ReleaseAndGetAddressOf()); // ReleaseAndGetAddressOf() cleans up the old object before giving us the pointer
+		backBufferTexture->Release();
+	}
+
+	// Set up the description of the texture to use for the depth buffer
+	D3D11_TEXTURE2D_DESC depthStencilDesc = {};
+	depthStencilDesc.Width				= width;
+	depthStencilDesc.Height				= height;
+	depthStencilDesc.MipLevels			= 1;
+	depthStencilDesc.ArraySize			= 1;
+	depthStencilDesc.Format				= DXGI_FORMAT_D24_UNORM_S8_UINT;
+	depthStencilDesc.Usage				= D3D11_USAGE_DEFAULT;
+	depthStencilDesc.BindFlags			= D3D11_BIND_DEPTH_STENCIL;
+	depthStencilDesc.CPUAccessFlags		= 0;
+	depthStencilDesc.MiscFlags			= 0;
+	depthStencilDesc.SampleDesc.Count	= 1;
+	depthStencilDesc.SampleDesc.Quality = 0;
+
+	// Create the depth buffer and its view, then 
+	// release our reference to the texture
+	ID3D11Texture2D* depthBufferTexture = 0;
+	device->CreateTexture2D(&depthStencilDesc, 0, &depthBufferTexture);
+	if (depthBufferTexture != 0)
+	{
+		device->CreateDepthStencilView(
+			depthBufferTexture, 
+			0, 
+			depthStencilView.ReleaseAndGetAddressOf());
+		depthBufferTexture->Release();
+	}
+
+	// Bind the views to the pipeline, so rendering properly 
+	// uses their underlying textures
+	context->OMSetRenderTargets(
+		1, 
+		backBufferRTV.GetAddressOf(), // This requires a pointer to a pointer (an array of pointers), so we get the address of the pointer
+		depthStencilView.Get());
+
+	// Lastly, set up a viewport so we render into
+	// to correct portion of the window
+	D3D11_VIEWPORT viewport = {};
+	viewport.TopLeftX = 0;
+	viewport.TopLeftY = 0;
+	viewport.Width = (float)width;
+	viewport.Height = (float)height;
+	viewport.MinDepth = 0.0f;
+	viewport.MaxDepth = 1.0f;
+	context->RSSetViewports(1, &viewport);
+}
+
+// --------------------------------------------------------
+// The version of DirectX actually being used (usually 11)
+// --------------------------------------------------------
+std::string D3D11RenderDevice::GetName()
+{
+	switch (dxFeatureLevel)
+	{
+	case D3D_FEATURE_LEVEL_11_1: return "DX 11.1";
+	case D3D_FEATURE_LEVEL_11_0: return "DX 11.0";
+	case D3D_FEATURE_LEVEL_10_1: return "DX 10.1";
+	case D3D_FEATURE_LEVEL_10_0: return "DX 10.0";
+	case D3D_FEATURE_LEVEL_9_3:  return "DX 9.3";
+	case D3D_FEATURE_LEVEL_9_2:  return "DX 9.2";
+	case D3D_FEATURE_LEVEL_9_1:  return "DX 9.1";
+	default:                     return "DX ???";
+	}
+}
+
+BufferHandle D3D11RenderDevice::CreateBuffer(BufferType type, BufferUsage usage, const void* data, unsigned int size)
+{
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = size;
+	switch (type)
+	{
+	case VertexBufferType:	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER; break;
+	case IndexBufferType:	desc.BindFlags = D3D11_BIND_INDEX_BUFFER; break;
+	case ConstantBufferType:
+		desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		desc.ByteWidth = (size + 15) / 16 * 16; // Must be a multiple of 16
+		break;
+	}
+	if (usage == DynamicUsage)
+	{
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	}
+	else if (usage == DefaultUsage)
+	{
+		desc.Usage = D3D11_USAGE_DEFAULT;
+	}
+	else
+	{
+		desc.Usage = D3D11_USAGE_IMMUTABLE;
+	}
+
+	D3D11_SUBRESOURCE_DATA initialData = {};
+	initialData.pSysMem = data;
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+	if (FAILED(device->CreateBuffer(&desc, data ? &initialData : 0, buffer.GetAddressOf())))
+		return 0;
+
+	// Reuse a released slot if there is one
+	if (!freeBuffers.empty())
+	{
+		BufferHandle handle = freeBuffers.back();
+		freeBuffers.pop_back();
+		buffers[handle - 1] = buffer;
+		return handle;
+	}
+
+	buffers.push_back(buffer);
+	return (BufferHandle)buffers.size();
+}
+
+void D3D11RenderDevice::ReleaseBuffer(BufferHandle buffer)
+{
+	if (buffer == 0 || buffer > buffers.size() || !buffers[buffer - 1])
+		return;
+
+	buffers[buffer - 1].Reset();
+	freeBuffers.push_back(buffer);
+}
+
+ShaderHandle D3D11RenderDevice::CreateVertexShader(const void* byteCode, size_t byteCodeSize)
+{
+	Microsoft::WRL::ComPtr<ID3D11VertexShader> shader;
+	if (FAILED(device->CreateVertexShader(byteCode, byteCodeSize, 0, shader.GetAddressOf())))
+		return 0;
+
+	vertexShaders.push_back(shader);
+	return (ShaderHandle)vertexShaders.size();
+}
+
+ShaderHandle D3D11RenderDevice::CreatePixelShader(const void* byteCode, size_t byteCodeSize)
+{
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> shader;
+	if (FAILED(device->CreatePixelShader(byteCode, byteCodeSize, 0, shader.GetAddressOf())))
+		return 0;
+
+	pixelShaders.push_back(shader);
+	return (ShaderHandle)pixelShaders.size();
+}
+
+// --------------------------------------------------------
+// Translates the device-agnostic layout into D3D11 input
+// elements and verifies it against the vertex shader code
+// --------------------------------------------------------
+InputLayoutHandle D3D11RenderDevice::CreateInputLayout(const VertexElement* elements, unsigned int elementCount,
+	const void* vsByteCode, size_t vsByteCodeSize)
+{
+	std::vector<D3D11_INPUT_ELEMENT_DESC> descs(elementCount);
+	for (unsigned int i = 0; i < elementCount; i++)
+	{
+		D3D11_INPUT_ELEMENT_DESC& desc = descs[i];
+		desc = {};
+		desc.SemanticName = elements[i].semanticName;
+		desc.SemanticIndex = elements[i].semanticIndex;
+		desc.InputSlot = elements[i].inputSlot;
+		desc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+		switch (elements[i].format)
+		{
+		case FormatFloat2: desc.Format = DXGI_FORMAT_R32G32_FLOAT; break;
+		case FormatFloat3: desc.Format = DXGI_FORMAT_R32G32B32_FLOAT; break;
+		case FormatFloat4: desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT; break;
+		case FormatUnorm8x4: desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM; break;
+		case FormatHalf4: desc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT; break;
+		}
+		if (elements[i].perInstance)
+		{
+			desc.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+			desc.InstanceDataStepRate = 1;
+		}
+	}
+
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> layout;
+	if (FAILED(device->CreateInputLayout(descs.data(), elementCount, vsByteCode, vsByteCodeSize, layout.GetAddressOf())))
+		return 0;
+
+	inputLayouts.push_back(layout);
+	return (InputLayoutHandle)inputLayouts.size();
+}
+
+void* D3D11RenderDevice::Map(BufferHandle buffer)
+{
+	D3D11_MAPPED_SUBRESOURCE mappedBuffer = {};
+	if (FAILED(context->Map(GetBuffer(buffer), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedBuffer)))
+		return 0;
+	return mappedBuffer.pData;
+}
+
+void D3D11RenderDevice::Unmap(BufferHandle buffer)
+{
+	context->Unmap(GetBuffer(buffer), 0);
+}
+
+void D3D11RenderDevice::UpdateBuffer(BufferHandle buffer, unsigned int offset, const void* data, unsigned int size)
+{
+	D3D11_BOX box = { offset, 0, 0, offset + size, 1, 1 };
+	context->UpdateSubresource(GetBuffer(buffer), 0, &box, data, 0, 0);
+}
+
+void D3D11RenderDevice::SetVertexShader(ShaderHandle shader)
+{
+	context->VSSetShader(shader ? vertexShaders[shader - 1].Get() : 0, 0, 0);
+}
+
+void D3D11RenderDevice::SetPixelShader(ShaderHandle shader)
+{
+	context->PSSetShader(shader ? pixelShaders[shader - 1].Get() : 0, 0, 0);
+}
+
+void D3D11RenderDevice::SetInputLayout(InputLayoutHandle layout)
+{
+	context->IASetInputLayout(layout ? inputLayouts[layout - 1].Get() : 0);
+}
+
+void D3D11RenderDevice::SetVertexBuffers(unsigned int startSlot, unsigned int count, const BufferHandle* buffers, const unsigned int* strides)
+{
+	ID3D11Buffer* d3dBuffers[MaxBindSlots];
+	UINT offsets[MaxBindSlots] = {};
+	for (unsigned int i = 0; i < count && i < MaxBindSlots; i++)
+		d3dBuffers[i] = GetBuffer(buffers[i]);
+
+	context->IASetVertexBuffers(startSlot, count, d3dBuffers, strides, offsets);
+}
+
+void D3D11RenderDevice::SetIndexBuffer(BufferHandle buffer, IndexFormat format)
+{
+	context->IASetIndexBuffer(GetBuffer(buffer), format == IndexFormat16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
+}
+
+void D3D11RenderDevice::SetVSConstantBuffers(unsigned int startSlot, unsigned int count, const BufferHandle* buffers)
+{
+	ID3D11Buffer* d3dBuffers[MaxBindSlots];
+	for (unsigned int i = 0; i < count && i < MaxBindSlots; i++)
+		d3dBuffers[i] = GetBuffer(buffers[i]);
+
+	context->VSSetConstantBuffers(startSlot, count, d3dBuffers);
+}
+
+// --------------------------------------------------------
+// Clear the render target and depth buffer (erases what's on the screen)
+//  - Do this ONCE PER FRAME
+//  - At the beginning of Draw (before drawing *anything*)
+// --------------------------------------------------------
+void D3D11RenderDevice::BeginFrame(const float clearColor[4])
+{
+	// Due to the usage of a more sophisticated swap chain,
+	// the render target must be re-bound after every call to Present()
+	context->OMSetRenderTargets(1, backBufferRTV.GetAddressOf(), depthStencilView.Get());
+
+	context->ClearRenderTargetView(backBufferRTV.Get(), clearColor);
+	context->ClearDepthStencilView(
+		depthStencilView.Get(),
+		D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL,
+		1.0f,
+		0);
+}
+
+void D3D11RenderDevice::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	context->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void D3D11RenderDevice::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount,
+	unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	context->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+// --------------------------------------------------------
+// Present the back buffer to the user
+//  - Puts the final frame we're drawing into the window so the user can see it
+//  - Headless runs have no swap chain; the frame just stays in the offscreen buffer
+// --------------------------------------------------------
+void D3D11RenderDevice::Present(bool vsync)
+{
+	if (swapChain)
+		swapChain->Present(vsync ? 1 : 0, 0);
+}
+
+ID3D11Buffer* D3D11RenderDevice::GetBuffer(BufferHandle buffer)
+{
+	return buffer ? buffers[buffer - 1].Get() : 0;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <d3d11.h>
+#include <vector>
+#include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
+#include "RenderDevice.h"
+
+// --------------------------------------------------------
+// RenderDevice on top of Direct3D 11.  Owns the device,
+// context, swap chain and the back/depth buffer views.
+// With no window it renders into an offscreen texture.
+//
+// Handles are indices (+1) into per-type arrays of ComPtrs.
+// --------------------------------------------------------
+class D3D11RenderDevice : public RenderDevice
+{
+public:
+	D3D11RenderDevice();
+
+	bool Initialize(void* windowHandle, unsigned int width, unsigned int height);
+	void Resize(unsigned int width, unsigned int height);
+	std::string GetName();
+
+	BufferHandle CreateBuffer(BufferType type, BufferUsage usage, const void* data, unsigned int size);
+	void ReleaseBuffer(BufferHandle buffer);
+	ShaderHandle CreateVertexShader(const void* byteCode, size_t byteCodeSize);
+	ShaderHandle CreatePixelShader(const void* byteCode, size_t byteCodeSize);
+	InputLayoutHandle CreateInputLayout(const VertexElement* elements, unsigned int elementCount,
+		const void* vsByteCode, size_t vsByteCodeSize);
+
+	void* Map(BufferHandle buffer);
+	void Unmap(BufferHandle buffer);
+	void UpdateBuffer(BufferHandle buffer, unsigned int offset, const void* data, unsigned int size);
+
+	void SetVertexShader(ShaderHandle shader);
+	void SetPixelShader(ShaderHandle shader);
+	void SetInputLayout(InputLayoutHandle layout);
+	void SetVertexBuffers(unsigned int startSlot, unsigned int count, const BufferHandle* buffers, const unsigned int* strides);
+	void SetIndexBuffer(BufferHandle buffer, IndexFormat format);
+	void SetVSConstantBuffers(unsigned int startSlot, unsigned int count, const BufferHandle* buffers);
+
+	void BeginFrame(const float clearColor[4]);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount,
+		unsigned int startIndex, int baseVertex, unsigned int startInstance);
+	void Present(bool vsync);
+
+private:
+	// DirectX related objects and variables
+	D3D_FEATURE_LEVEL		dxFeatureLevel;
+	Microsoft::WRL::ComPtr<IDXGISwapChain>		swapChain;
+	Microsoft::WRL::ComPtr<ID3D11Device>		device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext>	context;
+
+	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> backBufferRTV;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> depthStencilView;
+
+	unsigned int width;
+	unsigned int height;
+
+	//resources, indexed by handle - 1
+	std::vector<Microsoft::WRL::ComPtr<ID3D11Buffer>> buffers;
+	std::vector<BufferHandle> freeBuffers;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11VertexShader>> vertexShaders;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11PixelShader>> pixelShaders;
+	std::vector<Microsoft::WRL::ComPtr<ID3D11InputLayout>> inputLayouts;
+
+	ID3D11Buffer* GetBuffer(BufferHandle buffer);
+};
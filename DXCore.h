@@ -1,41 +1,29 @@
 #pragma once
 
-#include <Windows.h>
-#include <d3d11.h>
 #include <string>
-#include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
+#include "Platform.h"
+#include "RenderDevice.h"
 
-// We can include the correct library files here
-// instead of in Visual Studio settings if we want
-#pragma comment(lib, "d3d11.lib")
-
-class DXCore
+class DXCore : public PlatformListener
 {
 public:
 	DXCore(
-		HINSTANCE hInstance,		// The application's handle
+		Platform* platform,			// Window, messages, timing and paths
+		RenderDevice* renderDevice,	// What everything draws through
 		const char* titleBarText,	// Text for the window's title bar
 		unsigned int windowWidth,	// Width of the window's client area
 		unsigned int windowHeight,	// Height of the window's client area
 		bool debugTitleBarStats);	// Show extra stats (fps) in title bar?
 	~DXCore();
 
-	// Static requirements for OS-level message processing
-	static DXCore* DXCoreInstance;
-	static LRESULT CALLBACK WindowProc(
-		HWND hWnd,		// Window handle
-		UINT uMsg,		// Message
-		WPARAM wParam,	// Message's first parameter
-		LPARAM lParam	// Message's second parameter
-	);
-
-	// Internal method for message handling
-	LRESULT ProcessMessage(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+	// Platform events
+	void OnWindowResized(unsigned int width, unsigned int height);
+	void OnFocusChanged(bool focused);
 
 	// Initialization and game-loop related methods
-	HRESULT InitWindow();
-	HRESULT InitDirectX();
-	HRESULT Run();
+	bool InitWindow();
+	bool InitRenderDevice();
+	int Run(unsigned int frameLimit = 0);	// 0 = until the platform quits
 	void Quit();
 	virtual void OnResize();
 
@@ -44,9 +32,13 @@ public:
 	virtual void Update(float deltaTime, float totalTime) = 0;
 	virtual void Draw(float deltaTime, float totalTime) = 0;
 
+	// Extra text appended to the title bar stats (empty by default)
+	virtual std::string GetTitleBarStats() { return std::string(); }
+
 protected:
-	HINSTANCE	hInstance;		// The handle to the application
-	HWND		hWnd;			// The handle to the window itself
+	Platform*	platform;		// The OS layer (not owned)
+	RenderDevice* renderDevice;	// The graphics backend (not owned)
+	bool		renderDeviceReady;
 	std::string titleBarText;	// Custom text in window's title bar
 	bool		titleBarStats;	// Show extra stats in title bar?
 
@@ -58,15 +50,6 @@ protected:
 	// Helpful if we want to pause while not the active window
 	bool hasFocus;
 
-	// DirectX related objects and variables
-	D3D_FEATURE_LEVEL		dxFeatureLevel;
-	Microsoft::WRL::ComPtr<IDXGISwapChain>		swapChain;
-	Microsoft::WRL::ComPtr<ID3D11Device>		device;
-	Microsoft::WRL::ComPtr<ID3D11DeviceContext>	context;
-
-	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> backBufferRTV;
-	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> depthStencilView;
-
 	// Helper function for allocating a console window
 	void CreateConsoleWindow(int bufferLines, int bufferColumns, int windowLines, int windowColumns);
 
@@ -80,18 +63,17 @@ protected:
 
 private:
 	// Timing related data
-	double perfCounterSeconds;
 	float totalTime;
 	float deltaTime;
-	__int64 startTime;
-	__int64 currentTime;
-	__int64 previousTime;
+	double startTime;
+	double currentTime;
+	double previousTime;
 
 	// FPS calculation
 	int fpsFrameCount;
 	float fpsTimeElapsed;
 
 	void UpdateTimer();			// Updates the timer for this frame
-	void UpdateTitleBarStats();	// Puts debug info in the title bar
+	void UpdateTitleBarStats(bool partialSecond = false);	// Puts debug info in the title bar
 };
 
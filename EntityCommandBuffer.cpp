@@ -0,0 +1,116 @@
+#include "EntityCommandBuffer.h"
+
+const size_t EntityCommandBuffer::BlockSize;
+
+EntityCommandBuffer::EntityCommandBuffer()
+{
+	this->currentBlock = 0;
+	this->blockOffset = 0;
+}
+
+EntityCommandBuffer::~EntityCommandBuffer()
+{
+	Clear();
+}
+
+void EntityCommandBuffer::Destroy(Entity entity)
+{
+	Command command = { DestroyCommand, entity, 0, 0, 0 };
+	commands.push_back(command);
+}
+
+// --------------------------------------------------------
+// Makes every recorded change, in order.  Values are moved
+// into the store and their leftovers destroyed as we go.
+// --------------------------------------------------------
+void EntityCommandBuffer::Playback(EntityStore& store)
+{
+	for (size_t i = 0; i < commands.size(); i++)
+	{
+		const Command& command = commands[i];
+		switch (command.type)
+		{
+		case CreateCommand:
+			playbackTypeIds.clear();
+			playbackComponents.clear();
+			for (unsigned int v = 0; v < command.valueCount; v++)
+			{
+				playbackTypeIds.push_back(values[command.firstValue + v].typeId);
+				playbackComponents.push_back(values[command.firstValue + v].data);
+			}
+			store.CreateFromIds(playbackTypeIds.data(), playbackComponents.data(), command.valueCount);
+			break;
+
+		case DestroyCommand:
+			store.Destroy(command.entity);
+			break;
+
+		case AddCommand:
+			store.AddById(command.entity, command.typeId, values[command.firstValue].data);
+			break;
+
+		case RemoveCommand:
+			store.RemoveById(command.entity, command.typeId);
+			break;
+		}
+	}
+
+	// Moved-from values still need destroying, just like unplayed ones
+	Clear();
+}
+
+unsigned int EntityCommandBuffer::GetCommandCount()
+{
+	return (unsigned int)commands.size();
+}
+
+void EntityCommandBuffer::RecordValue(unsigned int typeId, void* component)
+{
+	const ComponentInfo& info = GetComponentInfo(typeId);
+	Value value;
+	value.typeId = typeId;
+	value.data = Allocate(info.size, info.alignment);
+	info.moveConstruct(value.data, component);
+	values.push_back(value);
+}
+
+// --------------------------------------------------------
+// Bump-allocates from the current block, moving on to the
+// next (reused or new) one when it's full
+// --------------------------------------------------------
+void* EntityCommandBuffer::Allocate(size_t size, size_t alignment)
+{
+	if (size > BlockSize)
+	{
+		oversizedBlocks.push_back(std::unique_ptr<unsigned char[]>(new unsigned char[size]));
+		return oversizedBlocks.back().get();
+	}
+
+	size_t offset = (blockOffset + alignment - 1) / alignment * alignment;
+	if (blocks.empty() || offset + size > BlockSize)
+	{
+		if (!blocks.empty())
+			currentBlock++;
+		if (currentBlock == blocks.size())
+			blocks.push_back(std::unique_ptr<unsigned char[]>(new unsigned char[BlockSize]));
+		offset = 0;
+	}
+
+	blockOffset = offset + size;
+	return blocks[currentBlock].get() + offset;
+}
+
+// --------------------------------------------------------
+// Destroys the recorded values and keeps the blocks for reuse
+// --------------------------------------------------------
+void EntityCommandBuffer::Clear()
+{
+	for (size_t i = 0; i < values.size(); i++)
+		GetComponentInfo(values[i].typeId).destroy(values[i].data);
+
+	commands.clear();
+	values.clear();
+	oversizedBlocks.clear();
+	currentBlock = 0;
+	blockOffset = 0;
+}
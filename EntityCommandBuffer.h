@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "EntityStore.h"
+
+// --------------------------------------------------------
+// Records structural changes (create, destroy, add and
+// remove) so they can be made while a query is walking an
+// EntityStore, then applied in one go with Playback().
+//
+// Component values are moved into fixed-size blocks that
+// never reallocate (so nothing gets moved behind a value's
+// back) and are reused after every playback.  Commands on
+// entities that are gone by playback time are skipped.
+// --------------------------------------------------------
+class EntityCommandBuffer
+{
+public:
+	EntityCommandBuffer();
+	~EntityCommandBuffer();
+	EntityCommandBuffer(const EntityCommandBuffer&) = delete;
+	EntityCommandBuffer& operator=(const EntityCommandBuffer&) = delete;
+
+	//recording - components are passed by value and moved in
+	template<typename... Ts> void Create(Ts... components);
+	void Destroy(Entity entity);
+	template<typename T> void Add(Entity entity, T component);
+	template<typename T> void Remove(Entity entity);
+
+	//applies every command in recorded order, then empties the buffer
+	void Playback(EntityStore& store);
+	//drops everything recorded so far
+	void Clear();
+	unsigned int GetCommandCount();
+
+	// Bytes per value block (bigger values get a block of their own)
+	static const size_t BlockSize = 16 * 1024;
+
+private:
+	enum CommandType
+	{
+		CreateCommand,
+		DestroyCommand,
+		AddCommand,
+		RemoveCommand
+	};
+
+	struct Command
+	{
+		CommandType type;
+		Entity entity;
+		unsigned int firstValue;	// Create/Add: index into values
+		unsigned int valueCount;
+		unsigned int typeId;		// Remove: which component
+	};
+
+	struct Value
+	{
+		unsigned int typeId;
+		void* data;
+	};
+
+	std::vector<Command> commands;
+	std::vector<Value> values;
+
+	//value storage
+	std::vector<std::unique_ptr<unsigned char[]>> blocks;
+	std::vector<std::unique_ptr<unsigned char[]>> oversizedBlocks;
+	size_t currentBlock;
+	size_t blockOffset;
+
+	//playback scratch for each Create's components, kept between playbacks
+	std::vector<unsigned int> playbackTypeIds;
+	std::vector<void*> playbackComponents;
+
+	void RecordValue(unsigned int typeId, void* component);
+	void* Allocate(size_t size, size_t alignment);
+};
+
+template<typename... Ts>
+void EntityCommandBuffer::Create(Ts... components)
+{
+	Command command = { CreateCommand, Entity(), (unsigned int)values.size(), sizeof...(Ts), 0 };
+	int expand[] = { 0, (RecordValue(GetComponentTypeId<Ts>(), &components), 0)... };
+	(void)expand;
+	commands.push_back(command);
+}
+
+template<typename T>
+void EntityCommandBuffer::Add(Entity entity, T component)
+{
+	Command command = { AddCommand, entity, (unsigned int)values.size(), 1, GetComponentTypeId<T>() };
+	RecordValue(command.typeId, &component);
+	commands.push_back(command);
+}
+
+template<typename T>
+void EntityCommandBuffer::Remove(Entity entity)
+{
+	Command command = { RemoveCommand, entity, 0, 0, GetComponentTypeId<T>() };
+	commands.push_back(command);
+}
@@ -0,0 +1,429 @@
+#include "EntityStore.h"
+
+// Every component type seen so far, indexed by type id
+static std::vector<ComponentInfo>& GetComponentInfos()
+{
+	static std::vector<ComponentInfo> infos;
+	return infos;
+}
+
+unsigned int RegisterComponentType(const ComponentInfo& info)
+{
+	// Reserved up front so references handed out by GetComponentInfo() stay put
+	std::vector<ComponentInfo>& infos = GetComponentInfos();
+	infos.reserve(MaxComponentTypes);
+	infos.push_back(info);
+	return (unsigned int)infos.size() - 1;
+}
+
+const ComponentInfo& GetComponentInfo(unsigned int typeId)
+{
+	return GetComponentInfos()[typeId];
+}
+
+const unsigned int EntityStore::MaxEntities;
+const unsigned int EntityStore::MinimumFreeSlots;
+
+static size_t AlignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+EntityStore::EntityStore()
+{
+	this->count = 0;
+	this->freeHead = 0;
+	this->freeTail = 0;
+	this->freeCount = 0;
+}
+
+// --------------------------------------------------------
+// Destroys every component still alive and frees the chunks
+// --------------------------------------------------------
+EntityStore::~EntityStore()
+{
+	for (size_t a = 0; a < archetypes.size(); a++)
+	{
+		Archetype* archetype = archetypes[a].get();
+		for (size_t c = 0; c < archetype->chunks.size(); c++)
+		{
+			Chunk& chunk = archetype->chunks[c];
+			for (size_t t = 0; t < archetype->typeIds.size(); t++)
+			{
+				const ComponentInfo& info = GetComponentInfo(archetype->typeIds[t]);
+				for (unsigned int row = 0; row < chunk.count; row++)
+					info.destroy(GetComponent(archetype, (unsigned int)c, row, (int)t));
+			}
+			delete[] chunk.data;
+		}
+		for (size_t c = 0; c < archetype->freeChunks.size(); c++)
+			delete[] archetype->freeChunks[c];
+	}
+}
+
+Entity EntityStore::Create()
+{
+	return NewEntity(GetArchetype(0));
+}
+
+// --------------------------------------------------------
+// Creates an entity with the given components, moving each
+// one out of components[i].  Repeated types only use the
+// first value.
+// --------------------------------------------------------
+Entity EntityStore::CreateFromIds(const unsigned int* typeIds, void* const* components, unsigned int componentCount)
+{
+	ComponentMask mask = 0;
+	for (unsigned int i = 0; i < componentCount; i++)
+		mask |= 1ull << typeIds[i];
+
+	Archetype* archetype = GetArchetype(mask);
+	Entity entity = NewEntity(archetype);
+	if (!entity.id)
+		return entity;
+	EntityRecord& record = records[entity.GetIndex()];
+
+	ComponentMask constructed = 0;
+	for (unsigned int i = 0; i < componentCount; i++)
+	{
+		ComponentMask bit = 1ull << typeIds[i];
+		if (constructed & bit)
+			continue;
+		constructed |= bit;
+
+		void* destination = GetComponent(archetype, record.chunk, record.row, archetype->slotOfType[typeIds[i]]);
+		GetComponentInfo(typeIds[i]).moveConstruct(destination, components[i]);
+	}
+
+	return entity;
+}
+
+void EntityStore::Destroy(Entity entity)
+{
+	EntityRecord* record = GetRecord(entity);
+	if (!record)
+		return;
+
+	RemoveRow(record->archetype, record->chunk, record->row);
+
+	record->archetype = 0;
+	record->generation = (record->generation + 1) & EntityGenerationMask;
+	if (record->generation == 0)
+		record->generation = 1;
+
+	// Queue the slot at the back of the free list
+	record->nextFree = 0;
+	if (freeCount == 0)
+		freeHead = entity.GetIndex();
+	else
+		records[freeTail].nextFree = entity.GetIndex();
+	freeTail = entity.GetIndex();
+	freeCount++;
+	count--;
+}
+
+bool EntityStore::IsAlive(Entity entity)
+{
+	return GetRecord(entity) != 0;
+}
+
+unsigned int EntityStore::GetCount()
+{
+	return count;
+}
+
+void EntityStore::Reserve(unsigned int entityCount)
+{
+	records.reserve(entityCount < MaxEntities ? entityCount : MaxEntities);
+}
+
+void* EntityStore::GetById(Entity entity, unsigned int typeId)
+{
+	EntityRecord* record = GetRecord(entity);
+	if (!record || typeId >= MaxComponentTypes)
+		return 0;
+
+	int slot = record->archetype->slotOfType[typeId];
+	if (slot < 0)
+		return 0;
+	return GetComponent(record->archetype, record->chunk, record->row, slot);
+}
+
+// --------------------------------------------------------
+// Moves the entity to the archetype with one more component
+// and moves the new component in (or replaces it, if the
+// entity already has one of this type)
+// --------------------------------------------------------
+void* EntityStore::AddById(Entity entity, unsigned int typeId, void* component)
+{
+	EntityRecord* record = GetRecord(entity);
+	if (!record || typeId >= MaxComponentTypes)
+		return 0;
+
+	const ComponentInfo& info = GetComponentInfo(typeId);
+	Archetype* source = record->archetype;
+	if (source->slotOfType[typeId] >= 0)
+	{
+		void* existing = GetComponent(source, record->chunk, record->row, source->slotOfType[typeId]);
+		info.destroy(existing);
+		info.moveConstruct(existing, component);
+		return existing;
+	}
+
+	if (!source->addEdges[typeId])
+		source->addEdges[typeId] = GetArchetype(source->mask | (1ull << typeId));
+	Archetype* destination = source->addEdges[typeId];
+
+	MoveEntity(entity, record, destination);
+
+	void* added = GetComponent(destination, record->chunk, record->row, destination->slotOfType[typeId]);
+	info.moveConstruct(added, component);
+	return added;
+}
+
+bool EntityStore::RemoveById(Entity entity, unsigned int typeId)
+{
+	EntityRecord* record = GetRecord(entity);
+	if (!record || typeId >= MaxComponentTypes || record->archetype->slotOfType[typeId] < 0)
+		return false;
+
+	Archetype* source = record->archetype;
+	if (!source->removeEdges[typeId])
+		source->removeEdges[typeId] = GetArchetype(source->mask & ~(1ull << typeId));
+
+	MoveEntity(entity, record, source->removeEdges[typeId]);
+	return true;
+}
+
+unsigned int EntityStore::GetArchetypeCount()
+{
+	return (unsigned int)archetypes.size();
+}
+
+unsigned int EntityStore::GetChunkCount()
+{
+	unsigned int chunks = 0;
+	for (size_t a = 0; a < archetypes.size(); a++)
+		chunks += (unsigned int)archetypes[a]->chunks.size();
+	return chunks;
+}
+
+// --------------------------------------------------------
+// Finds (or lays out) the archetype for a set of component
+// types.  As many entities as fit go in each chunk: their
+// ids first, then each component array, aligned for its type.
+// --------------------------------------------------------
+EntityStore::Archetype* EntityStore::GetArchetype(ComponentMask mask)
+{
+	std::unordered_map<ComponentMask, Archetype*>::iterator found = archetypesByMask.find(mask);
+	if (found != archetypesByMask.end())
+		return found->second;
+
+	std::unique_ptr<Archetype> archetype(new Archetype());
+	archetype->mask = mask;
+	archetype->entityCount = 0;
+	for (unsigned int i = 0; i < MaxComponentTypes; i++)
+	{
+		archetype->slotOfType[i] = -1;
+		archetype->addEdges[i] = 0;
+		archetype->removeEdges[i] = 0;
+	}
+
+	size_t bytesPerEntity = sizeof(Entity);
+	for (unsigned int typeId = 0; typeId < MaxComponentTypes; typeId++)
+	{
+		if (!(mask & (1ull << typeId)))
+			continue;
+		archetype->slotOfType[typeId] = (int)archetype->typeIds.size();
+		archetype->typeIds.push_back(typeId);
+		bytesPerEntity += GetComponentInfo(typeId).size;
+	}
+	archetype->arrayOffsets.resize(archetype->typeIds.size());
+
+	// Start from the unpadded estimate and back off until the aligned layout fits
+	unsigned int capacity = (unsigned int)(ChunkSize / bytesPerEntity);
+	if (capacity == 0)
+		capacity = 1;
+	for (;;)
+	{
+		size_t offset = capacity * sizeof(Entity);
+		for (size_t t = 0; t < archetype->typeIds.size(); t++)
+		{
+			const ComponentInfo& info = GetComponentInfo(archetype->typeIds[t]);
+			offset = AlignUp(offset, info.alignment);
+			archetype->arrayOffsets[t] = offset;
+			offset += info.size * capacity;
+		}
+
+		if (offset <= ChunkSize || capacity == 1)
+		{
+			archetype->chunkCapacity = capacity;
+			archetype->chunkBytes = offset;
+			break;
+		}
+		capacity--;
+	}
+
+	Archetype* result = archetype.get();
+	archetypes.push_back(std::move(archetype));
+	archetypesByMask[mask] = result;
+	return result;
+}
+
+EntityStore::EntityRecord* EntityStore::GetRecord(Entity entity)
+{
+	if (entity.GetIndex() >= records.size())
+		return 0;
+
+	EntityRecord& record = records[entity.GetIndex()];
+	if (!record.archetype || record.generation != entity.GetGeneration())
+		return 0;
+	return &record;
+}
+
+// --------------------------------------------------------
+// Picks a slot and gives it a row.  Freed slots are only
+// reused once enough of them are queued; until then (or if
+// none are free) a new slot is added.
+// --------------------------------------------------------
+Entity EntityStore::NewEntity(Archetype* archetype)
+{
+	unsigned int index;
+	if (freeCount >= MinimumFreeSlots || (freeCount > 0 && records.size() == MaxEntities))
+	{
+		index = freeHead;
+		freeHead = records[index].nextFree;
+		freeCount--;
+	}
+	else if (records.size() < MaxEntities)
+	{
+		EntityRecord record = {};
+		record.generation = 1;
+		records.push_back(record);
+		index = (unsigned int)records.size() - 1;
+	}
+	else
+	{
+		Entity none = {};
+		return none;
+	}
+
+	EntityRecord& record = records[index];
+	Entity entity;
+	entity.id = index | (record.generation << EntityIndexBits);
+	record.archetype = archetype;
+	AllocateRow(archetype, entity, record.chunk, record.row);
+
+	count++;
+	return entity;
+}
+
+// --------------------------------------------------------
+// Reserves the next row of an archetype (starting a new
+// chunk if the last one is full) and stores the entity id.
+// The components in the row are left for the caller.
+// --------------------------------------------------------
+void EntityStore::AllocateRow(Archetype* archetype, Entity entity, unsigned int& chunk, unsigned int& row)
+{
+	if (archetype->chunks.empty() || archetype->chunks.back().count == archetype->chunkCapacity)
+	{
+		Chunk newChunk;
+		if (!archetype->freeChunks.empty())
+		{
+			newChunk.data = archetype->freeChunks.back();
+			archetype->freeChunks.pop_back();
+		}
+		else
+		{
+			// Room to park every chunk we own, so freeing one never allocates
+			newChunk.data = new unsigned char[archetype->chunkBytes];
+			archetype->freeChunks.reserve(archetype->chunks.size() + 1);
+		}
+		newChunk.count = 0;
+		archetype->chunks.push_back(newChunk);
+	}
+
+	chunk = (unsigned int)archetype->chunks.size() - 1;
+	Chunk& last = archetype->chunks.back();
+	row = last.count++;
+	((Entity*)last.data)[row] = entity;
+	archetype->entityCount++;
+}
+
+// --------------------------------------------------------
+// Destroys the components in a row and fills the hole with
+// the archetype's last entity, so every chunk but the last
+// stays full.  The last chunk is set aside for reuse once
+// it empties.
+// --------------------------------------------------------
+void EntityStore::RemoveRow(Archetype* archetype, unsigned int chunk, unsigned int row)
+{
+	unsigned int lastChunk = (unsigned int)archetype->chunks.size() - 1;
+	unsigned int lastRow = archetype->chunks[lastChunk].count - 1;
+	bool isLast = chunk == lastChunk && row == lastRow;
+
+	for (size_t t = 0; t < archetype->typeIds.size(); t++)
+	{
+		const ComponentInfo& info = GetComponentInfo(archetype->typeIds[t]);
+		void* hole = GetComponent(archetype, chunk, row, (int)t);
+		info.destroy(hole);
+
+		if (!isLast)
+		{
+			void* moving = GetComponent(archetype, lastChunk, lastRow, (int)t);
+			info.moveConstruct(hole, moving);
+			info.destroy(moving);
+		}
+	}
+
+	if (!isLast)
+	{
+		Entity moved = ((Entity*)archetype->chunks[lastChunk].data)[lastRow];
+		((Entity*)archetype->chunks[chunk].data)[row] = moved;
+		records[moved.GetIndex()].chunk = chunk;
+		records[moved.GetIndex()].row = row;
+	}
+
+	archetype->entityCount--;
+	if (--archetype->chunks[lastChunk].count == 0)
+	{
+		archetype->freeChunks.push_back(archetype->chunks[lastChunk].data);
+		archetype->chunks.pop_back();
+	}
+}
+
+// --------------------------------------------------------
+// Moves an entity's shared components into a row of another
+// archetype, then removes its old row (destroying the moved-
+// from shells and anything the destination doesn't have)
+// --------------------------------------------------------
+void EntityStore::MoveEntity(Entity entity, EntityRecord* record, Archetype* destination)
+{
+	Archetype* source = record->archetype;
+	unsigned int chunk;
+	unsigned int row;
+	AllocateRow(destination, entity, chunk, row);
+
+	for (size_t t = 0; t < destination->typeIds.size(); t++)
+	{
+		int sourceSlot = source->slotOfType[destination->typeIds[t]];
+		if (sourceSlot < 0)
+			continue;
+
+		GetComponentInfo(destination->typeIds[t]).moveConstruct(
+			GetComponent(destination, chunk, row, (int)t),
+			GetComponent(source, record->chunk, record->row, sourceSlot));
+	}
+
+	RemoveRow(source, record->chunk, record->row);
+
+	record->archetype = destination;
+	record->chunk = chunk;
+	record->row = row;
+}
+
+void* EntityStore::GetComponent(Archetype* archetype, unsigned int chunk, unsigned int row, int slot)
+{
+	const ComponentInfo& info = GetComponentInfo(archetype->typeIds[slot]);
+	return archetype->chunks[chunk].data + archetype->arrayOffsets[slot] + info.size * row;
+}
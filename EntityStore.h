@@ -0,0 +1,275 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// --------------------------------------------------------
+// An entity is only a 32-bit id: the low EntityIndexBits
+// pick a slot in the store and the rest are that slot's
+// generation.  The generation goes up every time a slot is
+// reused, so ids of destroyed entities stop resolving
+// instead of finding whoever came next.  Generations skip
+// 0, so a zeroed Entity is never valid.
+// --------------------------------------------------------
+static const unsigned int EntityIndexBits = 20;
+static const unsigned int EntityIndexMask = (1u << EntityIndexBits) - 1;
+static const unsigned int EntityGenerationMask = 0xFFFFFFFFu >> EntityIndexBits;
+
+struct Entity
+{
+	unsigned int id;
+
+	unsigned int GetIndex() const { return id & EntityIndexMask; }
+	unsigned int GetGeneration() const { return id >> EntityIndexBits; }
+	bool operator==(const Entity& other) const { return id == other.id; }
+	bool operator!=(const Entity& other) const { return id != other.id; }
+};
+
+// Bit n is set when component type n is present
+typedef unsigned long long ComponentMask;
+static const unsigned int MaxComponentTypes = 64;
+
+// What the store needs to move and destroy a component it only knows by id
+struct ComponentInfo
+{
+	size_t size;
+	size_t alignment;
+	void (*moveConstruct)(void* destination, void* source);
+	void (*destroy)(void* component);
+};
+
+// Component type ids are handed out in first-use order (at most MaxComponentTypes)
+unsigned int RegisterComponentType(const ComponentInfo& info);
+const ComponentInfo& GetComponentInfo(unsigned int typeId);
+
+template<typename T>
+struct ComponentOperations
+{
+	static void MoveConstruct(void* destination, void* source) { new (destination) T(std::move(*(T*)source)); }
+	static void Destroy(void* component) { ((T*)component)->~T(); }
+};
+
+template<typename T>
+unsigned int GetComponentTypeId()
+{
+	static const unsigned int id = RegisterComponentType(
+		{ sizeof(T), alignof(T), &ComponentOperations<T>::MoveConstruct, &ComponentOperations<T>::Destroy });
+	return id;
+}
+
+// --------------------------------------------------------
+// Archetype-based entity/component storage
+//
+// Every distinct set of component types (an archetype) keeps
+// its entities in fixed-size chunks.  Inside a chunk each
+// component type is one contiguous array, so a query walks
+// plain arrays instead of chasing a pointer per entity.
+// Adding or removing a component moves the entity to the
+// matching archetype; removal swap-fills the hole with the
+// archetype's last entity so chunks stay packed.
+//
+// Spawning and despawning don't touch the heap once the
+// store has warmed up: freed slots are queued for reuse,
+// and emptied chunks are kept to back the next one the
+// archetype needs.
+//
+// Components only need to be movable - they're move-
+// constructed into place and destroyed in place (Transform
+// re-points its hierarchy links when it moves).
+//
+// Component pointers are only good until the next
+// structural change (create, destroy, add, remove), and
+// structural changes aren't allowed inside a query - record
+// them in an EntityCommandBuffer and play it back after.
+// --------------------------------------------------------
+class EntityStore
+{
+public:
+	// Bytes per chunk (a chunk grows past this only to fit a single huge entity)
+	static const unsigned int ChunkSize = 16 * 1024;
+	// Most entities alive at once (every slot index must fit in an Entity)
+	static const unsigned int MaxEntities = EntityIndexMask + 1;
+	// Freed slots wait in a FIFO until there are at least this many, so a
+	// slot's generation only comes round again after a long while
+	static const unsigned int MinimumFreeSlots = 1024;
+
+	EntityStore();
+	~EntityStore();
+	EntityStore(const EntityStore&) = delete;
+	EntityStore& operator=(const EntityStore&) = delete;
+
+	//entities - components are passed by value and moved in.
+	//Create() returns a zeroed (invalid) Entity once MaxEntities are alive
+	Entity Create();
+	template<typename... Ts> Entity Create(Ts... components);
+	void Destroy(Entity entity);
+	bool IsAlive(Entity entity);
+	unsigned int GetCount();
+	//grows the slot table up front so a burst of spawns doesn't reallocate it
+	void Reserve(unsigned int entityCount);
+
+	//components - Get() returns null if the entity is gone or lacks the component.
+	//Add() replaces an existing component of the same type
+	template<typename T> T* Get(Entity entity);
+	template<typename T> bool Has(Entity entity);
+	template<typename T> T* Add(Entity entity, T component);
+	template<typename T> bool Remove(Entity entity);
+
+	//queries over every entity that has (at least) the listed components
+	// - ForEach calls func(Entity, Ts&...) per entity
+	// - ForEachChunk calls func(count, const Entity*, Ts*...) per chunk, for batch/SIMD loops
+	template<typename... Ts, typename Func> void ForEach(Func func);
+	template<typename... Ts, typename Func> void ForEachChunk(Func func);
+	template<typename... Ts> unsigned int Count();
+
+	//the same operations by type id - components are moved from (command buffers use these)
+	Entity CreateFromIds(const unsigned int* typeIds, void* const* components, unsigned int componentCount);
+	void* AddById(Entity entity, unsigned int typeId, void* component);
+	bool RemoveById(Entity entity, unsigned int typeId);
+	void* GetById(Entity entity, unsigned int typeId);
+
+	//stats
+	unsigned int GetArchetypeCount();
+	unsigned int GetChunkCount();
+
+private:
+	struct Chunk
+	{
+		unsigned char* data;	// Entity ids first, then one array per component type
+		unsigned int count;
+	};
+
+	struct Archetype
+	{
+		ComponentMask mask;
+		std::vector<unsigned int> typeIds;		// Ascending
+		std::vector<size_t> arrayOffsets;		// Byte offset of each type's array in a chunk
+		int slotOfType[MaxComponentTypes];		// Index into typeIds, -1 if absent
+		unsigned int chunkCapacity;
+		size_t chunkBytes;
+		std::vector<Chunk> chunks;				// Only the last one can be partly full
+		std::vector<unsigned char*> freeChunks;	// Emptied chunk memory, reused before allocating
+		unsigned int entityCount;
+
+		// Archetypes one component away, found on first use
+		Archetype* addEdges[MaxComponentTypes];
+		Archetype* removeEdges[MaxComponentTypes];
+	};
+
+	struct EntityRecord
+	{
+		Archetype* archetype;	// Null while the slot is free
+		unsigned int chunk;
+		unsigned int row;
+		unsigned int generation;
+		unsigned int nextFree;	// Next slot in the free queue
+	};
+
+	std::vector<std::unique_ptr<Archetype>> archetypes;
+	std::unordered_map<ComponentMask, Archetype*> archetypesByMask;
+	std::vector<EntityRecord> records;
+	unsigned int count;
+
+	//free slots, oldest first, linked through EntityRecord::nextFree
+	unsigned int freeHead;
+	unsigned int freeTail;
+	unsigned int freeCount;
+
+	Archetype* GetArchetype(ComponentMask mask);
+	EntityRecord* GetRecord(Entity entity);
+	Entity NewEntity(Archetype* archetype);
+	void AllocateRow(Archetype* archetype, Entity entity, unsigned int& chunk, unsigned int& row);
+	void RemoveRow(Archetype* archetype, unsigned int chunk, unsigned int row);
+	void MoveEntity(Entity entity, EntityRecord* record, Archetype* destination);
+	static void* GetComponent(Archetype* archetype, unsigned int chunk, unsigned int row, int slot);
+
+	template<typename... Ts> static ComponentMask MakeMask();
+};
+
+template<typename... Ts>
+ComponentMask EntityStore::MakeMask()
+{
+	// The leading 0 keeps the array from being empty when Ts is
+	unsigned int typeIds[] = { 0, GetComponentTypeId<Ts>()... };
+	ComponentMask mask = 0;
+	for (size_t i = 1; i < sizeof(typeIds) / sizeof(typeIds[0]); i++)
+		mask |= 1ull << typeIds[i];
+	return mask;
+}
+
+template<typename... Ts>
+Entity EntityStore::Create(Ts... components)
+{
+	unsigned int typeIds[] = { GetComponentTypeId<Ts>()... };
+	void* pointers[] = { (void*)&components... };
+	return CreateFromIds(typeIds, pointers, sizeof...(Ts));
+}
+
+template<typename T>
+T* EntityStore::Get(Entity entity)
+{
+	return (T*)GetById(entity, GetComponentTypeId<T>());
+}
+
+template<typename T>
+bool EntityStore::Has(Entity entity)
+{
+	return GetById(entity, GetComponentTypeId<T>()) != 0;
+}
+
+template<typename T>
+T* EntityStore::Add(Entity entity, T component)
+{
+	return (T*)AddById(entity, GetComponentTypeId<T>(), &component);
+}
+
+template<typename T>
+bool EntityStore::Remove(Entity entity)
+{
+	return RemoveById(entity, GetComponentTypeId<T>());
+}
+
+template<typename... Ts, typename Func>
+void EntityStore::ForEachChunk(Func func)
+{
+	ComponentMask mask = MakeMask<Ts...>();
+	for (size_t a = 0; a < archetypes.size(); a++)
+	{
+		Archetype* archetype = archetypes[a].get();
+		if ((archetype->mask & mask) != mask)
+			continue;
+
+		for (size_t c = 0; c < archetype->chunks.size(); c++)
+		{
+			const Chunk& chunk = archetype->chunks[c];
+			func(chunk.count, (const Entity*)chunk.data,
+				(Ts*)(chunk.data + archetype->arrayOffsets[archetype->slotOfType[GetComponentTypeId<Ts>()]])...);
+		}
+	}
+}
+
+template<typename... Ts, typename Func>
+void EntityStore::ForEach(Func func)
+{
+	ForEachChunk<Ts...>([&](unsigned int chunkCount, const Entity* entities, Ts*... components)
+	{
+		for (unsigned int i = 0; i < chunkCount; i++)
+			func(entities[i], components[i]...);
+	});
+}
+
+template<typename... Ts>
+unsigned int EntityStore::Count()
+{
+	ComponentMask mask = MakeMask<Ts...>();
+	unsigned int total = 0;
+	for (size_t a = 0; a < archetypes.size(); a++)
+	{
+		if ((archetypes[a]->mask & mask) == mask)
+			total += archetypes[a]->entityCount;
+	}
+	return total;
+}
@@ -0,0 +1,145 @@
+#include "Frustum.h"
+
+using namespace DirectX;
+
+Frustum::Frustum()
+{
+    for (int i = 0; i < 6; i++)
+        planes[i] = XMFLOAT4(0, 0, 0, 0);
+}
+
+Frustum::Frustum(DirectX::XMFLOAT4X4 viewProjection)
+{
+    SetFromViewProjection(viewProjection);
+}
+
+// --------------------------------------------------------
+// Gribb/Hartmann plane extraction for row vectors and a
+// D3D-style [0, 1] depth range.  With clip = v * M, a point is
+// inside when -w <= x <= w, -w <= y <= w and 0 <= z <= w, and
+// each of those inequalities is a plane built from M's columns.
+// --------------------------------------------------------
+void Frustum::SetFromViewProjection(DirectX::XMFLOAT4X4 m)
+{
+    planes[0] = XMFLOAT4(m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41); // left
+    planes[1] = XMFLOAT4(m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41); // right
+    planes[2] = XMFLOAT4(m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42); // bottom
+    planes[3] = XMFLOAT4(m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42); // top
+    planes[4] = XMFLOAT4(m._13, m._23, m._33, m._43);                                 // near
+    planes[5] = XMFLOAT4(m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43); // far
+
+    // Normalize so plane distances are real distances (needed for sphere radii)
+    for (int i = 0; i < 6; i++)
+        XMStoreFloat4(&planes[i], XMPlaneNormalize(XMLoadFloat4(&planes[i])));
+}
+
+DirectX::XMFLOAT4 Frustum::GetPlane(int index)
+{
+    return planes[index];
+}
+
+// --------------------------------------------------------
+// Written as !(distance >= -radius) so a NaN center or radius
+// counts as outside, the same as the SIMD compares in
+// CullSpheres (which this also finishes off)
+// --------------------------------------------------------
+bool Frustum::IntersectsSphere(DirectX::XMFLOAT3 center, float radius)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        const XMFLOAT4& p = planes[i];
+        if (!(p.x * center.x + p.y * center.y + p.z * center.z + p.w >= -radius))
+            return false;
+    }
+    return true;
+}
+
+// --------------------------------------------------------
+// Tests 8 (AVX2) or 4 (SSE) spheres against each plane per
+// instruction, then compacts the survivors into an index list.
+// Whatever doesn't fill a full block goes through the scalar test.
+// --------------------------------------------------------
+unsigned int Frustum::CullSpheres(const float* centerX, const float* centerY, const float* centerZ,
+    const float* radius, unsigned int count, unsigned int* visibleIndices)
+{
+    unsigned int visibleCount = 0;
+    unsigned int i = 0;
+
+#if defined(SIMD_AVX2)
+    __m256 planeX8[6], planeY8[6], planeZ8[6], planeW8[6];
+    for (int p = 0; p < 6; p++)
+    {
+        planeX8[p] = _mm256_set1_ps(planes[p].x);
+        planeY8[p] = _mm256_set1_ps(planes[p].y);
+        planeZ8[p] = _mm256_set1_ps(planes[p].z);
+        planeW8[p] = _mm256_set1_ps(planes[p].w);
+    }
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(centerX + i);
+        __m256 y = _mm256_loadu_ps(centerY + i);
+        __m256 z = _mm256_loadu_ps(centerZ + i);
+        __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m256 d = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(planeX8[p], x), _mm256_mul_ps(planeY8[p], y)),
+                _mm256_add_ps(_mm256_mul_ps(planeZ8[p], z), planeW8[p]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negRadius, _CMP_GE_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(inside);
+        for (unsigned int lane = 0; mask != 0; lane++, mask >>= 1)
+        {
+            if (mask & 1)
+                visibleIndices[visibleCount++] = i + lane;
+        }
+    }
+#endif
+
+#if defined(SIMD_SSE)
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+    for (int p = 0; p < 6; p++)
+    {
+        planeX[p] = _mm_set1_ps(planes[p].x);
+        planeY[p] = _mm_set1_ps(planes[p].y);
+        planeZ[p] = _mm_set1_ps(planes[p].z);
+        planeW[p] = _mm_set1_ps(planes[p].w);
+    }
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(centerX + i);
+        __m128 y = _mm_loadu_ps(centerY + i);
+        __m128 z = _mm_loadu_ps(centerZ + i);
+        __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+
+        __m128 inside = _mm_cmpeq_ps(x, x); // all ones (unless NaN, which is culled anyway)
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 d = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negRadius));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (unsigned int lane = 0; mask != 0; lane++, mask >>= 1)
+        {
+            if (mask & 1)
+                visibleIndices[visibleCount++] = i + lane;
+        }
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        if (IntersectsSphere(XMFLOAT3(centerX[i], centerY[i], centerZ[i]), radius[i]))
+            visibleIndices[visibleCount++] = i;
+    }
+
+    return visibleCount;
+}
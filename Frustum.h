@@ -0,0 +1,33 @@
+#pragma once
+#include <DirectXMath.h>
+#include "SimdConfig.h"
+
+// --------------------------------------------------------
+// A view frustum as six inward-facing planes, pulled straight
+// out of a view * projection matrix.  Has no graphics API
+// dependencies so culling can be exercised on the CPU alone.
+// --------------------------------------------------------
+class Frustum
+{
+public:
+	Frustum();
+	Frustum(DirectX::XMFLOAT4X4 viewProjection);
+
+	void SetFromViewProjection(DirectX::XMFLOAT4X4 viewProjection);
+	DirectX::XMFLOAT4 GetPlane(int index);
+
+	//single sphere test
+	bool IntersectsSphere(DirectX::XMFLOAT3 center, float radius);
+
+	//batch test over spheres stored as separate x/y/z/radius arrays.
+	//Writes the indices of the spheres that touch the frustum to
+	//visibleIndices (which must hold count entries) and returns how many
+	unsigned int CullSpheres(const float* centerX, const float* centerY, const float* centerZ,
+		const float* radius, unsigned int count, unsigned int* visibleIndices);
+
+private:
+	// xyz = plane normal (pointing inside), w = distance
+	// Order: left, right, bottom, top, near, far
+	DirectX::XMFLOAT4 planes[6];
+};
+
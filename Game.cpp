@@ -4,31 +4,81 @@
 #include "Mesh.h"
 #include "Camera.h"
 #include <memory>
+#include <sstream>
+#include <fstream>
+#include <cstring>
 
-// Needed for a helper function to read compiled shader files from the hard drive
-#pragma comment(lib, "d3dcompiler.lib")
-#include <d3dcompiler.h>
+#ifndef ARRAYSIZE
+#define ARRAYSIZE(a) (sizeof(a) / sizeof(a[0]))
+#endif
 
 // For the DirectX Math library
 using namespace DirectX;
 
+// Pipeline ids used in render queue sort keys
+static const unsigned int DefaultShaderId = 0;
+static const unsigned int InstancedShaderId = 1;
+
+// Layout ids are the mesh's vertex layout id times two, plus one for the instanced layout
+static unsigned int GetLayoutId(unsigned int vertexLayoutId, bool instanced)
+{
+	return vertexLayoutId * 2 + (instanced ? 1 : 0);
+}
+
+// Render queue mesh ids are per mesh and LOD, so each LOD batches separately
+static unsigned int GetDrawId(unsigned int meshId, unsigned int lod)
+{
+	return meshId * MaxMeshLods + lod;
+}
+
+// Full-detail draws of meshes split into meshlets cull them one entity at a time
+static bool IsClustered(Mesh* mesh, unsigned int lod)
+{
+	return lod == 0 && mesh->GetMeshletCount() > 1;
+}
+
+// Most bytes of loaded meshes sent to the GPU per frame
+static const unsigned int MeshUploadBudget = 2 * 1024 * 1024;
+
+// The most a LOD's simplification may show on screen, in pixels
+static const float LodPixelError = 1.0f;
+
 // --------------------------------------------------------
 // Constructor
 //
 // DXCore (base class) constructor will set up underlying fields.
 // DirectX itself, and our window, are not ready yet!
 //
-// hInstance - the application's OS-level handle (unique ID)
+// platform - the OS layer (windowed or headless)
+// renderDevice - the graphics backend (D3D11 or null)
 // --------------------------------------------------------
-Game::Game(HINSTANCE hInstance)
+Game::Game(Platform* platform, RenderDevice* renderDevice)
 	: DXCore(
-		hInstance,		   // The application's handle
+		platform,		   // Window, messages, timing and paths
+		renderDevice,	   // What everything draws through
 		"DirectX Game",	   // Text for the window's title bar
 		1280,			   // Width of the window's client area
 		720,			   // Height of the window's client area
 		true),			   // Show extra stats (fps) in title bar?
 	vsync(false),
-	transform()
+	pixelShader(0),
+	vertexShader(0),
+	instancedVertexShader(0),
+	geometryPool(renderDevice),
+	assetLoader(&geometryPool),
+	meshCache(&geometryPool),
+	constantBufferPerFrame(0),
+	constantBufferVS(0),
+	instanceBuffer(0),
+	instanceBufferCapacity(0),
+	transform(),
+	visibleEntityCount(0),
+	entityBoundsStale(false),
+	bytesUploaded(0),
+	bufferUploads(0),
+	trianglesDrawn(0),
+	trianglesFullDetail(0),
+	meshletStats()
 {
 #if defined(DEBUG) || defined(_DEBUG)
 	// Do we want a console window?  Probably only in debug mode
@@ -46,10 +96,11 @@ Game::Game(HINSTANCE hInstance)
 // --------------------------------------------------------
 Game::~Game()
 {
-	// Note: Since we're using smart pointers (ComPtr),
-	// we don't need to explicitly clean up those DirectX objects
-	// - If we weren't using smart pointers, we'd need
-	//   to call Release() on each DirectX object created in Game
+	// Shaders and layouts live as long as the render device;
+	// buffers we made ourselves are handed back
+	renderDevice->ReleaseBuffer(constantBufferPerFrame);
+	renderDevice->ReleaseBuffer(constantBufferVS);
+	renderDevice->ReleaseBuffer(instanceBuffer);
 }
 
 // --------------------------------------------------------
@@ -64,99 +115,54 @@ void Game::Init()
 	//  - You'll be expanding and/or replacing these later
 	LoadShaders();
 	CreateBasicGeometry();
-	
-	// Tell the input assembler stage of the pipeline what kind of
-	// geometric primitives (points, lines or triangles) we want to draw.  
-	// Essentially: "What kind of shape should the GPU draw with our data?"
-	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-
-	// Get size as the next multiple of 16 (instead of hardcoding a size here!)  
-	unsigned int size = sizeof(VertexShaderExternalData);  
-	size = (size + 15) / 16 * 16; // This will work even if your struct size changes
-
-	// Describe the constant buffer  
-	D3D11_BUFFER_DESC cbDesc  = {}; // Sets struct to all zeros  
-	cbDesc.BindFlags  = D3D11_BIND_CONSTANT_BUFFER;  
-	cbDesc.ByteWidth  = size; // Must be a multiple of 16  
-	cbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;  
-	cbDesc.Usage    = D3D11_USAGE_DYNAMIC;
 
-	
-	device->CreateBuffer(&cbDesc, 0, constantBufferVS.GetAddressOf());
+	// Constant buffers are rewritten from the CPU every frame (the device
+	// rounds their size up to a multiple of 16)
+	constantBufferVS = renderDevice->CreateBuffer(ConstantBufferType, DynamicUsage, 0, sizeof(VertexShaderExternalData));
+
+	// Same again for the per-frame camera buffer shared by all vertex shaders
+	constantBufferPerFrame = renderDevice->CreateBuffer(ConstantBufferType, DynamicUsage, 0, sizeof(PerFrameVertexShaderData));
 
 	camera = std::make_shared<Camera>(DirectX::XM_1DIV2PI, 0.0f, 0.0f, -5.0f, (float)width / height);
 
 }
 
+// --------------------------------------------------------
+// Reads a whole file (compiled shader code, here) into memory.
+// Returns an empty vector if the file can't be opened, which
+// the null render device doesn't mind.
+// --------------------------------------------------------
+static std::vector<char> ReadFileBytes(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		return std::vector<char>();
+
+	std::vector<char> bytes((size_t)file.tellg());
+	file.seekg(0);
+	file.read(bytes.data(), bytes.size());
+	return bytes;
+}
+
 // --------------------------------------------------------
 // Loads shaders from compiled shader object (.cso) files
-// and also created the Input Layout that describes our 
-// vertex data to the rendering pipeline. 
-// - Input Layout creation is done here because it must 
-//    be verified against vertex shader byte code
-// - We'll have that byte code already loaded below
+// - The vertex shaders' byte code is kept, because input
+//    layouts must be verified against it (see GetInputLayout)
 // --------------------------------------------------------
 void Game::LoadShaders()
 {
-	// Blob for reading raw data
-	// - This is a simplified way of handling raw data
-	ID3DBlob* shaderBlob;
-
-	// Read our compiled vertex shader code into a blob
-	// - Essentially just "open the file and plop its contents here"
-	D3DReadFileToBlob(
-		GetFullPathTo_Wide(L"VertexShader.cso").c_str(), // Using a custom helper for file paths
-		&shaderBlob);
-
-	// Create a vertex shader from the information we
-	// have read into the blob above
-	// - A blob can give a pointer to its contents, and knows its own size
-	device->CreateVertexShader(
-		shaderBlob->GetBufferPointer(), // Get a pointer to the blob's contents
-		shaderBlob->GetBufferSize(),	// How big is that data?
-		0,								// No classes in this shader
-		vertexShader.GetAddressOf());	// The address of the ID3D11VertexShader*
-
-
-	// Create an input layout that describes the vertex format
-	// used by the vertex shader we're using
-	//  - This is used by the pipeline to know how to interpret the raw data
-	//     sitting inside a vertex buffer
-	//  - Doing this NOW because it requires a vertex shader's byte code to verify against!
-	//  - Luckily, we already have that loaded (the blob above)
-	D3D11_INPUT_ELEMENT_DESC inputElements[2] = {};
-
-	// Set up the first element - a position, which is 3 float values
-	inputElements[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;				// Most formats are described as color channels; really it just means "Three 32-bit floats"
-	inputElements[0].SemanticName = "POSITION";							// This is "POSITION" - needs to match the semantics in our vertex shader input!
-	inputElements[0].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;	// How far into the vertex is this?  Assume it's after the previous element
-
-	// Set up the second element - a color, which is 4 more float values
-	inputElements[1].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;			// 4x 32-bit floats
-	inputElements[1].SemanticName = "COLOR";							// Match our vertex shader input!
-	inputElements[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;	// After the previous element
-
-	// Create the input layout, verifying our description against actual shader code
-	device->CreateInputLayout(
-		inputElements,					// An array of descriptions
-		2,								// How many elements in that array
-		shaderBlob->GetBufferPointer(),	// Pointer to the code of a shader that uses this layout
-		shaderBlob->GetBufferSize(),	// Size of the shader code that uses this layout
-		inputLayout.GetAddressOf());	// Address of the resulting ID3D11InputLayout*
-
+	// Read our compiled vertex shader code and create a vertex shader from it
+	vertexShaderCode = ReadFileBytes(GetFullPathTo("VertexShader.cso"));
+	vertexShader = renderDevice->CreateVertexShader(vertexShaderCode.data(), vertexShaderCode.size());
 
+	// Read and create the instanced vertex shader, which takes
+	// its world matrix and tint from a second, per-instance buffer
+	instancedVertexShaderCode = ReadFileBytes(GetFullPathTo("InstancedVertexShader.cso"));
+	instancedVertexShader = renderDevice->CreateVertexShader(instancedVertexShaderCode.data(), instancedVertexShaderCode.size());
 
 	// Read and create the pixel shader
-	//  - Reusing the same blob here, since we're done with the vert shader code
-	D3DReadFileToBlob(
-		GetFullPathTo_Wide(L"PixelShader.cso").c_str(), // Using a custom helper for file paths
-		&shaderBlob);
-
-	device->CreatePixelShader(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		0,
-		pixelShader.GetAddressOf());
+	std::vector<char> shaderCode = ReadFileBytes(GetFullPathTo("PixelShader.cso"));
+	pixelShader = renderDevice->CreatePixelShader(shaderCode.data(), shaderCode.size());
 }
 
 
@@ -198,7 +204,9 @@ void Game::CreateBasicGeometry()
 	// - But just to see how it's done...
 	unsigned int indices[] = { 0, 1, 2 };
 
-	triangle = std::make_shared<Mesh>(vertices, ARRAYSIZE(vertices), indices, ARRAYSIZE(indices), device, context);
+	// 8-bit color is plenty for these, so they're stored as PackedVertex.  They come
+	// from the mesh cache, so generating the same shape twice only uploads it once
+	triangle = meshCache.GetMesh<PackedVertex>(vertices, ARRAYSIZE(vertices), indices, ARRAYSIZE(indices));
 	Vertex rectVertices[] =
 	{
 		{ XMFLOAT3(+0.25f, +0.75f, +0.0f), red },
@@ -207,7 +215,7 @@ void Game::CreateBasicGeometry()
 		{ XMFLOAT3(+0.5f, -0.25f, +0.0f), red }
 	};
 	unsigned int rectIndices[] = { 0, 1, 2, 2, 1, 3 };
-	rect = std::make_shared<Mesh>(rectVertices, ARRAYSIZE(rectVertices), rectIndices, ARRAYSIZE(rectIndices), device, context);
+	rect = meshCache.GetMesh<PackedVertex>(rectVertices, ARRAYSIZE(rectVertices), rectIndices, ARRAYSIZE(rectIndices));
 
 	Vertex pentaVertices[] =
 	{
@@ -218,17 +226,20 @@ void Game::CreateBasicGeometry()
 		{ XMFLOAT3(-0.75f, +0.25f, +0.0f), blue }
 	};
 	unsigned int pentaIndices[] = { 0, 1, 2, 2, 1, 3, 2, 4, 0 };
-	pentagon = std::make_shared<Mesh>(pentaVertices, ARRAYSIZE(pentaVertices), pentaIndices, ARRAYSIZE(pentaIndices), device, context);
-	std::shared_ptr<GameEntity> one = std::make_shared<GameEntity>(triangle);
-	entities.push_back(one);
-	std::shared_ptr<GameEntity> two = std::make_shared<GameEntity>(rect);
-	entities.push_back(two);
-	std::shared_ptr<GameEntity> three = std::make_shared<GameEntity>(pentagon);
-	entities.push_back(three);
-	std::shared_ptr<GameEntity> four = std::make_shared<GameEntity>(triangle);
-	entities.push_back(four);
-	std::shared_ptr<GameEntity> five = std::make_shared<GameEntity>(triangle);
-	entities.push_back(five);
+	pentagon = meshCache.GetMesh<PackedVertex>(pentaVertices, ARRAYSIZE(pentaVertices), pentaIndices, ARRAYSIZE(pentaIndices));
+
+	// Each entity is a transform (in the transform system), a mesh and a tint in the entity store
+	Mesh* entityMeshes[] = { triangle.get(), rect.get(), pentagon.get(), triangle.get(), triangle.get() };
+	for (unsigned int i = 0; i < ARRAYSIZE(entityMeshes); i++)
+		entities.push_back(CreateEntity(entityMeshes[i], XMFLOAT4(1.0f, 0.5f, 0.5f, 1.0f)));
+
+	// A baked model, read in the background - until it arrives (or if it's missing) this
+	// entity draws the loader's grey placeholder.  It doesn't move, so it's placed once here
+	octahedron = assetLoader.LoadMesh<PackedVertex>(GetFullPathTo("Models/Octahedron.mesh"));
+	entities.push_back(CreateEntity(octahedron.get(), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f)));
+	TransformSystem::Handle octahedronTransform = entityStore.Get<TransformComponent>(entities.back())->handle;
+	transformSystem.SetScale(octahedronTransform, .4f, .4f, .4f);
+	transformSystem.SetPosition(octahedronTransform, .75f, -.5f, 0);
 }
 
 
@@ -255,36 +266,432 @@ void Game::Update(float deltaTime, float totalTime)
 	if (Input::GetInstance().KeyDown(VK_ESCAPE))
 		Quit();
 
+	// Matrix rebuild/reuse counts are tracked per frame
+	Transform::ResetFrameStats();
+
+	TransformSystem::Handle transforms[5];
+	for (unsigned int i = 0; i < 5; i++)
+		transforms[i] = entityStore.Get<TransformComponent>(entities.at(i))->handle;
+
 	//manually changed different values to show off different combinations of scaling translations and rotations
 #pragma region entity drawing different transforms
 
 	//rotating in place
-	entities.at(0)->GetTransform()->SetScale(.5f, .5f,.5f);
-	entities.at(0)->GetTransform()->SetRotation( 0, 0, totalTime);
-	entities.at(0)->GetTransform()->SetPosition(.25, .25, .25);
+	transformSystem.SetScale(transforms[0], .5f, .5f,.5f);
+	transformSystem.SetRotation(transforms[0], 0, 0, totalTime);
+	transformSystem.SetPosition(transforms[0], .25, .25, .25);
 	
 	//rotating and scaling
-	entities.at(1)->GetTransform()->SetScale(1 - (sin(totalTime) * .5f), 1 - (sin(totalTime) * .5f), 1 - (cos(totalTime) * .5f));
-	entities.at(1)->GetTransform()->SetRotation(0, 0, cos(totalTime));
-	entities.at(1)->GetTransform()->SetPosition(-.25, -.25, 0);
+	transformSystem.SetScale(transforms[1], 1 - (sin(totalTime) * .5f), 1 - (sin(totalTime) * .5f), 1 - (cos(totalTime) * .5f));
+	transformSystem.SetRotation(transforms[1], 0, 0, cos(totalTime));
+	transformSystem.SetPosition(transforms[1], -.25, -.25, 0);
 
 	//moving and rotating
-	entities.at(2)->GetTransform()->SetScale(.5f, .5f, .5f);
-	entities.at(2)->GetTransform()->SetRotation(0, 0, cos(totalTime));
-	entities.at(2)->GetTransform()->SetPosition((sin(totalTime)), (sin(totalTime)), 0);
+	transformSystem.SetScale(transforms[2], .5f, .5f, .5f);
+	transformSystem.SetRotation(transforms[2], 0, 0, cos(totalTime));
+	transformSystem.SetPosition(transforms[2], (sin(totalTime)), (sin(totalTime)), 0);
 
 	//translation and scaling 
-	entities.at(3)->GetTransform()->SetScale(1 - (sin(totalTime) * .5), 1 - (sin(totalTime) * .5), 1 - (cos(totalTime) * .5));
-	entities.at(3)->GetTransform()->SetRotation(0, 0, 0);
-	entities.at(3)->GetTransform()->SetPosition(0, 1 - (sin(totalTime) * .5), 0);
+	transformSystem.SetScale(transforms[3], 1 - (sin(totalTime) * .5), 1 - (sin(totalTime) * .5), 1 - (cos(totalTime) * .5));
+	transformSystem.SetRotation(transforms[3], 0, 0, 0);
+	transformSystem.SetPosition(transforms[3], 0, 1 - (sin(totalTime) * .5), 0);
 
 	//scaling in only 2 directions
-	entities.at(4)->GetTransform()->SetScale(cos(totalTime), sin(totalTime), 1);
-	entities.at(4)->GetTransform()->SetRotation(0, 0, 0);
-	entities.at(4)->GetTransform()->SetPosition(-.5, .5, 0);
+	transformSystem.SetScale(transforms[4], cos(totalTime), sin(totalTime), 1);
+	transformSystem.SetRotation(transforms[4], 0, 0, 0);
+	transformSystem.SetPosition(transforms[4], -.5, .5, 0);
 
 	camera->Update(deltaTime);
 #pragma endregion
+
+	// Swap in any meshes the loader has finished reading - they bring their own bounds
+	if (assetLoader.Update(MeshUploadBudget) > 0)
+		entityBoundsStale = true;
+
+	// Batch-build the world matrices of every entity that moved
+	transformSystem.UpdateWorldMatrices();
+}
+
+// --------------------------------------------------------
+// Creates a drawable entity.  Its new transform is rebuilt
+// on the next update, which is when its bounds go into the
+// entity hierarchy, so its handle is mapped back to it here.
+// --------------------------------------------------------
+Entity Game::CreateEntity(Mesh* mesh, XMFLOAT4 tint)
+{
+	Entity entity = entityStore.Create(TransformComponent(&transformSystem), MeshComponent{ mesh }, TintComponent{ tint });
+	TransformComponent* transform = entityStore.Get<TransformComponent>(entity);
+	if (transform == 0)
+		return entity;
+
+	if (transform->handle >= transformEntities.size())
+		transformEntities.resize(transform->handle + 1, Entity());
+	transformEntities[transform->handle] = entity;
+	return entity;
+}
+
+// --------------------------------------------------------
+// Puts an entity's world bounding sphere, and the box
+// around it, where culling finds them
+// --------------------------------------------------------
+void Game::UpdateEntityBounds(Entity entity, TransformSystem::Handle transform, Mesh* mesh)
+{
+	unsigned int entityIndex = entity.GetIndex();
+	if (entityIndex >= boundsEntities.size())
+	{
+		boundsEntities.resize(entityIndex + 1, Entity());
+		entitySpheres.resize(entityIndex + 1);
+	}
+	boundsEntities[entityIndex] = entity;
+
+	XMFLOAT4 sphere = mesh->GetWorldBoundingSphere(transformSystem.GetWorldMatrix(transform));
+	entitySpheres[entityIndex] = sphere;
+	BvhBounds bounds =
+	{
+		{ sphere.x - sphere.w, sphere.y - sphere.w, sphere.z - sphere.w },
+		{ sphere.x + sphere.w, sphere.y + sphere.w, sphere.z + sphere.w }
+	};
+	entityBvh.SetBounds(entityIndex, bounds);
+}
+
+// --------------------------------------------------------
+// Refreshes the bounds of just the entities whose transforms
+// were rebuilt this frame (all of them, once, after the
+// loader swaps meshes in), so still entities cost nothing.
+// The entity hierarchy then finds what the frustum touches
+// without visiting most of what it doesn't, and only those
+// candidates are flattened into the draw arrays - mesh,
+// world matrix, tint and sphere - and batch-culled by sphere.
+// Fills visibleEntities with the survivors' indices into
+// those arrays.
+// --------------------------------------------------------
+void Game::CullEntities()
+{
+	if (entityBoundsStale)
+	{
+		entityStore.ForEachChunk<TransformComponent, MeshComponent, TintComponent>(
+			[&](unsigned int chunkCount, const Entity* chunkEntities, TransformComponent* transforms, MeshComponent* meshes, TintComponent*)
+		{
+			for (unsigned int i = 0; i < chunkCount; i++)
+				UpdateEntityBounds(chunkEntities[i], transforms[i].handle, meshes[i].mesh);
+		});
+		entityBoundsStale = false;
+	}
+	else
+	{
+		// Handles can outlive their entities (or be reused), so each is checked against the store
+		const std::vector<TransformSystem::Handle>& updated = transformSystem.GetUpdatedHandles();
+		for (size_t i = 0; i < updated.size(); i++)
+		{
+			if (updated[i] >= transformEntities.size())
+				continue;
+			Entity entity = transformEntities[updated[i]];
+			TransformComponent* transform = entityStore.Get<TransformComponent>(entity);
+			MeshComponent* mesh = entityStore.Get<MeshComponent>(entity);
+			if (transform != 0 && mesh != 0 && transform->handle == updated[i] && entityStore.Has<TintComponent>(entity))
+				UpdateEntityBounds(entity, updated[i], mesh->mesh);
+		}
+	}
+	entityBvh.Update();
+
+	Frustum frustum = camera->GetFrustum();
+	cullCandidates.clear();
+	entityBvh.QueryFrustum(frustum, cullCandidates);
+
+	// Destroyed entities are dropped from the hierarchy when a query first finds them
+	unsigned int count = 0;
+	drawMeshes.resize(cullCandidates.size());
+	drawWorldMatrices.resize(cullCandidates.size());
+	drawTints.resize(cullCandidates.size());
+	cullCenterX.resize(cullCandidates.size());
+	cullCenterY.resize(cullCandidates.size());
+	cullCenterZ.resize(cullCandidates.size());
+	cullRadius.resize(cullCandidates.size());
+	for (size_t i = 0; i < cullCandidates.size(); i++)
+	{
+		unsigned int entityIndex = cullCandidates[i];
+		Entity entity = boundsEntities[entityIndex];
+		TransformComponent* transform = entityStore.Get<TransformComponent>(entity);
+		MeshComponent* mesh = entityStore.Get<MeshComponent>(entity);
+		TintComponent* tint = entityStore.Get<TintComponent>(entity);
+		if (transform == 0 || mesh == 0 || tint == 0)
+		{
+			entityBvh.Remove(entityIndex);
+			continue;
+		}
+
+		drawMeshes[count] = mesh->mesh;
+		drawWorldMatrices[count] = transformSystem.GetWorldMatrix(transform->handle);
+		drawTints[count] = tint->color;
+		cullCenterX[count] = entitySpheres[entityIndex].x;
+		cullCenterY[count] = entitySpheres[entityIndex].y;
+		cullCenterZ[count] = entitySpheres[entityIndex].z;
+		cullRadius[count] = entitySpheres[entityIndex].w;
+		count++;
+	}
+
+	// The query's boxes hold the spheres, so the sphere test drops the corners
+	visibleEntities.resize(count);
+	visibleEntityCount = frustum.CullSpheres(cullCenterX.data(), cullCenterY.data(), cullCenterZ.data(), cullRadius.data(),
+		count, visibleEntities.data());
+}
+
+// --------------------------------------------------------
+// Submits every visible entity to the render queue and draws
+// it in key order.  Each entity gets the coarsest LOD whose
+// error, projected to the nearest point of its bounding
+// sphere, stays under LodPixelError.  Mesh LODs used by more
+// than one visible entity get the instanced pipeline's ids
+// in their keys, so after sorting they form contiguous runs
+// that each become a single instanced call (all of the
+// frame's instance data is uploaded with one Map).  Meshes
+// with meshlets are never instanced at full detail: each
+// entity culls its own clusters against the frustum and by
+// normal cone, and draws only the index ranges left.
+// Pipeline state and buffers are only re-bound when they
+// differ from what the state cache says is bound - meshes
+// share the geometry pool's buffers, so most draws bind none.
+// --------------------------------------------------------
+void Game::DrawVisibleEntities()
+{
+	// A local unit at view depth 1 covers this many pixels (the projection's y scale
+	// times half the screen height); it shrinks with depth and grows with scale
+	XMFLOAT4X4 view = camera->GetViewMatrix();
+	XMFLOAT4X4 projection = camera->GetProjectionMatrix();
+	float pixelsPerUnit = projection._22 * height * 0.5f;
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(XMLoadFloat4x4(&view), XMLoadFloat4x4(&projection)));
+	XMFLOAT3 cameraPosition = camera->GetTransform()->GetPosition();
+
+	// Pick each entity's LOD, and count visible users per mesh LOD to pick each draw's pipeline
+	visibleDrawIds.resize(visibleEntityCount);
+	visibleDepths.resize(visibleEntityCount);
+	for (unsigned int i = 0; i < visibleEntityCount; i++)
+	{
+		unsigned int entityIndex = visibleEntities[i];
+		Mesh* mesh = drawMeshes[entityIndex];
+		float depth =
+			cullCenterX[entityIndex] * view._13 +
+			cullCenterY[entityIndex] * view._23 +
+			cullCenterZ[entityIndex] * view._33 + view._43;
+
+		// Full detail once the camera is inside the bounding sphere's depth range
+		unsigned int lod = 0;
+		float nearest = depth - cullRadius[entityIndex];
+		if (nearest > 0 && mesh->GetSphereRadius() > 0)
+		{
+			float scale = cullRadius[entityIndex] / mesh->GetSphereRadius();
+			lod = mesh->SelectLod(scale * pixelsPerUnit / nearest, LodPixelError);
+		}
+
+		unsigned int drawId = GetDrawId(mesh->GetId(), lod);
+		if (drawId >= meshVisibleCount.size())
+			meshVisibleCount.resize(drawId + 1, 0);
+		meshVisibleCount[drawId]++;
+		visibleDrawIds[i] = drawId;
+		visibleDepths[i] = depth;
+	}
+
+	// Key each draw by pipeline, mesh LOD and view-space depth (front to back)
+	renderQueue.Clear();
+	for (unsigned int i = 0; i < visibleEntityCount; i++)
+	{
+		unsigned int entityIndex = visibleEntities[i];
+		bool instanced = meshVisibleCount[visibleDrawIds[i]] > 1 && !IsClustered(drawMeshes[entityIndex], visibleDrawIds[i] % MaxMeshLods);
+		renderQueue.Submit(RenderQueue::MakeKey(
+			instanced ? InstancedShaderId : DefaultShaderId,
+			GetLayoutId(drawMeshes[entityIndex]->GetVertexLayoutId(), instanced),
+			visibleDrawIds[i], visibleDepths[i]), entityIndex);
+	}
+	renderQueue.Sort();
+
+	for (unsigned int i = 0; i < visibleEntityCount; i++)
+		meshVisibleCount[visibleDrawIds[i]] = 0;
+
+	// Gather instance data in queue order, so each run is contiguous
+	unsigned int count = renderQueue.GetCount();
+	instanceData.clear();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (RenderQueue::GetShaderId(renderQueue.GetKey(i)) != InstancedShaderId)
+			continue;
+
+		InstanceData instance;
+		instance.worldMatrix = drawWorldMatrices[renderQueue.GetPayload(i)];
+		instance.colorTint = drawTints[renderQueue.GetPayload(i)];
+		instanceData.push_back(instance);
+	}
+
+	if (!instanceData.empty())
+	{
+		// Grow the instance buffer if this frame needs more room
+		if (instanceData.size() > instanceBufferCapacity)
+		{
+			instanceBufferCapacity *= 2;
+			if (instanceBufferCapacity < instanceData.size())
+				instanceBufferCapacity = (unsigned int)instanceData.size();
+
+			renderDevice->ReleaseBuffer(instanceBuffer);
+			instanceBuffer = renderDevice->CreateBuffer(VertexBufferType, DynamicUsage, 0, sizeof(InstanceData) * instanceBufferCapacity);
+		}
+
+		UploadBuffer(instanceBuffer, instanceData.data(), sizeof(InstanceData) * (unsigned int)instanceData.size());
+	}
+
+	// Walk the sorted queue, one draw per entity or per instanced run
+	unsigned int firstInstance = 0;
+	for (unsigned int start = 0; start < count;)
+	{
+		unsigned long long key = renderQueue.GetKey(start);
+		bool instanced = RenderQueue::GetShaderId(key) == InstancedShaderId;
+
+		// A run is every draw whose key differs only in depth
+		unsigned int end = start + 1;
+		if (instanced)
+		{
+			while (end < count && RenderQueue::SameBatch(renderQueue.GetKey(end), key))
+				end++;
+		}
+
+		Mesh* mesh = drawMeshes[renderQueue.GetPayload(start)];
+		unsigned int lod = RenderQueue::GetMeshId(key) % MaxMeshLods;
+		trianglesFullDetail += (unsigned long long)mesh->GetLod(0).indexCount / 3 * (end - start);
+
+		// Clustered meshes draw what's left of their meshlets, if anything
+		unsigned int rangeCount = 0;
+		if (IsClustered(mesh, lod))
+		{
+			unsigned int drawIndex = renderQueue.GetPayload(start);
+			rangeCount = mesh->CullMeshlets(drawWorldMatrices[drawIndex], viewProjection, cameraPosition, meshletRanges, &meshletStats);
+			if (rangeCount == 0)
+			{
+				start = end;
+				continue;
+			}
+			for (unsigned int r = 0; r < rangeCount; r++)
+				trianglesDrawn += meshletRanges[r].indexCount / 3;
+		}
+		else
+			trianglesDrawn += (unsigned long long)mesh->GetLod(lod).indexCount / 3 * (end - start);
+
+		ShaderHandle vs = instanced ? instancedVertexShader : vertexShader;
+		InputLayoutHandle layout = GetInputLayout(RenderQueue::GetLayoutId(key));
+
+		if (stateCache.Set(RenderStateCache::VertexShaderSlot, vs))
+			renderDevice->SetVertexShader(vs);
+		if (stateCache.Set(RenderStateCache::PixelShaderSlot, pixelShader))
+			renderDevice->SetPixelShader(pixelShader);
+		if (stateCache.Set(RenderStateCache::InputLayoutSlot, layout))
+			renderDevice->SetInputLayout(layout);
+
+		if (instanced)
+		{
+			mesh->DrawInstanced(&stateCache, instanceBuffer, end - start, firstInstance, lod);
+			firstInstance += end - start;
+		}
+		else
+		{
+			// Per-object constants (b1), then the mesh itself
+			unsigned int drawIndex = renderQueue.GetPayload(start);
+			VertexShaderExternalData vsData;
+			vsData.colorTint = drawTints[drawIndex];
+			vsData.worldMatrix = drawWorldMatrices[drawIndex];
+			UploadBuffer(constantBufferVS, &vsData, sizeof(vsData));
+			if (rangeCount > 0)
+				mesh->DrawRanges(&stateCache, meshletRanges.data(), rangeCount);
+			else
+				mesh->Draw(&stateCache, lod);
+		}
+		start = end;
+	}
+}
+
+// --------------------------------------------------------
+// Finds (or makes) the input layout for a render queue
+// layout id.  Instanced layouts add the per-instance data
+// (slot 1, which advances once per instance) after the
+// vertex type's own elements.
+//  - Input layouts must be verified against vertex shader byte code
+//  - Semantic names need to match the semantics in our vertex shader input!
+// --------------------------------------------------------
+InputLayoutHandle Game::GetInputLayout(unsigned int layoutId)
+{
+	if (layoutId >= inputLayouts.size())
+		inputLayouts.resize(layoutId + 1, 0);
+	if (inputLayouts[layoutId])
+		return inputLayouts[layoutId];
+
+	const VertexLayoutInfo& vertexLayout = GetVertexLayoutInfo(layoutId / 2);
+	std::vector<VertexElement> elements(vertexLayout.elements, vertexLayout.elements + vertexLayout.elementCount);
+	bool instanced = (layoutId & 1) != 0;
+	if (instanced)
+	{
+		VertexElement instanceElements[5] =
+		{
+			{ "WORLD", 0, FormatFloat4, 1, true },		// WORLD0 - WORLD3
+			{ "WORLD", 1, FormatFloat4, 1, true },
+			{ "WORLD", 2, FormatFloat4, 1, true },
+			{ "WORLD", 3, FormatFloat4, 1, true },
+			{ "TINT",  0, FormatFloat4, 1, true }
+		};
+		elements.insert(elements.end(), instanceElements, instanceElements + 5);
+	}
+
+	const std::vector<char>& shaderCode = instanced ? instancedVertexShaderCode : vertexShaderCode;
+	inputLayouts[layoutId] = renderDevice->CreateInputLayout(elements.data(), (unsigned int)elements.size(), shaderCode.data(), shaderCode.size());
+	return inputLayouts[layoutId];
+}
+
+// --------------------------------------------------------
+// Overwrites a dynamic buffer's contents and counts the bytes
+// --------------------------------------------------------
+void Game::UploadBuffer(BufferHandle buffer, const void* data, unsigned int size)
+{
+	memcpy(renderDevice->Map(buffer), data, size);
+	renderDevice->Unmap(buffer);
+
+	bytesUploaded += size;
+	bufferUploads++;
+}
+
+// --------------------------------------------------------
+// Reports how many world matrices were rebuilt vs. reused
+// last frame (entities' in the transform system, plus any
+// standalone Transforms like the camera's), how much
+// pipeline state the render queue bound vs. skipped as
+// redundant, how many
+// triangles LOD selection and meshlet culling left of the
+// full-detail count, how many meshlets were culled, how many
+// meshes are still loading, what the mesh cache saved, how
+// the entity hierarchy is holding up, and how full (and how
+// fragmented) the geometry pool is
+// --------------------------------------------------------
+std::string Game::GetTitleBarStats()
+{
+	GeometryPoolStats pool = geometryPool.GetStats();
+	AssetLoaderStats loading = assetLoader.GetStats();
+	MeshCacheStats cache = meshCache.GetStats();
+	BvhStats bvh = entityBvh.GetStats();
+	unsigned int systemRebuilt = transformSystem.GetMatricesRebuilt();
+	unsigned int systemCount = (unsigned int)transformSystem.GetCount();
+	unsigned int systemReused = systemCount > systemRebuilt ? systemCount - systemRebuilt : 0;
+	std::ostringstream output;
+	output << "    Matrices: " << Transform::GetMatricesRebuilt() + systemRebuilt << " rebuilt / " <<
+		Transform::GetMatricesReused() + systemReused << " reused" <<
+		"    State changes: " << stateCache.GetIssued() <<
+		" (" << stateCache.GetSkipped() << " skipped)" <<
+		"    Uploaded: " << bytesUploaded << " bytes in " << bufferUploads << " maps" <<
+		"    LOD triangles: " << trianglesDrawn << " of " << trianglesFullDetail <<
+		"    Meshlets: " << meshletStats.visible << " drawn, " << meshletStats.frustumCulled << " outside, " <<
+		meshletStats.backFacing << " facing away" <<
+		"    Loading: " << loading.queued + loading.ready << " meshes (" << loading.bytesUploaded << " bytes uploaded), " <<
+		loading.loaded << " loaded, " << loading.failed << " failed" <<
+		"    Mesh cache: " << cache.meshCount << " meshes, " << cache.hits << " hits, " << cache.bytesSaved << " bytes saved" <<
+		"    BVH: " << bvh.nodeCount << " nodes, " << bvh.nodesRefit << " refit, cost " << bvh.cost << " (built " << bvh.buildCost << ")" <<
+		(bvh.rebuilding ? ", rebuilding" : "") <<
+		"    Geometry: " << pool.usedBytes << "/" << pool.capacityBytes << " bytes in " << pool.bufferCount << " buffers, " <<
+		(int)(pool.fragmentation * 100.0f + 0.5f) << "% fragmented";
+	return output.str();
 }
 
 // --------------------------------------------------------
@@ -298,27 +705,35 @@ void Game::Draw(float deltaTime, float totalTime)
 	// Clear the render target and depth buffer (erases what's on the screen)
 	//  - Do this ONCE PER FRAME
 	//  - At the beginning of Draw (before drawing *anything*)
-	context->ClearRenderTargetView(backBufferRTV.Get(), color);
-	context->ClearDepthStencilView(
-		depthStencilView.Get(),
-		D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL,
-		1.0f,
-		0);
-	
+	renderDevice->BeginFrame(color);
 
-	//draws each entity meshes
-	for (int i = 0; i < entities.size(); i++)
-	{
-		entities.at(i)->Draw(context, constantBufferVS, depthStencilView, vertexShader, pixelShader, inputLayout, camera);
-	}
+	// Nothing bound before this point is tracked by the cache
+	stateCache.Reset();
+	stateCache.ResetStats();
+	bytesUploaded = 0;
+	bufferUploads = 0;
+	trianglesDrawn = 0;
+	trianglesFullDetail = 0;
+	meshletStats = MeshletCullStats();
+
+	// Camera data is the same for every draw, so upload and bind it once
+	// (b0), along with the per-object buffer every regular draw fills (b1)
+	XMFLOAT4X4 view = camera->GetViewMatrix();
+	XMFLOAT4X4 projection = camera->GetProjectionMatrix();
+	PerFrameVertexShaderData frameData;
+	XMStoreFloat4x4(&frameData.viewProjection, XMMatrixMultiply(XMLoadFloat4x4(&view), XMLoadFloat4x4(&projection)));
+	UploadBuffer(constantBufferPerFrame, &frameData, sizeof(frameData));
+
+	BufferHandle vsConstantBuffers[2] = { constantBufferPerFrame, constantBufferVS };
+	renderDevice->SetVSConstantBuffers(0, 2, vsConstantBuffers);
+
+	//draws each entity mesh that survived frustum culling
+	CullEntities();
+	DrawVisibleEntities();
 
 
 	// Present the back buffer to the user
 	//  - Puts the final frame we're drawing into the window so the user can see it
 	//  - Do this exactly ONCE PER FRAME (always at the very end of the frame)
-	swapChain->Present(vsync ? 1 : 0, 0);
-
-	// Due to the usage of a more sophisticated swap chain,
-	// the render target must be re-bound after every call to Present()
-	context->OMSetRenderTargets(1, backBufferRTV.GetAddressOf(), depthStencilView.Get());
+	renderDevice->Present(vsync);
 }
\ No newline at end of file
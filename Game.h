@@ -5,17 +5,24 @@
 #include <memory>
 #include <vector>
 #include "Mesh.h"
+#include "GeometryPool.h"
+#include "AssetLoader.h"
+#include "MeshCache.h"
 #include "BufferStructs.h"
-#include "GameEntity.h"
-#include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
+#include "EntityStore.h"
+#include "Components.h"
+#include "Transform.h"
 #include "Camera.h"
+#include "TransformSystem.h"
+#include "RenderQueue.h"
+#include "BoundingVolumeHierarchy.h"
 
 class Game 
 	: public DXCore
 {
 
 public:
-	Game(HINSTANCE hInstance);
+	Game(Platform* platform, RenderDevice* renderDevice);
 	~Game();
 
 	// Overridden setup and game loop methods, which
@@ -24,6 +31,7 @@ public:
 	void OnResize();
 	void Update(float deltaTime, float totalTime);
 	void Draw(float deltaTime, float totalTime);
+	std::string GetTitleBarStats();
 
 private:
 
@@ -33,27 +41,88 @@ private:
 	// Initialization helper methods - feel free to customize, combine, etc.
 	void LoadShaders(); 
 	void CreateBasicGeometry();
+	Entity CreateEntity(Mesh* mesh, DirectX::XMFLOAT4 tint);
+	void UpdateEntityBounds(Entity entity, TransformSystem::Handle transform, Mesh* mesh);
+	void CullEntities();
+	void DrawVisibleEntities();
+	InputLayoutHandle GetInputLayout(unsigned int layoutId);
 
-	// Note the usage of ComPtr below
-	//  - This is a smart pointer for objects that abide by the
-	//    Component Object Model, which DirectX objects do
-	//  - More info here: https://github.com/Microsoft/DirectXTK/wiki/ComPtr
-
-	// Buffers to hold actual geometry data
-	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
-	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
-	
-	// Shaders and shader-related constructs
-	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixelShader;
-	Microsoft::WRL::ComPtr<ID3D11VertexShader> vertexShader;
-	Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
+	// Shaders and shader-related constructs (handles from the render device)
+	ShaderHandle pixelShader;
+	ShaderHandle vertexShader;
+	ShaderHandle instancedVertexShader;
+	// Input layouts are made the first time a vertex type is drawn (indexed
+	// by render queue layout id), so the byte code they're checked against is kept
+	std::vector<InputLayoutHandle> inputLayouts;
+	std::vector<char> vertexShaderCode;
+	std::vector<char> instancedVertexShaderCode;
 
+	// Every mesh's vertices and indices (declared first, so it outlives them)
+	GeometryPool geometryPool;
+	// Mesh files read in the background, swapped in a few per frame (goes before the pool)
+	AssetLoader assetLoader;
+	// One mesh per distinct piece of geometry, however often it's asked for
+	MeshCache meshCache;
 	std::shared_ptr<Mesh> triangle;
 	std::shared_ptr<Mesh> rect;
 	std::shared_ptr<Mesh> pentagon;
-	std::vector<std::shared_ptr<GameEntity>> entities;
-	Microsoft::WRL::ComPtr<ID3D11Buffer> constantBufferVS;
+	std::shared_ptr<Mesh> octahedron;
+	TransformSystem transformSystem;
+	// Every entity is a TransformComponent + MeshComponent + TintComponent in the
+	// store.  Their transforms live in transformSystem, so it's declared first
+	EntityStore entityStore;
+	std::vector<Entity> entities;
+	BufferHandle constantBufferPerFrame;
+	BufferHandle constantBufferVS;
+
+	// Per-instance data for every instanced draw in a frame, uploaded with one Map
+	BufferHandle instanceBuffer;
+	unsigned int instanceBufferCapacity;
+	std::vector<InstanceData> instanceData;
 	std::shared_ptr<Camera> camera;
 	Transform transform;
+
+	// Per-frame culling scratch, kept around so it doesn't reallocate.
+	// The draw arrays hold the hierarchy's candidates, in query order
+	std::vector<unsigned int> cullCandidates;
+	std::vector<Mesh*> drawMeshes;
+	std::vector<DirectX::XMFLOAT4X4> drawWorldMatrices;
+	std::vector<DirectX::XMFLOAT4> drawTints;
+	std::vector<float> cullCenterX;
+	std::vector<float> cullCenterY;
+	std::vector<float> cullCenterZ;
+	std::vector<float> cullRadius;
+	std::vector<unsigned int> visibleEntities;
+	unsigned int visibleEntityCount;
+	// Every entity's world bounds, by entity index, kept up to date as transforms
+	// are rebuilt: its box in the hierarchy, its sphere, and which entity it is
+	// (so ones since destroyed are spotted).  transformEntities maps transform
+	// handles back to entities; entityBoundsStale means every entity needs
+	// refreshing, as loaded meshes have been swapped in with new bounds
+	BoundingVolumeHierarchy entityBvh;
+	std::vector<DirectX::XMFLOAT4> entitySpheres;
+	std::vector<Entity> boundsEntities;
+	std::vector<Entity> transformEntities;
+	bool entityBoundsStale;
+
+	// Sort-keyed draw list and the pipeline state it has bound this frame
+	RenderQueue renderQueue;
+	RenderStateCache stateCache;
+	// Indexed by render queue mesh id (mesh and LOD)
+	std::vector<unsigned int> meshVisibleCount;
+	// Per visible entity: its render queue mesh id and view-space depth
+	std::vector<unsigned int> visibleDrawIds;
+	std::vector<float> visibleDepths;
+
+	// Bytes written to GPU buffers (constant + instance) this frame
+	unsigned int bytesUploaded;
+	unsigned int bufferUploads;
+	// Triangles drawn this frame, and what they'd have been at full detail
+	unsigned long long trianglesDrawn;
+	unsigned long long trianglesFullDetail;
+	// Meshlet culling results this frame, and the index ranges of the current draw
+	MeshletCullStats meshletStats;
+	std::vector<MeshletRange> meshletRanges;
+	void UploadBuffer(BufferHandle buffer, const void* data, unsigned int size);
 };
 
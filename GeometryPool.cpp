@@ -0,0 +1,155 @@
+#include "GeometryPool.h"
+
+const unsigned int GeometryPool::DefaultPageSize;
+const unsigned int GeometryPool::FirstVertexArena;
+
+GeometryPool::GeometryPool(RenderDevice* renderDevice, unsigned int pageSize)
+{
+	this->renderDevice = renderDevice;
+	this->pageSize = pageSize;
+
+	arenas.resize(FirstVertexArena);
+	arenas[IndexFormat16].type = IndexBufferType;
+	arenas[IndexFormat16].elementSize = sizeof(unsigned short);
+	arenas[IndexFormat32].type = IndexBufferType;
+	arenas[IndexFormat32].elementSize = sizeof(unsigned int);
+}
+
+// --------------------------------------------------------
+// Every mesh should be gone by now - the pages go back to
+// the device whether or not anything is still in them
+// --------------------------------------------------------
+GeometryPool::~GeometryPool()
+{
+	for (size_t a = 0; a < arenas.size(); a++)
+	{
+		for (size_t p = 0; p < arenas[a].pages.size(); p++)
+			renderDevice->ReleaseBuffer(arenas[a].pages[p].buffer);
+	}
+}
+
+RenderDevice* GeometryPool::GetRenderDevice()
+{
+	return renderDevice;
+}
+
+bool GeometryPool::AllocateVertices(unsigned int vertexLayoutId, unsigned int stride, const void* vertices, unsigned int vertexCount, GeometryRange& range)
+{
+	unsigned int arenaIndex = FirstVertexArena + vertexLayoutId;
+	if (arenaIndex >= arenas.size())
+	{
+		Arena unused;
+		unused.type = VertexBufferType;
+		unused.elementSize = 0;
+		arenas.resize(arenaIndex + 1, unused);
+	}
+	arenas[arenaIndex].elementSize = stride;
+	return Allocate(arenaIndex, vertices, vertexCount, range);
+}
+
+bool GeometryPool::AllocateIndices(IndexFormat format, const void* indices, unsigned int indexCount, GeometryRange& range)
+{
+	return Allocate(format, indices, indexCount, range);
+}
+
+// --------------------------------------------------------
+// First page with a big enough free block wins, so meshes
+// pack into the oldest pages and the newest stay emptiest.
+// Failing that, a new page: pageSize bytes, or exactly
+// enough for the data if that's bigger.
+// --------------------------------------------------------
+bool GeometryPool::Allocate(unsigned int arenaIndex, const void* data, unsigned int count, GeometryRange& range)
+{
+	range.arena = arenaIndex;
+	range.page = 0;
+	range.offset = 0;
+	range.count = 0;
+	if (count == 0)
+		return true;
+
+	Arena& arena = arenas[arenaIndex];
+	unsigned int offset = 0;
+	size_t page = 0;
+	while (page < arena.pages.size() && !arena.pages[page].allocator.Allocate(count, offset))
+		page++;
+
+	if (page == arena.pages.size())
+	{
+		unsigned int capacity = pageSize / arena.elementSize;
+		if (capacity < count)
+			capacity = count;
+
+		Page newPage;
+		newPage.buffer = renderDevice->CreateBuffer(arena.type, DefaultUsage, 0, capacity * arena.elementSize);
+		if (newPage.buffer == 0)
+			return false;
+		newPage.allocator.Reset(capacity);
+		newPage.allocator.Allocate(count, offset);
+		arena.pages.push_back(newPage);
+	}
+
+	renderDevice->UpdateBuffer(arena.pages[page].buffer, offset * arena.elementSize, data, count * arena.elementSize);
+
+	range.page = (unsigned int)page;
+	range.offset = offset;
+	range.count = count;
+	return true;
+}
+
+void GeometryPool::Free(const GeometryRange& range)
+{
+	if (range.count == 0)
+		return;
+	arenas[range.arena].pages[range.page].allocator.Free(range.offset, range.count);
+}
+
+BufferHandle GeometryPool::GetBuffer(const GeometryRange& range)
+{
+	if (range.count == 0)
+		return 0;
+	return arenas[range.arena].pages[range.page].buffer;
+}
+
+unsigned int GeometryPool::GetStride(const GeometryRange& range)
+{
+	return arenas[range.arena].elementSize;
+}
+
+IndexFormat GeometryPool::GetIndexFormat(const GeometryRange& range)
+{
+	return range.arena == IndexFormat16 ? IndexFormat16 : IndexFormat32;
+}
+
+// --------------------------------------------------------
+// Sums every page.  Fragmentation counts free space that
+// isn't part of its page's largest free block - the space
+// a big allocation couldn't use without a new page.
+// --------------------------------------------------------
+GeometryPoolStats GeometryPool::GetStats()
+{
+	GeometryPoolStats stats = {};
+	unsigned long long freeBytes = 0;
+	unsigned long long strandedBytes = 0;
+
+	for (size_t a = 0; a < arenas.size(); a++)
+	{
+		Arena& arena = arenas[a];
+		for (size_t p = 0; p < arena.pages.size(); p++)
+		{
+			RangeAllocator& allocator = arena.pages[p].allocator;
+			unsigned long long capacity = (unsigned long long)allocator.GetCapacity() * arena.elementSize;
+			unsigned long long used = (unsigned long long)allocator.GetUsed() * arena.elementSize;
+
+			stats.bufferCount++;
+			stats.capacityBytes += capacity;
+			stats.usedBytes += used;
+			stats.freeBlocks += allocator.GetFreeBlockCount();
+			freeBytes += capacity - used;
+			strandedBytes += capacity - used - (unsigned long long)allocator.GetLargestFreeBlock() * arena.elementSize;
+		}
+	}
+
+	if (freeBytes > 0)
+		stats.fragmentation = (float)((double)strandedBytes / freeBytes);
+	return stats;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <vector>
+#include "RenderDevice.h"
+#include "RangeAllocator.h"
+
+// Where a mesh's vertices or indices live in a GeometryPool
+struct GeometryRange
+{
+	unsigned int arena;		// Which kind of buffer (an index format or vertex layout)
+	unsigned int page;		// Which buffer of that kind
+	unsigned int offset;	// First element (vertex or index) in the buffer
+	unsigned int count;
+};
+
+struct GeometryPoolStats
+{
+	unsigned int bufferCount;
+	unsigned long long capacityBytes;
+	unsigned long long usedBytes;
+	unsigned int freeBlocks;
+	// Share of the free space outside each buffer's largest free
+	// block - 0 when every buffer's free space is in one piece
+	float fragmentation;
+};
+
+// --------------------------------------------------------
+// Shared vertex and index buffers for every mesh.  Instead
+// of two small buffers per mesh, vertices go into big
+// buffers shared by everything with the same vertex layout
+// (and indices into ones shared by everything with the same
+// index format), and a mesh just remembers its ranges -
+// drawn with a base vertex and first index.  Consecutive
+// draws from the same buffers then need no rebinding.
+//
+// Each buffer ("page") is pageSize bytes, sub-allocated by a
+// RangeAllocator; a new page is made when none has room, and
+// anything bigger than a page gets one of its own.  Pages are
+// default-usage buffers filled with UpdateBuffer(), so only
+// the allocated range is written.  Pages stay around when
+// emptied, to be reused.
+// --------------------------------------------------------
+class GeometryPool
+{
+public:
+	// Default bytes per buffer
+	static const unsigned int DefaultPageSize = 4 * 1024 * 1024;
+
+	GeometryPool(RenderDevice* renderDevice, unsigned int pageSize = DefaultPageSize);
+	~GeometryPool();
+	GeometryPool(const GeometryPool&) = delete;
+	GeometryPool& operator=(const GeometryPool&) = delete;
+
+	RenderDevice* GetRenderDevice();
+
+	//copies data into a free range - false (with an empty range) if the device couldn't make a buffer for it.
+	//Vertices are stride bytes each, and every vertex of one layout id must have the same stride
+	bool AllocateVertices(unsigned int vertexLayoutId, unsigned int stride, const void* vertices, unsigned int vertexCount, GeometryRange& range);
+	bool AllocateIndices(IndexFormat format, const void* indices, unsigned int indexCount, GeometryRange& range);
+	void Free(const GeometryRange& range);
+
+	//the buffer a range is in (0 for an empty range), and how its elements are read
+	BufferHandle GetBuffer(const GeometryRange& range);
+	unsigned int GetStride(const GeometryRange& range);
+	IndexFormat GetIndexFormat(const GeometryRange& range);
+
+	GeometryPoolStats GetStats();
+
+private:
+	struct Page
+	{
+		BufferHandle buffer;
+		RangeAllocator allocator;
+	};
+
+	struct Arena
+	{
+		BufferType type;
+		unsigned int elementSize;	// Vertex stride or index size (0 while unused)
+		std::vector<Page> pages;
+	};
+
+	// Arena 0 is 16-bit indices, 1 is 32-bit, and 2 + n is vertex layout n
+	static const unsigned int FirstVertexArena = 2;
+
+	RenderDevice* renderDevice;
+	unsigned int pageSize;
+	std::vector<Arena> arenas;
+
+	bool Allocate(unsigned int arenaIndex, const void* data, unsigned int count, GeometryRange& range);
+};
@@ -0,0 +1,163 @@
+#include "HeadlessPlatform.h"
+#include "Input.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+HeadlessPlatform::HeadlessPlatform()
+{
+	this->startTime = std::chrono::steady_clock::now();
+	this->quitRequested = false;
+	this->exitCode = 0;
+}
+
+// --------------------------------------------------------
+// There's no window to make - the requested size is just
+// reported back as if one had been created
+// --------------------------------------------------------
+bool HeadlessPlatform::CreateAppWindow(const std::string& title, unsigned int width, unsigned int height)
+{
+	if (listener)
+		listener->OnWindowResized(width, height);
+	return true;
+}
+
+bool HeadlessPlatform::HasWindow()
+{
+	return false;
+}
+
+void* HeadlessPlatform::GetNativeWindowHandle()
+{
+	return 0;
+}
+
+void HeadlessPlatform::SetWindowTitle(const std::string& title)
+{
+	printf("%s\n", title.c_str());
+}
+
+// --------------------------------------------------------
+// Delivers the queued synthetic events in the order they
+// were posted
+// --------------------------------------------------------
+bool HeadlessPlatform::PumpMessages()
+{
+	for (size_t i = 0; i < pendingEvents.size(); i++)
+	{
+		const Event& e = pendingEvents[i];
+		switch (e.type)
+		{
+		case ResizeEvent:
+			if (listener)
+				listener->OnWindowResized((unsigned int)e.a, (unsigned int)e.b);
+			break;
+		case FocusEvent:
+			if (listener)
+				listener->OnFocusChanged(e.a != 0);
+			break;
+		case MouseWheelEvent:
+			Input::GetInstance().SetWheelDelta(e.value);
+			break;
+		case KeyEvent:
+			Input::GetInstance().SetKey(e.a, e.b != 0);
+			break;
+		case QuitEvent:
+			quitRequested = true;
+			exitCode = e.a;
+			break;
+		}
+	}
+	pendingEvents.clear();
+
+	return !quitRequested;
+}
+
+void HeadlessPlatform::RequestQuit()
+{
+	PostQuit(0);
+}
+
+int HeadlessPlatform::GetExitCode()
+{
+	return exitCode;
+}
+
+double HeadlessPlatform::GetTimeSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// --------------------------------------------------------
+// Finds the executable's folder, falling back to the
+// current directory if the OS won't say
+// --------------------------------------------------------
+std::string HeadlessPlatform::GetExePath()
+{
+	char currentDir[1024] = {};
+#ifdef _WIN32
+	GetModuleFileName(0, currentDir, 1024);
+#else
+	ssize_t length = readlink("/proc/self/exe", currentDir, sizeof(currentDir) - 1);
+	if (length <= 0)
+		return ".";
+	currentDir[length] = 0;
+#endif
+
+	char* lastSlash = strrchr(currentDir, GetPathSeparator());
+	if (!lastSlash)
+		return ".";
+
+	*lastSlash = 0;
+	return currentDir;
+}
+
+char HeadlessPlatform::GetPathSeparator()
+{
+#ifdef _WIN32
+	return '\\';
+#else
+	return '/';
+#endif
+}
+
+void HeadlessPlatform::PostResize(unsigned int width, unsigned int height)
+{
+	PostEvent(ResizeEvent, (int)width, (int)height, 0.0f);
+}
+
+void HeadlessPlatform::PostFocus(bool focused)
+{
+	PostEvent(FocusEvent, focused ? 1 : 0, 0, 0.0f);
+}
+
+void HeadlessPlatform::PostMouseWheel(float delta)
+{
+	PostEvent(MouseWheelEvent, 0, 0, delta);
+}
+
+void HeadlessPlatform::PostKey(int key, bool down)
+{
+	PostEvent(KeyEvent, key, down ? 1 : 0, 0.0f);
+}
+
+void HeadlessPlatform::PostQuit(int exitCode)
+{
+	PostEvent(QuitEvent, exitCode, 0, 0.0f);
+}
+
+void HeadlessPlatform::PostEvent(EventType type, int a, int b, float value)
+{
+	Event e;
+	e.type = type;
+	e.a = a;
+	e.b = b;
+	e.value = value;
+	pendingEvents.push_back(e);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include "Platform.h"
+
+// --------------------------------------------------------
+// A platform with no window, so the frame loop can run on
+// machines without a display (benchmarks, CI, Linux).
+//
+// Instead of OS messages, events are queued up front with
+// the Post*() methods and delivered by the next
+// PumpMessages(), just like a real pump would.  Title bar
+// updates are printed to stdout.
+// --------------------------------------------------------
+class HeadlessPlatform : public Platform
+{
+public:
+	HeadlessPlatform();
+
+	bool CreateAppWindow(const std::string& title, unsigned int width, unsigned int height);
+	bool HasWindow();
+	void* GetNativeWindowHandle();
+	void SetWindowTitle(const std::string& title);
+
+	bool PumpMessages();
+	void RequestQuit();
+	int GetExitCode();
+
+	double GetTimeSeconds();
+
+	std::string GetExePath();
+	char GetPathSeparator();
+
+	//synthetic events, delivered on the next PumpMessages()
+	void PostResize(unsigned int width, unsigned int height);
+	void PostFocus(bool focused);
+	void PostMouseWheel(float delta);
+	void PostKey(int key, bool down);
+	void PostQuit(int exitCode);
+
+private:
+	enum EventType
+	{
+		ResizeEvent,
+		FocusEvent,
+		MouseWheelEvent,
+		KeyEvent,
+		QuitEvent
+	};
+
+	struct Event
+	{
+		EventType type;
+		int a;
+		int b;
+		float value;
+	};
+
+	std::vector<Event> pendingEvents;
+	std::chrono::steady_clock::time_point startTime;
+	bool quitRequested;
+	int exitCode;
+
+	void PostEvent(EventType type, int a, int b, float value);
+};
@@ -1,4 +1,5 @@
 #include "Input.h"
+#include <cstring>
 
 // Singleton requirement
 Input* Input::instance;
@@ -62,6 +63,7 @@ Input::~Input()
 {
 	delete[] kbState;
 	delete[] prevKbState;
+	delete[] syntheticKbState;
 }
 
 // ---------------------------------------------------
@@ -70,14 +72,17 @@ Input::~Input()
 //
 //  windowHandle - the handle (id) of the window,
 //                 which is necessary for mouse input
+//                 (0 when running headless)
 // ---------------------------------------------------
-void Input::Initialize(HWND windowHandle)
+void Input::Initialize(void* windowHandle)
 {
 	kbState = new unsigned char[256];
 	prevKbState = new unsigned char[256];
+	syntheticKbState = new unsigned char[256];
 
 	memset(kbState, 0, sizeof(unsigned char) * 256);
 	memset(prevKbState, 0, sizeof(unsigned char) * 256);
+	memset(syntheticKbState, 0, sizeof(unsigned char) * 256);
 
 	wheelDelta = 0.0f;
 	mouseX = 0; mouseY = 0;
@@ -97,22 +102,35 @@ void Input::Update()
 	// Copy the old keys so we have last frame's data
 	memcpy(prevKbState, kbState, sizeof(unsigned char) * 256);
 
-	// Get the latest keys (from Windows)
-	// Note the use of (void), which denotes to the compiler
-	// that we're intentionally ignoring the return value
-	(void)GetKeyboardState(kbState);
-
-	// Get the current mouse position then make it relative to the window
-	POINT mousePos = {};
-	GetCursorPos(&mousePos);
-	ScreenToClient(windowHandle, &mousePos);
-
-	// Save the previous mouse position, then the current mouse 
-	// position and finally calculate the change from the previous frame
+	// Save the previous mouse position
 	prevMouseX = mouseX;
 	prevMouseY = mouseY;
-	mouseX = mousePos.x;
-	mouseY = mousePos.y;
+
+	bool polled = false;
+#ifdef _WIN32
+	if (windowHandle != 0)
+	{
+		// Get the latest keys (from Windows)
+		// Note the use of (void), which denotes to the compiler
+		// that we're intentionally ignoring the return value
+		(void)GetKeyboardState(kbState);
+
+		// Get the current mouse position then make it relative to the window
+		POINT mousePos = {};
+		GetCursorPos(&mousePos);
+		ScreenToClient((HWND)windowHandle, &mousePos);
+		mouseX = mousePos.x;
+		mouseY = mousePos.y;
+		polled = true;
+	}
+#endif
+
+	// Without a window (headless) there's nothing to poll, so
+	// the keys are whatever SetKey() has posted
+	if (!polled)
+		memcpy(kbState, syntheticKbState, sizeof(unsigned char) * 256);
+
+	// Calculate the change from the previous frame
 	mouseXDelta = mouseX - prevMouseX;
 	mouseYDelta = mouseY - prevMouseY;
 }
@@ -163,6 +181,18 @@ void Input::SetWheelDelta(float delta)
 	wheelDelta = delta;
 }
 
+// ----------------------------------------------------------
+//  Sets a key's state for synthetic (headless) input.  Takes
+//  effect on the next Update(), like a real key would, and
+//  is ignored while there's a window to poll instead
+// ----------------------------------------------------------
+void Input::SetKey(int key, bool down)
+{
+	if (key < 0 || key > 255) return;
+
+	syntheticKbState[key] = down ? 0x80 : 0;
+}
+
 
 // ----------------------------------------------------------
 //  Is the given key down this frame?
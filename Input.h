@@ -1,6 +1,19 @@
 #pragma once
 
+#ifdef _WIN32
 #include <Windows.h>
+#else
+// The Win32 virtual key codes Input and the game rely on, so
+// headless builds can use the same names without Windows.h
+#define VK_LBUTTON	0x01
+#define VK_RBUTTON	0x02
+#define VK_MBUTTON	0x04
+#define VK_TAB		0x09
+#define VK_SHIFT	0x10
+#define VK_CONTROL	0x11
+#define VK_ESCAPE	0x1B
+#define VK_SPACE	0x20
+#endif
 
 class Input
 {
@@ -29,7 +42,9 @@ private:
 public:
 	~Input();
 
-	void Initialize(HWND windowHandle);
+	// windowHandle is an HWND on Windows, or 0 with no window, in
+	// which case keys only change through SetKey()
+	void Initialize(void* windowHandle);
 	void Update();
 	void EndOfFrame();
 
@@ -39,6 +54,7 @@ public:
 	int GetMouseYDelta();
 	float GetMouseWheel();
 	void SetWheelDelta(float delta);
+	void SetKey(int key, bool down);
 
 	bool KeyDown(int key);
 	bool KeyUp(int key);
@@ -70,6 +86,10 @@ private:
 	unsigned char* kbState {0};
 	unsigned char* prevKbState {0};
 
+	// Key states from SetKey(), copied in by Update() when
+	// there's no window to poll
+	unsigned char* syntheticKbState {0};
+
 	// Mouse position and wheel data
 	int mouseX {0};
 	int mouseY {0};
@@ -81,6 +101,6 @@ private:
 
 	// The window's handle (id) from the OS, so
 	// we can get the cursor's position
-	HWND windowHandle {0};
+	void* windowHandle {0};
 };
 
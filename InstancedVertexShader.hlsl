@@ -0,0 +1,58 @@
+
+// Camera data, set once per frame (shared with VertexShader.hlsl)
+cbuffer PerFrame : register(b0)
+{
+	matrix viewProjection;
+}
+
+// Same per-vertex data as VertexShader.hlsl, plus the per-instance
+// data streamed from a second vertex buffer (input slot 1)
+// - The world matrix arrives as four float4 rows
+// - Must match InstanceData in BufferStructs.h
+struct VertexShaderInput
+{ 
+	// Data type
+	//  |
+	//  |   Name          Semantic
+	//  |    |                |
+	//  v    v                v
+	float3 localPosition	: POSITION;     // XYZ position
+	float4 color			: COLOR;        // RGBA color
+	float4 world0			: WORLD0;       // Instance world matrix, row 0
+	float4 world1			: WORLD1;       // Instance world matrix, row 1
+	float4 world2			: WORLD2;       // Instance world matrix, row 2
+	float4 world3			: WORLD3;       // Instance world matrix, row 3
+	float4 colorTint		: TINT;         // Instance color tint
+};
+
+// Must match the pixel shader's input
+struct VertexToPixel
+{
+	float4 screenPosition	: SV_POSITION;	// XYZW position (System Value Position)
+	float4 color			: COLOR;        // RGBA color
+};
+
+// --------------------------------------------------------
+// Instanced version of VertexShader.hlsl
+// 
+// - The world matrix and tint come from the instance buffer
+//   instead of the constant buffer, so one draw call can place
+//   every copy of a mesh
+// - The rows are built into a real (row-major) matrix, so the
+//   position is multiplied as a row vector first, then handed
+//   to viewProjection the same way VertexShader.hlsl does
+// --------------------------------------------------------
+VertexToPixel main( VertexShaderInput input )
+{
+	// Set up output struct
+	VertexToPixel output;
+
+	float4x4 world = float4x4(input.world0, input.world1, input.world2, input.world3);
+	float4 worldPosition = mul(float4(input.localPosition, 1.0f), world);
+	output.screenPosition = mul(viewProjection, worldPosition);
+
+	// Pass the tinted color through to be interpolated
+	output.color = input.color * input.colorTint;
+
+	return output;
+}
@@ -1,7 +1,93 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "Game.h"
+#include "HeadlessPlatform.h"
+#include "NullRenderDevice.h"
+#include "SoftwareRenderDevice.h"
 
+#ifdef _WIN32
 #include <Windows.h>
-#include "Game.h"
+#include "Win32Platform.h"
+#include "D3D11RenderDevice.h"
+#endif
 
+// Frames to run headless when no count is given
+static const unsigned int DefaultHeadlessFrames = 1000;
+
+// --------------------------------------------------------
+// Reads the command line and runs the game on whichever
+// platform and render device it asks for.  windowedPlatform
+// and gpuDevice are the Win32 window and D3D11, or null where
+// those don't exist - the game then always runs headless, and
+// draws with the software rasterizer unless told otherwise.
+//
+//  -headless [frames]	no window, a fixed number of frames (benchmarks,
+//						CI), printing the stats that would go in the title bar
+//  -nullrender			records draws instead of drawing them, so the CPU
+//						side of the frame can be measured without a GPU
+//  -software			draws with the CPU rasterizer (offscreen)
+//  -capture file.ppm	saves the software rasterizer's last frame on the way out
+// --------------------------------------------------------
+static int RunGame(const std::string& commandLine, Platform* windowedPlatform, RenderDevice* gpuDevice)
+{
+	const char* arguments = commandLine.c_str();
+	const char* headlessArg = strstr(arguments, "-headless");
+	bool headless = headlessArg != 0 || windowedPlatform == 0;
+	unsigned int frameLimit = 0;
+	if (headless)
+	{
+		if (headlessArg)
+			frameLimit = (unsigned int)strtoul(headlessArg + strlen("-headless"), 0, 10);
+		if (frameLimit == 0)
+			frameLimit = DefaultHeadlessFrames;
+	}
+
+	bool nullRender = strstr(arguments, "-nullrender") != 0;
+	bool softwareRender = !nullRender && (strstr(arguments, "-software") != 0 || gpuDevice == 0);
+
+	std::string capturePath;
+	const char* captureArg = strstr(arguments, "-capture");
+	if (captureArg)
+	{
+		const char* path = captureArg + strlen("-capture");
+		path += strspn(path, " \t");
+		capturePath.assign(path, strcspn(path, " \t"));
+	}
+
+	// Create the Game object on top of whichever
+	// platform and render device we're using
+	HeadlessPlatform headlessPlatform;
+	NullRenderDevice nullDevice;
+	SoftwareRenderDevice softwareDevice;
+	RenderDevice* renderDevice = gpuDevice;
+	if (nullRender)
+		renderDevice = &nullDevice;
+	else if (softwareRender)
+		renderDevice = &softwareDevice;
+
+	Game dxGame(headless ? &headlessPlatform : windowedPlatform, renderDevice);
+
+	// Attempt to create the window for our program, and
+	// exit early if something failed
+	if (!dxGame.InitWindow()) return -1;
+
+	// Attempt to initialize the render device, and exit
+	// early if something failed
+	if (!dxGame.InitRenderDevice()) return -1;
+
+	// Begin the message and game loop, and then return
+	// whatever we get back once the game loop is over
+	int result = dxGame.Run(frameLimit);
+
+	if (softwareRender && !capturePath.empty())
+		softwareDevice.WriteImage(capturePath.c_str());
+
+	return result;
+}
+
+#ifdef _WIN32
 // --------------------------------------------------------
 // Entry point for a graphical (non-console) Windows application
 // --------------------------------------------------------
@@ -18,24 +104,24 @@ int WINAPI WinMain(
 	_CrtSetDbgFlag( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF );
 #endif
 
-	// Create the Game object using
-	// the app handle we got from WinMain
-	Game dxGame(hInstance);
-
-	// Result variable for function calls below
-	HRESULT hr = S_OK;
-
-	// Attempt to create the window for our program, and
-	// exit early if something failed
-	hr = dxGame.InitWindow();
-	if(FAILED(hr)) return hr;
-
-	// Attempt to initialize DirectX, and exit
-	// early if something failed
-	hr = dxGame.InitDirectX();
-	if(FAILED(hr)) return hr;
-
-	// Begin the message and game loop, and then return
-	// whatever we get back once the game loop is over
-	return dxGame.Run();
+	Win32Platform windowedPlatform(hInstance);
+	D3D11RenderDevice d3d11Device;
+	return RunGame(lpCmdLine, &windowedPlatform, &d3d11Device);
 }
+#else
+// --------------------------------------------------------
+// Entry point everywhere else.  There's no window or D3D11
+// there, so the game always runs headless (see RunGame)
+// --------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	std::string commandLine;
+	for (int i = 1; i < argc; i++)
+	{
+		if (i > 1)
+			commandLine += ' ';
+		commandLine += argv[i];
+	}
+	return RunGame(commandLine, 0, 0);
+}
+#endif
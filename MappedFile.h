@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+// --------------------------------------------------------
+// A read-only view of a whole file, mapped into memory.
+// Nothing is read up front - pages come in from the OS file
+// cache as they're touched, and no copy of the data is made.
+// --------------------------------------------------------
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	//maps the file (closing any previous one); false if it can't be opened or is empty
+	bool Open(const std::string& path);
+	void Close();
+
+	//null / 0 while nothing is mapped
+	const void* GetData();
+	size_t GetSize();
+
+private:
+#if defined(_WIN32)
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+	const void* data;
+	size_t size;
+};
@@ -1,52 +1,150 @@
 #include "Mesh.h"
+#include "BufferStructs.h"
+#include "Frustum.h"
+#include <cmath>
+#include <cstddef>
+#include <utility>
 
-Mesh::Mesh(Vertex* vertexArray, unsigned long long vertexNum, unsigned int* indices, unsigned long long indiceNum, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
+unsigned int Mesh::nextId = 0;
+
+// --------------------------------------------------------
+// For procedural geometry.  Indices are narrowed to 16 bits
+// when every one fits - half the index bandwidth for any mesh
+// under 65,536 vertices.  They're relative to the mesh's own
+// vertices (the draw adds the base vertex), so that holds
+// however full the pool's vertex buffer is.
+// --------------------------------------------------------
+Mesh::Mesh(const Vertex* vertexArray, unsigned long long vertexNum, const unsigned int* indices, unsigned long long indiceNum,
+	const MeshBounds* bounds, const MeshLod* lods, unsigned int lodCount, unsigned int vertexLayoutId, GeometryPool* geometryPool)
 {
-	indiceNumber = indiceNum;
-	
-	D3D11_BUFFER_DESC vbd = {};
-	vbd.Usage = D3D11_USAGE_IMMUTABLE;
-	vbd.ByteWidth = sizeof(Vertex) * vertexNum;       // 3 = number of vertices in the buffer
-	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER; // Tells DirectX this is a vertex buffer
-	vbd.CPUAccessFlags = 0;
-	vbd.MiscFlags = 0;
-	vbd.StructureByteStride = 0;
+	Init(bounds ? *bounds : CalculateBounds(vertexArray, vertexNum), lods, lodCount, indiceNum, vertexLayoutId, geometryPool);
 
+	unsigned int maxIndex = 0;
+	for (unsigned long long i = 0; i < indiceNum; i++)
+	{
+		if (indices[i] > maxIndex)
+			maxIndex = indices[i];
+	}
 
-	D3D11_SUBRESOURCE_DATA initialVertexData = {};
-	initialVertexData.pSysMem = vertexArray;
+	if (maxIndex <= 0xFFFF)
+	{
+		std::vector<unsigned short> shortIndices(indices, indices + indiceNum);
+		CreateIndexBuffer(shortIndices.data(), IndexFormat16);
+	}
+	else
+		CreateIndexBuffer(indices, IndexFormat32);
+}
 
+// --------------------------------------------------------
+// For baked meshes: precomputed bounds and LODs mean nothing
+// has to scan the vertices, and the indices are already in
+// the format they're drawn in, so they go to the pool as
+// they are - the arrays can point straight into a memory-
+// mapped file.
+// --------------------------------------------------------
+Mesh::Mesh(const void* indices, IndexFormat indexFormat, unsigned long long indiceNum,
+	const MeshBounds& bounds, const MeshLod* lods, unsigned int lodCount, unsigned int vertexLayoutId, GeometryPool* geometryPool)
+{
+	Init(bounds, lods, lodCount, indiceNum, vertexLayoutId, geometryPool);
+	CreateIndexBuffer(indices, indexFormat);
+}
 
-	device->CreateBuffer(&vbd, &initialVertexData, vertexBuffer.GetAddressOf());
+void Mesh::Init(const MeshBounds& bounds, const MeshLod* lods, unsigned int lodCount, unsigned long long indiceNum,
+	unsigned int vertexLayoutId, GeometryPool* geometryPool)
+{
+	this->geometryPool = geometryPool;
+	this->renderDevice = geometryPool->GetRenderDevice();
+	this->vertexLayoutId = vertexLayoutId;
+	this->vertexRange = GeometryRange();
+	this->bounds = bounds;
+
+	if (lodCount == 0)
+	{
+		MeshLod lod = { 0, (unsigned int)indiceNum, 0.0f };
+		this->lods.push_back(lod);
+	}
+	else
+		this->lods.assign(lods, lods + (lodCount < MaxMeshLods ? lodCount : MaxMeshLods));
 
-	D3D11_BUFFER_DESC ibd = {};
-	ibd.Usage = D3D11_USAGE_IMMUTABLE;
-	ibd.ByteWidth = sizeof(unsigned int) * indiceNum;	// 3 = number of indices in the buffer
-	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;	// Tells DirectX this is an index buffer
-	ibd.CPUAccessFlags = 0;
-	ibd.MiscFlags = 0;
-	ibd.StructureByteStride = 0;
+	indiceNumber = (int)indiceNum;
+	id = nextId++;
+}
 
-	D3D11_SUBRESOURCE_DATA initialIndexData = {};
-	initialIndexData.pSysMem = indices;
+void Mesh::CreateIndexBuffer(const void* indices, IndexFormat indexFormat)
+{
+	this->indexFormat = indexFormat;
+	if (!geometryPool->AllocateIndices(indexFormat, indices, (unsigned int)indiceNumber, indexRange))
+		MakeEmpty();
+}
 
-	device->CreateBuffer(&ibd, &initialIndexData, indexBuffer.GetAddressOf());
+// --------------------------------------------------------
+// What a mesh becomes when the pool can't make room for its
+// geometry: no ranges, no indices and no meshlets, so it
+// draws nothing and has nothing to give back
+// --------------------------------------------------------
+void Mesh::MakeEmpty()
+{
+	geometryPool->Free(vertexRange);
+	geometryPool->Free(indexRange);
+	vertexRange = GeometryRange();
+	indexRange = GeometryRange();
+	indiceNumber = 0;
+	MeshLod lod = { 0, 0, 0.0f };
+	lods.assign(1, lod);
+	meshlets.clear();
+}
 
-	deviceContext = context;
+bool Mesh::IsEmpty()
+{
+	return vertexRange.count == 0 && indexRange.count == 0;
 }
 
 Mesh::~Mesh()
 {
+	if (IsEmpty())
+		return;
+	geometryPool->Free(vertexRange);
+	geometryPool->Free(indexRange);
 }
 
-Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetVertexBuffer()
+// --------------------------------------------------------
+// Lets a mesh's contents change under everything pointing at
+// it (a loaded mesh replacing its placeholder).  The ids stay
+// put, so render queue keys made from them stay valid.
+// --------------------------------------------------------
+bool Mesh::Swap(Mesh& other)
 {
-	return vertexBuffer;
+	if (other.geometryPool != geometryPool || other.vertexLayoutId != vertexLayoutId)
+		return false;
+
+	std::swap(indexRange, other.indexRange);
+	std::swap(vertexRange, other.vertexRange);
+	std::swap(indiceNumber, other.indiceNumber);
+	std::swap(indexFormat, other.indexFormat);
+	std::swap(bounds, other.bounds);
+	lods.swap(other.lods);
+	meshlets.swap(other.meshlets);
+	return true;
 }
 
-Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetIndexBuffer()
+BufferHandle Mesh::GetVertexBuffer()
 {
-	return indexBuffer;
+	return geometryPool->GetBuffer(vertexRange);
+}
+
+BufferHandle Mesh::GetIndexBuffer()
+{
+	return geometryPool->GetBuffer(indexRange);
+}
+
+unsigned int Mesh::GetBaseVertex()
+{
+	return vertexRange.offset;
+}
+
+unsigned int Mesh::GetFirstIndex()
+{
+	return indexRange.offset;
 }
 
 int Mesh::GetIndexCount()
@@ -54,15 +152,307 @@ int Mesh::GetIndexCount()
 	return indiceNumber;
 }
 
-void Mesh::Draw()
+unsigned int Mesh::GetId()
+{
+	return id;
+}
+
+unsigned int Mesh::GetVertexLayoutId()
+{
+	return vertexLayoutId;
+}
+
+IndexFormat Mesh::GetIndexFormat()
+{
+	return indexFormat;
+}
+
+DirectX::XMFLOAT3 Mesh::GetBoundsMin()
+{
+	return bounds.min;
+}
+
+DirectX::XMFLOAT3 Mesh::GetBoundsMax()
+{
+	return bounds.max;
+}
+
+DirectX::XMFLOAT3 Mesh::GetSphereCenter()
+{
+	return bounds.sphereCenter;
+}
+
+float Mesh::GetSphereRadius()
+{
+	return bounds.sphereRadius;
+}
+
+MeshBounds Mesh::GetBounds()
+{
+	return bounds;
+}
+
+unsigned int Mesh::GetLodCount()
+{
+	return (unsigned int)lods.size();
+}
+
+MeshLod Mesh::GetLod(unsigned int lod)
+{
+	return lods[lod < lods.size() ? lod : lods.size() - 1];
+}
+
+// --------------------------------------------------------
+// LOD errors only grow down the chain, so this walks it
+// until the next one would show
+// --------------------------------------------------------
+unsigned int Mesh::SelectLod(float pixelsPerUnit, float maxPixelError)
+{
+	unsigned int lod = 0;
+	while (lod + 1 < lods.size() && lods[lod + 1].error * pixelsPerUnit <= maxPixelError)
+		lod++;
+	return lod;
+}
+
+void Mesh::SetMeshlets(const Meshlet* meshlets, unsigned int meshletCount)
+{
+	if (IsEmpty())
+		return;
+	this->meshlets.assign(meshlets, meshlets + meshletCount);
+}
+
+unsigned int Mesh::GetMeshletCount()
+{
+	return (unsigned int)meshlets.size();
+}
+
+// --------------------------------------------------------
+// Works in local space, where the meshlet bounds are: the
+// frustum pulled from world * viewProjection is the camera's
+// carried back through the world matrix, and the camera
+// position goes through its inverse.  The cone test needs
+// angles and facing to survive the world matrix, so it's
+// skipped when that scales unevenly or mirrors.
+// --------------------------------------------------------
+unsigned int Mesh::CullMeshlets(const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4X4& viewProjection,
+	const DirectX::XMFLOAT3& cameraPosition, std::vector<MeshletRange>& ranges, MeshletCullStats* stats)
+{
+	ranges.clear();
+	if (meshlets.empty())
+		return 0;
+
+	DirectX::XMMATRIX worldMat = DirectX::XMLoadFloat4x4(&world);
+	DirectX::XMFLOAT4X4 localViewProjection;
+	DirectX::XMStoreFloat4x4(&localViewProjection, DirectX::XMMatrixMultiply(worldMat, DirectX::XMLoadFloat4x4(&viewProjection)));
+	Frustum frustum(localViewProjection);
+
+	float scaleX = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(worldMat.r[0]));
+	float scaleY = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(worldMat.r[1]));
+	float scaleZ = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(worldMat.r[2]));
+	float maxScaleSq = scaleX > scaleY ? scaleX : scaleY;
+	maxScaleSq = maxScaleSq > scaleZ ? maxScaleSq : scaleZ;
+	float minScaleSq = scaleX < scaleY ? scaleX : scaleY;
+	minScaleSq = minScaleSq < scaleZ ? minScaleSq : scaleZ;
+
+	DirectX::XMVECTOR determinant;
+	DirectX::XMMATRIX inverseWorld = DirectX::XMMatrixInverse(&determinant, worldMat);
+	bool coneTest = maxScaleSq <= minScaleSq * 1.02f && DirectX::XMVectorGetX(determinant) > 0;
+
+	DirectX::XMFLOAT3 localCamera;
+	DirectX::XMStoreFloat3(&localCamera, DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&cameraPosition), inverseWorld));
+	const float camera[3] = { localCamera.x, localCamera.y, localCamera.z };
+
+	MeshletCullStats counts = {};
+	for (size_t i = 0; i < meshlets.size(); i++)
+	{
+		const Meshlet& meshlet = meshlets[i];
+		if (!frustum.IntersectsSphere(DirectX::XMFLOAT3(meshlet.center), meshlet.radius))
+		{
+			counts.frustumCulled++;
+			continue;
+		}
+		if (coneTest && IsMeshletBackFacing(meshlet, camera))
+		{
+			counts.backFacing++;
+			continue;
+		}
+
+		// Meshlets are contiguous in the index buffer, so visible runs draw as one
+		counts.visible++;
+		if (!ranges.empty() && ranges.back().firstIndex + ranges.back().indexCount == meshlet.firstIndex)
+			ranges.back().indexCount += meshlet.indexCount;
+		else
+		{
+			MeshletRange range = { meshlet.firstIndex, meshlet.indexCount };
+			ranges.push_back(range);
+		}
+	}
+
+	if (stats)
+	{
+		stats->visible += counts.visible;
+		stats->frustumCulled += counts.frustumCulled;
+		stats->backFacing += counts.backFacing;
+	}
+	return (unsigned int)ranges.size();
+}
+
+// --------------------------------------------------------
+// Moves the local bounding sphere into world space.  The
+// radius grows by the largest axis scale so the sphere
+// still contains the mesh under non-uniform scaling.
+// --------------------------------------------------------
+DirectX::XMFLOAT4 Mesh::GetWorldBoundingSphere(const DirectX::XMFLOAT4X4& world)
+{
+	DirectX::XMMATRIX worldMat = DirectX::XMLoadFloat4x4(&world);
+
+	DirectX::XMFLOAT4 sphere;
+	DirectX::XMStoreFloat4(&sphere, DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&bounds.sphereCenter), worldMat));
+
+	float scaleX = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(worldMat.r[0]));
+	float scaleY = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(worldMat.r[1]));
+	float scaleZ = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(worldMat.r[2]));
+	float maxScaleSq = scaleX > scaleY ? scaleX : scaleY;
+	maxScaleSq = maxScaleSq > scaleZ ? maxScaleSq : scaleZ;
+
+	sphere.w = bounds.sphereRadius * sqrtf(maxScaleSq);
+	return sphere;
+}
+
+// --------------------------------------------------------
+// Binds the pool buffers holding this mesh (vertices to slot
+// 0), skipping any the state cache says are already bound -
+// with meshes sharing buffers, that's usually all of them
+// --------------------------------------------------------
+void Mesh::BindBuffers(unsigned int vertexStride, RenderStateCache* stateCache)
+{
+	BufferHandle vertexBuffer = geometryPool->GetBuffer(vertexRange);
+	if (!stateCache || stateCache->Set(RenderStateCache::VertexBufferSlot, vertexBuffer))
+		renderDevice->SetVertexBuffers(0, 1, &vertexBuffer, &vertexStride);
+
+	BufferHandle indexBuffer = geometryPool->GetBuffer(indexRange);
+	if (!stateCache || stateCache->Set(RenderStateCache::IndexBufferSlot, indexBuffer))
+		renderDevice->SetIndexBuffer(indexBuffer, indexFormat);
+}
+
+// --------------------------------------------------------
+// Binds this mesh's buffers and the shared instance buffer
+// (slot 1), then draws a range of instances from it
+// --------------------------------------------------------
+void Mesh::DrawInstancedWithStride(unsigned int vertexStride, RenderStateCache* stateCache,
+	BufferHandle instanceBuffer, unsigned int instanceCount, unsigned int firstInstance, unsigned int lod)
+{
+	if (IsEmpty())
+		return;
+	MeshLod range = GetLod(lod);
+	BindBuffers(vertexStride, stateCache);
+
+	unsigned int instanceStride = sizeof(InstanceData);
+	if (!stateCache || stateCache->Set(RenderStateCache::InstanceBufferSlot, instanceBuffer))
+		renderDevice->SetVertexBuffers(1, 1, &instanceBuffer, &instanceStride);
+
+	renderDevice->DrawIndexedInstanced(
+		range.indexCount,
+		instanceCount,
+		indexRange.offset + range.firstIndex,
+		vertexRange.offset,
+		firstInstance);
+}
+
+// --------------------------------------------------------
+// Finds the local AABB, then a bounding sphere centered on
+// the box that reaches the farthest vertex (a bit tighter
+// than using the box's half diagonal)
+// --------------------------------------------------------
+MeshBounds Mesh::CalculateBounds(const Vertex* vertexArray, unsigned long long vertexNum)
+{
+	MeshBounds bounds;
+	if (vertexNum == 0)
+	{
+		bounds.min = bounds.max = bounds.sphereCenter = DirectX::XMFLOAT3(0, 0, 0);
+		bounds.sphereRadius = 0;
+		return bounds;
+	}
+
+	bounds.min = bounds.max = vertexArray[0].Position;
+	for (unsigned long long i = 1; i < vertexNum; i++)
+	{
+		const DirectX::XMFLOAT3& p = vertexArray[i].Position;
+		if (p.x < bounds.min.x) bounds.min.x = p.x;
+		if (p.y < bounds.min.y) bounds.min.y = p.y;
+		if (p.z < bounds.min.z) bounds.min.z = p.z;
+		if (p.x > bounds.max.x) bounds.max.x = p.x;
+		if (p.y > bounds.max.y) bounds.max.y = p.y;
+		if (p.z > bounds.max.z) bounds.max.z = p.z;
+	}
+
+	bounds.sphereCenter = DirectX::XMFLOAT3(
+		(bounds.min.x + bounds.max.x) * 0.5f,
+		(bounds.min.y + bounds.max.y) * 0.5f,
+		(bounds.min.z + bounds.max.z) * 0.5f);
+
+	float maxDistSq = 0;
+	for (unsigned long long i = 0; i < vertexNum; i++)
+	{
+		const DirectX::XMFLOAT3& p = vertexArray[i].Position;
+		float dx = p.x - bounds.sphereCenter.x, dy = p.y - bounds.sphereCenter.y, dz = p.z - bounds.sphereCenter.z;
+		float distSq = dx * dx + dy * dy + dz * dz;
+		if (distSq > maxDistSq) maxDistSq = distSq;
+	}
+	bounds.sphereRadius = sqrtf(maxDistSq);
+	return bounds;
+}
+
+void Mesh::Optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, MeshOptimizationReport* report)
+{
+	size_t vertexCount = OptimizeMesh(vertices.data(), vertices.size(), sizeof(Vertex), offsetof(Vertex, Position),
+		indices.data(), indices.size(), report);
+	vertices.resize(vertexCount);
+}
+
+void Mesh::GenerateLods(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, std::vector<MeshLod>& lods)
+{
+	std::vector<SimplifiedLod> chain;
+	BuildLodChain(indices, chain, vertices.data(), vertices.size(), sizeof(Vertex), offsetof(Vertex, Position), MaxMeshLods);
+
+	lods.resize(chain.size());
+	for (size_t i = 0; i < chain.size(); i++)
+	{
+		lods[i].firstIndex = chain[i].firstIndex;
+		lods[i].indexCount = chain[i].indexCount;
+		lods[i].error = chain[i].error;
+	}
+}
+
+void Mesh::GenerateMeshlets(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, std::vector<Meshlet>& meshlets)
+{
+	BuildMeshlets(meshlets, indices.data(), indices.size(), vertices.data(), vertices.size(), sizeof(Vertex), offsetof(Vertex, Position));
+}
+
+void Mesh::DrawWithStride(unsigned int vertexStride, RenderStateCache* stateCache, unsigned int lod)
+{
+	if (IsEmpty())
+		return;
+	MeshLod range = GetLod(lod);
+	BindBuffers(vertexStride, stateCache);
+
+	renderDevice->DrawIndexed(
+		range.indexCount,
+		indexRange.offset + range.firstIndex,
+		vertexRange.offset);
+}
+
+void Mesh::DrawRangesWithStride(unsigned int vertexStride, RenderStateCache* stateCache, const MeshletRange* ranges, unsigned int rangeCount)
 {
-	UINT stride = sizeof(Vertex);
-	UINT offset = 0;
-	deviceContext->IASetVertexBuffers(0, 1, vertexBuffer.GetAddressOf(), &stride, &offset);
-	deviceContext->IASetIndexBuffer(indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	if (IsEmpty())
+		return;
+	BindBuffers(vertexStride, stateCache);
 
-	deviceContext->DrawIndexed(
-	indiceNumber,
-		0,
-		0);
+	for (unsigned int i = 0; i < rangeCount; i++)
+	{
+		renderDevice->DrawIndexed(
+			ranges[i].indexCount,
+			indexRange.offset + ranges[i].firstIndex,
+			vertexRange.offset);
+	}
 }
@@ -1,20 +1,240 @@
 #pragma once
-#include <d3d11.h>
-#include <wrl/client.h>
 #include "Vertex.h"
+#include "RenderDevice.h"
+#include "RenderQueue.h"
+#include "GeometryPool.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include <vector>
+
+//local-space bounds of a mesh's vertices
+struct MeshBounds
+{
+	DirectX::XMFLOAT3 min;
+	DirectX::XMFLOAT3 max;
+	DirectX::XMFLOAT3 sphereCenter;
+	float sphereRadius;
+};
+
+//one level of detail - a range of the mesh's index buffer, and how far
+//(in local units) its surface can be from the full-detail one
+struct MeshLod
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	float error;
+};
+
+// Most LODs a mesh keeps (any more in a file are ignored)
+static const unsigned int MaxMeshLods = 8;
+
+//meshlets tested by CullMeshlets(), and why the rest were dropped
+struct MeshletCullStats
+{
+	unsigned int visible;
+	unsigned int frustumCulled;
+	unsigned int backFacing;
+};
+
+// --------------------------------------------------------
+// Everything about a mesh that doesn't depend on its vertex
+// type: the indices, bounds, LODs and meshlets.  Meshes are made as
+// VertexMesh<VertexType> (below); code that only draws them
+// holds a Mesh.
+//
+// A mesh owns no buffers - its vertices and indices are
+// ranges of a GeometryPool's shared ones, given back when
+// the mesh goes (so the pool must outlive its meshes).  If
+// the pool can't make room, the mesh is left empty instead:
+// no geometry, one empty LOD, and draws that do nothing.
+// --------------------------------------------------------
 class Mesh
 {
-private:
-	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
-	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
-	Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext;
+protected:
+	GeometryPool* geometryPool;
+	GeometryRange indexRange;
+	GeometryRange vertexRange;	// Filled in by VertexMesh
+	RenderDevice* renderDevice;
 	int indiceNumber;
+	IndexFormat indexFormat;
+	unsigned int vertexLayoutId;
+	//small unique id, used in render queue sort keys
+	unsigned int id;
+	static unsigned int nextId;
+
+	MeshBounds bounds;
+	//always at least one; lods[0] is the full-detail mesh, then coarser and coarser
+	std::vector<MeshLod> lods;
+	//clusters of LOD 0, in index order (empty unless SetMeshlets() is called)
+	std::vector<Meshlet> meshlets;
+
+	//bounds are computed from the vertices when null, and lodCount 0 means one LOD of every index
+	Mesh(const Vertex* vertexArray, unsigned long long vertexNum, const unsigned int* indices, unsigned long long indiceNum,
+		const MeshBounds* bounds, const MeshLod* lods, unsigned int lodCount, unsigned int vertexLayoutId, GeometryPool* geometryPool);
+	//indices already in indexFormat (from a mesh file) are uploaded untouched
+	Mesh(const void* indices, IndexFormat indexFormat, unsigned long long indiceNum,
+		const MeshBounds& bounds, const MeshLod* lods, unsigned int lodCount, unsigned int vertexLayoutId, GeometryPool* geometryPool);
+	void Init(const MeshBounds& bounds, const MeshLod* lods, unsigned int lodCount, unsigned long long indiceNum,
+		unsigned int vertexLayoutId, GeometryPool* geometryPool);
+	void CreateIndexBuffer(const void* indices, IndexFormat indexFormat);
+	void MakeEmpty();
+	//the draws, given the vertex type's stride
+	void DrawWithStride(unsigned int vertexStride, RenderStateCache* stateCache, unsigned int lod);
+	void DrawInstancedWithStride(unsigned int vertexStride, RenderStateCache* stateCache,
+		BufferHandle instanceBuffer, unsigned int instanceCount, unsigned int firstInstance, unsigned int lod);
+	void DrawRangesWithStride(unsigned int vertexStride, RenderStateCache* stateCache, const MeshletRange* ranges, unsigned int rangeCount);
+	void BindBuffers(unsigned int vertexStride, RenderStateCache* stateCache);
 public:
-	Mesh(Vertex* vertexArray, unsigned long long vertexNum, unsigned int* indices, unsigned long long indiceNum, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext);
-	~Mesh();
-	Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer();
-	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer();
+	virtual ~Mesh();
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+	//trades geometry (buffers, bounds, LODs and meshlets) with another mesh of the same vertex
+	//type from the same pool, each keeping its id - false, swapping nothing, if they don't match
+	bool Swap(Mesh& other);
+	//true if the geometry pool couldn't hold the mesh - it then draws nothing
+	bool IsEmpty();
+	//the pool buffers this mesh is in, and where in them it starts
+	BufferHandle GetVertexBuffer();
+	BufferHandle GetIndexBuffer();
+	unsigned int GetBaseVertex();
+	unsigned int GetFirstIndex();
 	int GetIndexCount();
-	void Draw();
+	unsigned int GetId();
+	//GetVertexLayoutId<VertexType>() of the vertex buffer's type
+	unsigned int GetVertexLayoutId();
+	IndexFormat GetIndexFormat();
+	DirectX::XMFLOAT3 GetBoundsMin();
+	DirectX::XMFLOAT3 GetBoundsMax();
+	DirectX::XMFLOAT3 GetSphereCenter();
+	float GetSphereRadius();
+	MeshBounds GetBounds();
+	unsigned int GetLodCount();
+	MeshLod GetLod(unsigned int lod);
+	//the coarsest LOD whose error stays within maxPixelError on screen, where
+	//pixelsPerUnit is how many pixels one local unit covers at the mesh's distance
+	unsigned int SelectLod(float pixelsPerUnit, float maxPixelError);
+	//LOD 0's clusters, from BuildMeshlets() - its indices must already be in their order
+	void SetMeshlets(const Meshlet* meshlets, unsigned int meshletCount);
+	unsigned int GetMeshletCount();
+	//culls the meshlets against the frustum of world * viewProjection and, unless world scales
+	//unevenly, by normal cone from cameraPosition (world space).  ranges gets what's left as
+	//LOD 0 index ranges, neighbours merged; returns how many.  stats (if given) are added to
+	unsigned int CullMeshlets(const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4X4& viewProjection,
+		const DirectX::XMFLOAT3& cameraPosition, std::vector<MeshletRange>& ranges, MeshletCullStats* stats = 0);
+	//bounding sphere moved into world space (xyz = center, w = radius)
+	DirectX::XMFLOAT4 GetWorldBoundingSphere(const DirectX::XMFLOAT4X4& world);
+	//finds the local AABB, then a sphere centered on it that reaches the farthest vertex
+	static MeshBounds CalculateBounds(const Vertex* vertexArray, unsigned long long vertexNum);
+	//reorders procedurally built geometry for the GPU before it's handed to a constructor
+	//(baked .mesh files already are); unreferenced vertices are dropped
+	static void Optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, MeshOptimizationReport* report = 0);
+	//appends a chain of simplified LODs to (optimized) indices, for the bounds/LODs constructor
+	static void GenerateLods(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, std::vector<MeshLod>& lods);
+	//splits (optimized) indices into meshlets, reordering them - before GenerateLods, so only LOD 0 is touched
+	static void GenerateMeshlets(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, std::vector<Meshlet>& meshlets);
+	//both draws expect an input layout for GetVertexLayoutId(), and draw the full-detail LOD
+	//unless told otherwise.  Buffers already bound according to stateCache aren't bound again
+	//(null binds them all)
+	virtual void Draw(RenderStateCache* stateCache = 0, unsigned int lod = 0) = 0;
+	//draws instanceCount copies, reading per-instance data from slot 1
+	virtual void DrawInstanced(RenderStateCache* stateCache, BufferHandle instanceBuffer, unsigned int instanceCount, unsigned int firstInstance,
+		unsigned int lod = 0) = 0;
+	//draws index ranges of LOD 0 (from CullMeshlets), one draw call each
+	virtual void DrawRanges(RenderStateCache* stateCache, const MeshletRange* ranges, unsigned int rangeCount) = 0;
+};
+
+// --------------------------------------------------------
+// A mesh whose vertex buffer holds VertexType (Vertex,
+// PackedVertex, ...).  It's built from authored Vertex
+// arrays, packed on the way to the GPU (or from ones packed
+// already), and its stride is a compile-time constant from
+// VertexType's layout.  Indices are 16-bit whenever they fit
+// (mesh files are baked that way).
+// --------------------------------------------------------
+template<typename VertexType>
+class VertexMesh : public Mesh
+{
+public:
+	VertexMesh(const Vertex* vertexArray, unsigned long long vertexNum, const unsigned int* indices, unsigned long long indiceNum, GeometryPool* geometryPool);
+	//for loaders that already know the bounds and LOD ranges (lodCount 0 = one LOD of every index)
+	VertexMesh(const Vertex* vertexArray, unsigned long long vertexNum, const unsigned int* indices, unsigned long long indiceNum,
+		const MeshBounds& bounds, const MeshLod* lods, unsigned int lodCount, GeometryPool* geometryPool);
+	//for mesh files: vertices already packed (see PackVertices()) and indices narrowed (or not) when
+	//they were baked, so both are uploaded as they are
+	VertexMesh(const VertexType* packedVertices, unsigned long long vertexNum, const void* indices, IndexFormat indexFormat,
+		unsigned long long indiceNum, const MeshBounds& bounds, const MeshLod* lods, unsigned int lodCount, GeometryPool* geometryPool);
+	void Draw(RenderStateCache* stateCache = 0, unsigned int lod = 0);
+	void DrawInstanced(RenderStateCache* stateCache, BufferHandle instanceBuffer, unsigned int instanceCount, unsigned int firstInstance,
+		unsigned int lod = 0);
+	void DrawRanges(RenderStateCache* stateCache, const MeshletRange* ranges, unsigned int rangeCount);
+
+private:
+	void CreateVertexBuffer(const Vertex* vertexArray, unsigned long long vertexNum);
+	void UploadVertices(const VertexType* packedVertices, unsigned long long vertexNum);
 };
 
+template<typename VertexType>
+VertexMesh<VertexType>::VertexMesh(const Vertex* vertexArray, unsigned long long vertexNum, const unsigned int* indices, unsigned long long indiceNum,
+	GeometryPool* geometryPool)
+	: Mesh(vertexArray, vertexNum, indices, indiceNum, 0, 0, 0, ::GetVertexLayoutId<VertexType>(), geometryPool)
+{
+	CreateVertexBuffer(vertexArray, vertexNum);
+}
+
+template<typename VertexType>
+VertexMesh<VertexType>::VertexMesh(const Vertex* vertexArray, unsigned long long vertexNum, const unsigned int* indices, unsigned long long indiceNum,
+	const MeshBounds& bounds, const MeshLod* lods, unsigned int lodCount, GeometryPool* geometryPool)
+	: Mesh(vertexArray, vertexNum, indices, indiceNum, &bounds, lods, lodCount, ::GetVertexLayoutId<VertexType>(), geometryPool)
+{
+	CreateVertexBuffer(vertexArray, vertexNum);
+}
+
+template<typename VertexType>
+VertexMesh<VertexType>::VertexMesh(const VertexType* packedVertices, unsigned long long vertexNum, const void* indices, IndexFormat indexFormat,
+	unsigned long long indiceNum, const MeshBounds& bounds, const MeshLod* lods, unsigned int lodCount, GeometryPool* geometryPool)
+	: Mesh(indices, indexFormat, indiceNum, bounds, lods, lodCount, ::GetVertexLayoutId<VertexType>(), geometryPool)
+{
+	UploadVertices(packedVertices, vertexNum);
+}
+
+template<typename VertexType>
+void VertexMesh<VertexType>::CreateVertexBuffer(const Vertex* vertexArray, unsigned long long vertexNum)
+{
+	std::vector<VertexType> packed;
+	UploadVertices(PackVertices(vertexArray, vertexNum, packed), vertexNum);
+}
+
+template<typename VertexType>
+void VertexMesh<VertexType>::UploadVertices(const VertexType* packedVertices, unsigned long long vertexNum)
+{
+	// Without indices (none given, or no room for them) nothing would draw these
+	if (indiceNumber == 0)
+	{
+		MakeEmpty();
+		return;
+	}
+
+	if (!geometryPool->AllocateVertices(vertexLayoutId, VertexLayout<VertexType>::Stride, packedVertices,
+		(unsigned int)vertexNum, vertexRange))
+		MakeEmpty();
+}
+
+template<typename VertexType>
+void VertexMesh<VertexType>::Draw(RenderStateCache* stateCache, unsigned int lod)
+{
+	DrawWithStride(VertexLayout<VertexType>::Stride, stateCache, lod);
+}
+
+template<typename VertexType>
+void VertexMesh<VertexType>::DrawInstanced(RenderStateCache* stateCache, BufferHandle instanceBuffer, unsigned int instanceCount, unsigned int firstInstance,
+	unsigned int lod)
+{
+	DrawInstancedWithStride(VertexLayout<VertexType>::Stride, stateCache, instanceBuffer, instanceCount, firstInstance, lod);
+}
+
+template<typename VertexType>
+void VertexMesh<VertexType>::DrawRanges(RenderStateCache* stateCache, const MeshletRange* ranges, unsigned int rangeCount)
+{
+	DrawRangesWithStride(VertexLayout<VertexType>::Stride, stateCache, ranges, rangeCount);
+}
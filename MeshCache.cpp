@@ -0,0 +1,113 @@
+#include "MeshCache.h"
+#include <algorithm>
+#include <vector>
+
+const unsigned long long MeshCache::DefaultMemoryBudget;
+
+bool MeshCache::Key::operator<(const Key& other) const
+{
+	if (hash != other.hash)
+		return hash < other.hash;
+	if (vertexLayoutId != other.vertexLayoutId)
+		return vertexLayoutId < other.vertexLayoutId;
+	if (vertexCount != other.vertexCount)
+		return vertexCount < other.vertexCount;
+	return indexCount < other.indexCount;
+}
+
+MeshCache::MeshCache(GeometryPool* geometryPool, unsigned long long memoryBudget)
+{
+	this->geometryPool = geometryPool;
+	this->memoryBudget = memoryBudget;
+	this->useCount = 0;
+	this->stats = MeshCacheStats();
+}
+
+// --------------------------------------------------------
+// One streamed hash over everything that ends up in the
+// mesh.  The vertex type goes in the key as well, since the
+// same vertices packed two ways are two different meshes.
+// --------------------------------------------------------
+MeshCache::Key MeshCache::MakeKey(unsigned int vertexLayoutId, const Vertex* vertices, unsigned int vertexCount,
+	const unsigned int* indices, unsigned int indexCount, const MeshLod* lods, unsigned int lodCount)
+{
+	ContentHasher hasher;
+	hasher.Add(vertices, vertexCount * sizeof(Vertex));
+	hasher.Add(indices, indexCount * sizeof(unsigned int));
+	hasher.Add(&lodCount, sizeof(lodCount));
+	hasher.Add(lods, lodCount * sizeof(MeshLod));
+
+	Key key;
+	key.hash = hasher.Finish();
+	key.vertexLayoutId = vertexLayoutId;
+	key.vertexCount = vertexCount;
+	key.indexCount = indexCount;
+	return key;
+}
+
+std::shared_ptr<Mesh> MeshCache::Find(const Key& key)
+{
+	std::map<Key, Entry>::iterator found = entries.find(key);
+	if (found == entries.end())
+		return 0;
+
+	found->second.lastUsed = ++useCount;
+	stats.hits++;
+	stats.bytesSaved += found->second.bytes;
+	return found->second.mesh;
+}
+
+void MeshCache::Insert(const Key& key, const std::shared_ptr<Mesh>& mesh, unsigned long long bytes)
+{
+	Entry entry;
+	entry.mesh = mesh;
+	entry.bytes = bytes;
+	entry.lastUsed = ++useCount;
+	entries[key] = entry;
+
+	stats.misses++;
+	stats.meshCount++;
+	stats.bytes += bytes;
+	Trim();
+}
+
+// --------------------------------------------------------
+// A mesh is unused when the cache holds its only reference.
+// Those go oldest first until the cache fits.
+// --------------------------------------------------------
+void MeshCache::Trim()
+{
+	if (stats.bytes <= memoryBudget)
+		return;
+
+	std::vector<std::map<Key, Entry>::iterator> unused;
+	for (std::map<Key, Entry>::iterator it = entries.begin(); it != entries.end(); ++it)
+	{
+		if (it->second.mesh.use_count() == 1)
+			unused.push_back(it);
+	}
+	std::sort(unused.begin(), unused.end(),
+		[](const std::map<Key, Entry>::iterator& a, const std::map<Key, Entry>::iterator& b)
+		{
+			return a->second.lastUsed < b->second.lastUsed;
+		});
+
+	for (size_t i = 0; i < unused.size() && stats.bytes > memoryBudget; i++)
+	{
+		stats.bytes -= unused[i]->second.bytes;
+		stats.meshCount--;
+		stats.evictions++;
+		entries.erase(unused[i]);
+	}
+}
+
+void MeshCache::SetMemoryBudget(unsigned long long memoryBudget)
+{
+	this->memoryBudget = memoryBudget;
+	Trim();
+}
+
+MeshCacheStats MeshCache::GetStats()
+{
+	return stats;
+}
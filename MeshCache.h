@@ -0,0 +1,110 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include "Mesh.h"
+#include "GeometryPool.h"
+#include "ContentHash.h"
+
+// Counters kept by MeshCache
+struct MeshCacheStats
+{
+	unsigned int meshCount;				// Held by the cache, in use or not
+	unsigned long long bytes;			// GPU bytes of those meshes
+	unsigned int hits;
+	unsigned int misses;
+	unsigned int evictions;
+	unsigned long long bytesSaved;		// Uploads hits didn't have to make
+};
+
+// --------------------------------------------------------
+// Hands out one Mesh per distinct piece of geometry.  Meshes
+// are keyed by a content hash (ContentHash.h) of their
+// vertex type, vertices, indices and LODs, so asking for a
+// mesh identical to one already made returns that one - no
+// second upload, no second copy in the geometry pool.
+//
+// The cache keeps every mesh alive after its last user lets
+// go, in case it's asked for again, and evicts unused ones
+// (least recently asked for first) once everything it holds
+// is over memoryBudget bytes.  Meshes still in use are never
+// evicted, so the budget can be exceeded by them alone.
+//
+// Keys are 64-bit hashes plus the counts, and contents
+// aren't compared, so two different meshes would only be
+// mixed up on a hash collision.  Main thread only, like the
+// pool; the cache must go before the pool does.
+// --------------------------------------------------------
+class MeshCache
+{
+public:
+	static const unsigned long long DefaultMemoryBudget = 64 * 1024 * 1024;
+
+	MeshCache(GeometryPool* geometryPool, unsigned long long memoryBudget = DefaultMemoryBudget);
+	MeshCache(const MeshCache&) = delete;
+	MeshCache& operator=(const MeshCache&) = delete;
+
+	//the mesh for this geometry as VertexType, made (like the VertexMesh constructors)
+	//only if the cache doesn't already have it.  lodCount 0 = one LOD of every index
+	template<typename VertexType = Vertex>
+	std::shared_ptr<Mesh> GetMesh(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount,
+		const MeshLod* lods = 0, unsigned int lodCount = 0);
+
+	//evicts unused meshes until the cache is within budget (done after every miss)
+	void Trim();
+	void SetMemoryBudget(unsigned long long memoryBudget);
+
+	MeshCacheStats GetStats();
+
+private:
+	struct Key
+	{
+		unsigned long long hash;
+		unsigned int vertexLayoutId;
+		unsigned int vertexCount;
+		unsigned int indexCount;
+
+		bool operator<(const Key& other) const;
+	};
+
+	struct Entry
+	{
+		std::shared_ptr<Mesh> mesh;
+		unsigned long long bytes;
+		unsigned long long lastUsed;
+	};
+
+	GeometryPool* geometryPool;
+	unsigned long long memoryBudget;
+	std::map<Key, Entry> entries;
+	unsigned long long useCount;
+	MeshCacheStats stats;
+
+	static Key MakeKey(unsigned int vertexLayoutId, const Vertex* vertices, unsigned int vertexCount,
+		const unsigned int* indices, unsigned int indexCount, const MeshLod* lods, unsigned int lodCount);
+	//the cached mesh for key (counting the hit), or null
+	std::shared_ptr<Mesh> Find(const Key& key);
+	void Insert(const Key& key, const std::shared_ptr<Mesh>& mesh, unsigned long long bytes);
+};
+
+template<typename VertexType>
+std::shared_ptr<Mesh> MeshCache::GetMesh(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount,
+	const MeshLod* lods, unsigned int lodCount)
+{
+	Key key = MakeKey(::GetVertexLayoutId<VertexType>(), vertices, vertexCount, indices, indexCount, lods, lodCount);
+	std::shared_ptr<Mesh> mesh = Find(key);
+	if (mesh)
+		return mesh;
+
+	if (lodCount == 0)
+		mesh = std::make_shared<VertexMesh<VertexType>>(vertices, vertexCount, indices, indexCount, geometryPool);
+	else
+	{
+		mesh = std::make_shared<VertexMesh<VertexType>>(vertices, vertexCount, indices, indexCount,
+			Mesh::CalculateBounds(vertices, vertexCount), lods, lodCount, geometryPool);
+	}
+
+	unsigned int indexSize = mesh->GetIndexFormat() == IndexFormat16 ? sizeof(unsigned short) : sizeof(unsigned int);
+	Insert(key, mesh, (unsigned long long)vertexCount * VertexLayout<VertexType>::Stride + (unsigned long long)indexCount * indexSize);
+	return mesh;
+}
@@ -0,0 +1,39 @@
+#include "MeshFile.h"
+#include <cstddef>
+
+// The file's plain structs are used in place of the engine's, so they must match exactly
+static_assert(sizeof(MeshFileVertex) == sizeof(Vertex), "Vertex no longer matches the mesh file - bump MeshFileVersion");
+static_assert(offsetof(MeshFileVertex, position) == offsetof(Vertex, Position), "Vertex no longer matches the mesh file");
+static_assert(offsetof(MeshFileVertex, color) == offsetof(Vertex, Color), "Vertex no longer matches the mesh file");
+static_assert(sizeof(MeshFileLod) == sizeof(MeshLod), "MeshLod no longer matches the mesh file");
+static_assert(offsetof(MeshFileLod, firstIndex) == offsetof(MeshLod, firstIndex), "MeshLod no longer matches the mesh file");
+static_assert(offsetof(MeshFileLod, indexCount) == offsetof(MeshLod, indexCount), "MeshLod no longer matches the mesh file");
+static_assert(offsetof(MeshFileLod, error) == offsetof(MeshLod, error), "MeshLod no longer matches the mesh file");
+static_assert(sizeof(MeshFileMeshlet) == sizeof(Meshlet), "Meshlet no longer matches the mesh file");
+static_assert(offsetof(MeshFileMeshlet, firstIndex) == offsetof(Meshlet, firstIndex), "Meshlet no longer matches the mesh file");
+static_assert(offsetof(MeshFileMeshlet, indexCount) == offsetof(Meshlet, indexCount), "Meshlet no longer matches the mesh file");
+static_assert(offsetof(MeshFileMeshlet, center) == offsetof(Meshlet, center), "Meshlet no longer matches the mesh file");
+static_assert(offsetof(MeshFileMeshlet, radius) == offsetof(Meshlet, radius), "Meshlet no longer matches the mesh file");
+static_assert(offsetof(MeshFileMeshlet, coneApex) == offsetof(Meshlet, coneApex), "Meshlet no longer matches the mesh file");
+static_assert(offsetof(MeshFileMeshlet, coneAxis) == offsetof(Meshlet, coneAxis), "Meshlet no longer matches the mesh file");
+static_assert(offsetof(MeshFileMeshlet, coneCutoff) == offsetof(Meshlet, coneCutoff), "Meshlet no longer matches the mesh file");
+
+bool OpenMeshFile(const std::string& path, MappedFile& file, MeshFileContents& contents, MeshBounds& bounds)
+{
+	if (!file.Open(path))
+		return false;
+	if (!ReadMeshFile(file.GetData(), file.GetSize(), contents))
+		return false;
+
+	const MeshFileHeader* header = contents.header;
+	bounds.min = DirectX::XMFLOAT3(header->boundsMin);
+	bounds.max = DirectX::XMFLOAT3(header->boundsMax);
+	bounds.sphereCenter = DirectX::XMFLOAT3(header->sphereCenter);
+	bounds.sphereRadius = header->sphereRadius;
+	return true;
+}
+
+IndexFormat GetIndexFormat(const MeshFileHeader& header)
+{
+	return header.indexSize == sizeof(unsigned short) ? IndexFormat16 : IndexFormat32;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include "MappedFile.h"
+#include "Mesh.h"
+#include "MeshFileFormat.h"
+
+//maps a mesh file and checks it, filling in its streams and bounds; false on failure
+bool OpenMeshFile(const std::string& path, MappedFile& file, MeshFileContents& contents, MeshBounds& bounds);
+//the format of a (checked) mesh file's index stream
+IndexFormat GetIndexFormat(const MeshFileHeader& header);
+
+// --------------------------------------------------------
+// Maps a mesh file and builds a Mesh directly from the
+// mapped streams, packed into VertexType on the way to the
+// GPU, along with its meshlets; null on failure.  The streams are copied into the
+// geometry pool's buffers while the Mesh is built, so the
+// file is unmapped as soon as that's done.
+// --------------------------------------------------------
+template<typename VertexType = Vertex>
+std::shared_ptr<Mesh> LoadMeshFile(const std::string& path, GeometryPool* geometryPool)
+{
+	MappedFile file;
+	MeshFileContents contents;
+	MeshBounds bounds;
+	if (!OpenMeshFile(path, file, contents, bounds))
+		return 0;
+
+	const MeshFileHeader* header = contents.header;
+	std::vector<VertexType> packed;
+	std::shared_ptr<Mesh> mesh = std::make_shared<VertexMesh<VertexType>>(
+		PackVertices((const Vertex*)contents.vertices, header->vertexCount, packed), header->vertexCount,
+		contents.indices, GetIndexFormat(*header), header->indexCount,
+		bounds, (const MeshLod*)contents.lods, header->lodCount,
+		geometryPool);
+	mesh->SetMeshlets((const Meshlet*)contents.meshlets, header->meshletCount);
+	return mesh;
+}
@@ -0,0 +1,163 @@
+#include "MeshFileFormat.h"
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+static unsigned int AlignUp(unsigned int value, unsigned int alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+// True if count items of itemSize bytes starting at offset fit in size bytes
+static bool StreamFits(unsigned int offset, unsigned int count, size_t itemSize, size_t size)
+{
+	return offset <= size && (unsigned long long)count * itemSize <= size - offset;
+}
+
+// --------------------------------------------------------
+// Validates the header and stream ranges.  The data must
+// stay alive (mapped) for as long as contents is used.
+// --------------------------------------------------------
+bool ReadMeshFile(const void* data, size_t size, MeshFileContents& contents)
+{
+	if (!data || size < sizeof(MeshFileHeader))
+		return false;
+
+	const MeshFileHeader* header = (const MeshFileHeader*)data;
+	if (header->magic != MeshFileMagic ||
+		header->version != MeshFileVersion ||
+		header->vertexStride != sizeof(MeshFileVertex) ||
+		(header->indexSize != sizeof(unsigned short) && header->indexSize != sizeof(unsigned int)) ||
+		header->fileSize != size)
+		return false;
+
+	// Streams must be aligned for their types (mappings start page aligned)
+	if (header->vertexOffset % 4 != 0 || header->indexOffset % 4 != 0 || header->lodOffset % 4 != 0 || header->meshletOffset % 4 != 0)
+		return false;
+	if (!StreamFits(header->vertexOffset, header->vertexCount, sizeof(MeshFileVertex), size) ||
+		!StreamFits(header->indexOffset, header->indexCount, header->indexSize, size) ||
+		!StreamFits(header->lodOffset, header->lodCount, sizeof(MeshFileLod), size) ||
+		!StreamFits(header->meshletOffset, header->meshletCount, sizeof(MeshFileMeshlet), size))
+		return false;
+
+	const unsigned char* bytes = (const unsigned char*)data;
+	const MeshFileLod* lods = (const MeshFileLod*)(bytes + header->lodOffset);
+	for (unsigned int i = 0; i < header->lodCount; i++)
+	{
+		if (lods[i].firstIndex > header->indexCount || lods[i].indexCount > header->indexCount - lods[i].firstIndex)
+			return false;
+	}
+
+	// Meshlets only ever cover LOD 0
+	unsigned int lod0Count = header->lodCount ? lods[0].firstIndex + lods[0].indexCount : header->indexCount;
+	const MeshFileMeshlet* meshlets = (const MeshFileMeshlet*)(bytes + header->meshletOffset);
+	for (unsigned int i = 0; i < header->meshletCount; i++)
+	{
+		if (meshlets[i].firstIndex > lod0Count || meshlets[i].indexCount > lod0Count - meshlets[i].firstIndex)
+			return false;
+	}
+
+	contents.header = header;
+	contents.vertices = (const MeshFileVertex*)(bytes + header->vertexOffset);
+	contents.indices = bytes + header->indexOffset;
+	contents.lods = lods;
+	contents.meshlets = meshlets;
+	return true;
+}
+
+// --------------------------------------------------------
+// Same bounds Mesh::CalculateBounds() finds at runtime: the
+// AABB, then a sphere centered on it reaching the farthest
+// vertex
+// --------------------------------------------------------
+static void CalculateBounds(const MeshFileVertex* vertices, unsigned int vertexCount, MeshFileHeader& header)
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		header.boundsMin[axis] = vertexCount ? vertices[0].position[axis] : 0.0f;
+		header.boundsMax[axis] = header.boundsMin[axis];
+	}
+	for (unsigned int i = 1; i < vertexCount; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float p = vertices[i].position[axis];
+			if (p < header.boundsMin[axis]) header.boundsMin[axis] = p;
+			if (p > header.boundsMax[axis]) header.boundsMax[axis] = p;
+		}
+	}
+
+	for (int axis = 0; axis < 3; axis++)
+		header.sphereCenter[axis] = (header.boundsMin[axis] + header.boundsMax[axis]) * 0.5f;
+
+	float maxDistSq = 0;
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		float dx = vertices[i].position[0] - header.sphereCenter[0];
+		float dy = vertices[i].position[1] - header.sphereCenter[1];
+		float dz = vertices[i].position[2] - header.sphereCenter[2];
+		float distSq = dx * dx + dy * dy + dz * dz;
+		if (distSq > maxDistSq) maxDistSq = distSq;
+	}
+	header.sphereRadius = sqrtf(maxDistSq);
+}
+
+// --------------------------------------------------------
+// The index width is picked here, once, so loading never
+// has to scan or narrow the indices
+// --------------------------------------------------------
+bool WriteMeshFile(const std::string& path,
+	const MeshFileVertex* vertices, unsigned int vertexCount,
+	const unsigned int* indices, unsigned int indexCount,
+	const MeshFileLod* lods, unsigned int lodCount,
+	const MeshFileMeshlet* meshlets, unsigned int meshletCount)
+{
+	unsigned int maxIndex = 0;
+	for (unsigned int i = 0; i < indexCount; i++)
+	{
+		if (indices[i] > maxIndex)
+			maxIndex = indices[i];
+	}
+
+	std::vector<unsigned short> shortIndices;
+	const void* indexData = indices;
+	unsigned int indexSize = sizeof(unsigned int);
+	if (maxIndex <= 0xFFFF)
+	{
+		shortIndices.assign(indices, indices + indexCount);
+		indexData = shortIndices.data();
+		indexSize = sizeof(unsigned short);
+	}
+
+	MeshFileHeader header = {};
+	header.magic = MeshFileMagic;
+	header.version = MeshFileVersion;
+	header.vertexStride = sizeof(MeshFileVertex);
+	header.vertexCount = vertexCount;
+	header.indexCount = indexCount;
+	header.indexSize = indexSize;
+	header.lodCount = lodCount;
+	header.vertexOffset = AlignUp(sizeof(MeshFileHeader), 16);
+	header.indexOffset = AlignUp(header.vertexOffset + vertexCount * sizeof(MeshFileVertex), 4);
+	header.lodOffset = AlignUp(header.indexOffset + indexCount * indexSize, 4);
+	header.meshletCount = meshletCount;
+	header.meshletOffset = header.lodOffset + lodCount * sizeof(MeshFileLod);
+	header.fileSize = header.meshletOffset + meshletCount * sizeof(MeshFileMeshlet);
+	CalculateBounds(vertices, vertexCount, header);
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+
+	// Zero padding between streams, so identical meshes give identical files
+	static const char padding[16] = {};
+	file.write((const char*)&header, sizeof(header));
+	file.write(padding, header.vertexOffset - sizeof(header));
+	file.write((const char*)vertices, vertexCount * sizeof(MeshFileVertex));
+	file.write(padding, header.indexOffset - (header.vertexOffset + vertexCount * sizeof(MeshFileVertex)));
+	file.write((const char*)indexData, indexCount * indexSize);
+	file.write(padding, header.lodOffset - (header.indexOffset + indexCount * indexSize));
+	file.write((const char*)lods, lodCount * sizeof(MeshFileLod));
+	file.write((const char*)meshlets, meshletCount * sizeof(MeshFileMeshlet));
+	return (bool)file;
+}
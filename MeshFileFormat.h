@@ -0,0 +1,105 @@
+#pragma once
+
+#include <string>
+
+// --------------------------------------------------------
+// Runtime binary mesh container (.mesh)
+//
+// Laid out so a memory-mapped file can be handed straight to
+// Mesh with no parsing or copying:
+//
+//   MeshFileHeader
+//   vertex stream - vertexCount MeshFileVertex (16-byte aligned)
+//   index stream  - indexCount indices of indexSize bytes, LOD 0
+//                   first.  16-bit whenever every index fits, so
+//                   they go to the GPU as they are
+//   LOD table     - lodCount MeshFileLod entries (may be empty)
+//   meshlets      - meshletCount MeshFileMeshlet entries, clusters
+//                   of LOD 0 in index order (may be empty)
+//
+// All offsets are in bytes from the start of the file and all
+// values are little-endian.  Bump MeshFileVersion whenever the
+// layout of the header, vertex, LOD or meshlet entries changes.
+//
+// Only plain types are used here, so tools can read and write
+// meshes without the engine (or DirectXMath).  MeshFile.h
+// checks that they match Vertex, MeshBounds, MeshLod and
+// Meshlet.
+// --------------------------------------------------------
+static const unsigned int MeshFileMagic = 0x4853454D;	// "MESH"
+static const unsigned int MeshFileVersion = 3;
+
+struct MeshFileVertex
+{
+	float position[3];
+	float color[4];
+};
+
+struct MeshFileLod
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	float error;
+};
+
+struct MeshFileMeshlet
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	float center[3];
+	float radius;
+	float coneApex[3];
+	float coneAxis[3];
+	float coneCutoff;
+};
+
+struct MeshFileHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int vertexStride;	// Must match sizeof(MeshFileVertex)
+	unsigned int vertexCount;
+	unsigned int indexCount;
+	unsigned int indexSize;		// Bytes per index: 2 or 4
+	unsigned int lodCount;		// 0 = the whole index stream is one LOD
+	unsigned int vertexOffset;
+	unsigned int indexOffset;
+	unsigned int lodOffset;
+	unsigned int meshletCount;	// 0 = no clusters, cull the mesh whole
+	unsigned int meshletOffset;
+	unsigned int fileSize;		// Catches truncated files
+
+	//local-space bounds: AABB, then a sphere centered on it
+	float boundsMin[3];
+	float boundsMax[3];
+	float sphereCenter[3];
+	float sphereRadius;
+};
+
+static_assert(sizeof(MeshFileVertex) == 28, "MeshFileVertex layout is part of the file format");
+static_assert(sizeof(MeshFileLod) == 12, "MeshFileLod layout is part of the file format");
+static_assert(sizeof(MeshFileMeshlet) == 52, "MeshFileMeshlet layout is part of the file format");
+static_assert(sizeof(MeshFileHeader) == 92, "MeshFileHeader layout is part of the file format");
+
+// Pointers into a mesh file's memory, filled in by ReadMeshFile()
+struct MeshFileContents
+{
+	const MeshFileHeader* header;
+	const MeshFileVertex* vertices;
+	const void* indices;		// header->indexSize bytes each
+	const MeshFileLod* lods;
+	const MeshFileMeshlet* meshlets;
+};
+
+//checks the header and that every stream fits in the data, then points contents
+//into it (nothing is copied).  Index values aren't range-checked; both render
+//devices tolerate out-of-range ones
+bool ReadMeshFile(const void* data, size_t size, MeshFileContents& contents);
+
+//writes a mesh file, computing its bounds from the vertices (lodCount 0 = one LOD).
+//The indices are stored as 16-bit when they all fit
+bool WriteMeshFile(const std::string& path,
+	const MeshFileVertex* vertices, unsigned int vertexCount,
+	const unsigned int* indices, unsigned int indexCount,
+	const MeshFileLod* lods, unsigned int lodCount,
+	const MeshFileMeshlet* meshlets = 0, unsigned int meshletCount = 0);
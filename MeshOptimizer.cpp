@@ -0,0 +1,431 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// Forsyth's scoring constants
+static const int MaxCacheSize = 32;
+static const float CacheDecayPower = 1.5f;
+static const float LastTriangleScore = 0.75f;
+static const float ValenceBoostScale = 2.0f;
+static const float ValenceBoostPower = 0.5f;
+
+VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+	// A vertex is in the FIFO if it was added within the last cacheSize insertions
+	std::vector<unsigned int> insertedAt(vertexCount, 0);
+	std::vector<unsigned char> referenced(vertexCount, 0);
+	unsigned int timestamp = cacheSize + 1;
+	unsigned int misses = 0;
+	size_t uniqueVertices = 0;
+
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		unsigned int index = indices[i];
+		if (timestamp - insertedAt[index] > cacheSize)
+		{
+			insertedAt[index] = timestamp++;
+			misses++;
+		}
+		if (!referenced[index])
+		{
+			referenced[index] = 1;
+			uniqueVertices++;
+		}
+	}
+
+	VertexCacheStats stats;
+	stats.transformedVertices = misses;
+	stats.acmr = indexCount ? misses / (indexCount / 3.0f) : 0.0f;
+	stats.atvr = uniqueVertices ? misses / (float)uniqueVertices : 0.0f;
+	return stats;
+}
+
+namespace
+{
+	// Vertices with more triangles left than this all get the last valence score
+	const unsigned int MaxValence = 64;
+
+	// Forsyth's scores, tabulated per call (the baker runs several at once)
+	struct VertexScores
+	{
+		float cache[MaxCacheSize];
+		float valence[MaxValence + 1];
+
+		VertexScores()
+		{
+			// The last triangle's vertices get a fixed score, so the
+			// next triangle doesn't just reuse the same edge
+			for (int i = 0; i < MaxCacheSize; i++)
+				cache[i] = i < 3 ? LastTriangleScore : powf(1.0f - (i - 3) / (float)(MaxCacheSize - 3), CacheDecayPower);
+
+			// Vertices with few triangles left are worth finishing off
+			valence[0] = 0.0f;
+			for (unsigned int i = 1; i <= MaxValence; i++)
+				valence[i] = ValenceBoostScale * powf((float)i, -ValenceBoostPower);
+		}
+
+		float Score(int cachePosition, unsigned int remainingTriangles) const
+		{
+			if (remainingTriangles == 0)
+				return -1.0f;	// Nothing left to draw with it
+			float score = cachePosition >= 0 ? cache[cachePosition] : 0.0f;
+			return score + valence[remainingTriangles < MaxValence ? remainingTriangles : MaxValence];
+		}
+	};
+}
+
+// --------------------------------------------------------
+// Greedily emits the highest scoring triangle, where a
+// triangle scores the sum of its vertices: higher the nearer
+// they are to the front of a simulated LRU cache, and the
+// fewer triangles they have left.  Only the triangles of
+// vertices in the cache are rescored each step, so it runs
+// in linear time; when none remain it carries on from the
+// next unemitted triangle in the input.
+// --------------------------------------------------------
+void OptimizeVertexCache(unsigned int* destination, const unsigned int* indices, size_t indexCount, size_t vertexCount)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	// Triangles using each vertex, packed into one array
+	std::vector<unsigned int> triangleOffsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < indexCount; i++)
+		triangleOffsets[indices[i] + 1]++;
+	for (size_t v = 0; v < vertexCount; v++)
+		triangleOffsets[v + 1] += triangleOffsets[v];
+
+	std::vector<unsigned int> vertexTriangles(indexCount);
+	std::vector<unsigned int> remaining(vertexCount, 0);	// Unemitted triangles per vertex, also the fill cursor
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		unsigned int v = indices[i];
+		vertexTriangles[triangleOffsets[v] + remaining[v]++] = (unsigned int)(i / 3);
+	}
+
+	VertexScores scores;
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		vertexScore[v] = scores.Score(-1, remaining[v]);
+
+	std::vector<unsigned char> emitted(triangleCount, 0);
+
+	// Room for the cache plus the three vertices pushed in on top of it
+	unsigned int cache[MaxCacheSize + 3];
+	unsigned int newCache[MaxCacheSize + 3];
+	int cacheCount = 0;
+
+	// Start from the best triangle overall
+	size_t best = 0;
+	float bestScore = -1.0f;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+		if (score > bestScore)
+		{
+			bestScore = score;
+			best = t;
+		}
+	}
+
+	size_t inputCursor = 0;
+	for (size_t output = 0; output < triangleCount; output++)
+	{
+		const unsigned int* triangle = indices + best * 3;
+		memcpy(destination + output * 3, triangle, sizeof(unsigned int) * 3);
+		emitted[best] = 1;
+
+		// Take the triangle off each vertex's list
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int v = triangle[k];
+			unsigned int* list = &vertexTriangles[triangleOffsets[v]];
+			unsigned int count = remaining[v];
+			for (unsigned int i = 0; i < count; i++)
+			{
+				if (list[i] == best)
+				{
+					list[i] = list[count - 1];
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		// New LRU order: this triangle's vertices, then the rest of the old cache
+		int newCount = 0;
+		for (int k = 0; k < 3; k++)
+			newCache[newCount++] = triangle[k];
+		for (int i = 0; i < cacheCount; i++)
+		{
+			unsigned int v = cache[i];
+			if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+				newCache[newCount++] = v;
+		}
+
+		// Anything pushed past the end falls out of the cache
+		for (int i = MaxCacheSize; i < newCount; i++)
+			cachePosition[newCache[i]] = -1;
+		cacheCount = newCount < MaxCacheSize ? newCount : MaxCacheSize;
+		memcpy(cache, newCache, sizeof(unsigned int) * cacheCount);
+
+		for (int i = 0; i < cacheCount; i++)
+			cachePosition[cache[i]] = i;
+
+		// Rescore the cached vertices, then their triangles, tracking the best
+		for (int i = 0; i < newCount; i++)
+		{
+			unsigned int v = newCache[i];
+			vertexScore[v] = scores.Score(cachePosition[v], remaining[v]);
+		}
+
+		bestScore = -1.0f;
+		best = triangleCount;
+		for (int i = 0; i < cacheCount; i++)
+		{
+			unsigned int v = cache[i];
+			const unsigned int* list = &vertexTriangles[triangleOffsets[v]];
+			for (unsigned int j = 0; j < remaining[v]; j++)
+			{
+				unsigned int t = list[j];
+				float score = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+				if (score > bestScore)
+				{
+					bestScore = score;
+					best = t;
+				}
+			}
+		}
+
+		// Dead end - nothing in the cache has triangles left
+		if (best == triangleCount)
+		{
+			while (inputCursor < triangleCount && emitted[inputCursor])
+				inputCursor++;
+			best = inputCursor;
+		}
+	}
+}
+
+namespace
+{
+	// Triangles [start, end) that get moved as one piece
+	struct Cluster
+	{
+		size_t start;
+		size_t end;
+		float sortKey;
+	};
+
+	const float* GetPosition(const unsigned char* vertices, size_t vertexSize, size_t positionOffset, unsigned int index)
+	{
+		return (const float*)(vertices + index * vertexSize + positionOffset);
+	}
+
+	// Misses for each triangle against a FIFO cache that starts empty at every cluster boundary
+	void CountMisses(const unsigned int* indices, size_t startTriangle, size_t endTriangle,
+		std::vector<unsigned int>& insertedAt, unsigned int& timestamp, unsigned int cacheSize, std::vector<unsigned char>& misses)
+	{
+		timestamp += cacheSize + 1;	// Empties the cache
+		for (size_t t = startTriangle; t < endTriangle; t++)
+		{
+			misses[t] = 0;
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int index = indices[t * 3 + k];
+				if (timestamp - insertedAt[index] > cacheSize)
+				{
+					insertedAt[index] = timestamp++;
+					misses[t]++;
+				}
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Splits the triangles into clusters that can be reordered
+// without hurting the cache much: first where the cache
+// naturally restarts (all three vertices miss), then inside
+// those wherever the running ACMR is already within
+// threshold of the whole cluster's.  Clusters are then
+// sorted by how far out their average normal points from
+// the mesh center, so the outer surface is drawn first and
+// hides what's behind it.
+// --------------------------------------------------------
+void OptimizeOverdraw(unsigned int* destination, const unsigned int* indices, size_t indexCount,
+	const void* vertices, size_t vertexCount, size_t vertexSize, size_t positionOffset, float threshold)
+{
+	const unsigned int cacheSize = 16;
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return;
+
+	std::vector<unsigned int> insertedAt(vertexCount, 0);
+	unsigned int timestamp = 0;
+	std::vector<unsigned char> misses(triangleCount);
+	CountMisses(indices, 0, triangleCount, insertedAt, timestamp, cacheSize, misses);
+
+	std::vector<size_t> hardBoundaries;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		if (t == 0 || misses[t] == 3)
+			hardBoundaries.push_back(t);
+	}
+	hardBoundaries.push_back(triangleCount);
+
+	std::vector<Cluster> clusters;
+	for (size_t h = 0; h + 1 < hardBoundaries.size(); h++)
+	{
+		size_t start = hardBoundaries[h];
+		size_t end = hardBoundaries[h + 1];
+
+		unsigned int clusterMisses = 0;
+		CountMisses(indices, start, end, insertedAt, timestamp, cacheSize, misses);
+		for (size_t t = start; t < end; t++)
+			clusterMisses += misses[t];
+		float acmrLimit = threshold * clusterMisses / (float)(end - start);
+
+		// Cut wherever the run so far is efficient enough, restarting the count (and the cache)
+		timestamp += cacheSize + 1;
+		size_t softStart = start;
+		unsigned int runningMisses = 0;
+		for (size_t t = start; t < end; t++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int index = indices[t * 3 + k];
+				if (timestamp - insertedAt[index] > cacheSize)
+				{
+					insertedAt[index] = timestamp++;
+					runningMisses++;
+				}
+			}
+
+			if (t + 1 < end && runningMisses <= acmrLimit * (t + 1 - softStart))
+			{
+				Cluster cluster = { softStart, t + 1, 0.0f };
+				clusters.push_back(cluster);
+				softStart = t + 1;
+				runningMisses = 0;
+				timestamp += cacheSize + 1;
+			}
+		}
+		Cluster cluster = { softStart, end, 0.0f };
+		clusters.push_back(cluster);
+	}
+
+	// Area-weighted centers and normals
+	const unsigned char* bytes = (const unsigned char*)vertices;
+	float meshCenter[3] = { 0, 0, 0 };
+	float meshArea = 0.0f;
+	std::vector<float> clusterData(clusters.size() * 6, 0.0f);	// center xyz, normal xyz
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		float* center = &clusterData[c * 6];
+		float* normal = center + 3;
+		float clusterArea = 0.0f;
+		for (size_t t = clusters[c].start; t < clusters[c].end; t++)
+		{
+			const float* p0 = GetPosition(bytes, vertexSize, positionOffset, indices[t * 3]);
+			const float* p1 = GetPosition(bytes, vertexSize, positionOffset, indices[t * 3 + 1]);
+			const float* p2 = GetPosition(bytes, vertexSize, positionOffset, indices[t * 3 + 2]);
+			float u[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float v[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+			float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				center[axis] += (p0[axis] + p1[axis] + p2[axis]) / 3.0f * area;
+				normal[axis] += n[axis];
+			}
+			clusterArea += area;
+		}
+
+		for (int axis = 0; axis < 3; axis++)
+			meshCenter[axis] += center[axis];
+		meshArea += clusterArea;
+		if (clusterArea > 0.0f)
+		{
+			for (int axis = 0; axis < 3; axis++)
+				center[axis] /= clusterArea;
+		}
+	}
+	if (meshArea > 0.0f)
+	{
+		for (int axis = 0; axis < 3; axis++)
+			meshCenter[axis] /= meshArea;
+	}
+
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		const float* center = &clusterData[c * 6];
+		const float* normal = center + 3;
+		float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float key = 0.0f;
+		for (int axis = 0; axis < 3; axis++)
+			key += (center[axis] - meshCenter[axis]) * normal[axis];
+		clusters[c].sortKey = length > 0.0f ? key / length : 0.0f;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+	size_t output = 0;
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		size_t count = (clusters[c].end - clusters[c].start) * 3;
+		memcpy(destination + output, indices + clusters[c].start * 3, sizeof(unsigned int) * count);
+		output += count;
+	}
+}
+
+size_t OptimizeVertexFetch(void* destination, unsigned int* indices, size_t indexCount,
+	const void* vertices, size_t vertexCount, size_t vertexSize)
+{
+	const unsigned int unassigned = 0xFFFFFFFF;
+	std::vector<unsigned int> remap(vertexCount, unassigned);
+	unsigned char* output = (unsigned char*)destination;
+	const unsigned char* input = (const unsigned char*)vertices;
+
+	unsigned int nextVertex = 0;
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		unsigned int index = indices[i];
+		if (remap[index] == unassigned)
+		{
+			memcpy(output + nextVertex * vertexSize, input + index * vertexSize, vertexSize);
+			remap[index] = nextVertex++;
+		}
+		indices[i] = remap[index];
+	}
+	return nextVertex;
+}
+
+size_t OptimizeMesh(void* vertices, size_t vertexCount, size_t vertexSize, size_t positionOffset,
+	unsigned int* indices, size_t indexCount, MeshOptimizationReport* report)
+{
+	if (report)
+	{
+		report->before = AnalyzeVertexCache(indices, indexCount, vertexCount);
+		report->vertexCountBefore = vertexCount;
+	}
+
+	std::vector<unsigned int> scratch(indexCount);
+	OptimizeVertexCache(scratch.data(), indices, indexCount, vertexCount);
+	OptimizeOverdraw(indices, scratch.data(), indexCount, vertices, vertexCount, vertexSize, positionOffset);
+
+	std::vector<unsigned char> original((const unsigned char*)vertices, (const unsigned char*)vertices + vertexCount * vertexSize);
+	size_t newVertexCount = OptimizeVertexFetch(vertices, indices, indexCount, original.data(), vertexCount, vertexSize);
+
+	if (report)
+	{
+		report->after = AnalyzeVertexCache(indices, indexCount, newVertexCount);
+		report->vertexCountAfter = newVertexCount;
+	}
+	return newVertexCount;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+
+// --------------------------------------------------------
+// GPU-friendly reordering of indexed triangle meshes
+//
+// Run the passes in this order, each feeding the next:
+//   1. OptimizeVertexCache - triangle order for post-transform
+//      cache hits (Forsyth's linear-speed algorithm)
+//   2. OptimizeOverdraw    - reorders runs of cache-friendly
+//      triangles so outward-facing ones come first (after
+//      Sander, Nehab & Barczak), giving up at most threshold
+//      times the cache efficiency
+//   3. OptimizeVertexFetch - vertex order to match first use,
+//      so the fetch walks memory forwards
+// OptimizeMesh() does all three in place.
+//
+// Works on raw vertex bytes, so it serves both the runtime
+// (Vertex) and the baker (MeshFileVertex).  Positions are
+// three floats at positionOffset in each vertex.  Index
+// counts must be multiples of 3.
+// --------------------------------------------------------
+
+// How well an index order uses a FIFO post-transform cache
+struct VertexCacheStats
+{
+	unsigned int transformedVertices;	// Cache misses
+	float acmr;							// Misses per triangle (0.5 - 3, lower is better)
+	float atvr;							// Misses per referenced vertex (1 is ideal)
+};
+
+// Before and after numbers from OptimizeMesh()
+struct MeshOptimizationReport
+{
+	VertexCacheStats before;
+	VertexCacheStats after;
+	size_t vertexCountBefore;
+	size_t vertexCountAfter;	// Unreferenced vertices are dropped
+};
+
+//simulates a FIFO cache of cacheSize entries (16 is typical of current GPUs)
+VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = 16);
+
+//destination gets the reordered triangles (it may not alias indices)
+void OptimizeVertexCache(unsigned int* destination, const unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+//expects cache-optimized indices; threshold 1.05 allows a 5% worse ACMR
+void OptimizeOverdraw(unsigned int* destination, const unsigned int* indices, size_t indexCount,
+	const void* vertices, size_t vertexCount, size_t vertexSize, size_t positionOffset, float threshold = 1.05f);
+
+//rewrites vertices into destination in first-use order and remaps indices in place;
+//returns how many vertices were referenced (and written)
+size_t OptimizeVertexFetch(void* destination, unsigned int* indices, size_t indexCount,
+	const void* vertices, size_t vertexCount, size_t vertexSize);
+
+//all three passes, in place; returns the new vertex count
+size_t OptimizeMesh(void* vertices, size_t vertexCount, size_t vertexSize, size_t positionOffset,
+	unsigned int* indices, size_t indexCount, MeshOptimizationReport* report = 0);
@@ -0,0 +1,485 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <queue>
+
+namespace
+{
+	// How far a collapse may turn a surviving triangle (cosine of the angle)
+	const double MinNormalCosine = 0.25;
+
+	struct Vector3
+	{
+		double x, y, z;
+	};
+
+	Vector3 Subtract(const Vector3& a, const Vector3& b)
+	{
+		Vector3 result = { a.x - b.x, a.y - b.y, a.z - b.z };
+		return result;
+	}
+
+	Vector3 Cross(const Vector3& a, const Vector3& b)
+	{
+		Vector3 result = { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+		return result;
+	}
+
+	double Dot(const Vector3& a, const Vector3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	// --------------------------------------------------------
+	// The sum of squared distances to a set of planes, as the
+	// upper triangle of a symmetric 4x4 matrix.  Planes are
+	// weighted by their triangle's area, and the total weight
+	// is kept so errors can be reported as a mean.
+	// --------------------------------------------------------
+	struct Quadric
+	{
+		double a2, ab, ac, ad;
+		double b2, bc, bd;
+		double c2, cd;
+		double d2;
+		double weight;
+	};
+
+	void AddPlane(Quadric& q, const Vector3& normal, double d, double weight)
+	{
+		q.a2 += weight * normal.x * normal.x;
+		q.ab += weight * normal.x * normal.y;
+		q.ac += weight * normal.x * normal.z;
+		q.ad += weight * normal.x * d;
+		q.b2 += weight * normal.y * normal.y;
+		q.bc += weight * normal.y * normal.z;
+		q.bd += weight * normal.y * d;
+		q.c2 += weight * normal.z * normal.z;
+		q.cd += weight * normal.z * d;
+		q.d2 += weight * d * d;
+		q.weight += weight;
+	}
+
+	void AddQuadric(Quadric& q, const Quadric& other)
+	{
+		q.a2 += other.a2; q.ab += other.ab; q.ac += other.ac; q.ad += other.ad;
+		q.b2 += other.b2; q.bc += other.bc; q.bd += other.bd;
+		q.c2 += other.c2; q.cd += other.cd;
+		q.d2 += other.d2;
+		q.weight += other.weight;
+	}
+
+	// Mean squared distance from p to the quadric's planes
+	double GetError(const Quadric& q, const Vector3& p)
+	{
+		double error =
+			q.a2 * p.x * p.x + q.b2 * p.y * p.y + q.c2 * p.z * p.z +
+			2 * (q.ab * p.x * p.y + q.ac * p.x * p.z + q.bc * p.y * p.z) +
+			2 * (q.ad * p.x + q.bd * p.y + q.cd * p.z) + q.d2;
+		if (error < 0)
+			error = 0;
+		return q.weight > 0 ? error / q.weight : error;
+	}
+
+	// Moving vertex "from" onto vertex "to"
+	struct Collapse
+	{
+		double cost;
+		unsigned int from;
+		unsigned int to;
+		unsigned int fromVersion;	// Versions when queued - if either vertex has
+		unsigned int toVersion;		// changed since, the entry is stale
+	};
+
+	// Cheapest first, then lowest vertex indices, so ties always break the same way
+	struct CollapseOrder
+	{
+		bool operator()(const Collapse& a, const Collapse& b) const
+		{
+			if (a.cost != b.cost)
+				return a.cost > b.cost;
+			if (a.from != b.from)
+				return a.from > b.from;
+			return a.to > b.to;
+		}
+	};
+
+	class Simplifier
+	{
+	public:
+		Simplifier(const unsigned int* indices, size_t indexCount,
+			const void* vertices, size_t vertexCount, size_t vertexSize, size_t positionOffset);
+		//can be called again with a lower target to carry on from where the last call stopped
+		size_t Run(unsigned int* destination, size_t targetIndexCount, float targetError, float* resultError);
+
+	private:
+		std::vector<Vector3> positions;
+		std::vector<Quadric> quadrics;
+		std::vector<unsigned char> locked;		// On an open or non-manifold edge
+		std::vector<unsigned char> removed;		// Collapsed into another vertex
+		std::vector<unsigned int> versions;		// Bumped whenever a vertex's quadric changes
+
+		std::vector<unsigned int> triangles;	// Three corners each, updated as vertices collapse
+		std::vector<unsigned char> alive;
+		std::vector<std::vector<unsigned int>> vertexTriangles;
+		size_t liveTriangles;
+		double reached;		// Highest cost collapsed so far
+
+		std::priority_queue<Collapse, std::vector<Collapse>, CollapseOrder> queue;
+		std::vector<unsigned int> scratchA;
+		std::vector<unsigned int> scratchB;
+
+		bool Contains(unsigned int triangle, unsigned int vertex);
+		void GetNeighbours(unsigned int vertex, std::vector<unsigned int>& neighbours);
+		void QueueEdge(unsigned int a, unsigned int b);
+		bool CanCollapse(unsigned int from, unsigned int to);
+		void DoCollapse(unsigned int from, unsigned int to);
+	};
+
+	// --------------------------------------------------------
+	// Sets up each vertex's quadric from the planes of the
+	// triangles around it, locks vertices on edges that don't
+	// have exactly two triangles, and queues every edge.
+	// Triangles with a repeated corner are dropped.
+	// --------------------------------------------------------
+	Simplifier::Simplifier(const unsigned int* indices, size_t indexCount,
+		const void* vertices, size_t vertexCount, size_t vertexSize, size_t positionOffset)
+	{
+		const unsigned char* input = (const unsigned char*)vertices;
+		positions.resize(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			float p[3];
+			memcpy(p, input + i * vertexSize + positionOffset, sizeof(p));
+			positions[i].x = p[0];
+			positions[i].y = p[1];
+			positions[i].z = p[2];
+		}
+
+		Quadric zero = {};
+		quadrics.assign(vertexCount, zero);
+		locked.assign(vertexCount, 0);
+		removed.assign(vertexCount, 0);
+		versions.assign(vertexCount, 0);
+		vertexTriangles.resize(vertexCount);
+
+		for (size_t i = 0; i + 2 < indexCount; i += 3)
+		{
+			unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+			if (a == b || b == c || c == a)
+				continue;
+
+			unsigned int triangle = (unsigned int)(triangles.size() / 3);
+			triangles.push_back(a);
+			triangles.push_back(b);
+			triangles.push_back(c);
+			vertexTriangles[a].push_back(triangle);
+			vertexTriangles[b].push_back(triangle);
+			vertexTriangles[c].push_back(triangle);
+
+			Vector3 normal = Cross(Subtract(positions[b], positions[a]), Subtract(positions[c], positions[a]));
+			double length = sqrt(Dot(normal, normal));
+			if (length == 0)
+				continue;
+
+			normal.x /= length;
+			normal.y /= length;
+			normal.z /= length;
+			double d = -Dot(normal, positions[a]);
+			AddPlane(quadrics[a], normal, d, length * 0.5);
+			AddPlane(quadrics[b], normal, d, length * 0.5);
+			AddPlane(quadrics[c], normal, d, length * 0.5);
+		}
+		liveTriangles = triangles.size() / 3;
+		alive.assign(liveTriangles, 1);
+		reached = 0;
+
+		// Each edge as (lower index << 32 | higher), sorted so equal edges are adjacent
+		std::vector<unsigned long long> edges;
+		edges.reserve(triangles.size());
+		for (size_t t = 0; t < triangles.size(); t += 3)
+		{
+			for (int corner = 0; corner < 3; corner++)
+			{
+				unsigned long long a = triangles[t + corner];
+				unsigned long long b = triangles[t + (corner + 1) % 3];
+				edges.push_back(a < b ? (a << 32 | b) : (b << 32 | a));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+
+		for (size_t start = 0; start < edges.size();)
+		{
+			size_t end = start + 1;
+			while (end < edges.size() && edges[end] == edges[start])
+				end++;
+			if (end - start != 2)
+			{
+				locked[(unsigned int)(edges[start] >> 32)] = 1;
+				locked[(unsigned int)edges[start]] = 1;
+			}
+			start = end;
+		}
+
+		for (size_t start = 0; start < edges.size();)
+		{
+			QueueEdge((unsigned int)(edges[start] >> 32), (unsigned int)edges[start]);
+			size_t end = start + 1;
+			while (end < edges.size() && edges[end] == edges[start])
+				end++;
+			start = end;
+		}
+	}
+
+	bool Simplifier::Contains(unsigned int triangle, unsigned int vertex)
+	{
+		const unsigned int* corners = &triangles[triangle * 3];
+		return corners[0] == vertex || corners[1] == vertex || corners[2] == vertex;
+	}
+
+	// Sorted, without repeats
+	void Simplifier::GetNeighbours(unsigned int vertex, std::vector<unsigned int>& neighbours)
+	{
+		neighbours.clear();
+		const std::vector<unsigned int>& around = vertexTriangles[vertex];
+		for (size_t i = 0; i < around.size(); i++)
+		{
+			if (!alive[around[i]])
+				continue;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				unsigned int other = triangles[around[i] * 3 + corner];
+				if (other != vertex)
+					neighbours.push_back(other);
+			}
+		}
+		std::sort(neighbours.begin(), neighbours.end());
+		neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+	}
+
+	// --------------------------------------------------------
+	// Queues whichever direction of the edge is cheaper (locked
+	// vertices can't be the one that moves)
+	// --------------------------------------------------------
+	void Simplifier::QueueEdge(unsigned int a, unsigned int b)
+	{
+		if (locked[a] && locked[b])
+			return;
+
+		Quadric merged = quadrics[a];
+		AddQuadric(merged, quadrics[b]);
+		double costAToB = locked[a] ? DBL_MAX : GetError(merged, positions[b]);
+		double costBToA = locked[b] ? DBL_MAX : GetError(merged, positions[a]);
+
+		Collapse collapse;
+		if (costAToB <= costBToA)
+		{
+			collapse.cost = costAToB;
+			collapse.from = a;
+			collapse.to = b;
+		}
+		else
+		{
+			collapse.cost = costBToA;
+			collapse.from = b;
+			collapse.to = a;
+		}
+		collapse.fromVersion = versions[collapse.from];
+		collapse.toVersion = versions[collapse.to];
+		queue.push(collapse);
+	}
+
+	// --------------------------------------------------------
+	// Rejects collapses that would fold the surface: the ends
+	// may only share the neighbours across the triangles on
+	// the edge itself (otherwise two sheets get pinched
+	// together), and no triangle that survives may turn over
+	// --------------------------------------------------------
+	bool Simplifier::CanCollapse(unsigned int from, unsigned int to)
+	{
+		const std::vector<unsigned int>& around = vertexTriangles[from];
+		unsigned int edgeTriangles = 0;
+		for (size_t i = 0; i < around.size(); i++)
+		{
+			if (alive[around[i]] && Contains(around[i], to))
+				edgeTriangles++;
+		}
+
+		GetNeighbours(from, scratchA);
+		GetNeighbours(to, scratchB);
+		unsigned int shared = 0;
+		for (size_t a = 0, b = 0; a < scratchA.size() && b < scratchB.size();)
+		{
+			if (scratchA[a] < scratchB[b])
+				a++;
+			else if (scratchB[b] < scratchA[a])
+				b++;
+			else
+			{
+				shared++;
+				a++;
+				b++;
+			}
+		}
+		if (shared != edgeTriangles)
+			return false;
+
+		for (size_t i = 0; i < around.size(); i++)
+		{
+			unsigned int triangle = around[i];
+			if (!alive[triangle] || Contains(triangle, to))
+				continue;
+
+			const unsigned int* corners = &triangles[triangle * 3];
+			Vector3 before[3], after[3];
+			for (int corner = 0; corner < 3; corner++)
+			{
+				before[corner] = positions[corners[corner]];
+				after[corner] = corners[corner] == from ? positions[to] : before[corner];
+			}
+
+			Vector3 normalBefore = Cross(Subtract(before[1], before[0]), Subtract(before[2], before[0]));
+			Vector3 normalAfter = Cross(Subtract(after[1], after[0]), Subtract(after[2], after[0]));
+			// Turning more than ~75 degrees counts, so slivers don't sneak through on rounding
+			double lengths = sqrt(Dot(normalBefore, normalBefore) * Dot(normalAfter, normalAfter));
+			if (Dot(normalBefore, normalAfter) <= MinNormalCosine * lengths)
+				return false;
+		}
+		return true;
+	}
+
+	// --------------------------------------------------------
+	// Moves every triangle of "from" onto "to" (the ones on the
+	// edge disappear), merges the quadrics and re-queues the
+	// edges around "to" at their new costs
+	// --------------------------------------------------------
+	void Simplifier::DoCollapse(unsigned int from, unsigned int to)
+	{
+		std::vector<unsigned int>& around = vertexTriangles[from];
+		std::vector<unsigned int>& target = vertexTriangles[to];
+		for (size_t i = 0; i < around.size(); i++)
+		{
+			unsigned int triangle = around[i];
+			if (!alive[triangle])
+				continue;
+
+			if (Contains(triangle, to))
+			{
+				alive[triangle] = 0;
+				liveTriangles--;
+				continue;
+			}
+
+			unsigned int* corners = &triangles[triangle * 3];
+			for (int corner = 0; corner < 3; corner++)
+			{
+				if (corners[corner] == from)
+					corners[corner] = to;
+			}
+			target.push_back(triangle);
+		}
+		around.clear();
+		removed[from] = 1;
+
+		size_t kept = 0;
+		for (size_t i = 0; i < target.size(); i++)
+		{
+			if (alive[target[i]])
+				target[kept++] = target[i];
+		}
+		target.resize(kept);
+
+		AddQuadric(quadrics[to], quadrics[from]);
+		versions[to]++;
+
+		GetNeighbours(to, scratchA);
+		for (size_t i = 0; i < scratchA.size(); i++)
+			QueueEdge(to, scratchA[i]);
+	}
+
+	size_t Simplifier::Run(unsigned int* destination, size_t targetIndexCount, float targetError, float* resultError)
+	{
+		double maxCost = (double)targetError * targetError;
+
+		while (liveTriangles * 3 > targetIndexCount && !queue.empty())
+		{
+			Collapse collapse = queue.top();
+			if (collapse.cost > maxCost)
+				break;
+			queue.pop();
+
+			if (removed[collapse.from] || removed[collapse.to] ||
+				versions[collapse.from] != collapse.fromVersion || versions[collapse.to] != collapse.toVersion)
+				continue;
+			if (!CanCollapse(collapse.from, collapse.to))
+				continue;
+
+			DoCollapse(collapse.from, collapse.to);
+			if (collapse.cost > reached)
+				reached = collapse.cost;
+		}
+
+		size_t output = 0;
+		for (size_t t = 0; t < alive.size(); t++)
+		{
+			if (!alive[t])
+				continue;
+			destination[output++] = triangles[t * 3];
+			destination[output++] = triangles[t * 3 + 1];
+			destination[output++] = triangles[t * 3 + 2];
+		}
+
+		if (resultError)
+			*resultError = (float)sqrt(reached);
+		return output;
+	}
+}
+
+size_t SimplifyMesh(unsigned int* destination, const unsigned int* indices, size_t indexCount,
+	const void* vertices, size_t vertexCount, size_t vertexSize, size_t positionOffset,
+	size_t targetIndexCount, float targetError, float* resultError)
+{
+	Simplifier simplifier(indices, indexCount, vertices, vertexCount, vertexSize, positionOffset);
+	return simplifier.Run(destination, targetIndexCount, targetError, resultError);
+}
+
+// --------------------------------------------------------
+// One simplifier runs down through every level in turn.  The
+// quadrics still hold the planes of the original triangles,
+// so each level's error is measured against LOD 0's surface
+// rather than piling up approximations.
+// --------------------------------------------------------
+void BuildLodChain(std::vector<unsigned int>& indices, std::vector<SimplifiedLod>& lods,
+	const void* vertices, size_t vertexCount, size_t vertexSize, size_t positionOffset,
+	unsigned int maxLods, unsigned int minTriangles)
+{
+	size_t fullCount = indices.size();
+	SimplifiedLod full = { 0, (unsigned int)fullCount, 0.0f };
+	lods.assign(1, full);
+
+	Simplifier simplifier(indices.data(), fullCount, vertices, vertexCount, vertexSize, positionOffset);
+	std::vector<unsigned int> simplified(fullCount);
+	std::vector<unsigned int> optimized(fullCount);
+	while (lods.size() < maxLods)
+	{
+		size_t previousCount = lods.back().indexCount;
+		size_t target = previousCount / 6 * 3;
+		if (target < minTriangles * 3)
+			break;
+
+		float error = 0;
+		size_t count = simplifier.Run(simplified.data(), target, FLT_MAX, &error);
+
+		// Locked borders can stall it - a level that barely shrinks isn't worth its memory
+		if (count > previousCount * 3 / 4)
+			break;
+
+		OptimizeVertexCache(optimized.data(), simplified.data(), count, vertexCount);
+		SimplifiedLod lod = { (unsigned int)indices.size(), (unsigned int)count, error };
+		indices.insert(indices.end(), optimized.begin(), optimized.begin() + count);
+		lods.push_back(lod);
+	}
+}
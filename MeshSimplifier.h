@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// --------------------------------------------------------
+// Level-of-detail generation for indexed triangle meshes
+//
+// SimplifyMesh collapses edges in order of their quadric
+// error (Garland & Heckbert) until the triangle count or the
+// error budget runs out.  Every collapse moves one vertex
+// onto the other, so no vertices are made or changed - a
+// simplified mesh is just a new index list over the same
+// vertex buffer, and a whole LOD chain can share it.
+//
+// Vertices on open edges (including seams, where welding
+// left two vertices at one position) never move, so the
+// outline and attribute borders survive; collapses that
+// would flip a triangle or pinch the surface are skipped.
+//
+// Like MeshOptimizer, this works on raw vertex bytes with
+// three float positions at positionOffset, and it's fully
+// deterministic - the same input always gives the same
+// output, whatever the platform's hash or thread ordering.
+// --------------------------------------------------------
+
+// One level of a chain from BuildLodChain(): a range of its index list
+struct SimplifiedLod
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+	float error;			// Furthest (roughly) the surface has moved, in position units
+};
+
+//destination (room for indexCount, not aliasing indices) gets the surviving triangles in their
+//original order; returns the new index count.  Stops at targetIndexCount or once the next
+//collapse would move the surface more than targetError.  resultError gets the error reached
+size_t SimplifyMesh(unsigned int* destination, const unsigned int* indices, size_t indexCount,
+	const void* vertices, size_t vertexCount, size_t vertexSize, size_t positionOffset,
+	size_t targetIndexCount, float targetError, float* resultError = 0);
+
+//indices holds LOD 0 on the way in; each coarser LOD (about half the triangles of the one
+//before, cache-optimized) is appended after it.  lods gets every level, finest first, with
+//errors that never decrease.  Stops at maxLods, below minTriangles, or when a level can't
+//be reduced much further
+void BuildLodChain(std::vector<unsigned int>& indices, std::vector<SimplifiedLod>& lods,
+	const void* vertices, size_t vertexCount, size_t vertexSize, size_t positionOffset,
+	unsigned int maxLods = 8, unsigned int minTriangles = 16);
@@ -0,0 +1,452 @@
+#include "MeshletBuilder.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// What a candidate triangle costs on top of the new vertices it brings: its
+	// normal turning from the meshlet's, its distance out in meshlet radii, and
+	// each free triangle around it (so ones about to be cut off get taken now).
+	// Vertices dominate, so meshlets fill up; the rest keeps them round and flat
+	const float NormalCost = 0.5f;
+	const float DistanceCost = 0.25f;
+	const float FreeNeighbourCost = 0.02f;
+
+	// Normals spreading further than this from the axis (cosine) leave a cone
+	// too wide to be worth testing
+	const float MinConeCosine = 0.1f;
+
+	struct Vector3
+	{
+		float x, y, z;
+	};
+
+	Vector3 Subtract(const Vector3& a, const Vector3& b)
+	{
+		Vector3 result = { a.x - b.x, a.y - b.y, a.z - b.z };
+		return result;
+	}
+
+	Vector3 Cross(const Vector3& a, const Vector3& b)
+	{
+		Vector3 result = { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+		return result;
+	}
+
+	float Dot(const Vector3& a, const Vector3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	float Length(const Vector3& v)
+	{
+		return sqrtf(Dot(v, v));
+	}
+
+	// Unit length, or all zero if v is
+	Vector3 Normalize(const Vector3& v)
+	{
+		float length = Length(v);
+		Vector3 result = { 0, 0, 0 };
+		if (length > 0)
+		{
+			result.x = v.x / length;
+			result.y = v.y / length;
+			result.z = v.z / length;
+		}
+		return result;
+	}
+
+	struct Triangle
+	{
+		Vector3 normal;		// Unit front-face normal (zero if degenerate)
+		Vector3 centroid;
+	};
+
+	// --------------------------------------------------------
+	// Bounding sphere (centered on the AABB) and normal cone of
+	// one meshlet.  The cone axis is the average normal; its apex
+	// is pushed back along the axis until it's behind every
+	// triangle's plane, so any camera in the cone is too.
+	// --------------------------------------------------------
+	void FinishMeshlet(Meshlet& meshlet, const unsigned int* indices, const std::vector<Vector3>& positions,
+		const std::vector<Triangle>& triangles, const unsigned int* triangleOrder)
+	{
+		unsigned int triangleCount = meshlet.indexCount / 3;
+
+		Vector3 boundsMin = positions[indices[meshlet.firstIndex]];
+		Vector3 boundsMax = boundsMin;
+		for (unsigned int i = 0; i < meshlet.indexCount; i++)
+		{
+			const Vector3& p = positions[indices[meshlet.firstIndex + i]];
+			boundsMin.x = p.x < boundsMin.x ? p.x : boundsMin.x;
+			boundsMin.y = p.y < boundsMin.y ? p.y : boundsMin.y;
+			boundsMin.z = p.z < boundsMin.z ? p.z : boundsMin.z;
+			boundsMax.x = p.x > boundsMax.x ? p.x : boundsMax.x;
+			boundsMax.y = p.y > boundsMax.y ? p.y : boundsMax.y;
+			boundsMax.z = p.z > boundsMax.z ? p.z : boundsMax.z;
+		}
+
+		Vector3 center = { (boundsMin.x + boundsMax.x) * 0.5f, (boundsMin.y + boundsMax.y) * 0.5f, (boundsMin.z + boundsMax.z) * 0.5f };
+		float radius = 0;
+		for (unsigned int i = 0; i < meshlet.indexCount; i++)
+		{
+			float distance = Length(Subtract(positions[indices[meshlet.firstIndex + i]], center));
+			radius = distance > radius ? distance : radius;
+		}
+
+		meshlet.center[0] = center.x;
+		meshlet.center[1] = center.y;
+		meshlet.center[2] = center.z;
+		meshlet.radius = radius;
+
+		// Until proven otherwise, a cone that never culls
+		meshlet.coneApex[0] = center.x;
+		meshlet.coneApex[1] = center.y;
+		meshlet.coneApex[2] = center.z;
+		meshlet.coneAxis[0] = meshlet.coneAxis[1] = meshlet.coneAxis[2] = 0;
+		meshlet.coneCutoff = 2.0f;
+
+		Vector3 normalSum = { 0, 0, 0 };
+		for (unsigned int t = 0; t < triangleCount; t++)
+		{
+			const Vector3& normal = triangles[triangleOrder[t]].normal;
+			normalSum.x += normal.x;
+			normalSum.y += normal.y;
+			normalSum.z += normal.z;
+		}
+
+		Vector3 axis = Normalize(normalSum);
+		if (Dot(axis, axis) == 0)
+			return;
+
+		float minCosine = 1.0f;
+		float maxT = -FLT_MAX;
+		for (unsigned int t = 0; t < triangleCount; t++)
+		{
+			const Vector3& normal = triangles[triangleOrder[t]].normal;
+			if (Dot(normal, normal) == 0)
+				continue;
+
+			float cosine = Dot(normal, axis);
+			minCosine = cosine < minCosine ? cosine : minCosine;
+			if (minCosine <= MinConeCosine)
+				return;
+
+			// How far back along the axis the center has to go to reach this plane
+			const Vector3& p0 = positions[indices[meshlet.firstIndex + t * 3]];
+			float distance = Dot(Subtract(center, p0), normal) / cosine;
+			maxT = distance > maxT ? distance : maxT;
+		}
+		if (maxT == -FLT_MAX)
+			return;
+
+		meshlet.coneApex[0] = center.x - axis.x * maxT;
+		meshlet.coneApex[1] = center.y - axis.y * maxT;
+		meshlet.coneApex[2] = center.z - axis.z * maxT;
+		meshlet.coneAxis[0] = axis.x;
+		meshlet.coneAxis[1] = axis.y;
+		meshlet.coneAxis[2] = axis.z;
+		meshlet.coneCutoff = sqrtf(1.0f - minCosine * minCosine);
+	}
+}
+
+// --------------------------------------------------------
+// Grows one meshlet at a time from a seed triangle beside
+// the last one.  Each step adds the neighbouring triangle (one
+// sharing a position with the meshlet) that brings the
+// fewest new vertices, then the one closest in normal and
+// distance and with the fewest free neighbours, until either limit is hit or it runs out of
+// neighbours.  Neighbours are found by position rather than
+// vertex index, so meshlets grow across attribute seams.
+//
+// The neighbours are kept as a list that grows as positions
+// join the meshlet, and each position counts the free
+// triangles around it, so a step costs a few operations per
+// neighbour however big the mesh is.
+// --------------------------------------------------------
+size_t BuildMeshlets(std::vector<Meshlet>& meshlets, unsigned int* indices, size_t indexCount,
+	const void* vertices, size_t vertexCount, size_t vertexSize, size_t positionOffset)
+{
+	meshlets.clear();
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0)
+		return 0;
+
+	const unsigned char* input = (const unsigned char*)vertices;
+	std::vector<Vector3> positions(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+		memcpy(&positions[i], input + i * vertexSize + positionOffset, sizeof(Vector3));
+
+	// Every vertex's first vertex at the same position (sorted, so it's deterministic)
+	std::vector<unsigned int> sorted(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+		sorted[i] = (unsigned int)i;
+	std::sort(sorted.begin(), sorted.end(), [&](unsigned int a, unsigned int b)
+	{
+		const Vector3& pa = positions[a];
+		const Vector3& pb = positions[b];
+		if (pa.x != pb.x) return pa.x < pb.x;
+		if (pa.y != pb.y) return pa.y < pb.y;
+		if (pa.z != pb.z) return pa.z < pb.z;
+		return a < b;
+	});
+	std::vector<unsigned int> positionId(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		bool same = i > 0 && memcmp(&positions[sorted[i]], &positions[sorted[i - 1]], sizeof(Vector3)) == 0;
+		positionId[sorted[i]] = same ? positionId[sorted[i - 1]] : sorted[i];
+	}
+
+	std::vector<Triangle> triangles(triangleCount);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		const Vector3& p0 = positions[indices[t * 3]];
+		const Vector3& p1 = positions[indices[t * 3 + 1]];
+		const Vector3& p2 = positions[indices[t * 3 + 2]];
+		triangles[t].normal = Normalize(Cross(Subtract(p1, p0), Subtract(p2, p0)));
+		triangles[t].centroid.x = (p0.x + p1.x + p2.x) / 3.0f;
+		triangles[t].centroid.y = (p0.y + p1.y + p2.y) / 3.0f;
+		triangles[t].centroid.z = (p0.z + p1.z + p2.z) / 3.0f;
+	}
+
+	// Triangles around each position, as one array with per-position starts
+	std::vector<unsigned int> adjacencyStart(vertexCount + 1, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		adjacencyStart[positionId[indices[i]] + 1]++;
+	for (size_t i = 0; i < vertexCount; i++)
+		adjacencyStart[i + 1] += adjacencyStart[i];
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	std::vector<unsigned int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		adjacency[fill[positionId[indices[i]]]++] = (unsigned int)(i / 3);
+
+	std::vector<unsigned char> taken(triangleCount, 0);
+	std::vector<unsigned int> order;
+	order.reserve(triangleCount);
+
+	// Which meshlet last used each vertex (and each position), so membership is one lookup
+	const unsigned int None = 0xFFFFFFFF;
+	std::vector<unsigned int> vertexMeshlet(vertexCount, None);
+	std::vector<unsigned int> positionMeshlet(vertexCount, None);
+	std::vector<unsigned int> meshletPositions;
+	unsigned int meshletVertexCount = 0;
+
+	// Free triangles around each position, kept up to date as they're taken
+	std::vector<unsigned int> positionFree(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+		positionFree[i] = adjacencyStart[i + 1] - adjacencyStart[i];
+
+	// Triangles still free around a triangle's corners - the fewer, the more
+	// likely it is to be stranded in a meshlet of its own later
+	auto countFreeNeighbours = [&](unsigned int triangle)
+	{
+		return
+			positionFree[positionId[indices[triangle * 3]]] +
+			positionFree[positionId[indices[triangle * 3 + 1]]] +
+			positionFree[positionId[indices[triangle * 3 + 2]]];
+	};
+
+	// The current meshlet's free neighbours, each listed once (taken ones are
+	// dropped as the list is next walked)
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> candidateMeshlet(triangleCount, None);
+
+	size_t firstFree = 0;
+	while (true)
+	{
+		// Start next to the last meshlet, in its most hemmed-in free triangle, so
+		// the free region shrinks from its edge instead of leaving islands.
+		// Failing that, the first free triangle in index order
+		unsigned int seed = None;
+		unsigned int seedFree = None;
+		for (size_t p = 0; p < meshletPositions.size(); p++)
+		{
+			unsigned int position = meshletPositions[p];
+			for (unsigned int a = adjacencyStart[position]; a < adjacencyStart[position + 1]; a++)
+			{
+				unsigned int candidate = adjacency[a];
+				if (taken[candidate])
+					continue;
+				unsigned int free = countFreeNeighbours(candidate);
+				if (free < seedFree || (free == seedFree && candidate < seed))
+				{
+					seed = candidate;
+					seedFree = free;
+				}
+			}
+		}
+		if (seed == None)
+		{
+			while (firstFree < triangleCount && taken[firstFree])
+				firstFree++;
+			if (firstFree == triangleCount)
+				break;
+			seed = (unsigned int)firstFree;
+		}
+
+		unsigned int meshletIndex = (unsigned int)meshlets.size();
+		size_t firstTriangle = order.size();
+		Vector3 normalSum = { 0, 0, 0 };
+		Vector3 centroidSum = { 0, 0, 0 };
+		float radius = 0;
+		meshletPositions.clear();
+		meshletVertexCount = 0;
+		candidates.clear();
+
+		unsigned int next = seed;
+		while (true)
+		{
+			taken[next] = 1;
+			order.push_back(next);
+			for (int c = 0; c < 3; c++)
+			{
+				unsigned int vertex = indices[next * 3 + c];
+				if (vertexMeshlet[vertex] != meshletIndex)
+				{
+					vertexMeshlet[vertex] = meshletIndex;
+					meshletVertexCount++;
+				}
+				unsigned int position = positionId[vertex];
+				positionFree[position]--;
+				if (positionMeshlet[position] != meshletIndex)
+				{
+					positionMeshlet[position] = meshletIndex;
+					meshletPositions.push_back(position);
+					for (unsigned int a = adjacencyStart[position]; a < adjacencyStart[position + 1]; a++)
+					{
+						unsigned int candidate = adjacency[a];
+						if (!taken[candidate] && candidateMeshlet[candidate] != meshletIndex)
+						{
+							candidateMeshlet[candidate] = meshletIndex;
+							candidates.push_back(candidate);
+						}
+					}
+				}
+			}
+
+			const Triangle& added = triangles[next];
+			normalSum.x += added.normal.x;
+			normalSum.y += added.normal.y;
+			normalSum.z += added.normal.z;
+			centroidSum.x += added.centroid.x;
+			centroidSum.y += added.centroid.y;
+			centroidSum.z += added.centroid.z;
+
+			unsigned int meshletTriangles = (unsigned int)(order.size() - firstTriangle);
+			if (meshletTriangles == MeshletMaxTriangles)
+				break;
+
+			Vector3 center = { centroidSum.x / meshletTriangles, centroidSum.y / meshletTriangles, centroidSum.z / meshletTriangles };
+			Vector3 axis = Normalize(normalSum);
+			float addedDistance = Length(Subtract(added.centroid, center));
+			radius = addedDistance > radius ? addedDistance : radius;
+
+			unsigned int best = None;
+			float bestCost = FLT_MAX;
+			size_t kept = 0;
+			for (size_t i = 0; i < candidates.size(); i++)
+			{
+				unsigned int candidate = candidates[i];
+				if (taken[candidate])
+					continue;
+				candidates[kept++] = candidate;
+
+				unsigned int newVertices = 0;
+				for (int c = 0; c < 3; c++)
+					newVertices += vertexMeshlet[indices[candidate * 3 + c]] != meshletIndex;
+				if (meshletVertexCount + newVertices > MeshletMaxVertices)
+					continue;
+
+				const Triangle& triangle = triangles[candidate];
+				float cost = newVertices +
+					NormalCost * (1.0f - Dot(triangle.normal, axis)) +
+					DistanceCost * Length(Subtract(triangle.centroid, center)) / (radius > 0 ? radius : 1.0f) +
+					FreeNeighbourCost * countFreeNeighbours(candidate);
+				if (cost < bestCost || (cost == bestCost && candidate < best))
+				{
+					best = candidate;
+					bestCost = cost;
+				}
+			}
+			candidates.resize(kept);
+
+			if (best == None)
+				break;
+			next = best;
+		}
+
+		Meshlet meshlet;
+		meshlet.firstIndex = (unsigned int)(firstTriangle * 3);
+		meshlet.indexCount = (unsigned int)((order.size() - firstTriangle) * 3);
+		meshlets.push_back(meshlet);
+	}
+
+	// Rewrite the indices in meshlet order, then give each meshlet its bounds
+	std::vector<unsigned int> original(indices, indices + triangleCount * 3);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		indices[t * 3] = original[order[t] * 3];
+		indices[t * 3 + 1] = original[order[t] * 3 + 1];
+		indices[t * 3 + 2] = original[order[t] * 3 + 2];
+	}
+	for (size_t m = 0; m < meshlets.size(); m++)
+		FinishMeshlet(meshlets[m], indices, positions, triangles, order.data() + meshlets[m].firstIndex / 3);
+
+	// Growth order isn't cache order, so re-sort each meshlet's triangles for the
+	// vertex cache - on its own few vertices, renumbered from 0 and back again
+	std::vector<unsigned int> vertexToLocal(vertexCount, None);
+	std::vector<unsigned int> localToVertex;
+	std::vector<unsigned int> localIndices;
+	std::vector<unsigned int> optimized;
+	for (size_t m = 0; m < meshlets.size(); m++)
+	{
+		unsigned int* meshletIndices = indices + meshlets[m].firstIndex;
+		unsigned int count = meshlets[m].indexCount;
+		localToVertex.clear();
+		localIndices.resize(count);
+		for (unsigned int i = 0; i < count; i++)
+		{
+			unsigned int vertex = meshletIndices[i];
+			if (vertexToLocal[vertex] == None)
+			{
+				vertexToLocal[vertex] = (unsigned int)localToVertex.size();
+				localToVertex.push_back(vertex);
+			}
+			localIndices[i] = vertexToLocal[vertex];
+		}
+
+		optimized.resize(count);
+		OptimizeVertexCache(optimized.data(), localIndices.data(), count, localToVertex.size());
+		for (unsigned int i = 0; i < count; i++)
+			meshletIndices[i] = localToVertex[optimized[i]];
+		for (size_t v = 0; v < localToVertex.size(); v++)
+			vertexToLocal[localToVertex[v]] = None;
+	}
+
+	return meshlets.size();
+}
+
+// --------------------------------------------------------
+// The camera sees only back faces if it's inside the cone:
+// the direction from it to the apex within acos(cutoff) of
+// the axis
+// --------------------------------------------------------
+bool IsMeshletBackFacing(const Meshlet& meshlet, const float cameraPosition[3])
+{
+	if (meshlet.coneCutoff > 1.0f)
+		return false;
+
+	Vector3 toApex =
+	{
+		meshlet.coneApex[0] - cameraPosition[0],
+		meshlet.coneApex[1] - cameraPosition[1],
+		meshlet.coneApex[2] - cameraPosition[2]
+	};
+	Vector3 axis = { meshlet.coneAxis[0], meshlet.coneAxis[1], meshlet.coneAxis[2] };
+	float length = Length(toApex);
+	return length > 0 && Dot(toApex, axis) >= meshlet.coneCutoff * length;
+}
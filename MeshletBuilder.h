@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// --------------------------------------------------------
+// Meshlets: small clusters of a mesh's triangles, each with
+// its own bounding sphere and normal cone, so the CPU can
+// cull parts of a mesh - the half of a big model that's off
+// screen, or the side facing away from the camera - instead
+// of all or nothing.
+//
+// BuildMeshlets reorders an index list so every meshlet is
+// one contiguous range of it.  Surviving meshlets are drawn
+// as index ranges, and neighbours that both survive merge
+// into one draw.
+//
+// Like MeshOptimizer, this works on raw vertex bytes with
+// three float positions at positionOffset, and it's fully
+// deterministic.
+// --------------------------------------------------------
+
+// Most distinct vertices and triangles in one meshlet
+static const unsigned int MeshletMaxVertices = 64;
+static const unsigned int MeshletMaxTriangles = 128;
+
+struct Meshlet
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+
+	//local-space bounding sphere
+	float center[3];
+	float radius;
+
+	//every triangle faces away from a camera inside the cone: apex
+	//plus the directions within acos(coneCutoff) of coneAxis.  A
+	//cutoff above 1 means the normals spread too far to ever cull
+	float coneApex[3];
+	float coneAxis[3];
+	float coneCutoff;
+};
+
+// An index range left to draw after culling
+struct MeshletRange
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+};
+
+//reorders indices (in place) into meshlets of at most MeshletMaxVertices vertices and
+//MeshletMaxTriangles triangles, grown across shared vertices; meshlets gets one entry
+//per cluster, in index order.  Returns the meshlet count
+size_t BuildMeshlets(std::vector<Meshlet>& meshlets, unsigned int* indices, size_t indexCount,
+	const void* vertices, size_t vertexCount, size_t vertexSize, size_t positionOffset);
+
+//true if every triangle of the meshlet faces away from cameraPosition (local space)
+bool IsMeshletBackFacing(const Meshlet& meshlet, const float cameraPosition[3]);
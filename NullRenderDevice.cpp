@@ -0,0 +1,313 @@
+#include "NullRenderDevice.h"
+#include <cstring>
+
+const unsigned int NullRenderDevice::MaxBindSlots;
+
+NullRenderDevice::NullRenderDevice()
+{
+	this->width = 0;
+	this->height = 0;
+	this->vertexShaderCount = 0;
+	this->pixelShaderCount = 0;
+	this->inputLayoutCount = 0;
+
+	this->boundVertexShader = 0;
+	this->boundPixelShader = 0;
+	this->boundInputLayout = 0;
+	this->boundIndexBuffer = 0;
+	this->boundIndexFormat = IndexFormat32;
+	for (unsigned int i = 0; i < MaxBindSlots; i++)
+	{
+		this->boundVertexBuffers[i] = 0;
+		this->boundStrides[i] = 0;
+		this->boundVSConstantBuffers[i] = 0;
+	}
+
+	ResetStats();
+}
+
+bool NullRenderDevice::Initialize(void* windowHandle, unsigned int width, unsigned int height)
+{
+	this->width = width;
+	this->height = height;
+	return true;
+}
+
+void NullRenderDevice::Resize(unsigned int width, unsigned int height)
+{
+	this->width = width;
+	this->height = height;
+}
+
+std::string NullRenderDevice::GetName()
+{
+	return "Null device";
+}
+
+BufferHandle NullRenderDevice::CreateBuffer(BufferType type, BufferUsage usage, const void* data, unsigned int size)
+{
+	Buffer buffer;
+	buffer.type = type;
+	buffer.usage = usage;
+	buffer.size = size;
+	buffer.alive = true;
+	if (usage == DynamicUsage)
+	{
+		buffer.contents.resize(size);
+		if (data)
+			memcpy(buffer.contents.data(), data, size);
+	}
+
+	// Reuse a released slot if there is one
+	BufferHandle handle;
+	if (!freeBuffers.empty())
+	{
+		handle = freeBuffers.back();
+		freeBuffers.pop_back();
+		buffers[handle - 1] = buffer;
+	}
+	else
+	{
+		buffers.push_back(buffer);
+		handle = (BufferHandle)buffers.size();
+	}
+
+	stats.buffersCreated++;
+	stats.bytesAllocated += size;
+
+	Record(CreateBufferCommand, 4);
+	commands.push_back(handle);
+	commands.push_back((unsigned int)type);
+	commands.push_back((unsigned int)usage);
+	commands.push_back(size);
+	return handle;
+}
+
+void NullRenderDevice::ReleaseBuffer(BufferHandle buffer)
+{
+	if (buffer == 0 || buffer > buffers.size() || !buffers[buffer - 1].alive)
+		return;
+
+	buffers[buffer - 1].alive = false;
+	buffers[buffer - 1].contents.clear();
+	freeBuffers.push_back(buffer);
+
+	Record(ReleaseBufferCommand, 1);
+	commands.push_back(buffer);
+}
+
+ShaderHandle NullRenderDevice::CreateVertexShader(const void* byteCode, size_t byteCodeSize)
+{
+	return ++vertexShaderCount;
+}
+
+ShaderHandle NullRenderDevice::CreatePixelShader(const void* byteCode, size_t byteCodeSize)
+{
+	return ++pixelShaderCount;
+}
+
+InputLayoutHandle NullRenderDevice::CreateInputLayout(const VertexElement* elements, unsigned int elementCount,
+	const void* vsByteCode, size_t vsByteCodeSize)
+{
+	return ++inputLayoutCount;
+}
+
+// --------------------------------------------------------
+// Hands back the buffer's CPU copy - only dynamic buffers
+// can be mapped, same as on a real device
+// --------------------------------------------------------
+void* NullRenderDevice::Map(BufferHandle buffer)
+{
+	if (buffer == 0 || buffer > buffers.size())
+		return 0;
+
+	Buffer& b = buffers[buffer - 1];
+	if (!b.alive || b.usage != DynamicUsage)
+		return 0;
+
+	stats.maps++;
+	stats.bytesUploaded += b.size;
+
+	Record(MapCommand, 2);
+	commands.push_back(buffer);
+	commands.push_back(b.size);
+	return b.contents.data();
+}
+
+void NullRenderDevice::Unmap(BufferHandle buffer)
+{
+	Record(UnmapCommand, 1);
+	commands.push_back(buffer);
+}
+
+void NullRenderDevice::UpdateBuffer(BufferHandle buffer, unsigned int offset, const void* data, unsigned int size)
+{
+	if (buffer == 0 || buffer > buffers.size())
+		return;
+
+	Buffer& b = buffers[buffer - 1];
+	if (!b.alive || b.usage != DefaultUsage || offset + size > b.size)
+		return;
+
+	stats.updates++;
+	stats.bytesUploaded += size;
+
+	Record(UpdateBufferCommand, 3);
+	commands.push_back(buffer);
+	commands.push_back(offset);
+	commands.push_back(size);
+}
+
+void NullRenderDevice::SetVertexShader(ShaderHandle shader)
+{
+	CountStateChange(shader != boundVertexShader);
+	boundVertexShader = shader;
+
+	Record(SetVertexShaderCommand, 1);
+	commands.push_back(shader);
+}
+
+void NullRenderDevice::SetPixelShader(ShaderHandle shader)
+{
+	CountStateChange(shader != boundPixelShader);
+	boundPixelShader = shader;
+
+	Record(SetPixelShaderCommand, 1);
+	commands.push_back(shader);
+}
+
+void NullRenderDevice::SetInputLayout(InputLayoutHandle layout)
+{
+	CountStateChange(layout != boundInputLayout);
+	boundInputLayout = layout;
+
+	Record(SetInputLayoutCommand, 1);
+	commands.push_back(layout);
+}
+
+void NullRenderDevice::SetVertexBuffers(unsigned int startSlot, unsigned int count, const BufferHandle* buffers, const unsigned int* strides)
+{
+	Record(SetVertexBuffersCommand, 2 + count * 2);
+	commands.push_back(startSlot);
+	commands.push_back(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned int slot = startSlot + i;
+		if (slot < MaxBindSlots)
+		{
+			CountStateChange(buffers[i] != boundVertexBuffers[slot] || strides[i] != boundStrides[slot]);
+			boundVertexBuffers[slot] = buffers[i];
+			boundStrides[slot] = strides[i];
+		}
+		commands.push_back(buffers[i]);
+		commands.push_back(strides[i]);
+	}
+}
+
+void NullRenderDevice::SetIndexBuffer(BufferHandle buffer, IndexFormat format)
+{
+	CountStateChange(buffer != boundIndexBuffer || format != boundIndexFormat);
+	boundIndexBuffer = buffer;
+	boundIndexFormat = format;
+
+	Record(SetIndexBufferCommand, 2);
+	commands.push_back(buffer);
+	commands.push_back((unsigned int)format);
+}
+
+void NullRenderDevice::SetVSConstantBuffers(unsigned int startSlot, unsigned int count, const BufferHandle* buffers)
+{
+	Record(SetVSConstantBuffersCommand, 2 + count);
+	commands.push_back(startSlot);
+	commands.push_back(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned int slot = startSlot + i;
+		if (slot < MaxBindSlots)
+		{
+			CountStateChange(buffers[i] != boundVSConstantBuffers[slot]);
+			boundVSConstantBuffers[slot] = buffers[i];
+		}
+		commands.push_back(buffers[i]);
+	}
+}
+
+// --------------------------------------------------------
+// Starts a new frame's command stream.  Counters keep going
+// until ResetStats(), so they can cover several frames.
+// --------------------------------------------------------
+void NullRenderDevice::BeginFrame(const float clearColor[4])
+{
+	commands.clear();
+	Record(BeginFrameCommand, 0);
+}
+
+void NullRenderDevice::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	stats.drawCalls++;
+	stats.instancesDrawn++;
+	stats.indicesDrawn += indexCount;
+
+	Record(DrawIndexedCommand, 3);
+	commands.push_back(indexCount);
+	commands.push_back(startIndex);
+	commands.push_back((unsigned int)baseVertex);
+}
+
+void NullRenderDevice::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount,
+	unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	stats.drawCalls++;
+	stats.instancesDrawn += instanceCount;
+	stats.indicesDrawn += (unsigned long long)indexCount * instanceCount;
+
+	Record(DrawIndexedInstancedCommand, 5);
+	commands.push_back(indexCount);
+	commands.push_back(instanceCount);
+	commands.push_back(startIndex);
+	commands.push_back((unsigned int)baseVertex);
+	commands.push_back(startInstance);
+}
+
+void NullRenderDevice::Present(bool vsync)
+{
+	Record(PresentCommand, 0);
+}
+
+const std::vector<unsigned int>& NullRenderDevice::GetCommandStream()
+{
+	return commands;
+}
+
+NullRenderDevice::Command NullRenderDevice::GetCommand(unsigned int headerWord)
+{
+	return (Command)(headerWord & 0xFFFF);
+}
+
+unsigned int NullRenderDevice::GetArgCount(unsigned int headerWord)
+{
+	return headerWord >> 16;
+}
+
+RenderDeviceStats NullRenderDevice::GetStats()
+{
+	return stats;
+}
+
+void NullRenderDevice::ResetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+void NullRenderDevice::Record(Command command, unsigned int argCount)
+{
+	commands.push_back((unsigned int)command | (argCount << 16));
+}
+
+void NullRenderDevice::CountStateChange(bool changed)
+{
+	if (changed)
+		stats.stateChanges++;
+	else
+		stats.redundantStateChanges++;
+}
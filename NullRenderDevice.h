@@ -0,0 +1,130 @@
+#pragma once
+
+#include <vector>
+#include "RenderDevice.h"
+
+// Counters kept by NullRenderDevice since the last ResetStats()
+struct RenderDeviceStats
+{
+	unsigned int drawCalls;
+	unsigned int instancesDrawn;		// 1 per DrawIndexed, instanceCount per instanced draw
+	unsigned long long indicesDrawn;	// Index count * instances
+	unsigned int stateChanges;			// Binds that changed what was bound
+	unsigned int redundantStateChanges;	// Binds of what was already bound
+	unsigned int maps;
+	unsigned int updates;				// UpdateBuffer() calls
+	unsigned long long bytesUploaded;	// Size of every buffer Map()ed (a discard rewrites all of it) and range updated
+	unsigned int buffersCreated;
+	unsigned long long bytesAllocated;	// Size of every buffer created
+};
+
+// --------------------------------------------------------
+// A RenderDevice with no GPU behind it.  Every call is
+// appended to a compact command stream (cleared at
+// BeginFrame, so it holds the current frame) and counted,
+// so the submission path can be benchmarked and checked
+// anywhere - including machines with no display or GPU.
+//
+// Stream layout: a header word (command | argCount << 16)
+// followed by argCount argument words.  Upload contents
+// aren't recorded, only their sizes.
+// --------------------------------------------------------
+class NullRenderDevice : public RenderDevice
+{
+public:
+	enum Command
+	{
+		BeginFrameCommand,
+		CreateBufferCommand,		// handle, type, usage, size
+		ReleaseBufferCommand,		// handle
+		MapCommand,					// handle, size
+		UnmapCommand,				// handle
+		UpdateBufferCommand,		// handle, offset, size
+		SetVertexShaderCommand,		// handle
+		SetPixelShaderCommand,		// handle
+		SetInputLayoutCommand,		// handle
+		SetVertexBuffersCommand,	// startSlot, count, (handle, stride) * count
+		SetIndexBufferCommand,		// handle, format
+		SetVSConstantBuffersCommand,// startSlot, count, handle * count
+		DrawIndexedCommand,			// indexCount, startIndex, baseVertex
+		DrawIndexedInstancedCommand,// indexCount, instanceCount, startIndex, baseVertex, startInstance
+		PresentCommand
+	};
+
+	NullRenderDevice();
+
+	bool Initialize(void* windowHandle, unsigned int width, unsigned int height);
+	void Resize(unsigned int width, unsigned int height);
+	std::string GetName();
+
+	BufferHandle CreateBuffer(BufferType type, BufferUsage usage, const void* data, unsigned int size);
+	void ReleaseBuffer(BufferHandle buffer);
+	ShaderHandle CreateVertexShader(const void* byteCode, size_t byteCodeSize);
+	ShaderHandle CreatePixelShader(const void* byteCode, size_t byteCodeSize);
+	InputLayoutHandle CreateInputLayout(const VertexElement* elements, unsigned int elementCount,
+		const void* vsByteCode, size_t vsByteCodeSize);
+
+	void* Map(BufferHandle buffer);
+	void Unmap(BufferHandle buffer);
+	void UpdateBuffer(BufferHandle buffer, unsigned int offset, const void* data, unsigned int size);
+
+	void SetVertexShader(ShaderHandle shader);
+	void SetPixelShader(ShaderHandle shader);
+	void SetInputLayout(InputLayoutHandle layout);
+	void SetVertexBuffers(unsigned int startSlot, unsigned int count, const BufferHandle* buffers, const unsigned int* strides);
+	void SetIndexBuffer(BufferHandle buffer, IndexFormat format);
+	void SetVSConstantBuffers(unsigned int startSlot, unsigned int count, const BufferHandle* buffers);
+
+	void BeginFrame(const float clearColor[4]);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount,
+		unsigned int startIndex, int baseVertex, unsigned int startInstance);
+	void Present(bool vsync);
+
+	//recording
+	const std::vector<unsigned int>& GetCommandStream();
+	static Command GetCommand(unsigned int headerWord);
+	static unsigned int GetArgCount(unsigned int headerWord);
+
+	//counters
+	RenderDeviceStats GetStats();
+	void ResetStats();
+
+	// Most slots tracked for vertex and constant buffers
+	static const unsigned int MaxBindSlots = 8;
+
+private:
+	struct Buffer
+	{
+		BufferType type;
+		BufferUsage usage;
+		unsigned int size;
+		bool alive;
+		std::vector<unsigned char> contents;	// Only kept for dynamic buffers, so Map() has somewhere to write
+	};
+
+	unsigned int width;
+	unsigned int height;
+
+	std::vector<Buffer> buffers;
+	std::vector<BufferHandle> freeBuffers;
+	unsigned int vertexShaderCount;
+	unsigned int pixelShaderCount;
+	unsigned int inputLayoutCount;
+
+	//what's bound right now
+	ShaderHandle boundVertexShader;
+	ShaderHandle boundPixelShader;
+	InputLayoutHandle boundInputLayout;
+	BufferHandle boundVertexBuffers[MaxBindSlots];
+	unsigned int boundStrides[MaxBindSlots];
+	BufferHandle boundIndexBuffer;
+	IndexFormat boundIndexFormat;
+	BufferHandle boundVSConstantBuffers[MaxBindSlots];
+
+	std::vector<unsigned int> commands;
+	RenderDeviceStats stats;
+
+	void Record(Command command, unsigned int argCount);
+	void CountStateChange(bool changed);
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+
+// --------------------------------------------------------
+// Receives the OS events DXCore cares about, whichever
+// platform they come from
+// --------------------------------------------------------
+class PlatformListener
+{
+public:
+	virtual ~PlatformListener() {}
+
+	virtual void OnWindowResized(unsigned int width, unsigned int height) = 0;
+	virtual void OnFocusChanged(bool focused) = 0;
+};
+
+// --------------------------------------------------------
+// The OS services the game loop needs: a window (optional),
+// a message pump, a monotonic clock and executable paths.
+// Win32Platform is the real thing; HeadlessPlatform runs
+// the same loop with no window, for benchmarks and CI.
+// --------------------------------------------------------
+class Platform
+{
+public:
+	Platform() : listener(0) {}
+	virtual ~Platform() {}
+
+	void SetListener(PlatformListener* listener) { this->listener = listener; }
+
+	//window
+	virtual bool CreateAppWindow(const std::string& title, unsigned int width, unsigned int height) = 0;
+	virtual bool HasWindow() = 0;
+	virtual void* GetNativeWindowHandle() = 0;	// HWND on Win32, 0 when there's no window
+	virtual void SetWindowTitle(const std::string& title) = 0;
+
+	//messages - PumpMessages() handles everything pending and
+	//returns false once the app has been asked to quit
+	virtual bool PumpMessages() = 0;
+	virtual void RequestQuit() = 0;
+	virtual int GetExitCode() = 0;
+
+	//monotonic time in seconds, from an arbitrary starting point
+	virtual double GetTimeSeconds() = 0;
+
+	//folder containing the executable, without a trailing separator
+	virtual std::string GetExePath() = 0;
+	virtual char GetPathSeparator() = 0;
+
+protected:
+	PlatformListener* listener;
+};
@@ -0,0 +1,114 @@
+#include "RangeAllocator.h"
+
+RangeAllocator::RangeAllocator(unsigned int capacity)
+{
+	Reset(capacity);
+}
+
+void RangeAllocator::Reset(unsigned int capacity)
+{
+	this->capacity = capacity;
+	this->used = 0;
+	freeByOffset.clear();
+	freeBySize.clear();
+	if (capacity > 0)
+		AddFreeBlock(0, capacity);
+}
+
+// --------------------------------------------------------
+// Takes the front of the smallest free block that fits; the
+// rest of it goes back on the free list.  Empty ranges always
+// succeed and take no space.
+// --------------------------------------------------------
+bool RangeAllocator::Allocate(unsigned int size, unsigned int& offset)
+{
+	if (size == 0)
+	{
+		offset = 0;
+		return true;
+	}
+
+	SizeMap::iterator fit = freeBySize.lower_bound(size);
+	if (fit == freeBySize.end())
+		return false;
+
+	unsigned int blockOffset = fit->second;
+	unsigned int blockSize = fit->first;
+	RemoveFreeBlock(freeByOffset.find(blockOffset));
+	if (blockSize > size)
+		AddFreeBlock(blockOffset + size, blockSize - size);
+
+	used += size;
+	offset = blockOffset;
+	return true;
+}
+
+// --------------------------------------------------------
+// Returns a range, merging it with the free blocks directly
+// before and after it so free space never splinters into
+// neighbouring pieces
+// --------------------------------------------------------
+void RangeAllocator::Free(unsigned int offset, unsigned int size)
+{
+	if (size == 0)
+		return;
+
+	used -= size;
+
+	OffsetMap::iterator next = freeByOffset.lower_bound(offset);
+	if (next != freeByOffset.end() && offset + size == next->first)
+	{
+		size += next->second;
+		RemoveFreeBlock(next);
+	}
+
+	next = freeByOffset.lower_bound(offset);
+	if (next != freeByOffset.begin())
+	{
+		OffsetMap::iterator previous = next;
+		--previous;
+		if (previous->first + previous->second == offset)
+		{
+			offset = previous->first;
+			size += previous->second;
+			RemoveFreeBlock(previous);
+		}
+	}
+
+	AddFreeBlock(offset, size);
+}
+
+unsigned int RangeAllocator::GetCapacity()
+{
+	return capacity;
+}
+
+unsigned int RangeAllocator::GetUsed()
+{
+	return used;
+}
+
+unsigned int RangeAllocator::GetFreeBlockCount()
+{
+	return (unsigned int)freeByOffset.size();
+}
+
+unsigned int RangeAllocator::GetLargestFreeBlock()
+{
+	return freeBySize.empty() ? 0 : freeBySize.rbegin()->first;
+}
+
+void RangeAllocator::AddFreeBlock(unsigned int offset, unsigned int size)
+{
+	freeByOffset[offset] = size;
+	freeBySize.insert(SizeMap::value_type(size, offset));
+}
+
+void RangeAllocator::RemoveFreeBlock(OffsetMap::iterator block)
+{
+	SizeMap::iterator bySize = freeBySize.lower_bound(block->second);
+	while (bySize->second != block->first)
+		++bySize;
+	freeBySize.erase(bySize);
+	freeByOffset.erase(block);
+}
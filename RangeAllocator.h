@@ -0,0 +1,43 @@
+#pragma once
+#include <map>
+
+// --------------------------------------------------------
+// Hands out ranges of a fixed-size space (the elements of a
+// buffer, say) and takes them back.  Free space is a list of
+// blocks in offset order, so a freed range merges with its
+// free neighbours straight away, plus the same blocks by
+// size, so allocation takes the smallest block that fits
+// (best fit keeps big blocks whole for big requests).  Both
+// are O(log n) in the number of free blocks.
+// --------------------------------------------------------
+class RangeAllocator
+{
+public:
+	RangeAllocator(unsigned int capacity = 0);
+
+	//forgets every allocation - the whole space is one free block again
+	void Reset(unsigned int capacity);
+
+	//false (and offset untouched) if no free block is big enough
+	bool Allocate(unsigned int size, unsigned int& offset);
+	//size must be what was allocated at offset
+	void Free(unsigned int offset, unsigned int size);
+
+	//stats
+	unsigned int GetCapacity();
+	unsigned int GetUsed();
+	unsigned int GetFreeBlockCount();
+	unsigned int GetLargestFreeBlock();
+
+private:
+	typedef std::map<unsigned int, unsigned int> OffsetMap;		// Offset -> size
+	typedef std::multimap<unsigned int, unsigned int> SizeMap;	// Size -> offset
+
+	OffsetMap freeByOffset;
+	SizeMap freeBySize;
+	unsigned int capacity;
+	unsigned int used;
+
+	void AddFreeBlock(unsigned int offset, unsigned int size);
+	void RemoveFreeBlock(OffsetMap::iterator block);
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Resource handles - 0 always means "none"
+typedef unsigned int BufferHandle;
+typedef unsigned int ShaderHandle;
+typedef unsigned int InputLayoutHandle;
+
+enum BufferType
+{
+	VertexBufferType,
+	IndexBufferType,
+	ConstantBufferType
+};
+
+enum BufferUsage
+{
+	ImmutableUsage,		// Contents given at creation, never change
+	DynamicUsage,		// Rewritten from the CPU with Map()/Unmap()
+	DefaultUsage		// GPU-resident, rewritten a range at a time with UpdateBuffer()
+};
+
+enum IndexFormat
+{
+	IndexFormat16,
+	IndexFormat32
+};
+
+enum VertexElementFormat
+{
+	FormatFloat2,
+	FormatFloat3,
+	FormatFloat4,
+	FormatUnorm8x4,		// Four bytes, read as floats in [0, 1]
+	FormatHalf4			// Four 16-bit floats
+};
+
+// Bytes an element of each format takes up
+constexpr unsigned int GetVertexElementSize(VertexElementFormat format)
+{
+	return format == FormatFloat2 ? 8 :
+		format == FormatFloat3 ? 12 :
+		format == FormatFloat4 ? 16 :
+		format == FormatUnorm8x4 ? 4 : 8;
+}
+
+// --------------------------------------------------------
+// One element of a vertex layout.  Elements are packed one
+// after another within their input slot, like
+// D3D11_APPEND_ALIGNED_ELEMENT.
+// --------------------------------------------------------
+struct VertexElement
+{
+	const char* semanticName;
+	unsigned int semanticIndex;
+	VertexElementFormat format;
+	unsigned int inputSlot;
+	bool perInstance;	// Advances once per instance instead of once per vertex
+};
+
+// --------------------------------------------------------
+// The thin layer everything draws through: buffer creation,
+// Map/Unmap, shader/layout/buffer binding and indexed draws.
+// D3D11RenderDevice is the real GPU; NullRenderDevice just
+// records and counts, so submission can run without one, and
+// SoftwareRenderDevice rasterizes on the CPU.
+// --------------------------------------------------------
+class RenderDevice
+{
+public:
+	virtual ~RenderDevice() {}
+
+	//setup - windowHandle comes from Platform::GetNativeWindowHandle() (0 = render offscreen)
+	virtual bool Initialize(void* windowHandle, unsigned int width, unsigned int height) = 0;
+	virtual void Resize(unsigned int width, unsigned int height) = 0;
+	virtual std::string GetName() = 0;
+
+	//diagnostics - extra title bar text, covering the time since the previous call
+	virtual std::string GetFrameStats() { return std::string(); }
+
+	//resources
+	virtual BufferHandle CreateBuffer(BufferType type, BufferUsage usage, const void* data, unsigned int size) = 0;
+	virtual void ReleaseBuffer(BufferHandle buffer) = 0;
+	virtual ShaderHandle CreateVertexShader(const void* byteCode, size_t byteCodeSize) = 0;
+	virtual ShaderHandle CreatePixelShader(const void* byteCode, size_t byteCodeSize) = 0;
+	virtual InputLayoutHandle CreateInputLayout(const VertexElement* elements, unsigned int elementCount,
+		const void* vsByteCode, size_t vsByteCodeSize) = 0;
+
+	//dynamic buffer updates - Map() discards the old contents
+	virtual void* Map(BufferHandle buffer) = 0;
+	virtual void Unmap(BufferHandle buffer) = 0;
+	//default-usage buffer updates - only the given byte range changes
+	virtual void UpdateBuffer(BufferHandle buffer, unsigned int offset, const void* data, unsigned int size) = 0;
+
+	//pipeline state
+	virtual void SetVertexShader(ShaderHandle shader) = 0;
+	virtual void SetPixelShader(ShaderHandle shader) = 0;
+	virtual void SetInputLayout(InputLayoutHandle layout) = 0;
+	virtual void SetVertexBuffers(unsigned int startSlot, unsigned int count, const BufferHandle* buffers, const unsigned int* strides) = 0;
+	virtual void SetIndexBuffer(BufferHandle buffer, IndexFormat format) = 0;
+	virtual void SetVSConstantBuffers(unsigned int startSlot, unsigned int count, const BufferHandle* buffers) = 0;
+
+	//frames and draws (always triangle lists)
+	virtual void BeginFrame(const float clearColor[4]) = 0;
+	virtual void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) = 0;
+	virtual void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount,
+		unsigned int startIndex, int baseVertex, unsigned int startInstance) = 0;
+	virtual void Present(bool vsync) = 0;
+};
@@ -0,0 +1,159 @@
+#include "RenderQueue.h"
+#include <cstring>
+
+// --------------------------------------------------------
+// Packs the draw's state into a key.  Depth uses the bits of
+// the (non-negative) view-space distance: positive floats
+// sort the same as their bit patterns, so the top 24 bits
+// below the sign give a front-to-back order with no far plane
+// --------------------------------------------------------
+unsigned long long RenderQueue::MakeKey(unsigned int shaderId, unsigned int layoutId, unsigned int meshId, float viewDepth)
+{
+    if (!(viewDepth > 0.0f))
+        viewDepth = 0.0f;
+
+    unsigned int depthBits;
+    memcpy(&depthBits, &viewDepth, sizeof(depthBits));
+    depthBits = (depthBits >> 7) & 0xFFFFFF;
+
+    return ((unsigned long long)(shaderId & 0xFF) << 56) |
+        ((unsigned long long)(layoutId & 0xFF) << 48) |
+        ((unsigned long long)(meshId & 0xFFFFFF) << 24) |
+        (unsigned long long)depthBits;
+}
+
+unsigned int RenderQueue::GetShaderId(unsigned long long key)
+{
+    return (unsigned int)(key >> 56) & 0xFF;
+}
+
+unsigned int RenderQueue::GetLayoutId(unsigned long long key)
+{
+    return (unsigned int)(key >> 48) & 0xFF;
+}
+
+unsigned int RenderQueue::GetMeshId(unsigned long long key)
+{
+    return (unsigned int)(key >> 24) & 0xFFFFFF;
+}
+
+bool RenderQueue::SameBatch(unsigned long long a, unsigned long long b)
+{
+    return (a >> 24) == (b >> 24);
+}
+
+void RenderQueue::Clear()
+{
+    keys.clear();
+    payloads.clear();
+}
+
+void RenderQueue::Submit(unsigned long long key, unsigned int payload)
+{
+    keys.push_back(key);
+    payloads.push_back(payload);
+}
+
+// --------------------------------------------------------
+// LSD radix sort, one byte per pass.  Passes where every key
+// has the same byte (common for the shader/layout bytes) are
+// skipped entirely.  Stable, so equal keys keep submit order.
+// --------------------------------------------------------
+void RenderQueue::Sort()
+{
+    size_t count = keys.size();
+    if (count < 2)
+        return;
+
+    scratchKeys.resize(count);
+    scratchPayloads.resize(count);
+
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        unsigned int histogram[256] = {};
+        for (size_t i = 0; i < count; i++)
+            histogram[(keys[i] >> shift) & 0xFF]++;
+
+        // Everything lands in one bucket - this byte can't change the order
+        if (histogram[(keys[0] >> shift) & 0xFF] == count)
+            continue;
+
+        unsigned int offset = 0;
+        for (unsigned int b = 0; b < 256; b++)
+        {
+            unsigned int bucketSize = histogram[b];
+            histogram[b] = offset;
+            offset += bucketSize;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            unsigned int dest = histogram[(keys[i] >> shift) & 0xFF]++;
+            scratchKeys[dest] = keys[i];
+            scratchPayloads[dest] = payloads[i];
+        }
+
+        keys.swap(scratchKeys);
+        payloads.swap(scratchPayloads);
+    }
+}
+
+unsigned int RenderQueue::GetCount()
+{
+    return (unsigned int)keys.size();
+}
+
+unsigned long long RenderQueue::GetKey(unsigned int index)
+{
+    return keys[index];
+}
+
+unsigned int RenderQueue::GetPayload(unsigned int index)
+{
+    return payloads[index];
+}
+
+RenderStateCache::RenderStateCache()
+{
+    Reset();
+    ResetStats();
+}
+
+void RenderStateCache::Reset()
+{
+    for (int i = 0; i < StateSlotCount; i++)
+    {
+        bound[i] = 0;
+        known[i] = false;
+    }
+}
+
+void RenderStateCache::ResetStats()
+{
+    issued = 0;
+    skipped = 0;
+}
+
+bool RenderStateCache::Set(StateSlot slot, unsigned int value)
+{
+    if (known[slot] && bound[slot] == value)
+    {
+        skipped++;
+        return false;
+    }
+
+    bound[slot] = value;
+    known[slot] = true;
+    issued++;
+    return true;
+}
+
+unsigned int RenderStateCache::GetIssued()
+{
+    return issued;
+}
+
+unsigned int RenderStateCache::GetSkipped()
+{
+    return skipped;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+
+// --------------------------------------------------------
+// A list of draws, each tagged with a packed 64-bit sort key:
+//
+//   63      56 55      48 47              24 23             0
+//  [ shader  ][ layout  ][     mesh id      ][     depth     ]
+//
+// Sorting by key puts draws that share pipeline state (and then
+// mesh) next to each other, front to back within each group.
+// The payload is whatever the submitter needs to find the draw
+// again (an entity index for Game).
+// --------------------------------------------------------
+class RenderQueue
+{
+public:
+	static unsigned long long MakeKey(unsigned int shaderId, unsigned int layoutId, unsigned int meshId, float viewDepth);
+	static unsigned int GetShaderId(unsigned long long key);
+	static unsigned int GetLayoutId(unsigned long long key);
+	static unsigned int GetMeshId(unsigned long long key);
+	//true if the keys differ only in depth (same shader, layout and mesh)
+	static bool SameBatch(unsigned long long a, unsigned long long b);
+
+	void Clear();
+	void Submit(unsigned long long key, unsigned int payload);
+	void Sort();
+
+	unsigned int GetCount();
+	unsigned long long GetKey(unsigned int index);
+	unsigned int GetPayload(unsigned int index);
+
+private:
+	std::vector<unsigned long long> keys;
+	std::vector<unsigned int> payloads;
+
+	// Radix sort ping-pong buffers
+	std::vector<unsigned long long> scratchKeys;
+	std::vector<unsigned int> scratchPayloads;
+};
+
+// --------------------------------------------------------
+// Remembers what's currently bound to each piece of pipeline
+// state so redundant changes can be skipped, and counts how
+// many were issued vs. skipped since the last Reset()
+// --------------------------------------------------------
+class RenderStateCache
+{
+public:
+	enum StateSlot
+	{
+		VertexShaderSlot,
+		PixelShaderSlot,
+		InputLayoutSlot,
+		VertexBufferSlot,
+		InstanceBufferSlot,
+		IndexBufferSlot,
+		StateSlotCount
+	};
+
+	RenderStateCache();
+
+	//forgets everything bound (call whenever something else may have changed state)
+	void Reset();
+	void ResetStats();
+
+	//returns true if the value differs from what's bound, meaning the caller must issue the change
+	bool Set(StateSlot slot, unsigned int value);
+
+	unsigned int GetIssued();
+	unsigned int GetSkipped();
+
+private:
+	unsigned int bound[StateSlotCount];
+	bool known[StateSlotCount];
+	unsigned int issued;
+	unsigned int skipped;
+};
+
@@ -0,0 +1,25 @@
+#pragma once
+
+// --------------------------------------------------------
+// Picks the widest batch path the compiler is allowed to emit
+// for our hand-written SIMD loops.  Mirrors how DirectXMath picks
+// its own intrinsics (define _XM_NO_INTRINSICS_ to force scalar).
+//  - SIMD_AVX2: 8-wide paths (needs /arch:AVX2 or -mavx2)
+//  - SIMD_SSE:  4-wide paths (always on for x64)
+// SIMD_AVX2 implies SIMD_SSE, since the 8-wide loops finish
+// their tails 4 at a time.
+// --------------------------------------------------------
+#if !defined(_XM_NO_INTRINSICS_) && defined(__AVX2__)
+#define SIMD_AVX2
+#endif
+
+#if !defined(_XM_NO_INTRINSICS_) && (defined(SIMD_AVX2) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SIMD_SSE
+#endif
+
+#if defined(SIMD_SSE)
+#include <xmmintrin.h>
+#endif
+#if defined(SIMD_AVX2)
+#include <immintrin.h>
+#endif
@@ -0,0 +1,674 @@
+#include "SoftwareRasterizer.h"
+#include "SimdConfig.h"
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+#if defined(SIMD_SSE)
+#include <emmintrin.h> // SSE2 integer lanes for the edge functions
+#endif
+
+const unsigned int SoftwareRasterizer::TileSize;
+
+// Vertices snap to a grid of 1/16 pixel
+static const int SubpixelBits = 4;
+static const int SubpixelScale = 1 << SubpixelBits;
+
+// How far (in pixels) triangles may reach past the viewport before
+// they're clipped.  Keeps every snapped coordinate, and so every
+// edge function step, small enough for 32 bit lanes
+static const float GuardBandPixels = 4096.0f;
+
+// Edge function values are clamped to this at the start of each
+// row.  A row is at most one tile wide, so stepping across it moves
+// a value by less than 2^28 - too little to overflow or to change
+// the sign of a clamped value
+static const long long MaxEdgeValue = 1 << 30;
+
+// Clip planes: near (z >= 0), far (z <= w), then the guard band
+static const int ClipPlaneCount = 6;
+static const int MaxClipVertices = 3 + ClipPlaneCount;
+
+static float Clamp01(float value)
+{
+	return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+static unsigned int PackColor(float r, float g, float b, float a)
+{
+	return
+		(unsigned int)(Clamp01(r) * 255.0f + 0.5f) |
+		((unsigned int)(Clamp01(g) * 255.0f + 0.5f) << 8) |
+		((unsigned int)(Clamp01(b) * 255.0f + 0.5f) << 16) |
+		((unsigned int)(Clamp01(a) * 255.0f + 0.5f) << 24);
+}
+
+static RasterVertex LerpVertex(const RasterVertex& a, const RasterVertex& b, float t)
+{
+	RasterVertex result;
+	result.x = a.x + (b.x - a.x) * t;
+	result.y = a.y + (b.y - a.y) * t;
+	result.z = a.z + (b.z - a.z) * t;
+	result.w = a.w + (b.w - a.w) * t;
+	result.r = a.r + (b.r - a.r) * t;
+	result.g = a.g + (b.g - a.g) * t;
+	result.b = a.b + (b.b - a.b) * t;
+	result.a = a.a + (b.a - a.a) * t;
+	return result;
+}
+
+#if defined(SIMD_SSE)
+// Same rounding as PackColor(), 4 pixels at once
+static __m128i PackColor4(__m128 r, __m128 g, __m128 b, __m128 a)
+{
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 scale = _mm_set1_ps(255.0f);
+	__m128 half = _mm_set1_ps(0.5f);
+
+	__m128i ri = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(r, zero), one), scale), half));
+	__m128i gi = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(g, zero), one), scale), half));
+	__m128i bi = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(b, zero), one), scale), half));
+	__m128i ai = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(a, zero), one), scale), half));
+
+	return _mm_or_si128(
+		_mm_or_si128(ri, _mm_slli_epi32(gi, 8)),
+		_mm_or_si128(_mm_slli_epi32(bi, 16), _mm_slli_epi32(ai, 24)));
+}
+#endif
+
+// --------------------------------------------------------
+// threadCount includes the thread that will be calling
+// Flush().  The workers start on the first Flush(), so an
+// unused rasterizer costs no threads.
+// --------------------------------------------------------
+SoftwareRasterizer::SoftwareRasterizer(unsigned int threadCount)
+{
+	this->width = 0;
+	this->height = 0;
+	this->pitch = 0;
+	this->guardBandX = 1.0f;
+	this->guardBandY = 1.0f;
+	this->tilesX = 0;
+	this->tilesY = 0;
+
+	this->jobId = 0;
+	this->busyWorkers = 0;
+	this->quitting = false;
+	this->nextTile = 0;
+	this->pixelsWritten = 0;
+	ResetStats();
+
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+	this->threadCount = threadCount;
+}
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		quitting = true;
+	}
+	jobReady.notify_all();
+
+	for (unsigned int i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+// --------------------------------------------------------
+// Reallocates the color and depth buffers.  Anything
+// submitted but not yet flushed is dropped.
+// --------------------------------------------------------
+void SoftwareRasterizer::Resize(unsigned int width, unsigned int height)
+{
+	this->width = width;
+	this->height = height;
+
+	// Rows are padded to a multiple of 4 pixels so the SIMD loop
+	// can always touch whole groups of 4
+	pitch = (width + 3) & ~3u;
+	colorBuffer.assign(pitch * height, 0);
+	depthBuffer.assign(pitch * height, 1.0f);
+
+	tilesX = (width + TileSize - 1) / TileSize;
+	tilesY = (height + TileSize - 1) / TileSize;
+	tileBins.assign(tilesX * tilesY, std::vector<unsigned int>());
+	triangles.clear();
+
+	// Guard band in clip space: x / w and y / w limits that land
+	// GuardBandPixels outside the viewport
+	guardBandX = width ? 1.0f + 2.0f * GuardBandPixels / width : 1.0f;
+	guardBandY = height ? 1.0f + 2.0f * GuardBandPixels / height : 1.0f;
+}
+
+void SoftwareRasterizer::Clear(const float color[4], float depth)
+{
+	unsigned int packed = PackColor(color[0], color[1], color[2], color[3]);
+	for (size_t i = 0; i < colorBuffer.size(); i++)
+	{
+		colorBuffer[i] = packed;
+		depthBuffer[i] = depth;
+	}
+}
+
+// --------------------------------------------------------
+// Clips a triangle (in clip space) to the near and far
+// planes and the guard band, and sets up whatever is left.
+// Most triangles sit inside all of them and skip clipping.
+// --------------------------------------------------------
+void SoftwareRasterizer::SubmitTriangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2)
+{
+	stats.trianglesSubmitted++;
+	if (width == 0 || height == 0)
+		return;
+
+	unsigned int outcode0 = GetOutcode(v0);
+	unsigned int outcode1 = GetOutcode(v1);
+	unsigned int outcode2 = GetOutcode(v2);
+
+	// All three outside the same plane
+	if (outcode0 & outcode1 & outcode2)
+		return;
+
+	unsigned int crossedPlanes = outcode0 | outcode1 | outcode2;
+	if (crossedPlanes == 0)
+	{
+		SetupTriangle(v0, v1, v2);
+		return;
+	}
+
+	// Clip as a polygon (Sutherland-Hodgman) against each plane
+	// the triangle crosses, ping-ponging between two arrays
+	RasterVertex polygon[2][MaxClipVertices];
+	polygon[0][0] = v0;
+	polygon[0][1] = v1;
+	polygon[0][2] = v2;
+	unsigned int count = 3;
+	int current = 0;
+
+	for (int plane = 0; plane < ClipPlaneCount; plane++)
+	{
+		if (!(crossedPlanes & (1 << plane)))
+			continue;
+
+		const RasterVertex* in = polygon[current];
+		RasterVertex* out = polygon[1 - current];
+		unsigned int outCount = 0;
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			const RasterVertex& a = in[i];
+			const RasterVertex& b = in[(i + 1) % count];
+			float distanceA = GetClipDistance(a, plane);
+			float distanceB = GetClipDistance(b, plane);
+
+			if (distanceA >= 0.0f)
+				out[outCount++] = a;
+			if ((distanceA >= 0.0f) != (distanceB >= 0.0f))
+				out[outCount++] = LerpVertex(a, b, distanceA / (distanceA - distanceB));
+		}
+
+		count = outCount;
+		current = 1 - current;
+		if (count < 3)
+			return;
+	}
+
+	// Fan the clipped polygon back into triangles (keeps the winding)
+	for (unsigned int i = 1; i + 1 < count; i++)
+		SetupTriangle(polygon[current][0], polygon[current][i], polygon[current][i + 1]);
+}
+
+// Bit n is set when the vertex is outside clip plane n
+unsigned int SoftwareRasterizer::GetOutcode(const RasterVertex& v)
+{
+	unsigned int outcode = 0;
+	for (int plane = 0; plane < ClipPlaneCount; plane++)
+	{
+		if (GetClipDistance(v, plane) < 0.0f)
+			outcode |= 1 << plane;
+	}
+	return outcode;
+}
+
+// Signed distance to a clip plane - negative is outside
+float SoftwareRasterizer::GetClipDistance(const RasterVertex& v, int plane)
+{
+	switch (plane)
+	{
+	case 0: return v.z;
+	case 1: return v.w - v.z;
+	case 2: return guardBandX * v.w - v.x;
+	case 3: return guardBandX * v.w + v.x;
+	case 4: return guardBandY * v.w - v.y;
+	default: return guardBandY * v.w + v.y;
+	}
+}
+
+// --------------------------------------------------------
+// Projects a clipped triangle to the screen, culls it if
+// it faces away, and builds its edge functions and
+// attribute planes for the tile workers
+// --------------------------------------------------------
+void SoftwareRasterizer::SetupTriangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2)
+{
+	const RasterVertex* v[3] = { &v0, &v1, &v2 };
+	Triangle tri;
+
+	int snappedX[3];
+	int snappedY[3];
+	float screenX[3];
+	float screenY[3];
+	float attributes[3][AttributeCount];
+	for (int i = 0; i < 3; i++)
+	{
+		// Perspective divide and viewport transform (y points down)
+		float invW = 1.0f / v[i]->w;
+		float x = (v[i]->x * invW * 0.5f + 0.5f) * width;
+		float y = (0.5f - v[i]->y * invW * 0.5f) * height;
+
+		snappedX[i] = (int)floorf(x * SubpixelScale + 0.5f);
+		snappedY[i] = (int)floorf(y * SubpixelScale + 0.5f);
+		screenX[i] = (float)snappedX[i] / SubpixelScale;
+		screenY[i] = (float)snappedY[i] / SubpixelScale;
+
+		attributes[i][DepthAttribute] = v[i]->z * invW;
+		attributes[i][InvWAttribute] = invW;
+		attributes[i][RedAttribute] = v[i]->r * invW;
+		attributes[i][GreenAttribute] = v[i]->g * invW;
+		attributes[i][BlueAttribute] = v[i]->b * invW;
+		attributes[i][AlphaAttribute] = v[i]->a * invW;
+	}
+
+	// Front faces wind clockwise on screen, which (with y down) is a
+	// positive area.  Back faces and slivers with no area are culled
+	long long area =
+		(long long)(snappedX[1] - snappedX[0]) * (snappedY[2] - snappedY[0]) -
+		(long long)(snappedX[2] - snappedX[0]) * (snappedY[1] - snappedY[0]);
+	if (area <= 0)
+		return;
+
+	// Pixels whose centers could be inside
+	int minSnappedX = snappedX[0], maxSnappedX = snappedX[0];
+	int minSnappedY = snappedY[0], maxSnappedY = snappedY[0];
+	for (int i = 1; i < 3; i++)
+	{
+		if (snappedX[i] < minSnappedX) minSnappedX = snappedX[i];
+		if (snappedX[i] > maxSnappedX) maxSnappedX = snappedX[i];
+		if (snappedY[i] < minSnappedY) minSnappedY = snappedY[i];
+		if (snappedY[i] > maxSnappedY) maxSnappedY = snappedY[i];
+	}
+
+	float halfPixel = SubpixelScale / 2.0f;
+	tri.minX = (int)ceilf((minSnappedX - halfPixel) / SubpixelScale);
+	tri.maxX = (int)floorf((maxSnappedX - halfPixel) / SubpixelScale);
+	tri.minY = (int)ceilf((minSnappedY - halfPixel) / SubpixelScale);
+	tri.maxY = (int)floorf((maxSnappedY - halfPixel) / SubpixelScale);
+	if (tri.minX < 0) tri.minX = 0;
+	if (tri.minY < 0) tri.minY = 0;
+	if (tri.maxX > (int)width - 1) tri.maxX = (int)width - 1;
+	if (tri.maxY > (int)height - 1) tri.maxY = (int)height - 1;
+	if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+		return;
+
+	// Edge i runs from vertex i to vertex i + 1
+	for (int i = 0; i < 3; i++)
+	{
+		int next = (i + 1) % 3;
+		int dx = snappedX[next] - snappedX[i];
+		int dy = snappedY[next] - snappedY[i];
+
+		tri.edgeA[i] = -dy;
+		tri.edgeB[i] = dx;
+		tri.edgeC[i] = (long long)dy * snappedX[i] - (long long)dx * snappedY[i];
+
+		// Top-left rule: a pixel center exactly on an edge only belongs
+		// to this triangle if it's a top or left edge, so two triangles
+		// sharing an edge never both draw (or both skip) a pixel.
+		// Other edges need a strictly positive value - the same as
+		// >= 0 after subtracting 1, since the values are integers
+		bool topLeft = dy < 0 || (dy == 0 && dx > 0);
+		if (!topLeft)
+			tri.edgeC[i] -= 1;
+	}
+
+	// Attribute planes, relative to vertex 0 to keep precision
+	float x1 = screenX[1] - screenX[0];
+	float y1 = screenY[1] - screenY[0];
+	float x2 = screenX[2] - screenX[0];
+	float y2 = screenY[2] - screenY[0];
+	float invArea = 1.0f / (x1 * y2 - x2 * y1);
+
+	tri.originX = screenX[0];
+	tri.originY = screenY[0];
+	for (int a = 0; a < AttributeCount; a++)
+	{
+		float d1 = attributes[1][a] - attributes[0][a];
+		float d2 = attributes[2][a] - attributes[0][a];
+		tri.value[a] = attributes[0][a];
+		tri.ddx[a] = (d1 * y2 - d2 * y1) * invArea;
+		tri.ddy[a] = (d2 * x1 - d1 * x2) * invArea;
+	}
+
+	triangles.push_back(tri);
+	stats.trianglesDrawn++;
+}
+
+// --------------------------------------------------------
+// Bins everything submitted since the last flush into
+// tiles, then fills the tiles across all threads
+// --------------------------------------------------------
+void SoftwareRasterizer::Flush()
+{
+	if (triangles.empty())
+		return;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (unsigned int t = 0; t < triangles.size(); t++)
+	{
+		const Triangle& tri = triangles[t];
+		unsigned int firstTileX = tri.minX / TileSize;
+		unsigned int lastTileX = tri.maxX / TileSize;
+		unsigned int firstTileY = tri.minY / TileSize;
+		unsigned int lastTileY = tri.maxY / TileSize;
+
+		for (unsigned int ty = firstTileY; ty <= lastTileY; ty++)
+			for (unsigned int tx = firstTileX; tx <= lastTileX; tx++)
+				tileBins[ty * tilesX + tx].push_back(t);
+	}
+
+	if (workers.empty())
+	{
+		for (unsigned int i = 1; i < threadCount; i++)
+			workers.push_back(std::thread(&SoftwareRasterizer::WorkerLoop, this));
+	}
+
+	// Wake the workers and pitch in until every tile is taken
+	nextTile = 0;
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		jobId++;
+		busyWorkers = (unsigned int)workers.size();
+	}
+	jobReady.notify_all();
+
+	RasterizeTiles();
+
+	{
+		std::unique_lock<std::mutex> lock(jobMutex);
+		jobDone.wait(lock, [this] { return busyWorkers == 0; });
+	}
+
+	for (unsigned int i = 0; i < tileBins.size(); i++)
+		tileBins[i].clear();
+	triangles.clear();
+
+	stats.rasterSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void SoftwareRasterizer::WorkerLoop()
+{
+	unsigned long long finishedJob = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobReady.wait(lock, [&] { return quitting || jobId != finishedJob; });
+			if (quitting)
+				return;
+			finishedJob = jobId;
+		}
+
+		RasterizeTiles();
+
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			busyWorkers--;
+		}
+		jobDone.notify_one();
+	}
+}
+
+// --------------------------------------------------------
+// Takes tiles off the shared counter until there are none
+// left.  A tile is only ever touched by one thread.
+// --------------------------------------------------------
+void SoftwareRasterizer::RasterizeTiles()
+{
+	unsigned int tileCount = tilesX * tilesY;
+	for (;;)
+	{
+		unsigned int tile = nextTile++;
+		if (tile >= tileCount)
+			return;
+
+		const std::vector<unsigned int>& bin = tileBins[tile];
+		if (bin.empty())
+			continue;
+
+		int tileMinX = (int)((tile % tilesX) * TileSize);
+		int tileMinY = (int)((tile / tilesX) * TileSize);
+		int tileMaxX = tileMinX + (int)TileSize - 1;
+		int tileMaxY = tileMinY + (int)TileSize - 1;
+
+		unsigned long long written = 0;
+		for (unsigned int i = 0; i < bin.size(); i++)
+			written += RasterizeTriangle(triangles[bin[i]], tileMinX, tileMinY, tileMaxX, tileMaxY);
+		pixelsWritten += written;
+	}
+}
+
+// --------------------------------------------------------
+// Fills the part of one triangle inside one tile, running
+// the depth test and PixelShader.hlsl (which just outputs
+// the interpolated color).  Returns the pixels written.
+// --------------------------------------------------------
+unsigned long long SoftwareRasterizer::RasterizeTriangle(const Triangle& tri, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY)
+{
+	int minX = tri.minX > tileMinX ? tri.minX : tileMinX;
+	int minY = tri.minY > tileMinY ? tri.minY : tileMinY;
+	int maxX = tri.maxX < tileMaxX ? tri.maxX : tileMaxX;
+	int maxY = tri.maxY < tileMaxY ? tri.maxY : tileMaxY;
+
+#if defined(SIMD_SSE)
+	// Start on a group of 4 (tiles are a multiple of 4 wide, so
+	// this never leaves the tile); lanes outside the triangle's
+	// bounds are masked off
+	int startX = minX & ~3;
+#else
+	int startX = minX;
+#endif
+
+	unsigned long long written = 0;
+	for (int y = minY; y <= maxY; y++)
+	{
+		// Edge values at the center of the row's first pixel
+		long long centerX = (long long)startX * SubpixelScale + SubpixelScale / 2;
+		long long centerY = (long long)y * SubpixelScale + SubpixelScale / 2;
+		int rowEdge[3];
+		for (int e = 0; e < 3; e++)
+		{
+			long long value = tri.edgeA[e] * centerX + tri.edgeB[e] * centerY + tri.edgeC[e];
+			rowEdge[e] = (int)(value < -MaxEdgeValue ? -MaxEdgeValue : (value > MaxEdgeValue ? MaxEdgeValue : value));
+		}
+
+		// Attribute values at the row's first pixel
+		float relativeX = startX + 0.5f - tri.originX;
+		float relativeY = y + 0.5f - tri.originY;
+		float rowValue[AttributeCount];
+		for (int a = 0; a < AttributeCount; a++)
+			rowValue[a] = tri.value[a] + tri.ddx[a] * relativeX + tri.ddy[a] * relativeY;
+
+		unsigned int* colorRow = &colorBuffer[y * pitch];
+		float* depthRow = &depthBuffer[y * pitch];
+
+#if defined(SIMD_SSE)
+		__m128i edge[3];
+		__m128i edgeStep[3];
+		for (int e = 0; e < 3; e++)
+		{
+			int step = tri.edgeA[e] * SubpixelScale;
+			edge[e] = _mm_setr_epi32(rowEdge[e], rowEdge[e] + step, rowEdge[e] + step * 2, rowEdge[e] + step * 3);
+			edgeStep[e] = _mm_set1_epi32(step * 4);
+		}
+
+		__m128 value[AttributeCount];
+		__m128 valueStep[AttributeCount];
+		for (int a = 0; a < AttributeCount; a++)
+		{
+			value[a] = _mm_setr_ps(rowValue[a], rowValue[a] + tri.ddx[a], rowValue[a] + tri.ddx[a] * 2, rowValue[a] + tri.ddx[a] * 3);
+			valueStep[a] = _mm_set1_ps(tri.ddx[a] * 4);
+		}
+
+		__m128i laneX = _mm_setr_epi32(startX, startX + 1, startX + 2, startX + 3);
+		__m128i laneStep = _mm_set1_epi32(4);
+		__m128i firstX = _mm_set1_epi32(minX - 1);
+		__m128i lastX = _mm_set1_epi32(maxX + 1);
+		__m128 one = _mm_set1_ps(1.0f);
+
+		for (int x = startX; x <= maxX; x += 4)
+		{
+			// Covered when all three edge values are >= 0, which is
+			// when none of them has its sign bit set
+			__m128i inBounds = _mm_and_si128(_mm_cmpgt_epi32(laneX, firstX), _mm_cmplt_epi32(laneX, lastX));
+			__m128i anyNegative = _mm_or_si128(_mm_or_si128(edge[0], edge[1]), edge[2]);
+			__m128 covered = _mm_castsi128_ps(_mm_andnot_si128(_mm_srai_epi32(anyNegative, 31), inBounds));
+
+			if (_mm_movemask_ps(covered))
+			{
+				__m128 oldDepth = _mm_loadu_ps(depthRow + x);
+				__m128 pass = _mm_and_ps(covered, _mm_cmplt_ps(value[DepthAttribute], oldDepth));
+				int passMask = _mm_movemask_ps(pass);
+
+				if (passMask)
+				{
+					_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(pass, value[DepthAttribute]), _mm_andnot_ps(pass, oldDepth)));
+
+					__m128 w = _mm_div_ps(one, value[InvWAttribute]);
+					__m128i color = PackColor4(
+						_mm_mul_ps(value[RedAttribute], w),
+						_mm_mul_ps(value[GreenAttribute], w),
+						_mm_mul_ps(value[BlueAttribute], w),
+						_mm_mul_ps(value[AlphaAttribute], w));
+
+					__m128i passBits = _mm_castps_si128(pass);
+					__m128i* colorPointer = (__m128i*)(colorRow + x);
+					__m128i oldColor = _mm_loadu_si128(colorPointer);
+					_mm_storeu_si128(colorPointer, _mm_or_si128(_mm_and_si128(passBits, color), _mm_andnot_si128(passBits, oldColor)));
+
+					written += (passMask & 1) + ((passMask >> 1) & 1) + ((passMask >> 2) & 1) + ((passMask >> 3) & 1);
+				}
+			}
+
+			for (int e = 0; e < 3; e++)
+				edge[e] = _mm_add_epi32(edge[e], edgeStep[e]);
+			for (int a = 0; a < AttributeCount; a++)
+				value[a] = _mm_add_ps(value[a], valueStep[a]);
+			laneX = _mm_add_epi32(laneX, laneStep);
+		}
+#else
+		for (int x = startX; x <= maxX; x++)
+		{
+			int step = x - startX;
+			bool covered =
+				rowEdge[0] + tri.edgeA[0] * SubpixelScale * step >= 0 &&
+				rowEdge[1] + tri.edgeA[1] * SubpixelScale * step >= 0 &&
+				rowEdge[2] + tri.edgeA[2] * SubpixelScale * step >= 0;
+			if (!covered)
+				continue;
+
+			float depth = rowValue[DepthAttribute] + tri.ddx[DepthAttribute] * step;
+			if (!(depth < depthRow[x]))
+				continue;
+
+			float w = 1.0f / (rowValue[InvWAttribute] + tri.ddx[InvWAttribute] * step);
+			depthRow[x] = depth;
+			colorRow[x] = PackColor(
+				(rowValue[RedAttribute] + tri.ddx[RedAttribute] * step) * w,
+				(rowValue[GreenAttribute] + tri.ddx[GreenAttribute] * step) * w,
+				(rowValue[BlueAttribute] + tri.ddx[BlueAttribute] * step) * w,
+				(rowValue[AlphaAttribute] + tri.ddx[AlphaAttribute] * step) * w);
+			written++;
+		}
+#endif
+	}
+
+	return written;
+}
+
+unsigned int SoftwareRasterizer::GetWidth()
+{
+	return width;
+}
+
+unsigned int SoftwareRasterizer::GetHeight()
+{
+	return height;
+}
+
+unsigned int SoftwareRasterizer::GetPitch()
+{
+	return pitch;
+}
+
+const unsigned int* SoftwareRasterizer::GetColorBuffer()
+{
+	return colorBuffer.data();
+}
+
+const float* SoftwareRasterizer::GetDepthBuffer()
+{
+	return depthBuffer.data();
+}
+
+// --------------------------------------------------------
+// Saves the color buffer as a binary PPM (alpha dropped)
+// --------------------------------------------------------
+bool SoftwareRasterizer::WritePPM(const char* path)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	file << "P6\n" << width << " " << height << "\n255\n";
+
+	std::vector<unsigned char> row(width * 3);
+	for (unsigned int y = 0; y < height; y++)
+	{
+		for (unsigned int x = 0; x < width; x++)
+		{
+			unsigned int pixel = colorBuffer[y * pitch + x];
+			row[x * 3 + 0] = (unsigned char)(pixel & 0xFF);
+			row[x * 3 + 1] = (unsigned char)((pixel >> 8) & 0xFF);
+			row[x * 3 + 2] = (unsigned char)((pixel >> 16) & 0xFF);
+		}
+		file.write((const char*)row.data(), row.size());
+	}
+
+	return file.good();
+}
+
+unsigned int SoftwareRasterizer::GetThreadCount()
+{
+	return threadCount;
+}
+
+RasterizerStats SoftwareRasterizer::GetStats()
+{
+	RasterizerStats result = stats;
+	result.pixelsWritten = pixelsWritten;
+	return result;
+}
+
+void SoftwareRasterizer::ResetStats()
+{
+	stats.trianglesSubmitted = 0;
+	stats.trianglesDrawn = 0;
+	stats.pixelsWritten = 0;
+	stats.rasterSeconds = 0;
+	pixelsWritten = 0;
+}
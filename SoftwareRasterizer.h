@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One vertex shader output: clip-space position plus the
+// color PixelShader.hlsl passes straight through
+struct RasterVertex
+{
+	float x, y, z, w;
+	float r, g, b, a;
+};
+
+// Counters kept by SoftwareRasterizer since the last ResetStats()
+struct RasterizerStats
+{
+	unsigned long long trianglesSubmitted;
+	unsigned long long trianglesDrawn;	// Survived clipping and back-face culling (clipped pieces count separately)
+	unsigned long long pixelsWritten;	// Passed the depth test
+	double rasterSeconds;				// Wall time spent binning and filling tiles
+};
+
+// --------------------------------------------------------
+// A tile-binned, multithreaded triangle rasterizer that
+// follows the D3D11 defaults the starter uses: clockwise
+// front faces with back-face culling, the top-left fill
+// rule, a LESS depth test and R8G8B8A8 output.
+//
+// Triangles are clipped and set up as they're submitted,
+// then Flush() bins them into screen tiles and hands the
+// tiles out to worker threads.  Each tile draws its
+// triangles in submission order, so the image doesn't
+// depend on how many threads there are.
+//
+// Coverage uses integer edge functions on a 1/16 pixel
+// grid (4 pixels at a time with SSE2); depth and color are
+// interpolated perspective-correct in floating point.
+// Viewports up to 4096 pixels on a side are supported.
+//
+// Not thread-safe itself - drive it from one thread.
+// --------------------------------------------------------
+class SoftwareRasterizer
+{
+public:
+	SoftwareRasterizer(unsigned int threadCount = 0);	// 0 = one per hardware thread
+	~SoftwareRasterizer();
+
+	void Resize(unsigned int width, unsigned int height);
+	void Clear(const float color[4], float depth);
+
+	//drawing - nothing reaches the buffers until Flush()
+	void SubmitTriangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2);
+	void Flush();
+
+	//results
+	unsigned int GetWidth();
+	unsigned int GetHeight();
+	unsigned int GetPitch();				// Pixels from one row to the next
+	const unsigned int* GetColorBuffer();	// R8G8B8A8, red in the lowest byte
+	const float* GetDepthBuffer();
+	bool WritePPM(const char* path);
+
+	unsigned int GetThreadCount();
+	RasterizerStats GetStats();
+	void ResetStats();
+
+	static const unsigned int TileSize = 64;
+
+private:
+	//interpolated values, each a plane over the screen
+	enum Attribute
+	{
+		DepthAttribute,		// z / w
+		InvWAttribute,		// 1 / w
+		RedAttribute,		// Colors are divided by w, so they
+		GreenAttribute,		// can be made perspective-correct
+		BlueAttribute,		// per pixel
+		AlphaAttribute,
+		AttributeCount
+	};
+
+	struct Triangle
+	{
+		// Edge function for each edge: a * x + b * y + c, in 1/16 pixels.
+		// Covered pixel centers are >= 0 on all three (c carries the fill rule)
+		int edgeA[3];
+		int edgeB[3];
+		long long edgeC[3];
+
+		// Pixel bounds (inclusive), already clamped to the viewport
+		int minX, minY, maxX, maxY;
+
+		// Attribute planes: value + ddx * (px - originX) + ddy * (py - originY)
+		float originX, originY;
+		float value[AttributeCount];
+		float ddx[AttributeCount];
+		float ddy[AttributeCount];
+	};
+
+	unsigned int width;
+	unsigned int height;
+	unsigned int pitch;
+	float guardBandX;
+	float guardBandY;
+	std::vector<unsigned int> colorBuffer;
+	std::vector<float> depthBuffer;
+
+	std::vector<Triangle> triangles;
+	unsigned int tilesX;
+	unsigned int tilesY;
+	std::vector<std::vector<unsigned int>> tileBins;	// Triangle indices per tile
+
+	//workers - the thread calling Flush() fills tiles too
+	unsigned int threadCount;
+	std::vector<std::thread> workers;
+	std::mutex jobMutex;
+	std::condition_variable jobReady;
+	std::condition_variable jobDone;
+	unsigned long long jobId;
+	unsigned int busyWorkers;
+	bool quitting;
+	std::atomic<unsigned int> nextTile;
+	std::atomic<unsigned long long> pixelsWritten;
+
+	RasterizerStats stats;
+
+	void SetupTriangle(const RasterVertex& v0, const RasterVertex& v1, const RasterVertex& v2);
+	unsigned int GetOutcode(const RasterVertex& v);
+	float GetClipDistance(const RasterVertex& v, int plane);
+
+	void WorkerLoop();
+	void RasterizeTiles();
+	unsigned long long RasterizeTriangle(const Triangle& tri, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY);
+};
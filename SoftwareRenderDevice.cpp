@@ -0,0 +1,471 @@
+#include "SoftwareRenderDevice.h"
+#include "BufferStructs.h"
+#include <DirectXPackedVector.h>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+const unsigned int SoftwareRenderDevice::MaxBindSlots;
+
+// --------------------------------------------------------
+// The math of VertexShader.hlsl and InstancedVertexShader.hlsl:
+// position * world * viewProjection, and color * tint.
+// The matrices are the row-major ones the CPU wrote, so the
+// row-vector products here are what the shaders' column-major
+// mul()s work out to.
+// --------------------------------------------------------
+static RasterVertex RunStarterVertexShader(const float position[3], const float color[4],
+	const float world[16], const float tint[4], const float viewProjection[16])
+{
+	float worldPosition[4];
+	for (int c = 0; c < 4; c++)
+	{
+		worldPosition[c] =
+			position[0] * world[c] +
+			position[1] * world[4 + c] +
+			position[2] * world[8 + c] +
+			world[12 + c];
+	}
+
+	float screenPosition[4];
+	for (int c = 0; c < 4; c++)
+	{
+		screenPosition[c] =
+			worldPosition[0] * viewProjection[c] +
+			worldPosition[1] * viewProjection[4 + c] +
+			worldPosition[2] * viewProjection[8 + c] +
+			worldPosition[3] * viewProjection[12 + c];
+	}
+
+	RasterVertex output;
+	output.x = screenPosition[0];
+	output.y = screenPosition[1];
+	output.z = screenPosition[2];
+	output.w = screenPosition[3];
+	output.r = color[0] * tint[0];
+	output.g = color[1] * tint[1];
+	output.b = color[2] * tint[2];
+	output.a = color[3] * tint[3];
+	return output;
+}
+
+// --------------------------------------------------------
+// Reads one element as floats, the way the input assembler
+// would - missing components stay as the caller set them
+// --------------------------------------------------------
+static void ReadElement(const unsigned char* data, VertexElementFormat format, float* output, unsigned int outputCount)
+{
+	switch (format)
+	{
+	case FormatUnorm8x4:
+		for (unsigned int i = 0; i < outputCount && i < 4; i++)
+			output[i] = data[i] / 255.0f;
+		break;
+
+	case FormatHalf4:
+		for (unsigned int i = 0; i < outputCount && i < 4; i++)
+		{
+			DirectX::PackedVector::HALF half;
+			memcpy(&half, data + i * 2, 2);
+			output[i] = DirectX::PackedVector::XMConvertHalfToFloat(half);
+		}
+		break;
+
+	default:
+	{
+		unsigned int count = GetVertexElementSize(format) / 4;
+		memcpy(output, data, sizeof(float) * (count < outputCount ? count : outputCount));
+		break;
+	}
+	}
+}
+
+SoftwareRenderDevice::SoftwareRenderDevice(unsigned int threadCount)
+	: rasterizer(threadCount)
+{
+	this->vertexShaderCount = 0;
+	this->pixelShaderCount = 0;
+
+	this->boundInputLayout = 0;
+	this->boundIndexBuffer = 0;
+	this->boundIndexFormat = IndexFormat32;
+	for (unsigned int i = 0; i < MaxBindSlots; i++)
+	{
+		this->boundVertexBuffers[i] = 0;
+		this->boundStrides[i] = 0;
+		this->boundVSConstantBuffers[i] = 0;
+	}
+
+	this->shadeSeconds = 0;
+	this->framesPresented = 0;
+}
+
+bool SoftwareRenderDevice::Initialize(void* windowHandle, unsigned int width, unsigned int height)
+{
+	rasterizer.Resize(width, height);
+	return true;
+}
+
+void SoftwareRenderDevice::Resize(unsigned int width, unsigned int height)
+{
+	rasterizer.Resize(width, height);
+}
+
+std::string SoftwareRenderDevice::GetName()
+{
+	std::ostringstream output;
+	output << "Software (" << rasterizer.GetThreadCount() << " threads)";
+	return output.str();
+}
+
+// --------------------------------------------------------
+// Triangles and pixels per frame and per second of
+// rendering work (vertex shading plus rasterizing) since
+// the previous call, which starts a new measurement
+// --------------------------------------------------------
+std::string SoftwareRenderDevice::GetFrameStats()
+{
+	RasterizerStats stats = rasterizer.GetStats();
+	double seconds = shadeSeconds + stats.rasterSeconds;
+	unsigned int frames = framesPresented ? framesPresented : 1;
+
+	std::ostringstream output;
+	output.precision(4);
+	output << "    Triangles: " << stats.trianglesDrawn / frames;
+	output << " (" << (seconds > 0 ? stats.trianglesDrawn / seconds / 1000000.0 : 0.0) << "M/s)";
+	output << "    Pixels: " << stats.pixelsWritten / frames;
+	output << " (" << (seconds > 0 ? stats.pixelsWritten / seconds / 1000000.0 : 0.0) << "M/s)";
+
+	rasterizer.ResetStats();
+	shadeSeconds = 0;
+	framesPresented = 0;
+	return output.str();
+}
+
+// --------------------------------------------------------
+// Every buffer lives in plain memory, since the vertex
+// shaders read them all on the CPU
+// --------------------------------------------------------
+BufferHandle SoftwareRenderDevice::CreateBuffer(BufferType type, BufferUsage usage, const void* data, unsigned int size)
+{
+	Buffer buffer;
+	buffer.type = type;
+	buffer.alive = true;
+	buffer.contents.resize(size);
+	if (data)
+		memcpy(buffer.contents.data(), data, size);
+
+	// Reuse a released slot if there is one
+	if (!freeBuffers.empty())
+	{
+		BufferHandle handle = freeBuffers.back();
+		freeBuffers.pop_back();
+		buffers[handle - 1] = buffer;
+		return handle;
+	}
+
+	buffers.push_back(buffer);
+	return (BufferHandle)buffers.size();
+}
+
+void SoftwareRenderDevice::ReleaseBuffer(BufferHandle buffer)
+{
+	Buffer* b = GetBuffer(buffer);
+	if (!b)
+		return;
+
+	b->alive = false;
+	b->contents.clear();
+	b->contents.shrink_to_fit();
+	freeBuffers.push_back(buffer);
+}
+
+// The byte code is only a token - see the class comment
+ShaderHandle SoftwareRenderDevice::CreateVertexShader(const void* byteCode, size_t byteCodeSize)
+{
+	return ++vertexShaderCount;
+}
+
+ShaderHandle SoftwareRenderDevice::CreatePixelShader(const void* byteCode, size_t byteCodeSize)
+{
+	return ++pixelShaderCount;
+}
+
+// --------------------------------------------------------
+// Works out where each starter shader input sits, and
+// whether the layout is the instanced one
+// --------------------------------------------------------
+InputLayoutHandle SoftwareRenderDevice::CreateInputLayout(const VertexElement* elements, unsigned int elementCount,
+	const void* vsByteCode, size_t vsByteCodeSize)
+{
+	InputLayout layout = {};
+	unsigned int slotOffsets[MaxBindSlots] = {};
+
+	for (unsigned int i = 0; i < elementCount; i++)
+	{
+		const VertexElement& element = elements[i];
+		if (element.inputSlot >= MaxBindSlots)
+			continue;
+
+		unsigned int offset = slotOffsets[element.inputSlot];
+		slotOffsets[element.inputSlot] += GetVertexElementSize(element.format);
+
+		if (strcmp(element.semanticName, "POSITION") == 0)
+		{
+			layout.positionSlot = element.inputSlot;
+			layout.positionOffset = offset;
+			layout.positionFormat = element.format;
+		}
+		else if (strcmp(element.semanticName, "COLOR") == 0)
+		{
+			layout.hasColor = true;
+			layout.colorSlot = element.inputSlot;
+			layout.colorOffset = offset;
+			layout.colorFormat = element.format;
+		}
+		else if (strcmp(element.semanticName, "WORLD") == 0 && element.perInstance && element.semanticIndex < 4)
+		{
+			layout.instanced = true;
+			layout.worldOffset[element.semanticIndex] = offset;
+		}
+		else if (strcmp(element.semanticName, "TINT") == 0 && element.perInstance)
+		{
+			layout.hasTint = true;
+			layout.tintOffset = offset;
+		}
+	}
+
+	inputLayouts.push_back(layout);
+	return (InputLayoutHandle)inputLayouts.size();
+}
+
+void* SoftwareRenderDevice::Map(BufferHandle buffer)
+{
+	Buffer* b = GetBuffer(buffer);
+	return b ? b->contents.data() : 0;
+}
+
+void SoftwareRenderDevice::Unmap(BufferHandle buffer)
+{
+}
+
+void SoftwareRenderDevice::UpdateBuffer(BufferHandle buffer, unsigned int offset, const void* data, unsigned int size)
+{
+	Buffer* b = GetBuffer(buffer);
+	if (b && offset + size <= b->contents.size())
+		memcpy(b->contents.data() + offset, data, size);
+}
+
+// Only one vertex and one pixel shader of each kind exist here
+void SoftwareRenderDevice::SetVertexShader(ShaderHandle shader)
+{
+}
+
+void SoftwareRenderDevice::SetPixelShader(ShaderHandle shader)
+{
+}
+
+void SoftwareRenderDevice::SetInputLayout(InputLayoutHandle layout)
+{
+	boundInputLayout = layout;
+}
+
+void SoftwareRenderDevice::SetVertexBuffers(unsigned int startSlot, unsigned int count, const BufferHandle* buffers, const unsigned int* strides)
+{
+	for (unsigned int i = 0; i < count && startSlot + i < MaxBindSlots; i++)
+	{
+		boundVertexBuffers[startSlot + i] = buffers[i];
+		boundStrides[startSlot + i] = strides[i];
+	}
+}
+
+void SoftwareRenderDevice::SetIndexBuffer(BufferHandle buffer, IndexFormat format)
+{
+	boundIndexBuffer = buffer;
+	boundIndexFormat = format;
+}
+
+void SoftwareRenderDevice::SetVSConstantBuffers(unsigned int startSlot, unsigned int count, const BufferHandle* buffers)
+{
+	for (unsigned int i = 0; i < count && startSlot + i < MaxBindSlots; i++)
+		boundVSConstantBuffers[startSlot + i] = buffers[i];
+}
+
+void SoftwareRenderDevice::BeginFrame(const float clearColor[4])
+{
+	rasterizer.Flush();
+	rasterizer.Clear(clearColor, 1.0f);
+}
+
+void SoftwareRenderDevice::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	Draw(indexCount, 1, startIndex, baseVertex, 0);
+}
+
+void SoftwareRenderDevice::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount,
+	unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	Draw(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+// --------------------------------------------------------
+// Finishes the frame - the image stays in the rasterizer
+// (see GetRasterizer() and WriteImage())
+// --------------------------------------------------------
+void SoftwareRenderDevice::Present(bool vsync)
+{
+	rasterizer.Flush();
+	framesPresented++;
+}
+
+SoftwareRasterizer* SoftwareRenderDevice::GetRasterizer()
+{
+	return &rasterizer;
+}
+
+// --------------------------------------------------------
+// Saves the last presented frame as a PPM image
+// --------------------------------------------------------
+bool SoftwareRenderDevice::WriteImage(const char* path)
+{
+	rasterizer.Flush();
+	return rasterizer.WritePPM(path);
+}
+
+SoftwareRenderDevice::Buffer* SoftwareRenderDevice::GetBuffer(BufferHandle buffer)
+{
+	if (buffer == 0 || buffer > buffers.size() || !buffers[buffer - 1].alive)
+		return 0;
+	return &buffers[buffer - 1];
+}
+
+// --------------------------------------------------------
+// Shared by both draw calls.  Shades every vertex the
+// indices reach once per instance, then hands the
+// triangles to the rasterizer.  Draws with anything
+// missing or out of range are skipped, like the debug
+// layer would complain about.
+// --------------------------------------------------------
+void SoftwareRenderDevice::Draw(unsigned int indexCount, unsigned int instanceCount,
+	unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	if (boundInputLayout == 0 || boundInputLayout > inputLayouts.size() || indexCount < 3)
+		return;
+	const InputLayout& layout = inputLayouts[boundInputLayout - 1];
+
+	// Camera (b0) is needed by both shaders
+	Buffer* frameBuffer = GetBuffer(boundVSConstantBuffers[0]);
+	if (!frameBuffer || frameBuffer->contents.size() < sizeof(PerFrameVertexShaderData))
+		return;
+	PerFrameVertexShaderData frameData;
+	memcpy(&frameData, frameBuffer->contents.data(), sizeof(frameData));
+
+	// Indices, and the range of vertices they touch
+	Buffer* indexBuffer = GetBuffer(boundIndexBuffer);
+	unsigned int indexSize = boundIndexFormat == IndexFormat16 ? 2 : 4;
+	if (!indexBuffer || (size_t)(startIndex + indexCount) * indexSize > indexBuffer->contents.size())
+		return;
+
+	drawIndices.resize(indexCount);
+	unsigned int* indices = drawIndices.data();
+	const unsigned char* indexData = indexBuffer->contents.data() + startIndex * indexSize;
+	for (unsigned int i = 0; i < indexCount; i++)
+	{
+		if (indexSize == 2)
+		{
+			unsigned short index;
+			memcpy(&index, indexData + i * 2, 2);
+			indices[i] = index;
+		}
+		else
+			memcpy(&indices[i], indexData + i * 4, 4);
+	}
+
+	unsigned int minIndex = indices[0];
+	unsigned int maxIndex = indices[0];
+	for (unsigned int i = 1; i < indexCount; i++)
+	{
+		if (indices[i] < minIndex) minIndex = indices[i];
+		if (indices[i] > maxIndex) maxIndex = indices[i];
+	}
+	long long firstVertex = (long long)minIndex + baseVertex;
+	long long lastVertex = (long long)maxIndex + baseVertex;
+	if (firstVertex < 0)
+		return;
+
+	// Per-vertex streams
+	Buffer* positionBuffer = GetBuffer(boundVertexBuffers[layout.positionSlot]);
+	unsigned int positionStride = boundStrides[layout.positionSlot];
+	if (!positionBuffer || lastVertex * positionStride + layout.positionOffset + GetVertexElementSize(layout.positionFormat) > (long long)positionBuffer->contents.size())
+		return;
+
+	Buffer* colorBuffer = layout.hasColor ? GetBuffer(boundVertexBuffers[layout.colorSlot]) : 0;
+	unsigned int colorStride = layout.hasColor ? boundStrides[layout.colorSlot] : 0;
+	if (layout.hasColor && (!colorBuffer || lastVertex * colorStride + layout.colorOffset + GetVertexElementSize(layout.colorFormat) > (long long)colorBuffer->contents.size()))
+		return;
+
+	// World matrix and tint - from the instance stream or from b1
+	Buffer* instanceBuffer = 0;
+	unsigned int instanceStride = 0;
+	VertexShaderExternalData objectData;
+	if (layout.instanced)
+	{
+		instanceBuffer = GetBuffer(boundVertexBuffers[1]);
+		instanceStride = boundStrides[1];
+		if (!instanceBuffer || (size_t)(startInstance + instanceCount) * instanceStride > instanceBuffer->contents.size())
+			return;
+	}
+	else
+	{
+		Buffer* objectBuffer = GetBuffer(boundVSConstantBuffers[1]);
+		if (!objectBuffer || objectBuffer->contents.size() < sizeof(VertexShaderExternalData))
+			return;
+		memcpy(&objectData, objectBuffer->contents.data(), sizeof(objectData));
+	}
+
+	unsigned int vertexCount = maxIndex - minIndex + 1;
+	shadedVertices.resize(vertexCount);
+
+	for (unsigned int instance = 0; instance < instanceCount; instance++)
+	{
+		float world[16];
+		float tint[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		if (layout.instanced)
+		{
+			const unsigned char* instanceData = instanceBuffer->contents.data() + (size_t)(startInstance + instance) * instanceStride;
+			for (int row = 0; row < 4; row++)
+				memcpy(world + row * 4, instanceData + layout.worldOffset[row], sizeof(float) * 4);
+			if (layout.hasTint)
+				memcpy(tint, instanceData + layout.tintOffset, sizeof(tint));
+		}
+		else
+		{
+			memcpy(world, &objectData.worldMatrix, sizeof(world));
+			memcpy(tint, &objectData.colorTint, sizeof(tint));
+		}
+
+		for (unsigned int v = 0; v < vertexCount; v++)
+		{
+			size_t vertex = (size_t)(firstVertex + v);
+			float position[3];
+			float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+			ReadElement(positionBuffer->contents.data() + vertex * positionStride + layout.positionOffset, layout.positionFormat, position, 3);
+			if (colorBuffer)
+				ReadElement(colorBuffer->contents.data() + vertex * colorStride + layout.colorOffset, layout.colorFormat, color, 4);
+
+			shadedVertices[v] = RunStarterVertexShader(position, color, world, tint, &frameData.viewProjection._11);
+		}
+
+		for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+		{
+			rasterizer.SubmitTriangle(
+				shadedVertices[indices[i] - minIndex],
+				shadedVertices[indices[i + 1] - minIndex],
+				shadedVertices[indices[i + 2] - minIndex]);
+		}
+	}
+
+	shadeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
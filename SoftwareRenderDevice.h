@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vector>
+#include "RenderDevice.h"
+#include "SoftwareRasterizer.h"
+
+// --------------------------------------------------------
+// A RenderDevice that draws on the CPU with
+// SoftwareRasterizer - a reference renderer for golden
+// images and GPU-free throughput numbers.
+//
+// Shader byte code can't run here, so vertices go through
+// C++ versions of the starter shaders instead.  The input
+// layout picks which: one with per-instance WORLD rows gets
+// InstancedVertexShader.hlsl, anything else gets
+// VertexShader.hlsl (reading b0 and b1 as BufferStructs.h
+// lays them out).  Pixels always get PixelShader.hlsl.
+//
+// Always renders offscreen, even when given a window.
+// --------------------------------------------------------
+class SoftwareRenderDevice : public RenderDevice
+{
+public:
+	SoftwareRenderDevice(unsigned int threadCount = 0);	// 0 = one per hardware thread
+
+	bool Initialize(void* windowHandle, unsigned int width, unsigned int height);
+	void Resize(unsigned int width, unsigned int height);
+	std::string GetName();
+	std::string GetFrameStats();
+
+	BufferHandle CreateBuffer(BufferType type, BufferUsage usage, const void* data, unsigned int size);
+	void ReleaseBuffer(BufferHandle buffer);
+	ShaderHandle CreateVertexShader(const void* byteCode, size_t byteCodeSize);
+	ShaderHandle CreatePixelShader(const void* byteCode, size_t byteCodeSize);
+	InputLayoutHandle CreateInputLayout(const VertexElement* elements, unsigned int elementCount,
+		const void* vsByteCode, size_t vsByteCodeSize);
+
+	void* Map(BufferHandle buffer);
+	void Unmap(BufferHandle buffer);
+	void UpdateBuffer(BufferHandle buffer, unsigned int offset, const void* data, unsigned int size);
+
+	void SetVertexShader(ShaderHandle shader);
+	void SetPixelShader(ShaderHandle shader);
+	void SetInputLayout(InputLayoutHandle layout);
+	void SetVertexBuffers(unsigned int startSlot, unsigned int count, const BufferHandle* buffers, const unsigned int* strides);
+	void SetIndexBuffer(BufferHandle buffer, IndexFormat format);
+	void SetVSConstantBuffers(unsigned int startSlot, unsigned int count, const BufferHandle* buffers);
+
+	void BeginFrame(const float clearColor[4]);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount,
+		unsigned int startIndex, int baseVertex, unsigned int startInstance);
+	void Present(bool vsync);
+
+	//results - the last presented frame
+	SoftwareRasterizer* GetRasterizer();
+	bool WriteImage(const char* path);
+
+	// Vertex and constant buffer slots
+	static const unsigned int MaxBindSlots = 8;
+
+private:
+	struct Buffer
+	{
+		BufferType type;
+		bool alive;
+		std::vector<unsigned char> contents;
+	};
+
+	// Where the starter shaders' inputs live (byte offsets within their slot)
+	struct InputLayout
+	{
+		bool instanced;
+		unsigned int positionSlot;
+		unsigned int positionOffset;
+		VertexElementFormat positionFormat;
+		bool hasColor;
+		unsigned int colorSlot;
+		unsigned int colorOffset;
+		VertexElementFormat colorFormat;
+		unsigned int worldOffset[4];	// Instanced only (slot 1), one per matrix row
+		bool hasTint;
+		unsigned int tintOffset;		// Instanced only (slot 1)
+	};
+
+	SoftwareRasterizer rasterizer;
+
+	std::vector<Buffer> buffers;
+	std::vector<BufferHandle> freeBuffers;
+	std::vector<InputLayout> inputLayouts;
+	unsigned int vertexShaderCount;
+	unsigned int pixelShaderCount;
+
+	//what's bound right now
+	InputLayoutHandle boundInputLayout;
+	BufferHandle boundVertexBuffers[MaxBindSlots];
+	unsigned int boundStrides[MaxBindSlots];
+	BufferHandle boundIndexBuffer;
+	IndexFormat boundIndexFormat;
+	BufferHandle boundVSConstantBuffers[MaxBindSlots];
+
+	//per-draw scratch, kept around so drawing doesn't allocate once they've grown
+	std::vector<unsigned int> drawIndices;
+	std::vector<RasterVertex> shadedVertices;
+
+	//throughput since the last GetFrameStats()
+	double shadeSeconds;
+	unsigned int framesPresented;
+
+	Buffer* GetBuffer(BufferHandle buffer);
+	void Draw(unsigned int indexCount, unsigned int instanceCount,
+		unsigned int startIndex, int baseVertex, unsigned int startInstance);
+};
@@ -0,0 +1,300 @@
+// Fills a BoundingVolumeHierarchy with ItemCount boxes, then for Frames
+// frames moves a tenth of them, adds and removes a few (so a background
+// rebuild is usually in flight), and checks every frustum, sphere, box
+// and ray query against a linear scan of the same boxes.  Prints the
+// time per query.  Returns non-zero on any mismatch, if no query ran
+// while a rebuild was in flight, or (in optimized builds) if even the
+// fastest query of a kind takes over TargetQueryMilliseconds - the
+// fastest, as the rebuild thread can share the core with the others.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <DirectXMath.h>
+#include "BoundingVolumeHierarchy.h"
+
+using namespace DirectX;
+
+static const unsigned int ItemCount = 100000;
+static const unsigned int Frames = 60;
+static const unsigned int MovesPerFrame = ItemCount / 10;
+static const unsigned int ChurnPerFrame = 100;
+static const unsigned int QueriesPerFrame = 8;
+static const double TargetQueryMilliseconds = 1.0;
+
+static unsigned int randomState = 2463534242u;
+static unsigned int NextRandom()
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+static float RandomRange(float low, float high)
+{
+	return low + (high - low) * (NextRandom() & 0xFFFFFF) / (float)0xFFFFFF;
+}
+
+// A box of half-size 0.5 - 2 somewhere in a 1000 x 100 x 1000 world
+static BvhBounds RandomBounds()
+{
+	float center[3] = { RandomRange(-500, 500), RandomRange(-50, 50), RandomRange(-500, 500) };
+	float extent = RandomRange(0.5f, 2.0f);
+	BvhBounds bounds;
+	for (int a = 0; a < 3; a++)
+	{
+		bounds.min[a] = center[a] - extent;
+		bounds.max[a] = center[a] + extent;
+	}
+	return bounds;
+}
+
+// --------------------------------------------------------
+// The reference tests, written out plainly: the frustum one
+// is the same furthest-corner test the hierarchy makes (so
+// the results must match exactly), the others are the usual
+// box overlap, box-sphere distance and slab tests
+// --------------------------------------------------------
+static bool InFrustum(const BvhBounds& b, const XMFLOAT4 planes[6])
+{
+	for (int i = 0; i < 6; i++)
+	{
+		const XMFLOAT4& p = planes[i];
+		float furthest =
+			p.x * (p.x >= 0 ? b.max[0] : b.min[0]) +
+			p.y * (p.y >= 0 ? b.max[1] : b.min[1]) +
+			p.z * (p.z >= 0 ? b.max[2] : b.min[2]) + p.w;
+		if (furthest < 0)
+			return false;
+	}
+	return true;
+}
+
+static bool TouchesSphere(const BvhBounds& b, const float center[3], float radius)
+{
+	float distanceSquared = 0;
+	for (int a = 0; a < 3; a++)
+	{
+		float outside = std::max(b.min[a] - center[a], std::max(center[a] - b.max[a], 0.0f));
+		distanceSquared += outside * outside;
+	}
+	return distanceSquared <= radius * radius;
+}
+
+static bool Overlaps(const BvhBounds& b, const BvhBounds& other)
+{
+	for (int a = 0; a < 3; a++)
+	{
+		if (b.min[a] > other.max[a] || b.max[a] < other.min[a])
+			return false;
+	}
+	return true;
+}
+
+static bool RayEnters(const BvhBounds& b, const float origin[3], const float direction[3], float maxT, float& t)
+{
+	float tNear = 0;
+	float tFar = maxT;
+	for (int a = 0; a < 3; a++)
+	{
+		if (direction[a] == 0)
+		{
+			if (origin[a] < b.min[a] || origin[a] > b.max[a])
+				return false;
+			continue;
+		}
+		float inverse = 1.0f / direction[a];
+		float t0 = (b.min[a] - origin[a]) * inverse;
+		float t1 = (b.max[a] - origin[a]) * inverse;
+		if (inverse < 0)
+			std::swap(t0, t1);
+		tNear = std::max(tNear, t0);
+		tFar = std::min(tFar, t1);
+		if (tNear > tFar)
+			return false;
+	}
+	t = tNear;
+	return true;
+}
+
+static bool passed = true;
+
+static void Check(bool condition, const char* what, unsigned int frame)
+{
+	if (!condition)
+	{
+		printf("FAILED: %s (frame %u)\n", what, frame);
+		passed = false;
+	}
+}
+
+// The hierarchy returns items in tree order; the scan in id order
+static bool SameItems(std::vector<unsigned int>& found, const std::vector<unsigned int>& expected)
+{
+	std::sort(found.begin(), found.end());
+	return found == expected;
+}
+
+int main()
+{
+	BoundingVolumeHierarchy bvh;
+	std::vector<BvhBounds> bounds(ItemCount);
+	std::vector<unsigned char> present(ItemCount, 1);
+	for (unsigned int i = 0; i < ItemCount; i++)
+	{
+		bounds[i] = RandomBounds();
+		bvh.SetBounds(i, bounds[i]);
+	}
+
+	auto buildStart = std::chrono::steady_clock::now();
+	bvh.Update();
+	double buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(
+		XMMatrixLookToLH(XMVectorSet(0, 0, -100, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0)),
+		XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 150.0f)));
+	Frustum frustum(viewProjection);
+	XMFLOAT4 planes[6];
+	for (int i = 0; i < 6; i++)
+		planes[i] = frustum.GetPlane(i);
+
+	double updateMilliseconds = 0;
+	double queryMilliseconds[4] = {};
+	double fastestMilliseconds[4] = { 1e9, 1e9, 1e9, 1e9 };
+	unsigned int queryCounts[4] = {};
+	unsigned int queryResults[4] = {};
+	unsigned int queriesDuringRebuild = 0;
+	std::vector<unsigned int> found;
+	std::vector<unsigned int> expected;
+	for (unsigned int frame = 0; frame < Frames; frame++)
+	{
+		// Most moves are small nudges, so the tree is refit; a few jump across the world
+		for (unsigned int m = 0; m < MovesPerFrame; m++)
+		{
+			unsigned int item = NextRandom() % ItemCount;
+			if (!present[item])
+				continue;
+			if (m % 64 == 0)
+				bounds[item] = RandomBounds();
+			else
+			{
+				float offset[3] = { RandomRange(-1, 1), RandomRange(-1, 1), RandomRange(-1, 1) };
+				for (int a = 0; a < 3; a++)
+				{
+					bounds[item].min[a] += offset[a];
+					bounds[item].max[a] += offset[a];
+				}
+			}
+			bvh.SetBounds(item, bounds[item]);
+		}
+		for (unsigned int c = 0; c < ChurnPerFrame; c++)
+		{
+			unsigned int item = NextRandom() % ItemCount;
+			if (present[item])
+				bvh.Remove(item);
+			else
+			{
+				bounds[item] = RandomBounds();
+				bvh.SetBounds(item, bounds[item]);
+			}
+			present[item] ^= 1;
+		}
+
+		auto updateStart = std::chrono::steady_clock::now();
+		bvh.Update();
+		updateMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - updateStart).count();
+		if (bvh.GetStats().rebuilding)
+			queriesDuringRebuild++;
+
+		for (unsigned int q = 0; q < QueriesPerFrame; q++)
+		{
+			unsigned int kind = q % 4;
+			float center[3] = { RandomRange(-500, 500), RandomRange(-50, 50), RandomRange(-500, 500) };
+			found.clear();
+			expected.clear();
+
+			auto start = std::chrono::steady_clock::now();
+			if (kind == 0)
+				bvh.QueryFrustum(frustum, found);
+			else if (kind == 1)
+				bvh.QuerySphere(center, 20.0f, found);
+			else if (kind == 2)
+			{
+				BvhBounds box = { { center[0] - 20, center[1] - 20, center[2] - 20 }, { center[0] + 20, center[1] + 20, center[2] + 20 } };
+				bvh.QueryBounds(box, found);
+			}
+			unsigned int hitItem = 0;
+			float hitT = 0;
+			float direction[3] = { RandomRange(-1, 1), RandomRange(-0.1f, 0.1f), RandomRange(-1, 1) };
+			bool hit = kind == 3 && bvh.Raycast(center, direction, 1000.0f, hitItem, hitT);
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			queryMilliseconds[kind] += milliseconds;
+			fastestMilliseconds[kind] = std::min(fastestMilliseconds[kind], milliseconds);
+			queryCounts[kind]++;
+			queryResults[kind] += kind == 3 ? (hit ? 1 : 0) : (unsigned int)found.size();
+
+			if (kind == 3)
+			{
+				// Ties can go either way, so only the distance has to match
+				bool expectedHit = false;
+				float nearest = 1000.0f;
+				for (unsigned int i = 0; i < ItemCount; i++)
+				{
+					float t;
+					if (present[i] && RayEnters(bounds[i], center, direction, nearest, t))
+					{
+						expectedHit = true;
+						nearest = t;
+					}
+				}
+				Check(hit == expectedHit, "Raycast hit", frame);
+				if (hit && expectedHit)
+				{
+					float t;
+					Check(hitT == nearest, "Raycast distance", frame);
+					Check(present[hitItem] && RayEnters(bounds[hitItem], center, direction, 1000.0f, t) && t == hitT, "Raycast item", frame);
+				}
+				continue;
+			}
+
+			BvhBounds box = { { center[0] - 20, center[1] - 20, center[2] - 20 }, { center[0] + 20, center[1] + 20, center[2] + 20 } };
+			for (unsigned int i = 0; i < ItemCount; i++)
+			{
+				if (!present[i])
+					continue;
+				bool inside = kind == 0 ? InFrustum(bounds[i], planes) : kind == 1 ? TouchesSphere(bounds[i], center, 20.0f) : Overlaps(bounds[i], box);
+				if (inside)
+					expected.push_back(i);
+			}
+			static const char* names[] = { "QueryFrustum matches a linear scan", "QuerySphere matches a linear scan", "QueryBounds matches a linear scan" };
+			Check(SameItems(found, expected), names[kind], frame);
+		}
+	}
+	bvh.FinishRebuild();
+	BvhStats stats = bvh.GetStats();
+
+	printf("%u items: first build %.2f ms, Update %.3f ms/frame, %u rebuilds, %u of %u frames queried mid-rebuild\n",
+		ItemCount, buildMilliseconds, updateMilliseconds / Frames, stats.rebuilds, queriesDuringRebuild, Frames);
+	static const char* kinds[] = { "frustum", "sphere", "bounds", "ray" };
+	double slowest = 0;
+	for (int kind = 0; kind < 4; kind++)
+	{
+		slowest = std::max(slowest, fastestMilliseconds[kind]);
+		printf("  %-8s %.4f ms/query (fastest %.4f), %.1f items found per query\n", kinds[kind],
+			queryMilliseconds[kind] / queryCounts[kind], fastestMilliseconds[kind], (double)queryResults[kind] / queryCounts[kind]);
+	}
+	Check(queriesDuringRebuild > 0, "queries ran while a rebuild was in flight", Frames);
+	Check(stats.rebuilds > 0, "a background rebuild was swapped in", Frames);
+
+#ifdef NDEBUG
+	if (slowest > TargetQueryMilliseconds)
+	{
+		printf("Above the target of %.1f ms per query\n", TargetQueryMilliseconds);
+		passed = false;
+	}
+#endif
+	printf("%s\n", passed ? "ok" : "FAILED");
+	return passed ? 0 : 1;
+}
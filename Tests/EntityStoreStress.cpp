@@ -0,0 +1,143 @@
+// Spawn/despawn stress benchmark for EntityStore.  Randomly creates
+// and destroys entities of two archetypes between MinLive and MaxLive
+// entities, counting heap allocations.  Returns non-zero if the
+// measured run allocates at all, leaves a stale handle alive, or (in
+// optimized builds) manages fewer than TargetOpsPerSecond.
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include "EntityStore.h"
+#include "Components.h"
+
+static const unsigned int MinLive = 5000;
+static const unsigned int MaxLive = 15000;
+static const unsigned int WarmUpOps = 1000000;
+static const unsigned int MeasuredOps = 4000000;
+static const double TargetOpsPerSecond = 1000000.0;
+
+// Counts every global operator new while counting is on
+static std::atomic<bool> countAllocations(false);
+static std::atomic<unsigned int> allocationCount(0);
+
+void* operator new(size_t size)
+{
+	if (countAllocations)
+		allocationCount++;
+	void* memory = malloc(size ? size : 1);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* memory) noexcept { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+
+// xorshift32, so the sequence is the same on every platform
+static unsigned int randomState = 2463534242u;
+static unsigned int NextRandom()
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+// --------------------------------------------------------
+// Spawns or despawns one entity, keeping the live count in
+// [MinLive, MaxLive].  Despawns pick a random live entity and
+// swap-remove it from the list.  Every 64th despawn checks the
+// dead handle no longer resolves
+// --------------------------------------------------------
+static bool Step(EntityStore& store, std::vector<Entity>& live, unsigned int op)
+{
+	unsigned int roll = NextRandom();
+	bool spawn = live.size() < MinLive || (live.size() < MaxLive && (roll & 1));
+	if (spawn)
+	{
+		Entity entity = (roll & 2)
+			? store.Create(TintComponent{ { 1.0f, 0.5f, 0.25f, 1.0f } })
+			: store.Create(MeshComponent{ 0 }, TintComponent{ { 0.0f, 0.0f, 0.0f, 1.0f } });
+		if (entity.id == 0)
+			return false;
+		live.push_back(entity);
+		return true;
+	}
+
+	unsigned int index = (roll >> 2) % live.size();
+	Entity entity = live[index];
+	live[index] = live.back();
+	live.pop_back();
+	store.Destroy(entity);
+	return (op & 63) != 0 || !store.IsAlive(entity);
+}
+
+int main()
+{
+	EntityStore store;
+	store.Reserve(MaxLive * 2);
+	std::vector<Entity> live;
+	live.reserve(MaxLive);
+
+	// Warm up: fill each archetype to MaxLive and empty it, so
+	// every chunk either could need is parked, then churn so the
+	// slot table and free list settle
+	for (unsigned int archetype = 0; archetype < 2; archetype++)
+	{
+		for (unsigned int i = 0; i < MaxLive; i++)
+		{
+			live.push_back(archetype
+				? store.Create(TintComponent{ { 1.0f, 0.5f, 0.25f, 1.0f } })
+				: store.Create(MeshComponent{ 0 }, TintComponent{ { 0.0f, 0.0f, 0.0f, 1.0f } }));
+		}
+		for (unsigned int i = 0; i < MaxLive; i++)
+			store.Destroy(live[i]);
+		live.clear();
+	}
+	for (unsigned int op = 0; op < WarmUpOps; op++)
+	{
+		if (!Step(store, live, op))
+		{
+			printf("Warm-up failed at op %u\n", op);
+			return 1;
+		}
+	}
+
+	countAllocations = true;
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int op = 0; op < MeasuredOps; op++)
+	{
+		if (!Step(store, live, op))
+		{
+			countAllocations = false;
+			printf("Stale or failed handle at op %u\n", op);
+			return 1;
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	countAllocations = false;
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+	double opsPerSecond = MeasuredOps / seconds;
+	printf("%u spawn/despawn ops over %u-%u live entities: %.1fM ops/s, %u heap allocations\n",
+		MeasuredOps, MinLive, MaxLive, opsPerSecond / 1000000.0, allocationCount.load());
+
+	bool passed = allocationCount == 0;
+#ifdef NDEBUG
+	if (opsPerSecond < TargetOpsPerSecond)
+	{
+		printf("Below the target of %.1fM ops/s\n", TargetOpsPerSecond / 1000000.0);
+		passed = false;
+	}
+#endif
+	return passed ? 0 : 1;
+}
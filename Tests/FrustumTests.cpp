@@ -0,0 +1,69 @@
+// Checks Frustum::CullSpheres (SIMD blocks and scalar tail) agrees
+// with IntersectsSphere on every sphere, including NaN ones, which
+// both must cull.  Returns non-zero on any disagreement.
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+#include <DirectXMath.h>
+#include "Frustum.h"
+
+using namespace DirectX;
+
+int main()
+{
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(
+		XMMatrixLookToLH(XMVectorSet(0, 0, -5, 0), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0)),
+		XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 100.0f)));
+	Frustum frustum(viewProjection);
+
+	// 19 spheres, so there's an AVX2 block, an SSE block and a scalar tail
+	// whichever paths are compiled in.  Every fifth one has a NaN somewhere
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	const unsigned int count = 19;
+	std::vector<float> x(count), y(count), z(count), radius(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		x[i] = (float)i - 9.0f;
+		y[i] = sinf((float)i) * 3.0f;
+		z[i] = (float)(i % 7) * 4.0f - 6.0f;
+		radius[i] = 0.5f + (float)(i % 3);
+	}
+	for (unsigned int i = 2; i < count; i += 5)
+	{
+		switch (i % 4)
+		{
+		case 0: x[i] = nan; break;
+		case 1: y[i] = nan; break;
+		case 2: z[i] = nan; break;
+		default: radius[i] = nan; break;
+		}
+	}
+
+	std::vector<unsigned int> visible(count);
+	unsigned int visibleCount = frustum.CullSpheres(x.data(), y.data(), z.data(), radius.data(), count, visible.data());
+
+	bool passed = true;
+	unsigned int next = 0;
+	unsigned int expectedCount = 0;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		bool single = frustum.IntersectsSphere(XMFLOAT3(x[i], y[i], z[i]), radius[i]);
+		bool batched = next < visibleCount && visible[next] == i;
+		if (batched)
+			next++;
+		if (single)
+			expectedCount++;
+
+		bool hasNaN = std::isnan(x[i]) || std::isnan(y[i]) || std::isnan(z[i]) || std::isnan(radius[i]);
+		if (single != batched || (hasNaN && single))
+		{
+			printf("Sphere %u: IntersectsSphere %d, CullSpheres %d%s\n", i, single, batched, hasNaN ? " (NaN)" : "");
+			passed = false;
+		}
+	}
+
+	printf("%u of %u spheres visible, %u expected: %s\n", visibleCount, count, expectedCount, passed ? "ok" : "FAILED");
+	return passed && next == visibleCount ? 0 : 1;
+}
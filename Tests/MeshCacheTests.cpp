@@ -0,0 +1,123 @@
+// Checks HashContent against published XXH64 values (empty input,
+// under and over one 32-byte stripe) and that ContentHasher gives the
+// same results fed in pieces.  Then checks MeshCache: asking
+// twice for the same geometry returns the same mesh and counts the
+// upload saved, unused meshes are evicted oldest first once over
+// budget, and meshes in use are never evicted.  Returns non-zero on
+// any failure.
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include "ContentHash.h"
+#include "MeshCache.h"
+#include "NullRenderDevice.h"
+
+using namespace DirectX;
+
+static bool passed = true;
+
+static void Check(bool condition, const char* what)
+{
+	if (!condition)
+	{
+		printf("FAILED: %s\n", what);
+		passed = false;
+	}
+}
+
+struct KnownHash
+{
+	const char* text;
+	unsigned long long seed;
+	unsigned long long hash;
+};
+
+static const KnownHash KnownHashes[] =
+{
+	{ "", 0, 0xEF46DB3751D8E999ull },
+	{ "a", 0, 0xD24EC4F1A98C6E5Bull },
+	{ "abc", 0, 0x44BC2CF5AD770999ull },
+	{ "xxhash", 0, 0x32DD38952C4BC720ull },
+	{ "Nobody inspects the spammish repetition", 0, 0xFBCEA83C8A378BF1ull },
+};
+
+// A triangle at height y - the same size as every other one, but different content
+static std::shared_ptr<Mesh> GetTriangle(MeshCache& cache, float y)
+{
+	Vertex vertices[3] =
+	{
+		{ XMFLOAT3(0.0f, y, 0.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f) },
+		{ XMFLOAT3(1.0f, y, 0.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f) },
+		{ XMFLOAT3(0.0f, y, 1.0f), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f) },
+	};
+	unsigned int indices[3] = { 0, 2, 1 };
+	return cache.GetMesh(vertices, 3, indices, 3);
+}
+
+int main()
+{
+	// Known answers, whole and split at every point (so pieces straddle the 32-byte stripes)
+	for (size_t i = 0; i < sizeof(KnownHashes) / sizeof(KnownHashes[0]); i++)
+	{
+		const KnownHash& known = KnownHashes[i];
+		size_t length = strlen(known.text);
+		Check(HashContent(known.text, length, known.seed) == known.hash, "HashContent matches XXH64");
+		for (size_t split = 0; split <= length; split++)
+		{
+			ContentHasher hasher(known.seed);
+			hasher.Add(known.text, split);
+			hasher.Add(known.text + split, length - split);
+			Check(hasher.Finish() == known.hash, "ContentHasher in two pieces matches XXH64");
+		}
+	}
+
+	// Longer input in uneven pieces, against the one-shot hash
+	unsigned char data[1000];
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = (unsigned char)(i * 131 + 7);
+	ContentHasher pieces(7);
+	for (size_t start = 0, size = 1; start < sizeof(data); start += size, size = size * 2 + 1)
+		pieces.Add(data + start, start + size <= sizeof(data) ? size : sizeof(data) - start);
+	Check(pieces.Finish() == HashContent(data, sizeof(data), 7), "ContentHasher in many pieces matches HashContent");
+	Check(HashContent(data, sizeof(data), 7) != HashContent(data, sizeof(data), 8), "the seed changes the hash");
+
+	NullRenderDevice device;
+	GeometryPool pool(&device);
+	MeshCache cache(&pool);
+
+	// Hits hand back the same mesh and count the bytes not uploaded
+	std::shared_ptr<Mesh> first = GetTriangle(cache, 0.0f);
+	unsigned long long meshBytes = cache.GetStats().bytes;
+	std::shared_ptr<Mesh> again = GetTriangle(cache, 0.0f);
+	MeshCacheStats stats = cache.GetStats();
+	Check(first && first == again, "a hit returns the same mesh");
+	Check(stats.hits == 1 && stats.misses == 1 && stats.meshCount == 1, "one miss, then one hit");
+	Check(stats.bytesSaved == meshBytes, "bytesSaved grows by the mesh's bytes on a hit");
+	Check(GetTriangle(cache, 1.0f) != first, "different geometry, different mesh");
+	first.reset();
+	again.reset();
+
+	// Room for three: with 0 and 1 unused, 0 asked for again and 2 made, making 3 evicts 1
+	cache.SetMemoryBudget(meshBytes * 3);
+	GetTriangle(cache, 0.0f);
+	std::shared_ptr<Mesh> held = GetTriangle(cache, 2.0f);
+	stats = cache.GetStats();
+	Check(stats.evictions == 0 && stats.meshCount == 3, "nothing evicted within budget");
+	GetTriangle(cache, 3.0f);
+	stats = cache.GetStats();
+	Check(stats.evictions == 1 && stats.meshCount == 3 && stats.bytes <= meshBytes * 3, "one eviction over budget");
+	unsigned int hits = stats.hits;
+	GetTriangle(cache, 0.0f).reset();
+	Check(cache.GetStats().hits == hits + 1, "the recently used mesh stayed");
+	GetTriangle(cache, 1.0f).reset();
+	Check(cache.GetStats().hits == hits + 1, "the least recently used mesh went first");
+
+	// In use is never evicted, even over budget
+	cache.SetMemoryBudget(0);
+	stats = cache.GetStats();
+	Check(stats.meshCount == 1 && stats.bytes == meshBytes, "only the mesh in use is left");
+	Check(GetTriangle(cache, 2.0f) == held, "the mesh in use is still cached");
+
+	printf("%s\n", passed ? "ok" : "FAILED");
+	return passed ? 0 : 1;
+}
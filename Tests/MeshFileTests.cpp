@@ -0,0 +1,89 @@
+// Writes small mesh files, reads them back, and checks the index
+// stream comes out in the width picked at bake time: 16-bit when every
+// index fits, 32-bit otherwise - whether the file is loaded directly or
+// through the background loader.  Returns non-zero on any failure.
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "AssetLoader.h"
+#include "MeshFile.h"
+#include "NullRenderDevice.h"
+
+static bool passed = true;
+
+static void Check(bool condition, const char* what)
+{
+	if (!condition)
+	{
+		printf("FAILED: %s\n", what);
+		passed = false;
+	}
+}
+
+// --------------------------------------------------------
+// A strip of vertexCount vertices along x, indexed as
+// triangles over its first and last three vertices
+// --------------------------------------------------------
+static void TestRoundTrip(const std::string& path, unsigned int vertexCount, IndexFormat expectedFormat)
+{
+	std::vector<MeshFileVertex> vertices(vertexCount);
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		MeshFileVertex vertex = { { (float)i, (float)(i % 2), 0.0f }, { 1.0f, 1.0f, 1.0f, 1.0f } };
+		vertices[i] = vertex;
+	}
+	unsigned int indices[] = { 0, 1, 2, vertexCount - 3, vertexCount - 2, vertexCount - 1, 2, 1, 0 };
+	MeshFileLod lods[] = { { 0, 6, 0.0f }, { 6, 3, 1.0f } };
+
+	Check(WriteMeshFile(path, vertices.data(), vertexCount, indices, 9, lods, 2), "WriteMeshFile");
+
+	MappedFile file;
+	MeshFileContents contents;
+	MeshBounds bounds;
+	if (!OpenMeshFile(path, file, contents, bounds))
+	{
+		Check(false, "OpenMeshFile");
+		return;
+	}
+	Check(GetIndexFormat(*contents.header) == expectedFormat, "index format picked at bake time");
+	Check(contents.header->indexCount == 9, "index count");
+
+	// The stream holds the indices as they are, in the chosen width
+	for (unsigned int i = 0; i < 9; i++)
+	{
+		unsigned int index = expectedFormat == IndexFormat16
+			? ((const unsigned short*)contents.indices)[i]
+			: ((const unsigned int*)contents.indices)[i];
+		Check(index == indices[i], "index values");
+	}
+	Check(contents.lods[1].firstIndex == 6 && contents.lods[1].indexCount == 3, "LOD table after the index stream");
+
+	NullRenderDevice device;
+	GeometryPool pool(&device);
+	std::shared_ptr<Mesh> mesh = LoadMeshFile<Vertex>(path, &pool);
+	Check(mesh != 0, "LoadMeshFile");
+	if (mesh)
+	{
+		Check(mesh->GetIndexFormat() == expectedFormat, "mesh index format");
+		Check(mesh->GetIndexCount() == 9 && mesh->GetLodCount() == 2, "mesh index and LOD counts");
+	}
+
+	// The loader's workers pack the vertices, so its placeholder becomes the same mesh
+	AssetLoader loader(&pool, 1);
+	std::shared_ptr<Mesh> loaded = loader.LoadMesh<PackedVertex>(path);
+	loader.Finish();
+	Check(loader.GetStats().loaded == 1, "AssetLoader swapped the mesh in");
+	Check(!loaded->IsEmpty() && loaded->GetIndexFormat() == expectedFormat, "loaded mesh index format");
+	Check(loaded->GetIndexCount() == 9 && loaded->GetLodCount() == 2, "loaded mesh index and LOD counts");
+}
+
+int main()
+{
+	TestRoundTrip("MeshFileTests16.mesh", 100, IndexFormat16);
+	TestRoundTrip("MeshFileTests32.mesh", 70000, IndexFormat32);
+	remove("MeshFileTests16.mesh");
+	remove("MeshFileTests32.mesh");
+
+	printf("%s\n", passed ? "ok" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+// Shuffles the triangles of a grid (with a few vertices nothing uses)
+// and checks OptimizeMesh keeps exactly the same triangles, windings
+// included, drops the unused vertices and doesn't make the ACMR worse;
+// then that OptimizeVertexFetch lays vertices out in first-use order.
+// Returns non-zero on any failure.
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "MeshOptimizer.h"
+#include "Vertex.h"
+
+using namespace DirectX;
+
+static const unsigned int GridSize = 64;
+static const unsigned int UnusedVertices = 10;
+
+static bool passed = true;
+
+static void Check(bool condition, const char* what)
+{
+	if (!condition)
+	{
+		printf("FAILED: %s\n", what);
+		passed = false;
+	}
+}
+
+static unsigned int randomState = 2463534242u;
+static unsigned int NextRandom()
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+// A triangle as its three positions (each grid vertex has its own),
+// rotated so the smallest comes first - the same triangle and winding
+// whichever corner a pass starts it on
+typedef std::array<float, 9> Triangle;
+
+static std::vector<Triangle> GetTriangles(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+	std::vector<Triangle> triangles;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const XMFLOAT3* corners[3] = { &vertices[indices[i]].Position, &vertices[indices[i + 1]].Position, &vertices[indices[i + 2]].Position };
+		int first = 0;
+		for (int c = 1; c < 3; c++)
+		{
+			if (std::make_pair(corners[c]->x, corners[c]->y) < std::make_pair(corners[first]->x, corners[first]->y))
+				first = c;
+		}
+		Triangle triangle;
+		for (int c = 0; c < 3; c++)
+		{
+			const XMFLOAT3* p = corners[(first + c) % 3];
+			triangle[c * 3] = p->x;
+			triangle[c * 3 + 1] = p->y;
+			triangle[c * 3 + 2] = p->z;
+		}
+		triangles.push_back(triangle);
+	}
+	std::sort(triangles.begin(), triangles.end());
+	return triangles;
+}
+
+int main()
+{
+	// A bumpy grid, so the overdraw pass has slopes to sort by
+	std::vector<Vertex> vertices;
+	for (unsigned int y = 0; y <= GridSize; y++)
+	{
+		for (unsigned int x = 0; x <= GridSize; x++)
+			vertices.push_back({ XMFLOAT3((float)x, (float)y, (float)((x * 7 + y * 3) % 5)), XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f) });
+	}
+	for (unsigned int i = 0; i < UnusedVertices; i++)
+		vertices.push_back({ XMFLOAT3(-1.0f, -1.0f - i, 0.0f), XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f) });
+
+	std::vector<std::array<unsigned int, 3>> quads;
+	for (unsigned int y = 0; y < GridSize; y++)
+	{
+		for (unsigned int x = 0; x < GridSize; x++)
+		{
+			unsigned int a = y * (GridSize + 1) + x;
+			unsigned int b = a + 1;
+			unsigned int c = a + GridSize + 1;
+			unsigned int d = c + 1;
+			quads.push_back({ a, c, d });
+			quads.push_back({ a, d, b });
+		}
+	}
+	for (size_t i = quads.size() - 1; i > 0; i--)
+		std::swap(quads[i], quads[NextRandom() % (i + 1)]);
+	std::vector<unsigned int> indices;
+	for (size_t i = 0; i < quads.size(); i++)
+		indices.insert(indices.end(), quads[i].begin(), quads[i].end());
+
+	// The whole pipeline: same triangles, fewer cache misses, unused vertices gone
+	std::vector<Triangle> expected = GetTriangles(vertices, indices);
+	std::vector<Vertex> optimizedVertices = vertices;
+	std::vector<unsigned int> optimizedIndices = indices;
+	MeshOptimizationReport report;
+	size_t vertexCount = OptimizeMesh(optimizedVertices.data(), optimizedVertices.size(), sizeof(Vertex), offsetof(Vertex, Position),
+		optimizedIndices.data(), optimizedIndices.size(), &report);
+	optimizedVertices.resize(vertexCount);
+	printf("%zu triangles: ACMR %.3f -> %.3f, %zu -> %zu vertices\n", indices.size() / 3,
+		report.before.acmr, report.after.acmr, report.vertexCountBefore, report.vertexCountAfter);
+	Check(vertexCount == vertices.size() - UnusedVertices && report.vertexCountAfter == vertexCount, "unused vertices dropped");
+	Check(std::all_of(optimizedIndices.begin(), optimizedIndices.end(), [&](unsigned int i) { return i < vertexCount; }), "indices inside the vertex buffer");
+	Check(GetTriangles(optimizedVertices, optimizedIndices) == expected, "same triangles and windings");
+	Check(report.after.acmr <= report.before.acmr, "ACMR no worse");
+	Check(report.before.acmr == AnalyzeVertexCache(indices.data(), indices.size(), vertices.size()).acmr, "report.before matches AnalyzeVertexCache");
+	Check(report.after.acmr == AnalyzeVertexCache(optimizedIndices.data(), optimizedIndices.size(), vertexCount).acmr, "report.after matches AnalyzeVertexCache");
+
+	// OptimizeVertexFetch alone: each new index is the next vertex, holding what it held before
+	std::vector<unsigned int> fetchIndices = indices;
+	std::vector<Vertex> fetched(vertices.size());
+	size_t referenced = OptimizeVertexFetch(fetched.data(), fetchIndices.data(), fetchIndices.size(), vertices.data(), vertices.size(), sizeof(Vertex));
+	Check(referenced == vertices.size() - UnusedVertices, "OptimizeVertexFetch counts referenced vertices");
+	unsigned int next = 0;
+	bool firstUseOrder = true;
+	bool sameVertices = true;
+	for (size_t i = 0; i < fetchIndices.size(); i++)
+	{
+		if (fetchIndices[i] == next)
+			next++;
+		else if (fetchIndices[i] > next)
+			firstUseOrder = false;
+		sameVertices = sameVertices && memcmp(&fetched[fetchIndices[i]], &vertices[indices[i]], sizeof(Vertex)) == 0;
+	}
+	Check(firstUseOrder, "vertices in first-use order");
+	Check(next == referenced, "no unreferenced vertices written");
+	Check(sameVertices, "every index still reaches the same vertex");
+
+	printf("%s\n", passed ? "ok" : "FAILED");
+	return passed ? 0 : 1;
+}
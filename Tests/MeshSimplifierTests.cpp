@@ -0,0 +1,130 @@
+// Builds a LOD chain for a procedural sphere twice and checks the two
+// are identical byte for byte, that every LOD is a valid range of the
+// index list with no degenerate triangles and errors that never
+// decrease, and that Mesh::SelectLod walks down the chain as an object
+// covers fewer pixels.  Returns non-zero on any failure.
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "Mesh.h"
+#include "MeshSimplifier.h"
+#include "NullRenderDevice.h"
+
+using namespace DirectX;
+
+static bool passed = true;
+
+static void Check(bool condition, const char* what)
+{
+	if (!condition)
+	{
+		printf("FAILED: %s\n", what);
+		passed = false;
+	}
+}
+
+// --------------------------------------------------------
+// A closed, welded UV sphere: one vertex at each pole and
+// rings of segments vertices between them
+// --------------------------------------------------------
+static void BuildSphere(unsigned int rings, unsigned int segments, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	XMFLOAT4 white(1.0f, 1.0f, 1.0f, 1.0f);
+	vertices.push_back({ XMFLOAT3(0.0f, 1.0f, 0.0f), white });
+	for (unsigned int ring = 1; ring < rings; ring++)
+	{
+		float theta = XM_PI * ring / rings;
+		for (unsigned int segment = 0; segment < segments; segment++)
+		{
+			float phi = XM_2PI * segment / segments;
+			vertices.push_back({ XMFLOAT3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi)), white });
+		}
+	}
+	vertices.push_back({ XMFLOAT3(0.0f, -1.0f, 0.0f), white });
+
+	unsigned int bottom = (unsigned int)vertices.size() - 1;
+	for (unsigned int segment = 0; segment < segments; segment++)
+	{
+		unsigned int next = (segment + 1) % segments;
+
+		// Polar caps
+		indices.insert(indices.end(), { 0, 1 + next, 1 + segment });
+		unsigned int last = 1 + (rings - 2) * segments;
+		indices.insert(indices.end(), { bottom, last + segment, last + next });
+
+		// Quads between rings
+		for (unsigned int ring = 0; ring + 2 < rings; ring++)
+		{
+			unsigned int a = 1 + ring * segments + segment;
+			unsigned int b = 1 + ring * segments + next;
+			unsigned int c = a + segments;
+			unsigned int d = b + segments;
+			indices.insert(indices.end(), { a, b, d, a, d, c });
+		}
+	}
+}
+
+int main()
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> sphere;
+	BuildSphere(32, 48, vertices, sphere);
+
+	// Determinism: two runs over the same input give the same bytes
+	std::vector<unsigned int> indices[2] = { sphere, sphere };
+	std::vector<SimplifiedLod> lods[2];
+	for (int run = 0; run < 2; run++)
+		BuildLodChain(indices[run], lods[run], vertices.data(), vertices.size(), sizeof(Vertex), offsetof(Vertex, Position));
+	Check(indices[0].size() == indices[1].size() &&
+		memcmp(indices[0].data(), indices[1].data(), indices[0].size() * sizeof(unsigned int)) == 0, "index lists identical");
+	Check(lods[0].size() == lods[1].size() &&
+		memcmp(lods[0].data(), lods[1].data(), lods[0].size() * sizeof(SimplifiedLod)) == 0, "LOD tables identical");
+	Check(lods[0].size() > 2, "more than two LODs");
+
+	// Every LOD is whole triangles inside the list, LOD 0 untouched, errors never falling
+	Check(memcmp(indices[0].data(), sphere.data(), sphere.size() * sizeof(unsigned int)) == 0, "LOD 0 is the input");
+	for (size_t i = 0; i < lods[0].size(); i++)
+	{
+		const SimplifiedLod& lod = lods[0][i];
+		Check(lod.indexCount % 3 == 0 && lod.indexCount > 0, "whole triangles");
+		Check((size_t)lod.firstIndex + lod.indexCount <= indices[0].size(), "range inside indices");
+		if (i > 0)
+		{
+			Check(lod.error >= lods[0][i - 1].error, "errors never decrease");
+			Check(lod.indexCount < lods[0][i - 1].indexCount, "each LOD coarser than the last");
+		}
+		for (unsigned int t = lod.firstIndex; t + 3 <= lod.firstIndex + lod.indexCount && t + 3 <= indices[0].size(); t += 3)
+		{
+			unsigned int a = indices[0][t], b = indices[0][t + 1], c = indices[0][t + 2];
+			Check(a != b && b != c && a != c, "no triangle repeats a corner");
+			Check(a < vertices.size() && b < vertices.size() && c < vertices.size(), "indices inside the vertex buffer");
+		}
+	}
+	printf("%zu LODs:", lods[0].size());
+	for (size_t i = 0; i < lods[0].size(); i++)
+		printf(" %u (%g)", lods[0][i].indexCount / 3, lods[0][i].error);
+	printf("\n");
+
+	// The fewer pixels a unit covers, the coarser the LOD picked
+	NullRenderDevice device;
+	GeometryPool pool(&device);
+	std::vector<MeshLod> meshLods(lods[0].size());
+	for (size_t i = 0; i < lods[0].size(); i++)
+		meshLods[i] = { lods[0][i].firstIndex, lods[0][i].indexCount, lods[0][i].error };
+	VertexMesh<Vertex> mesh(vertices.data(), vertices.size(), indices[0].data(), indices[0].size(),
+		Mesh::CalculateBounds(vertices.data(), vertices.size()), meshLods.data(), (unsigned int)meshLods.size(), &pool);
+	Check(mesh.SelectLod(1e9f, 1.0f) == 0, "full detail up close");
+	Check(mesh.SelectLod(1e-9f, 1.0f) == meshLods.size() - 1, "coarsest far away");
+	unsigned int previous = 0;
+	for (float pixelsPerUnit = 1e6f; pixelsPerUnit > 1e-3f; pixelsPerUnit *= 0.5f)
+	{
+		unsigned int lod = mesh.SelectLod(pixelsPerUnit, 1.0f);
+		Check(lod >= previous, "coarser as pixelsPerUnit falls");
+		Check(lod == 0 || meshLods[lod].error * pixelsPerUnit <= 1.0f, "picked LOD stays under the pixel error");
+		previous = lod;
+	}
+
+	printf("%s\n", passed ? "ok" : "FAILED");
+	return passed ? 0 : 1;
+}
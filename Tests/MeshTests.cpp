@@ -0,0 +1,86 @@
+// Checks a mesh the geometry pool can't make room for is left empty:
+// nothing allocated, one empty LOD, and draws that issue nothing.
+// Returns non-zero on any failure.
+#include <cstdio>
+#include "Mesh.h"
+#include "NullRenderDevice.h"
+
+using namespace DirectX;
+
+// A null device that can refuse vertex or index buffers, as a real
+// device does when it runs out of memory
+class FailingRenderDevice : public NullRenderDevice
+{
+public:
+	bool failVertexBuffers;
+	bool failIndexBuffers;
+
+	FailingRenderDevice() : failVertexBuffers(false), failIndexBuffers(false) {}
+
+	BufferHandle CreateBuffer(BufferType type, BufferUsage usage, const void* data, unsigned int size)
+	{
+		if ((type == VertexBufferType && failVertexBuffers) || (type == IndexBufferType && failIndexBuffers))
+			return 0;
+		return NullRenderDevice::CreateBuffer(type, usage, data, size);
+	}
+};
+
+static const Vertex TriangleVertices[3] =
+{
+	{ XMFLOAT3(+0.0f, +1.0f, +0.0f), XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f) },
+	{ XMFLOAT3(+1.5f, -1.0f, +0.0f), XMFLOAT4(0.0f, 0.0f, 1.0f, 1.0f) },
+	{ XMFLOAT3(-1.5f, -1.0f, +0.0f), XMFLOAT4(0.0f, 1.0f, 0.0f, 1.0f) }
+};
+static const unsigned int TriangleIndices[3] = { 0, 1, 2 };
+
+static bool passed = true;
+
+static void Check(bool condition, const char* name, const char* what)
+{
+	if (!condition)
+	{
+		printf("FAILED: %s: %s\n", name, what);
+		passed = false;
+	}
+}
+
+static void TestMesh(const char* name, bool failVertexBuffers, bool failIndexBuffers)
+{
+	FailingRenderDevice device;
+	device.failVertexBuffers = failVertexBuffers;
+	device.failIndexBuffers = failIndexBuffers;
+	GeometryPool pool(&device);
+	bool expectEmpty = failVertexBuffers || failIndexBuffers;
+	{
+		VertexMesh<Vertex> mesh(TriangleVertices, 3, TriangleIndices, 3, &pool);
+		Meshlet meshlet = {};
+		meshlet.indexCount = 3;
+		mesh.SetMeshlets(&meshlet, 1);
+
+		Check(mesh.IsEmpty() == expectEmpty, name, "IsEmpty");
+		if (expectEmpty)
+		{
+			Check(mesh.GetIndexCount() == 0 && mesh.GetLodCount() == 1 && mesh.GetLod(0).indexCount == 0, name, "one empty LOD");
+			Check(mesh.GetMeshletCount() == 0, name, "meshlets dropped");
+			Check(pool.GetStats().usedBytes == 0, name, "partial allocation given back");
+			Check(mesh.GetVertexBuffer() == 0 && mesh.GetIndexBuffer() == 0, name, "no buffers");
+		}
+
+		device.ResetStats();
+		MeshletRange range = { 0, 3 };
+		mesh.Draw();
+		mesh.DrawInstanced(0, 0, 2, 0);
+		mesh.DrawRanges(0, &range, 1);
+		Check(device.GetStats().drawCalls == (expectEmpty ? 0u : 3u), name, "draw calls");
+	}
+	Check(pool.GetStats().usedBytes == 0, name, "freed with the mesh");
+	printf("%-24s %s\n", name, passed ? "ok" : "FAILED");
+}
+
+int main()
+{
+	TestMesh("Allocated", false, false);
+	TestMesh("No room for vertices", true, false);
+	TestMesh("No room for indices", false, true);
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+// Checks meshlet culling is conservative: from cameras all round (and
+// inside) a bumpy sphere, IsMeshletBackFacing never rejects a meshlet
+// with a triangle facing the camera, and Mesh::CullMeshlets' ranges
+// hold every triangle that faces the camera and isn't wholly outside
+// the frustum.  Returns non-zero on any failure.
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "Frustum.h"
+#include "Mesh.h"
+#include "MeshletBuilder.h"
+#include "NullRenderDevice.h"
+
+using namespace DirectX;
+
+static const unsigned int CameraCount = 200;
+
+static bool passed = true;
+
+static void Check(bool condition, const char* what)
+{
+	if (!condition)
+	{
+		printf("FAILED: %s\n", what);
+		passed = false;
+	}
+}
+
+static unsigned int randomState = 2463534242u;
+static float RandomRange(float low, float high)
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return low + (high - low) * (randomState & 0xFFFFFF) / (float)0xFFFFFF;
+}
+
+// --------------------------------------------------------
+// A closed, welded sphere with bumps, so its meshlets have
+// cones of many widths; clockwise from outside, like the
+// starter's front faces
+// --------------------------------------------------------
+static void BuildBumpySphere(unsigned int rings, unsigned int segments, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	XMFLOAT4 white(1.0f, 1.0f, 1.0f, 1.0f);
+	vertices.push_back({ XMFLOAT3(0.0f, 1.0f, 0.0f), white });
+	for (unsigned int ring = 1; ring < rings; ring++)
+	{
+		float theta = XM_PI * ring / rings;
+		for (unsigned int segment = 0; segment < segments; segment++)
+		{
+			float phi = XM_2PI * segment / segments;
+			float radius = 1.0f + 0.15f * sinf(5.0f * phi) * sinf(4.0f * theta);
+			vertices.push_back({ XMFLOAT3(radius * sinf(theta) * cosf(phi), radius * cosf(theta), radius * sinf(theta) * sinf(phi)), white });
+		}
+	}
+	vertices.push_back({ XMFLOAT3(0.0f, -1.0f, 0.0f), white });
+
+	unsigned int bottom = (unsigned int)vertices.size() - 1;
+	unsigned int last = 1 + (rings - 2) * segments;
+	for (unsigned int segment = 0; segment < segments; segment++)
+	{
+		unsigned int next = (segment + 1) % segments;
+		indices.insert(indices.end(), { 0, 1 + next, 1 + segment });
+		indices.insert(indices.end(), { bottom, last + segment, last + next });
+		for (unsigned int ring = 0; ring + 2 < rings; ring++)
+		{
+			unsigned int a = 1 + ring * segments + segment;
+			unsigned int b = 1 + ring * segments + next;
+			unsigned int c = a + segments;
+			unsigned int d = b + segments;
+			indices.insert(indices.end(), { a, b, d, a, d, c });
+		}
+	}
+}
+
+static XMVECTOR GetPosition(const std::vector<Vertex>& vertices, unsigned int index, FXMMATRIX world)
+{
+	return XMVector3TransformCoord(XMLoadFloat3(&vertices[index].Position), world);
+}
+
+// Front faces have cross(p1 - p0, p2 - p0) toward the viewer.  A small
+// tolerance (relative to the triangle) keeps edge-on triangles out of it
+static bool FacesCamera(FXMVECTOR p0, FXMVECTOR p1, FXMVECTOR p2, GXMVECTOR camera)
+{
+	XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+	XMVECTOR toCamera = XMVectorSubtract(camera, p0);
+	float facing = XMVectorGetX(XMVector3Dot(normal, toCamera));
+	float scale = XMVectorGetX(XMVector3Length(normal)) * XMVectorGetX(XMVector3Length(toCamera));
+	return facing > scale * 1e-4f;
+}
+
+static bool OutsidePlane(FXMVECTOR p, const XMFLOAT4& plane)
+{
+	return XMVectorGetX(XMVector3Dot(p, XMLoadFloat3((const XMFLOAT3*)&plane))) + plane.w < 0;
+}
+
+int main()
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	BuildBumpySphere(48, 96, vertices, indices);
+	std::vector<Meshlet> meshlets;
+	Mesh::GenerateMeshlets(vertices, indices, meshlets);
+
+	NullRenderDevice device;
+	GeometryPool pool(&device);
+	MeshLod lod = { 0, (unsigned int)indices.size(), 0.0f };
+	VertexMesh<Vertex> mesh(vertices.data(), vertices.size(), indices.data(), indices.size(),
+		Mesh::CalculateBounds(vertices.data(), vertices.size()), &lod, 1, &pool);
+	mesh.SetMeshlets(meshlets.data(), (unsigned int)meshlets.size());
+
+	// Uniformly scaled (so the cone test runs) and stretched (so it's skipped)
+	XMMATRIX rotation = XMMatrixRotationQuaternion(XMQuaternionRotationRollPitchYaw(0.4f, 0.7f, 0.1f));
+	XMFLOAT4X4 worlds[2];
+	XMStoreFloat4x4(&worlds[0], XMMatrixScaling(2.0f, 2.0f, 2.0f) * rotation * XMMatrixTranslation(1.0f, -0.5f, 3.0f));
+	XMStoreFloat4x4(&worlds[1], XMMatrixScaling(3.0f, 1.0f, 1.5f) * rotation * XMMatrixTranslation(1.0f, -0.5f, 3.0f));
+
+	MeshletCullStats stats = {};
+	unsigned int conesChecked = 0;
+	std::vector<MeshletRange> ranges;
+	std::vector<unsigned char> drawn(indices.size() / 3);
+	for (unsigned int w = 0; w < 2; w++)
+	{
+		XMMATRIX world = XMLoadFloat4x4(&worlds[w]);
+		XMVECTOR determinant;
+		XMMATRIX inverseWorld = XMMatrixInverse(&determinant, world);
+		for (unsigned int c = 0; c < CameraCount; c++)
+		{
+			// Mostly outside, looking roughly at the sphere; every tenth one inside it
+			float distance = c % 10 == 0 ? RandomRange(0.0f, 0.8f) : RandomRange(3.0f, 12.0f);
+			XMVECTOR direction = XMVector3Normalize(XMVectorSet(RandomRange(-1, 1), RandomRange(-1, 1), RandomRange(-1, 1), 0));
+			XMVECTOR center = XMVector3TransformCoord(XMVectorZero(), world);
+			XMVECTOR camera = XMVectorAdd(center, XMVectorScale(direction, distance * (w == 0 ? 2.0f : 1.0f)));
+			XMVECTOR target = XMVectorAdd(center, XMVectorSet(RandomRange(-2, 2), RandomRange(-2, 2), RandomRange(-2, 2), 0));
+			XMFLOAT4X4 viewProjection;
+			XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(
+				XMMatrixLookToLH(camera, XMVectorSubtract(target, camera), XMVectorSet(0, 1, 0, 0)),
+				XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 100.0f)));
+			XMFLOAT3 cameraPosition;
+			XMStoreFloat3(&cameraPosition, camera);
+
+			// The cone test alone, in local space (where the cones are)
+			if (w == 0)
+			{
+				XMFLOAT3 localCamera;
+				XMStoreFloat3(&localCamera, XMVector3TransformCoord(camera, inverseWorld));
+				const float local[3] = { localCamera.x, localCamera.y, localCamera.z };
+				XMVECTOR localCameraVector = XMLoadFloat3(&localCamera);
+				for (size_t m = 0; m < meshlets.size(); m++)
+				{
+					if (!IsMeshletBackFacing(meshlets[m], local))
+						continue;
+					conesChecked++;
+					for (unsigned int i = meshlets[m].firstIndex; i < meshlets[m].firstIndex + meshlets[m].indexCount; i += 3)
+					{
+						Check(!FacesCamera(GetPosition(vertices, indices[i], XMMatrixIdentity()),
+							GetPosition(vertices, indices[i + 1], XMMatrixIdentity()),
+							GetPosition(vertices, indices[i + 2], XMMatrixIdentity()), localCameraVector),
+							"IsMeshletBackFacing only rejects meshlets facing away");
+					}
+				}
+			}
+
+			// The whole cull, in world space: anything left out must face away or be off screen
+			mesh.CullMeshlets(worlds[w], viewProjection, cameraPosition, ranges, &stats);
+			std::fill(drawn.begin(), drawn.end(), 0);
+			for (size_t r = 0; r < ranges.size(); r++)
+			{
+				for (unsigned int i = ranges[r].firstIndex; i < ranges[r].firstIndex + ranges[r].indexCount; i += 3)
+					drawn[i / 3] = 1;
+			}
+
+			Frustum frustum(viewProjection);
+			for (size_t t = 0; t < drawn.size(); t++)
+			{
+				if (drawn[t])
+					continue;
+				XMVECTOR p0 = GetPosition(vertices, indices[t * 3], world);
+				XMVECTOR p1 = GetPosition(vertices, indices[t * 3 + 1], world);
+				XMVECTOR p2 = GetPosition(vertices, indices[t * 3 + 2], world);
+				bool offScreen = false;
+				for (int p = 0; p < 6 && !offScreen; p++)
+				{
+					XMFLOAT4 plane = frustum.GetPlane(p);
+					offScreen = OutsidePlane(p0, plane) && OutsidePlane(p1, plane) && OutsidePlane(p2, plane);
+				}
+				Check(offScreen || !FacesCamera(p0, p1, p2, camera), "CullMeshlets keeps every visible triangle");
+			}
+		}
+	}
+
+	printf("%zu meshlets, %u cameras: %u visible, %u outside, %u facing away (%u cone rejections checked)\n",
+		meshlets.size(), CameraCount * 2, stats.visible, stats.frustumCulled, stats.backFacing, conesChecked);
+	Check(stats.backFacing > 0 && stats.frustumCulled > 0, "both tests cull something");
+	printf("%s\n", passed ? "ok" : "FAILED");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,283 @@
+// Rasterizes known triangles with SoftwareRasterizer and checks exact
+// pixels: triangles sharing edges cover every pixel once (top-left
+// rule), the LESS depth test, near-plane clipping, that the image doesn't
+// depend on the thread count, and WritePPM's output.  Returns non-zero
+// on any failure.
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "SoftwareRasterizer.h"
+
+// Across two tiles each way, with a partial tile at the edges
+static const unsigned int Width = 100;
+static const unsigned int Height = 80;
+
+static const float Black[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+static bool passed = true;
+
+static void Check(bool condition, const char* name, const char* what)
+{
+	if (!condition)
+	{
+		printf("FAILED: %s: %s\n", name, what);
+		passed = false;
+	}
+}
+
+// A vertex at a screen position (pixels, y down) with w = 1, so depth is z as given
+static RasterVertex ScreenVertex(float x, float y, float z, unsigned int color)
+{
+	RasterVertex v =
+	{
+		x / Width * 2.0f - 1.0f, 1.0f - y / Height * 2.0f, z, 1.0f,
+		(float)(color & 0xFF) / 255.0f, (float)((color >> 8) & 0xFF) / 255.0f,
+		(float)((color >> 16) & 0xFF) / 255.0f, (float)(color >> 24) / 255.0f
+	};
+	return v;
+}
+
+static unsigned int GetPixel(SoftwareRasterizer& rasterizer, unsigned int x, unsigned int y)
+{
+	return rasterizer.GetColorBuffer()[y * rasterizer.GetPitch() + x];
+}
+
+// Which side of the edge a to b a point is on (positive = inside a clockwise triangle)
+static double EdgeSide(double ax, double ay, double bx, double by, double px, double py)
+{
+	return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+}
+
+// --------------------------------------------------------
+// A fan of triangles round a center point, with corners on
+// the 1/16 pixel grid (so snapping doesn't move them) and
+// some edges through pixel centers.  Each triangle is drawn
+// on its own, and every pixel must be drawn by exactly one
+// of them if its center is inside the fan, by none if it's
+// outside (pixels on the fan's outline could go either way)
+// --------------------------------------------------------
+static void TestSharedEdges(unsigned int threadCount, std::vector<unsigned int>& fanImage)
+{
+	const char* name = "Shared edges";
+	const double centerX = 50.5, centerY = 40.5;
+	const double ring[][2] =
+	{
+		{ 50.5, 4.5 }, { 80.0625, 12.25 }, { 95.5, 40.5 }, { 79.5, 70.5 },
+		{ 50.5, 76.8125 }, { 20.5, 69.5 }, { 6.25, 40.5 }, { 19.5, 11.5 }
+	};
+	const unsigned int ringCount = sizeof(ring) / sizeof(ring[0]);
+	const unsigned int white = 0xFFFFFFFF;
+
+	SoftwareRasterizer rasterizer(threadCount);
+	rasterizer.Resize(Width, Height);
+	std::vector<unsigned int> coverage(Width * Height, 0);
+	for (unsigned int t = 0; t < ringCount; t++)
+	{
+		const double* a = ring[t];
+		const double* b = ring[(t + 1) % ringCount];
+		rasterizer.Clear(Black, 1.0f);
+		rasterizer.SubmitTriangle(
+			ScreenVertex((float)centerX, (float)centerY, 0.5f, white),
+			ScreenVertex((float)a[0], (float)a[1], 0.5f, white),
+			ScreenVertex((float)b[0], (float)b[1], 0.5f, white));
+		rasterizer.Flush();
+		for (unsigned int y = 0; y < Height; y++)
+		{
+			for (unsigned int x = 0; x < Width; x++)
+			{
+				unsigned int pixel = GetPixel(rasterizer, x, y);
+				Check(pixel == 0 || pixel == white, name, "flat color is exact");
+				if (pixel == white)
+					coverage[y * Width + x]++;
+			}
+		}
+	}
+
+	// The fan's outline, then each pixel center against it
+	unsigned int inside = 0;
+	for (unsigned int y = 0; y < Height; y++)
+	{
+		for (unsigned int x = 0; x < Width; x++)
+		{
+			double px = x + 0.5, py = y + 0.5;
+			double nearest = 1.0;
+			for (unsigned int t = 0; t < ringCount; t++)
+			{
+				const double* a = ring[t];
+				const double* b = ring[(t + 1) % ringCount];
+				nearest = std::fmin(nearest, EdgeSide(a[0], a[1], b[0], b[1], px, py));
+			}
+			unsigned int count = coverage[y * Width + x];
+			Check(count <= 1, name, "no pixel drawn twice");
+			if (nearest > 0)
+			{
+				Check(count == 1, name, "no pixel inside dropped");
+				inside++;
+			}
+			else if (nearest < 0)
+				Check(count == 0, name, "nothing drawn outside");
+		}
+	}
+	Check(inside > 4000, name, "the fan covers most of the screen");
+
+	// Drawn together (same depth), the fan should look the same as the union
+	rasterizer.Clear(Black, 1.0f);
+	for (unsigned int t = 0; t < ringCount; t++)
+	{
+		const double* a = ring[t];
+		const double* b = ring[(t + 1) % ringCount];
+		rasterizer.SubmitTriangle(
+			ScreenVertex((float)centerX, (float)centerY, 0.5f, white),
+			ScreenVertex((float)a[0], (float)a[1], 0.5f, white),
+			ScreenVertex((float)b[0], (float)b[1], 0.5f, white));
+	}
+	rasterizer.Flush();
+	fanImage.resize(Width * Height);
+	for (unsigned int y = 0; y < Height; y++)
+	{
+		for (unsigned int x = 0; x < Width; x++)
+		{
+			fanImage[y * Width + x] = GetPixel(rasterizer, x, y);
+			Check((fanImage[y * Width + x] == white) == (coverage[y * Width + x] == 1), name, "fan drawn at once matches");
+		}
+	}
+	printf("%-28s %u threads, %u pixels inside\n", name, rasterizer.GetThreadCount(), inside);
+}
+
+// --------------------------------------------------------
+// Screen-covering triangles at different depths: only ones
+// strictly nearer than what's there get through
+// --------------------------------------------------------
+static void TestDepth()
+{
+	const char* name = "Depth test";
+	const unsigned int red = 0xFF0000FF, green = 0xFF00FF00, blue = 0xFFFF0000, white = 0xFFFFFFFF;
+	SoftwareRasterizer rasterizer(1);
+	rasterizer.Resize(Width, Height);
+	rasterizer.Clear(Black, 1.0f);
+
+	const float depths[] = { 0.5f, 0.5f, 0.25f, 0.75f, 0.25f };
+	const unsigned int colors[] = { red, green, blue, white, green };
+	for (int i = 0; i < 5; i++)
+	{
+		rasterizer.SubmitTriangle(
+			ScreenVertex(0.0f, 0.0f, depths[i], colors[i]),
+			ScreenVertex(2.0f * Width, 0.0f, depths[i], colors[i]),
+			ScreenVertex(0.0f, 2.0f * Height, depths[i], colors[i]));
+	}
+	rasterizer.Flush();
+
+	bool allBlue = true;
+	bool allDepth = true;
+	for (unsigned int y = 0; y < Height; y++)
+	{
+		for (unsigned int x = 0; x < Width; x++)
+		{
+			allBlue &= GetPixel(rasterizer, x, y) == blue;
+			allDepth &= rasterizer.GetDepthBuffer()[y * rasterizer.GetPitch() + x] == 0.25f;
+		}
+	}
+	Check(allBlue, name, "equal and farther depths fail, nearer passes");
+	Check(allDepth, name, "depth buffer holds the nearest");
+	Check(rasterizer.GetStats().pixelsWritten == 2ull * Width * Height, name, "two passing layers counted");
+	printf("%-28s %s\n", name, passed ? "ok" : "FAILED");
+}
+
+// --------------------------------------------------------
+// A screen-covering triangle whose depth runs from -0.5 on
+// the left edge to 0.5 on the right (z = x / 2 in clip
+// space): the left half is behind the near plane
+// --------------------------------------------------------
+static void TestNearClip()
+{
+	const char* name = "Near-plane clipping";
+	const unsigned int red = 0xFF0000FF;
+	SoftwareRasterizer rasterizer(1);
+	rasterizer.Resize(Width, Height);
+	rasterizer.Clear(Black, 1.0f);
+
+	RasterVertex v0 = { -1.0f, 1.0f, -0.5f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f };
+	RasterVertex v1 = { 3.0f, 1.0f, 1.5f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f };
+	RasterVertex v2 = { -1.0f, -3.0f, -0.5f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f };
+	rasterizer.SubmitTriangle(v0, v1, v2);
+
+	// Entirely behind the near plane - nothing at all
+	RasterVertex behind[3] = { v0, v1, v2 };
+	for (int i = 0; i < 3; i++)
+		behind[i].z = -0.1f;
+	rasterizer.SubmitTriangle(behind[0], behind[1], behind[2]);
+	rasterizer.Flush();
+
+	for (unsigned int y = 0; y < Height; y++)
+	{
+		for (unsigned int x = 0; x < Width; x++)
+		{
+			float clipX = (x + 0.5f) / Width * 2.0f - 1.0f;
+			float depth = rasterizer.GetDepthBuffer()[y * rasterizer.GetPitch() + x];
+			if (clipX < 0)
+				Check(GetPixel(rasterizer, x, y) == 0 && depth == 1.0f, name, "nothing drawn behind the near plane");
+			else
+			{
+				Check(GetPixel(rasterizer, x, y) == red, name, "everything drawn in front of it");
+				Check(std::fabs(depth - clipX * 0.5f) < 1e-5f, name, "depth interpolated across the clipped triangle");
+			}
+		}
+	}
+	Check(rasterizer.GetStats().trianglesSubmitted == 2, name, "both submitted");
+	printf("%-28s %llu triangles drawn of 2\n", name, rasterizer.GetStats().trianglesDrawn);
+}
+
+// --------------------------------------------------------
+// A binary PPM: "P6", size, 255, then RGB rows top to bottom
+// --------------------------------------------------------
+static void TestWritePPM()
+{
+	const char* name = "WritePPM";
+	const char* path = "SoftwareRasterizerTests.ppm";
+	const float clearColor[4] = { 1.0f, 0.5f, 0.0f, 1.0f };
+	SoftwareRasterizer rasterizer(1);
+	rasterizer.Resize(4, 3);
+	rasterizer.Clear(clearColor, 1.0f);
+	// Covers the top-left pixel's center only
+	RasterVertex v0 = { -1.0f, 1.0f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f };
+	RasterVertex v1 = { -0.25f, 1.0f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f };
+	RasterVertex v2 = { -1.0f, 0.25f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f };
+	rasterizer.SubmitTriangle(v0, v1, v2);
+	rasterizer.Flush();
+	Check(rasterizer.WritePPM(path), name, "written");
+
+	std::ifstream file(path, std::ios::binary);
+	std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+	remove(path);
+
+	std::string header = "P6\n4 3\n255\n";
+	Check(contents.size() == header.size() + 4 * 3 * 3, name, "size");
+	Check(contents.compare(0, header.size(), header) == 0, name, "header");
+	if (contents.size() == header.size() + 4 * 3 * 3)
+	{
+		const unsigned char* pixels = (const unsigned char*)contents.data() + header.size();
+		Check(pixels[0] == 0 && pixels[1] == 0 && pixels[2] == 255, name, "drawn pixel");
+		for (unsigned int i = 1; i < 12; i++)
+			Check(pixels[i * 3] == 255 && pixels[i * 3 + 1] == 128 && pixels[i * 3 + 2] == 0, name, "cleared pixels");
+	}
+	printf("%-28s %s\n", name, passed ? "ok" : "FAILED");
+}
+
+int main()
+{
+	std::vector<unsigned int> oneThread, threeThreads;
+	TestSharedEdges(1, oneThread);
+	TestSharedEdges(3, threeThreads);
+	Check(oneThread == threeThreads, "Threads", "the same image whatever the thread count");
+	TestDepth();
+	TestNearClip();
+	TestWritePPM();
+
+	printf("%s\n", passed ? "ok" : "FAILED");
+	return passed ? 0 : 1;
+}
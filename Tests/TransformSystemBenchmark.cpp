@@ -0,0 +1,101 @@
+// Times TransformSystem's batched world matrix update against calling
+// Transform::UpdateMatricies() on the same transforms one at a time,
+// with every transform moving each frame and with one in ten moving.
+// Returns non-zero if the two disagree on any world matrix, or the system
+// reports rebuilding any transform that didn't move.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "Transform.h"
+#include "TransformSystem.h"
+
+using namespace DirectX;
+
+static const unsigned int TransformCount = 100000;
+static const unsigned int Frames = 50;
+static const float MaxError = 1e-4f;
+
+// --------------------------------------------------------
+// Moves every stride'th transform in both versions, rebuilds
+// their matrices Frames times, and prints the per-frame cost
+// of each.  Returns the largest difference between the two
+// sets of world matrices afterwards
+// --------------------------------------------------------
+static float Run(std::vector<Transform>& transforms, TransformSystem& system,
+	const std::vector<TransformSystem::Handle>& handles, unsigned int stride)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned int frame = 0; frame < Frames; frame++)
+	{
+		for (unsigned int i = 0; i < TransformCount; i += stride)
+		{
+			transforms[i].SetPosition((float)i, (float)frame, 0.0f);
+			transforms[i].UpdateMatricies();
+		}
+	}
+	auto middle = std::chrono::steady_clock::now();
+	for (unsigned int frame = 0; frame < Frames; frame++)
+	{
+		for (unsigned int i = 0; i < TransformCount; i += stride)
+			system.SetPosition(handles[i], (float)i, (float)frame, 0.0f);
+		system.UpdateWorldMatrices();
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	double oneByOne = std::chrono::duration<double, std::milli>(middle - start).count() / Frames;
+	double batched = std::chrono::duration<double, std::milli>(end - middle).count() / Frames;
+	printf("%6u of %u moving: Transform %.3f ms/frame, TransformSystem %.3f ms/frame (%.2fx)\n",
+		(TransformCount + stride - 1) / stride, TransformCount, oneByOne, batched, oneByOne / batched);
+
+	float maxError = 0.0f;
+	for (unsigned int i = 0; i < TransformCount; i++)
+	{
+		XMFLOAT4X4 a = transforms[i].GetWorldMatrix();
+		XMFLOAT4X4 b = system.GetWorldMatrix(handles[i]);
+		for (int row = 0; row < 4; row++)
+		{
+			for (int column = 0; column < 4; column++)
+				maxError = fmaxf(maxError, fabsf(a.m[row][column] - b.m[row][column]));
+		}
+	}
+	return maxError;
+}
+
+int main()
+{
+	// The same spread of rotations and (non-uniform) scales in both
+	std::vector<Transform> transforms(TransformCount);
+	TransformSystem system(TransformCount);
+	std::vector<TransformSystem::Handle> handles(TransformCount);
+	for (unsigned int i = 0; i < TransformCount; i++)
+	{
+		float a = i * 0.001f;
+		handles[i] = system.Create();
+		transforms[i].SetRotation(a, a * 0.5f, -a);
+		transforms[i].SetScale(1.0f + a, 2.0f - a, 0.5f + a);
+		system.SetRotation(handles[i], a, a * 0.5f, -a);
+		system.SetScale(handles[i], 1.0f + a, 2.0f - a, 0.5f + a);
+	}
+
+	bool passed = true;
+	unsigned int strides[] = { 1, 10 };
+	for (unsigned int stride : strides)
+	{
+		float error = Run(transforms, system, handles, stride);
+		if (error > MaxError)
+		{
+			printf("World matrices differ by %g\n", error);
+			passed = false;
+		}
+		// Only the last frame's movers count, each exactly once
+		size_t moving = (TransformCount + stride - 1) / stride;
+		const std::vector<TransformSystem::Handle>& updated = system.GetUpdatedHandles();
+		if (updated.size() != moving)
+		{
+			printf("%zu transforms reported updated, not %zu\n", updated.size(), moving);
+			passed = false;
+		}
+	}
+	return passed ? 0 : 1;
+}
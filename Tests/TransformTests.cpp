@@ -0,0 +1,125 @@
+// Checks Transform's closed-form normal matrix against the general
+// inverse-transpose, then times the two.  CPU only - no device needed.
+// Returns non-zero if any case is off by more than MaxError.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <DirectXMath.h>
+#include "Transform.h"
+
+using namespace DirectX;
+
+// Largest allowed distance between the unit normals the two matrices give
+static const float MaxError = 1e-5f;
+static const int TimingIterations = 1000000;
+
+// --------------------------------------------------------
+// Transforms a spread of directions by the transform's normal
+// matrix and by transpose(inverse(world)), and returns the
+// largest distance between the normalized results (the
+// closed form is only right up to a scale factor)
+// --------------------------------------------------------
+static float NormalError(Transform& transform)
+{
+	XMFLOAT4X4 world = transform.GetWorldMatrix();
+	XMFLOAT4X4 normalMatrix = transform.GetWorldInverseTransposeMatrix();
+	XMMATRIX closedForm = XMLoadFloat4x4(&normalMatrix);
+	XMMATRIX reference = XMMatrixTranspose(XMMatrixInverse(0, XMLoadFloat4x4(&world)));
+
+	float maxError = 0.0f;
+	for (int i = 0; i < 32; i++)
+	{
+		XMVECTOR normal = XMVector3Normalize(XMVectorSet(
+			sinf(i * 1.0f), cosf(i * 1.3f), sinf(i * 0.7f) + 0.2f, 0.0f));
+		XMVECTOR a = XMVector3Normalize(XMVector3TransformNormal(normal, closedForm));
+		XMVECTOR b = XMVector3Normalize(XMVector3TransformNormal(normal, reference));
+		maxError = fmaxf(maxError, XMVectorGetX(XMVector3Length(XMVectorSubtract(a, b))));
+	}
+	return maxError;
+}
+
+static bool Check(const char* name, Transform& transform)
+{
+	float error = NormalError(transform);
+	bool passed = error <= MaxError;
+	printf("%-28s max error %g  %s\n", name, error, passed ? "ok" : "FAILED");
+	return passed;
+}
+
+// --------------------------------------------------------
+// Times rebuilding the matrices through Transform against
+// building the world matrix the same way and inverting it
+// --------------------------------------------------------
+static void Time()
+{
+	Transform transform;
+	transform.SetScale(2.0f, 0.5f, 3.0f);
+	transform.SetRotation(0.4f, 0.2f, 0.1f);
+
+	float sink = 0.0f;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < TimingIterations; i++)
+	{
+		transform.SetPosition((float)i, 0.0f, 0.0f);
+		sink += transform.GetWorldInverseTransposeMatrix()._11;
+	}
+	auto middle = std::chrono::steady_clock::now();
+	XMVECTOR rotation = XMQuaternionRotationRollPitchYaw(0.4f, 0.2f, 0.1f);
+	for (int i = 0; i < TimingIterations; i++)
+	{
+		XMMATRIX world = XMMatrixScaling(2.0f, 0.5f, 3.0f) *
+			XMMatrixRotationQuaternion(rotation) *
+			XMMatrixTranslation((float)i, 0.0f, 0.0f);
+		XMFLOAT4X4 normalMatrix;
+		XMStoreFloat4x4(&normalMatrix, XMMatrixTranspose(XMMatrixInverse(0, world)));
+		sink += normalMatrix._11;
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	double closedForm = std::chrono::duration<double, std::nano>(middle - start).count() / TimingIterations;
+	double inverse = std::chrono::duration<double, std::nano>(end - middle).count() / TimingIterations;
+	printf("Closed form: %.1f ns per transform, with inverse: %.1f ns (%g)\n", closedForm, inverse, sink);
+}
+
+int main()
+{
+	bool passed = true;
+
+	Transform uniform;
+	uniform.SetScale(1.5f, 1.5f, 1.5f);
+	uniform.SetRotation(-0.3f, 0.9f, 0.2f);
+	uniform.SetPosition(4.0f, 0.0f, 1.0f);
+	passed &= Check("Uniform scale", uniform);
+
+	Transform nonUniform;
+	nonUniform.SetScale(2.0f, 0.5f, 3.0f);
+	nonUniform.SetRotation(0.4f, 0.2f, 0.1f);
+	nonUniform.SetPosition(1.0f, 2.0f, 3.0f);
+	passed &= Check("Non-uniform scale", nonUniform);
+
+	// A uniformly scaled child of a non-uniformly scaled parent,
+	// and a non-uniform grandchild under both
+	Transform parent;
+	parent.SetScale(2.0f, 0.5f, 3.0f);
+	parent.SetRotation(0.4f, 0.2f, 0.1f);
+	parent.SetPosition(1.0f, 2.0f, 3.0f);
+	Transform child;
+	child.SetParent(&parent);
+	child.SetScale(1.5f, 1.5f, 1.5f);
+	child.SetRotation(-0.3f, 0.9f, 0.2f);
+	child.SetPosition(4.0f, 0.0f, 1.0f);
+	Transform grandchild;
+	grandchild.SetParent(&child);
+	grandchild.SetScale(0.25f, 4.0f, 1.0f);
+	grandchild.SetRotation(1.1f, -0.6f, 0.8f);
+	grandchild.SetPosition(-2.0f, 1.0f, 0.5f);
+	passed &= Check("Parented", child);
+	passed &= Check("Parented, two levels", grandchild);
+
+	// Moving the parent has to reach the children's normal matrices
+	parent.SetScale(0.3f, 2.5f, 1.0f);
+	passed &= Check("Parented, after parent moved", grandchild);
+
+	Time();
+	return passed ? 0 : 1;
+}
@@ -1,5 +1,10 @@
 #include "Transform.h"
+#include <algorithm>
 using namespace DirectX;
+
+unsigned int Transform::matricesRebuilt = 0;
+unsigned int Transform::matricesReused = 0;
+
 Transform::Transform()
 {
     this->worldMatrix = DirectX::XMFLOAT4X4(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
@@ -10,6 +15,9 @@ Transform::Transform()
     this->forward = DirectX::XMFLOAT3(0, 0, 1);
     this->up = DirectX::XMFLOAT3(0, 1, 0);
     this->right = DirectX::XMFLOAT3(1, 0, 0);
+    this->basisDirty = false;
+    this->matricesDirty = false;
+    this->parent = 0;
 }
 
 Transform::Transform(DirectX::XMFLOAT4X4 world, DirectX::XMFLOAT4X4 worldInverseTranspose, DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 scale, DirectX::XMFLOAT4 rotaion)
@@ -19,67 +27,124 @@ Transform::Transform(DirectX::XMFLOAT4X4 world, DirectX::XMFLOAT4X4 worldInverse
     this->position = position;
     this->scale = scale;
     this->rotation = rotaion;
+    // the passed in matrices aren't guaranteed to match the TRS values
+    this->matricesDirty = true;
+    this->parent = 0;
     this->forward = DirectX::XMFLOAT3(0, 0, 1);
     this->up = DirectX::XMFLOAT3(0, 1, 0);
     this->right = DirectX::XMFLOAT3(1, 0, 0);
-     XMVECTOR forwardRot = DirectX::XMVector3Rotate(XMLoadFloat3(&forward),
-        DirectX::XMLoadFloat4(&rotation));
-     XMVECTOR upRot = DirectX::XMVector3Rotate(XMLoadFloat3(&up),
-         DirectX::XMLoadFloat4(&rotation));
-     XMVECTOR rightRot = DirectX::XMVector3Rotate(XMLoadFloat3(&right),
-         DirectX::XMLoadFloat4(&rotation));
-    XMStoreFloat3(&forward, forwardRot);
-    XMStoreFloat3(&up, upRot);
-    XMStoreFloat3(&right, rightRot);
+    this->basisDirty = true;
+}
+
+// --------------------------------------------------------
+// Takes over another transform's values and its place in the
+// hierarchy, so transforms can live in storage that moves its
+// elements around (like the entity store's chunks).  The
+// moved-from transform is left detached with no children.
+// --------------------------------------------------------
+Transform::Transform(Transform&& other)
+{
+    this->parent = 0;
+    TakeOver(other);
+}
+
+Transform& Transform::operator=(Transform&& other)
+{
+    if (this != &other)
+    {
+        Detach();
+        TakeOver(other);
+    }
+    return *this;
+}
+
+// --------------------------------------------------------
+// Unhooks this transform from the hierarchy.  Children become
+// roots, so their local transform is now their world transform.
+// --------------------------------------------------------
+Transform::~Transform()
+{
+    Detach();
+}
+
+void Transform::Detach()
+{
+    SetParent(0);
+    for (Transform* child : children)
+    {
+        child->parent = 0;
+        child->MarkDirty();
+    }
+    children.clear();
+}
+
+// --------------------------------------------------------
+// Copies everything out of other and points its parent and
+// children at this transform instead.  Expects this one to
+// already be detached.
+// --------------------------------------------------------
+void Transform::TakeOver(Transform& other)
+{
+    worldMatrix = other.worldMatrix;
+    worldInverseTranspose = other.worldInverseTranspose;
+    position = other.position;
+    scale = other.scale;
+    rotation = other.rotation;
+    up = other.up;
+    right = other.right;
+    forward = other.forward;
+    matricesDirty = other.matricesDirty;
+    basisDirty = other.basisDirty;
+
+    parent = other.parent;
+    if (parent != 0)
+        std::replace(parent->children.begin(), parent->children.end(), &other, this);
+
+    children = std::move(other.children);
+    for (Transform* child : children)
+        child->parent = this;
+
+    other.parent = 0;
+    other.children.clear();
 }
 
 void Transform::SetPosition(float x, float y, float z)
 {
     position = DirectX::XMFLOAT3(x, y, z);
+    MarkDirty();
 }
 
 void Transform::SetPosition(DirectX::XMFLOAT3 xyz)
 {
     position = xyz;
+    MarkDirty();
 }
 
 void Transform::SetRotation(float pitch, float yaw, float roll)
 {
     DirectX::XMVECTOR quat = DirectX::XMQuaternionRotationRollPitchYaw(pitch, yaw, roll);
     XMStoreFloat4(&rotation, quat);
-    XMVECTOR forwardRot = DirectX::XMVector3Rotate(XMLoadFloat3(&forward),
-        DirectX::XMLoadFloat4(&rotation));
-    XMVECTOR upRot = DirectX::XMVector3Rotate(XMLoadFloat3(&up),
-        DirectX::XMLoadFloat4(&rotation));
-    XMVECTOR rightRot = DirectX::XMVector3Rotate(XMLoadFloat3(&right),
-        DirectX::XMLoadFloat4(&rotation));
-    XMStoreFloat3(&forward, forwardRot);
-    XMStoreFloat3(&up, upRot);
-    XMStoreFloat3(&right, rightRot);
+    basisDirty = true;
+    MarkDirty();
 }
 
 void Transform::SetRotation(DirectX::XMFLOAT4 quaternion)
 {
     rotation = quaternion;
-    XMVECTOR forwardRot = DirectX::XMVector3Rotate(XMLoadFloat3(&forward),
-        DirectX::XMLoadFloat4(&rotation));
-    XMVECTOR upRot = DirectX::XMVector3Rotate(XMLoadFloat3(&up),
-        DirectX::XMLoadFloat4(&rotation));
-    XMVECTOR rightRot = DirectX::XMVector3Rotate(XMLoadFloat3(&right),
-        DirectX::XMLoadFloat4(&rotation));
-    XMStoreFloat3(&forward, forwardRot);
-    XMStoreFloat3(&up, upRot);
-    XMStoreFloat3(&right, rightRot);
+    basisDirty = true;
+    MarkDirty();
 }
 
 void Transform::SetScale(float x, float y, float z)
 {
     scale = DirectX::XMFLOAT3(x, y, z);
+    MarkDirty();
 }
 
 void Transform::SetScale(DirectX::XMFLOAT3 xyz)
 {
     scale = xyz;
+    MarkDirty();
 }
 
 DirectX::XMFLOAT3 Transform::GetPosition()
@@ -100,36 +165,117 @@ DirectX::XMFLOAT3 Transform::GetScale()
 
 DirectX::XMFLOAT4X4 Transform::GetWorldMatrix()
 {
-    UpdateMatricies();
+    if (matricesDirty)
+        UpdateMatricies();
+    else
+        matricesReused++;
     return worldMatrix;
 }
 
 DirectX::XMFLOAT4X4 Transform::GetWorldInverseTransposeMatrix()
 {
-    UpdateMatricies();
+    if (matricesDirty)
+        UpdateMatricies();
+    else
+        matricesReused++;
     return worldInverseTranspose;
 }
 
 DirectX::XMFLOAT3 Transform::GetRight()
 {
+    if (basisDirty)
+        UpdateBasis();
     return right;
 }
 
 DirectX::XMFLOAT3 Transform::GetUp()
 {
+    if (basisDirty)
+        UpdateBasis();
     return up;
 }
 
 DirectX::XMFLOAT3 Transform::GetForward()
 {
+    if (basisDirty)
+        UpdateBasis();
     return forward;
 }
 
+// --------------------------------------------------------
+// Fills the basis vectors of many transforms at once.  Any of
+// the output arrays can be null if those vectors aren't needed.
+// --------------------------------------------------------
+void Transform::GetBasisVectors(Transform* const* transforms, size_t count,
+    DirectX::XMFLOAT3* rights, DirectX::XMFLOAT3* ups, DirectX::XMFLOAT3* forwards)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        Transform* t = transforms[i];
+        if (t->basisDirty)
+            t->UpdateBasis();
+
+        if (rights) rights[i] = t->right;
+        if (ups) ups[i] = t->up;
+        if (forwards) forwards[i] = t->forward;
+    }
+}
+
+bool Transform::IsDirty()
+{
+    return matricesDirty;
+}
+
+// --------------------------------------------------------
+// Attaches this transform under another one (or detaches it
+// when given null).  Refuses to create a cycle.
+// --------------------------------------------------------
+bool Transform::SetParent(Transform* newParent)
+{
+    for (Transform* t = newParent; t != 0; t = t->parent)
+    {
+        if (t == this)
+            return false;
+    }
+
+    if (parent == newParent)
+        return true;
+
+    if (parent != 0)
+    {
+        std::vector<Transform*>& siblings = parent->children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), this));
+    }
+
+    parent = newParent;
+    if (parent != 0)
+        parent->children.push_back(this);
+
+    MarkDirty();
+    return true;
+}
+
+Transform* Transform::GetParent()
+{
+    return parent;
+}
+
+unsigned int Transform::GetChildCount()
+{
+    return (unsigned int)children.size();
+}
+
+Transform* Transform::GetChild(unsigned int index)
+{
+    return children[index];
+}
+
 void Transform::MoveAbsolute(float x, float y, float z)
 {
     position.x += x;
     position.y += y;
     position.z += z;
+    MarkDirty();
 }
 
 void Transform::MoveRelative(float x, float y, float z)
@@ -140,6 +286,7 @@ void Transform::MoveRelative(float x, float y, float z)
 
     DirectX::XMVECTOR newPos = DirectX::XMLoadFloat3(&position) + rotatedVec;
     DirectX::XMStoreFloat3(&position, newPos);
+    MarkDirty();
 }
 
 void Transform::Rotate(DirectX::XMFLOAT4 quaternionRotation)
@@ -150,15 +297,8 @@ void Transform::Rotate(DirectX::XMFLOAT4 quaternionRotation)
 
     XMStoreFloat4(&rotation, rotationVect);
 
-    XMVECTOR forwardRot = DirectX::XMVector3Rotate(XMLoadFloat3(&forward),
-        DirectX::XMLoadFloat4(&rotation));
-    XMVECTOR upRot = DirectX::XMVector3Rotate(XMLoadFloat3(&up),
-        DirectX::XMLoadFloat4(&rotation));
-    XMVECTOR rightRot = DirectX::XMVector3Rotate(XMLoadFloat3(&right),
-        DirectX::XMLoadFloat4(&rotation));
-    XMStoreFloat3(&forward, forwardRot);
-    XMStoreFloat3(&up, upRot);
-    XMStoreFloat3(&right, rightRot);
+    basisDirty = true;
+    MarkDirty();
 }
 
 void Transform::Rotate(float pitch, float yaw, float roll)
@@ -169,15 +309,8 @@ void Transform::Rotate(float pitch, float yaw, float roll)
 
     XMStoreFloat4(&rotation, rotationVect);
 
-    XMVECTOR forwardRot = DirectX::XMVector3Rotate(XMLoadFloat3(&forward),
-        DirectX::XMLoadFloat4(&rotation));
-    XMVECTOR upRot = DirectX::XMVector3Rotate(XMLoadFloat3(&up),
-        DirectX::XMLoadFloat4(&rotation));
-    XMVECTOR rightRot = DirectX::XMVector3Rotate(XMLoadFloat3(&right),
-        DirectX::XMLoadFloat4(&rotation));
-    XMStoreFloat3(&forward, forwardRot);
-    XMStoreFloat3(&up, upRot);
-    XMStoreFloat3(&right, rightRot);
+    basisDirty = true;
+    MarkDirty();
 }
 
 void Transform::Scale(float x, float y, float z)
@@ -185,14 +318,92 @@ void Transform::Scale(float x, float y, float z)
     scale.x *= x;
     scale.y *= y;
     scale.z *= z;
+    MarkDirty();
+}
+
+// --------------------------------------------------------
+// Flags this transform and its whole subtree for a rebuild.
+// A dirty transform's children are always dirty too, so an
+// already dirty transform can stop the walk early.
+// --------------------------------------------------------
+void Transform::MarkDirty()
+{
+    if (matricesDirty)
+        return;
+
+    matricesDirty = true;
+    for (Transform* child : children)
+        child->MarkDirty();
+}
+
+// --------------------------------------------------------
+// The local axes rotated by the quaternion are exactly the
+// rows of its rotation matrix, so one quaternion-to-matrix
+// conversion replaces three separate vector rotations (and
+// always starts from the quaternion, so nothing drifts)
+// --------------------------------------------------------
+void Transform::UpdateBasis()
+{
+    float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+
+    right = DirectX::XMFLOAT3(1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w));
+    up = DirectX::XMFLOAT3(2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w));
+    forward = DirectX::XMFLOAT3(2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y));
+
+    basisDirty = false;
 }
 
+// --------------------------------------------------------
+// Rebuilds the world matrix and the normal (inverse-transpose)
+// matrix.  For world = S * R * T the upper 3x3 inverse-transpose
+// is just R with each row divided by that axis' scale, so no
+// general 4x4 inverse is needed.  With uniform scale that is R
+// times a constant, which normalizing the normal cancels out, so
+// R is used as-is.  The translation part of the normal matrix is
+// left at zero since normals are directions.
+// --------------------------------------------------------
 void Transform::UpdateMatricies()
 {
-    DirectX::XMMATRIX world = (Scaling() * RotationRollPitchYaw() * Translation());
+    DirectX::XMMATRIX rotationMatrix = RotationRollPitchYaw();
+    DirectX::XMMATRIX world = (Scaling() * rotationMatrix * Translation());
+
+    DirectX::XMMATRIX normalMatrix = rotationMatrix;
+    if (scale.x != scale.y || scale.y != scale.z)
+    {
+        normalMatrix.r[0] = DirectX::XMVectorScale(normalMatrix.r[0], 1.0f / scale.x);
+        normalMatrix.r[1] = DirectX::XMVectorScale(normalMatrix.r[1], 1.0f / scale.y);
+        normalMatrix.r[2] = DirectX::XMVectorScale(normalMatrix.r[2], 1.0f / scale.z);
+    }
+
+    // (local * parent)^-T = local^-T * parent^-T
+    if (parent != 0)
+    {
+        DirectX::XMFLOAT4X4 parentWorld = parent->GetWorldMatrix();
+        world = world * DirectX::XMLoadFloat4x4(&parentWorld);
+        normalMatrix = normalMatrix * DirectX::XMLoadFloat4x4(&parent->worldInverseTranspose);
+    }
 
     DirectX::XMStoreFloat4x4(&worldMatrix, world);
-    DirectX::XMStoreFloat4x4(&worldInverseTranspose, DirectX::XMMatrixTranspose(world));
+    DirectX::XMStoreFloat4x4(&worldInverseTranspose, normalMatrix);
+
+    matricesDirty = false;
+    matricesRebuilt++;
+}
+
+void Transform::ResetFrameStats()
+{
+    matricesRebuilt = 0;
+    matricesReused = 0;
+}
+
+unsigned int Transform::GetMatricesRebuilt()
+{
+    return matricesRebuilt;
+}
+
+unsigned int Transform::GetMatricesReused()
+{
+    return matricesReused;
 }
 
 DirectX::XMMATRIX Transform::Translation()
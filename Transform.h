@@ -1,11 +1,10 @@
 #pragma once
 #include <DirectXMath.h>
+#include <vector>
 
 class Transform
 {
 private:
-
-public:
 	//fields
 	DirectX::XMFLOAT4X4 worldMatrix;
 	DirectX::XMFLOAT4X4 worldInverseTranspose;
@@ -16,10 +15,37 @@ public:
 	DirectX::XMFLOAT3 right;
 	DirectX::XMFLOAT3 forward;
 
+	//set by every setter, cleared once the matrices are rebuilt
+	bool matricesDirty;
+
+	//right/up/forward are derived from the quaternion the next time they're read
+	bool basisDirty;
+
+	//hierarchy - world matrices are local * parent's world
+	Transform* parent;
+	std::vector<Transform*> children;
+
+	//hierarchy bookkeeping shared by the destructor and moves
+	void Detach();
+	void TakeOver(Transform& other);
+
+	//per-frame stats shared by every transform
+	static unsigned int matricesRebuilt;
+	static unsigned int matricesReused;
+
+public:
 	//constructors
 	Transform();
 	Transform(DirectX::XMFLOAT4X4 world, DirectX::XMFLOAT4X4 worldInverseTranspose, 
 		DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 scale, DirectX::XMFLOAT4 rotaion);
+	~Transform();
+
+	//children point back at their parent, so copies aren't allowed.
+	//Moves re-point the parent and children at the new transform
+	Transform(const Transform&) = delete;
+	Transform& operator=(const Transform&) = delete;
+	Transform(Transform&& other);
+	Transform& operator=(Transform&& other);
 
 	//different types of seters so different variable types can be used on the same functions
 	void SetPosition(float x, float y, float z);
@@ -39,6 +65,15 @@ public:
 	DirectX::XMFLOAT3 GetRight();
 	DirectX::XMFLOAT3 GetUp();
 	DirectX::XMFLOAT3 GetForward();
+	bool IsDirty();
+	static void GetBasisVectors(Transform* const* transforms, size_t count,
+		DirectX::XMFLOAT3* rights, DirectX::XMFLOAT3* ups, DirectX::XMFLOAT3* forwards);
+
+	//hierarchy
+	bool SetParent(Transform* newParent);
+	Transform* GetParent();
+	unsigned int GetChildCount();
+	Transform* GetChild(unsigned int index);
 
 	//functions
 	void MoveAbsolute(float x, float y, float z);
@@ -47,7 +82,14 @@ public:
 	void Rotate(float pitch, float yaw, float roll);
 	void Scale(float x, float y, float z);
 
+	//frame stats - how many matrix reads had to rebuild vs. used the cached copy
+	static void ResetFrameStats();
+	static unsigned int GetMatricesRebuilt();
+	static unsigned int GetMatricesReused();
+
 	//helpers 
+	void MarkDirty();
+	void UpdateBasis();
 	void UpdateMatricies();
 	DirectX::XMMATRIX Translation();
 	DirectX::XMMATRIX Scaling();
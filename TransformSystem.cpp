@@ -0,0 +1,599 @@
+#include "TransformSystem.h"
+#include <cstring>
+
+using namespace DirectX;
+
+const TransformSystem::Handle TransformSystem::InvalidHandle;
+
+TransformSystem::TransformSystem(size_t initialCapacity)
+{
+    count = 0;
+    matricesRebuilt = 0;
+    linkCount = 0;
+    hierarchyDirty = false;
+
+    positionX.reserve(initialCapacity); positionY.reserve(initialCapacity); positionZ.reserve(initialCapacity);
+    rotationX.reserve(initialCapacity); rotationY.reserve(initialCapacity); rotationZ.reserve(initialCapacity); rotationW.reserve(initialCapacity);
+    scaleX.reserve(initialCapacity); scaleY.reserve(initialCapacity); scaleZ.reserve(initialCapacity);
+    dirty.reserve(initialCapacity);
+    localMatrices.reserve(initialCapacity);
+    worldMatrices.reserve(initialCapacity);
+    parentHandle.reserve(initialCapacity);
+    parentIndex.reserve(initialCapacity);
+    childCount.reserve(initialCapacity);
+    indexToHandle.reserve(initialCapacity);
+    handleToIndex.reserve(initialCapacity);
+}
+
+// --------------------------------------------------------
+// Adds an identity transform to the end of the dense arrays
+// and hands back a handle to it (recycling old handles first)
+// --------------------------------------------------------
+TransformSystem::Handle TransformSystem::Create()
+{
+    Handle handle;
+    if (!freeHandles.empty())
+    {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    }
+    else
+    {
+        handle = (Handle)handleToIndex.size();
+        handleToIndex.push_back(0);
+    }
+
+    size_t index = count++;
+    handleToIndex[handle] = (unsigned int)index;
+    indexToHandle.push_back(handle);
+
+    positionX.push_back(0); positionY.push_back(0); positionZ.push_back(0);
+    rotationX.push_back(0); rotationY.push_back(0); rotationZ.push_back(0); rotationW.push_back(1);
+    scaleX.push_back(1); scaleY.push_back(1); scaleZ.push_back(1);
+    dirty.push_back(1);
+    localMatrices.push_back(XMFLOAT4X4(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1));
+    worldMatrices.push_back(XMFLOAT4X4(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1));
+    parentHandle.push_back(InvalidHandle);
+    parentIndex.push_back(InvalidHandle);
+    childCount.push_back(0);
+
+    return handle;
+}
+
+// --------------------------------------------------------
+// Removes a transform by moving the last one into its slot,
+// so the arrays stay densely packed.  Any children are
+// detached and keep their local transform as their world.
+// --------------------------------------------------------
+void TransformSystem::Destroy(Handle handle)
+{
+    if (!IsValid(handle))
+        return;
+
+    size_t index = handleToIndex[handle];
+    if (childCount[index] > 0)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (parentHandle[i] == handle)
+                SetParent(indexToHandle[i], InvalidHandle);
+        }
+    }
+    SetParent(handle, InvalidHandle);
+
+    size_t last = count - 1;
+    if (index != last)
+    {
+        positionX[index] = positionX[last]; positionY[index] = positionY[last]; positionZ[index] = positionZ[last];
+        rotationX[index] = rotationX[last]; rotationY[index] = rotationY[last];
+        rotationZ[index] = rotationZ[last]; rotationW[index] = rotationW[last];
+        scaleX[index] = scaleX[last]; scaleY[index] = scaleY[last]; scaleZ[index] = scaleZ[last];
+        dirty[index] = dirty[last];
+        localMatrices[index] = localMatrices[last];
+        worldMatrices[index] = worldMatrices[last];
+        parentHandle[index] = parentHandle[last];
+        childCount[index] = childCount[last];
+
+        // The moved transform may now sit before its parent
+        if (linkCount > 0)
+            hierarchyDirty = true;
+
+        Handle moved = indexToHandle[last];
+        indexToHandle[index] = moved;
+        handleToIndex[moved] = (unsigned int)index;
+    }
+
+    positionX.pop_back(); positionY.pop_back(); positionZ.pop_back();
+    rotationX.pop_back(); rotationY.pop_back(); rotationZ.pop_back(); rotationW.pop_back();
+    scaleX.pop_back(); scaleY.pop_back(); scaleZ.pop_back();
+    dirty.pop_back();
+    localMatrices.pop_back();
+    worldMatrices.pop_back();
+    parentHandle.pop_back();
+    parentIndex.pop_back();
+    childCount.pop_back();
+    indexToHandle.pop_back();
+
+    handleToIndex[handle] = InvalidHandle;
+    freeHandles.push_back(handle);
+    count--;
+}
+
+bool TransformSystem::IsValid(Handle handle)
+{
+    return handle < handleToIndex.size() && handleToIndex[handle] != InvalidHandle;
+}
+
+size_t TransformSystem::GetCount()
+{
+    return count;
+}
+
+void TransformSystem::SetPosition(Handle handle, float x, float y, float z)
+{
+    size_t i = handleToIndex[handle];
+    positionX[i] = x;
+    positionY[i] = y;
+    positionZ[i] = z;
+    dirty[i] = 1;
+}
+
+void TransformSystem::SetRotation(Handle handle, float pitch, float yaw, float roll)
+{
+    XMFLOAT4 quat;
+    XMStoreFloat4(&quat, XMQuaternionRotationRollPitchYaw(pitch, yaw, roll));
+    SetRotation(handle, quat);
+}
+
+void TransformSystem::SetRotation(Handle handle, DirectX::XMFLOAT4 quaternion)
+{
+    size_t i = handleToIndex[handle];
+    rotationX[i] = quaternion.x;
+    rotationY[i] = quaternion.y;
+    rotationZ[i] = quaternion.z;
+    rotationW[i] = quaternion.w;
+    dirty[i] = 1;
+}
+
+void TransformSystem::SetScale(Handle handle, float x, float y, float z)
+{
+    size_t i = handleToIndex[handle];
+    scaleX[i] = x;
+    scaleY[i] = y;
+    scaleZ[i] = z;
+    dirty[i] = 1;
+}
+
+void TransformSystem::MoveAbsolute(Handle handle, float x, float y, float z)
+{
+    size_t i = handleToIndex[handle];
+    positionX[i] += x;
+    positionY[i] += y;
+    positionZ[i] += z;
+    dirty[i] = 1;
+}
+
+void TransformSystem::Rotate(Handle handle, float pitch, float yaw, float roll)
+{
+    XMFLOAT4 current = GetQuaternion(handle);
+    XMVECTOR rotated = XMQuaternionMultiply(XMLoadFloat4(&current),
+        XMQuaternionRotationRollPitchYaw(pitch, yaw, roll));
+
+    XMFLOAT4 quat;
+    XMStoreFloat4(&quat, rotated);
+    SetRotation(handle, quat);
+}
+
+// --------------------------------------------------------
+// Parents one transform to another.  Fails (returns false)
+// if that would create a cycle.  The arrays are re-sorted
+// into depth-first order on the next update.
+// --------------------------------------------------------
+bool TransformSystem::SetParent(Handle child, Handle parent)
+{
+    if (!IsValid(child) || (parent != InvalidHandle && !IsValid(parent)))
+        return false;
+
+    // Walk up from the new parent to make sure the child isn't an ancestor
+    for (Handle h = parent; h != InvalidHandle; h = parentHandle[handleToIndex[h]])
+    {
+        if (h == child)
+            return false;
+    }
+
+    size_t index = handleToIndex[child];
+    Handle oldParent = parentHandle[index];
+    if (oldParent == parent)
+        return true;
+
+    if (oldParent != InvalidHandle)
+    {
+        childCount[handleToIndex[oldParent]]--;
+        linkCount--;
+    }
+    if (parent != InvalidHandle)
+    {
+        childCount[handleToIndex[parent]]++;
+        linkCount++;
+    }
+
+    parentHandle[index] = parent;
+    dirty[index] = 1;
+    hierarchyDirty = true;
+    return true;
+}
+
+TransformSystem::Handle TransformSystem::GetParent(Handle handle)
+{
+    return parentHandle[handleToIndex[handle]];
+}
+
+DirectX::XMFLOAT3 TransformSystem::GetPosition(Handle handle)
+{
+    size_t i = handleToIndex[handle];
+    return XMFLOAT3(positionX[i], positionY[i], positionZ[i]);
+}
+
+DirectX::XMFLOAT4 TransformSystem::GetQuaternion(Handle handle)
+{
+    size_t i = handleToIndex[handle];
+    return XMFLOAT4(rotationX[i], rotationY[i], rotationZ[i], rotationW[i]);
+}
+
+DirectX::XMFLOAT3 TransformSystem::GetScale(Handle handle)
+{
+    size_t i = handleToIndex[handle];
+    return XMFLOAT3(scaleX[i], scaleY[i], scaleZ[i]);
+}
+
+// --------------------------------------------------------
+// Returns the matrix built by the last UpdateWorldMatrices().
+// If this transform or any ancestor changed since then, the
+// chain is resolved on the spot (without clearing the flags,
+// so the next batched update still refreshes the subtree).
+// --------------------------------------------------------
+DirectX::XMFLOAT4X4 TransformSystem::GetWorldMatrix(Handle handle)
+{
+    size_t i = handleToIndex[handle];
+    if (!IsChainDirty(i))
+        return worldMatrices[i];
+
+    XMFLOAT4X4 world;
+    XMStoreFloat4x4(&world, ComputeWorld(i));
+    return world;
+}
+
+// --------------------------------------------------------
+// The rotated axes are the rows of the rotation matrix, so
+// each basis is a handful of multiplies on the quaternion
+// --------------------------------------------------------
+void TransformSystem::GetBasisVectors(const Handle* handles, size_t handleCount,
+    DirectX::XMFLOAT3* rights, DirectX::XMFLOAT3* ups, DirectX::XMFLOAT3* forwards)
+{
+    for (size_t n = 0; n < handleCount; n++)
+    {
+        size_t i = handleToIndex[handles[n]];
+        float x = rotationX[i], y = rotationY[i], z = rotationZ[i], w = rotationW[i];
+
+        if (rights) rights[n] = XMFLOAT3(1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w));
+        if (ups) ups[n] = XMFLOAT3(2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w));
+        if (forwards) forwards[n] = XMFLOAT3(2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y));
+    }
+}
+
+bool TransformSystem::IsChainDirty(size_t index)
+{
+    for (Handle h = indexToHandle[index]; h != InvalidHandle; h = parentHandle[handleToIndex[h]])
+    {
+        if (dirty[handleToIndex[h]])
+            return true;
+    }
+    return false;
+}
+
+DirectX::XMMATRIX TransformSystem::ComputeWorld(size_t index)
+{
+    if (dirty[index])
+        ComposeScalar(index, index + 1);
+
+    XMMATRIX local = XMLoadFloat4x4(&localMatrices[index]);
+    if (parentHandle[index] == InvalidHandle)
+        return local;
+    return XMMatrixMultiply(local, ComputeWorld(handleToIndex[parentHandle[index]]));
+}
+
+unsigned int TransformSystem::GetMatricesRebuilt()
+{
+    return matricesRebuilt;
+}
+
+const std::vector<TransformSystem::Handle>& TransformSystem::GetUpdatedHandles()
+{
+    return updatedHandles;
+}
+
+// --------------------------------------------------------
+// Two passes over the (depth-first ordered) arrays:
+//  - Builds local = scale * rotation * translation for every
+//    dirty transform.  Blocks of 4/8 with at least one dirty
+//    transform are composed together (recomputing a clean lane
+//    gives the same matrix back, so that's harmless), and the
+//    remainder is finished with the scalar path.
+//  - Walks the arrays once, pushing the dirty flag down from
+//    parent to child and resolving world = local * parentWorld
+//    only for transforms inside a dirty subtree.
+// --------------------------------------------------------
+void TransformSystem::UpdateWorldMatrices()
+{
+    if (hierarchyDirty)
+        SortHierarchy();
+
+    matricesRebuilt = 0;
+    updatedHandles.clear();
+    size_t i = 0;
+
+#if defined(SIMD_AVX2)
+    for (; i + 8 <= count; i += 8)
+    {
+        unsigned long long flags;
+        memcpy(&flags, &dirty[i], sizeof(flags));
+        if (flags == 0)
+            continue;
+
+        ComposeAVX2(i);
+    }
+#endif
+
+#if defined(SIMD_SSE)
+    for (; i + 4 <= count; i += 4)
+    {
+        unsigned int flags;
+        memcpy(&flags, &dirty[i], sizeof(flags));
+        if (flags == 0)
+            continue;
+
+        ComposeSSE(i);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        if (dirty[i])
+            ComposeScalar(i, i + 1);
+    }
+
+    // Parents always come first, so their flag and world matrix
+    // are final by the time any of their children are reached
+    for (i = 0; i < count; i++)
+    {
+        unsigned int parent = parentIndex[i];
+        if (parent != InvalidHandle)
+            dirty[i] |= dirty[parent];
+        if (!dirty[i])
+            continue;
+
+        if (parent == InvalidHandle)
+            worldMatrices[i] = localMatrices[i];
+        else
+            XMStoreFloat4x4(&worldMatrices[i], XMMatrixMultiply(
+                XMLoadFloat4x4(&localMatrices[i]), XMLoadFloat4x4(&worldMatrices[parent])));
+        updatedHandles.push_back(indexToHandle[i]);
+        matricesRebuilt++;
+    }
+
+    // Flags are only cleared once every child has seen its parent's
+    memset(dirty.data(), 0, count);
+}
+
+// Reorders one SoA array so that element i comes from old index order[i]
+template<typename T>
+static void Permute(std::vector<T>& values, const std::vector<unsigned int>& order, std::vector<T>& scratch)
+{
+    scratch.resize(values.size());
+    for (size_t i = 0; i < order.size(); i++)
+        scratch[i] = values[order[i]];
+    values.swap(scratch);
+}
+
+// --------------------------------------------------------
+// Rebuilds the depth-first order after parenting changes or
+// removals.  Roots keep their relative order and each one is
+// followed by its whole subtree.
+// --------------------------------------------------------
+void TransformSystem::SortHierarchy()
+{
+    // Bucket children by parent index (counting sort into one array)
+    std::vector<unsigned int> childStart(count + 1, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (parentHandle[i] != InvalidHandle)
+            childStart[handleToIndex[parentHandle[i]] + 1]++;
+    }
+    for (size_t i = 0; i < count; i++)
+        childStart[i + 1] += childStart[i];
+
+    std::vector<unsigned int> children(childStart[count]);
+    std::vector<unsigned int> fill(childStart.begin(), childStart.end() - 1);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (parentHandle[i] != InvalidHandle)
+            children[fill[handleToIndex[parentHandle[i]]]++] = (unsigned int)i;
+    }
+
+    // Iterative pre-order walk from every root
+    std::vector<unsigned int> order;
+    std::vector<unsigned int> stack;
+    order.reserve(count);
+    for (size_t root = 0; root < count; root++)
+    {
+        if (parentHandle[root] != InvalidHandle)
+            continue;
+
+        stack.push_back((unsigned int)root);
+        while (!stack.empty())
+        {
+            unsigned int node = stack.back();
+            stack.pop_back();
+            order.push_back(node);
+
+            // Push in reverse so children come out in their original order
+            for (unsigned int c = childStart[node + 1]; c > childStart[node]; c--)
+                stack.push_back(children[c - 1]);
+        }
+    }
+
+    std::vector<float> floatScratch;
+    Permute(positionX, order, floatScratch); Permute(positionY, order, floatScratch); Permute(positionZ, order, floatScratch);
+    Permute(rotationX, order, floatScratch); Permute(rotationY, order, floatScratch);
+    Permute(rotationZ, order, floatScratch); Permute(rotationW, order, floatScratch);
+    Permute(scaleX, order, floatScratch); Permute(scaleY, order, floatScratch); Permute(scaleZ, order, floatScratch);
+
+    std::vector<unsigned char> byteScratch;
+    Permute(dirty, order, byteScratch);
+
+    std::vector<XMFLOAT4X4> matrixScratch;
+    Permute(localMatrices, order, matrixScratch);
+    Permute(worldMatrices, order, matrixScratch);
+
+    std::vector<unsigned int> uintScratch;
+    Permute(parentHandle, order, uintScratch);
+    Permute(childCount, order, uintScratch);
+    Permute(indexToHandle, order, uintScratch);
+
+    for (size_t i = 0; i < count; i++)
+        handleToIndex[indexToHandle[i]] = (unsigned int)i;
+    for (size_t i = 0; i < count; i++)
+        parentIndex[i] = parentHandle[i] == InvalidHandle ? InvalidHandle : handleToIndex[parentHandle[i]];
+
+    hierarchyDirty = false;
+}
+
+// --------------------------------------------------------
+// Same math as XMMatrixScaling * XMMatrixRotationQuaternion *
+// XMMatrixTranslation, written out so the SIMD paths can
+// mirror it lane for lane
+// --------------------------------------------------------
+void TransformSystem::ComposeScalar(size_t start, size_t end)
+{
+    for (size_t i = start; i < end; i++)
+    {
+        float x = rotationX[i], y = rotationY[i], z = rotationZ[i], w = rotationW[i];
+        float sx = scaleX[i], sy = scaleY[i], sz = scaleZ[i];
+
+        XMFLOAT4X4& m = localMatrices[i];
+        m._11 = (1 - 2 * (y * y + z * z)) * sx;
+        m._12 = 2 * (x * y + z * w) * sx;
+        m._13 = 2 * (x * z - y * w) * sx;
+        m._14 = 0;
+        m._21 = 2 * (x * y - z * w) * sy;
+        m._22 = (1 - 2 * (x * x + z * z)) * sy;
+        m._23 = 2 * (y * z + x * w) * sy;
+        m._24 = 0;
+        m._31 = 2 * (x * z + y * w) * sz;
+        m._32 = 2 * (y * z - x * w) * sz;
+        m._33 = (1 - 2 * (x * x + y * y)) * sz;
+        m._34 = 0;
+        m._41 = positionX[i];
+        m._42 = positionY[i];
+        m._43 = positionZ[i];
+        m._44 = 1;
+    }
+}
+
+#if defined(SIMD_SSE)
+// Transposes one matrix row held as 4 lane-vectors and writes it
+// into the matching row of 4 consecutive matrices
+static inline void StoreRows4(DirectX::XMFLOAT4X4* out, int row, __m128 c0, __m128 c1, __m128 c2, __m128 c3)
+{
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_storeu_ps(out[0].m[row], c0);
+    _mm_storeu_ps(out[1].m[row], c1);
+    _mm_storeu_ps(out[2].m[row], c2);
+    _mm_storeu_ps(out[3].m[row], c3);
+}
+
+void TransformSystem::ComposeSSE(size_t index)
+{
+    __m128 x = _mm_loadu_ps(&rotationX[index]);
+    __m128 y = _mm_loadu_ps(&rotationY[index]);
+    __m128 z = _mm_loadu_ps(&rotationZ[index]);
+    __m128 w = _mm_loadu_ps(&rotationW[index]);
+    __m128 sx = _mm_loadu_ps(&scaleX[index]);
+    __m128 sy = _mm_loadu_ps(&scaleY[index]);
+    __m128 sz = _mm_loadu_ps(&scaleZ[index]);
+
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 two = _mm_set1_ps(2.0f);
+    __m128 zero = _mm_setzero_ps();
+
+    __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+    __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+    __m128 xw = _mm_mul_ps(x, w), yw = _mm_mul_ps(y, w), zw = _mm_mul_ps(z, w);
+
+    __m128 m11 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+    __m128 m12 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, zw)), sx);
+    __m128 m13 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, yw)), sx);
+    __m128 m21 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, zw)), sy);
+    __m128 m22 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+    __m128 m23 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, xw)), sy);
+    __m128 m31 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, yw)), sz);
+    __m128 m32 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, xw)), sz);
+    __m128 m33 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+
+    XMFLOAT4X4* out = &localMatrices[index];
+    StoreRows4(out, 0, m11, m12, m13, zero);
+    StoreRows4(out, 1, m21, m22, m23, zero);
+    StoreRows4(out, 2, m31, m32, m33, zero);
+    StoreRows4(out, 3, _mm_loadu_ps(&positionX[index]), _mm_loadu_ps(&positionY[index]),
+        _mm_loadu_ps(&positionZ[index]), one);
+}
+#endif
+
+#if defined(SIMD_AVX2)
+// Splits 8 lane-vectors into two SSE halves for the transposed store
+static inline void StoreRows8(DirectX::XMFLOAT4X4* out, int row, __m256 c0, __m256 c1, __m256 c2, __m256 c3)
+{
+    StoreRows4(out, row,
+        _mm256_castps256_ps128(c0), _mm256_castps256_ps128(c1),
+        _mm256_castps256_ps128(c2), _mm256_castps256_ps128(c3));
+    StoreRows4(out + 4, row,
+        _mm256_extractf128_ps(c0, 1), _mm256_extractf128_ps(c1, 1),
+        _mm256_extractf128_ps(c2, 1), _mm256_extractf128_ps(c3, 1));
+}
+
+void TransformSystem::ComposeAVX2(size_t index)
+{
+    __m256 x = _mm256_loadu_ps(&rotationX[index]);
+    __m256 y = _mm256_loadu_ps(&rotationY[index]);
+    __m256 z = _mm256_loadu_ps(&rotationZ[index]);
+    __m256 w = _mm256_loadu_ps(&rotationW[index]);
+    __m256 sx = _mm256_loadu_ps(&scaleX[index]);
+    __m256 sy = _mm256_loadu_ps(&scaleY[index]);
+    __m256 sz = _mm256_loadu_ps(&scaleZ[index]);
+
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 two = _mm256_set1_ps(2.0f);
+    __m256 zero = _mm256_setzero_ps();
+
+    __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+    __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+    __m256 xw = _mm256_mul_ps(x, w), yw = _mm256_mul_ps(y, w), zw = _mm256_mul_ps(z, w);
+
+    __m256 m11 = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx);
+    __m256 m12 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, zw)), sx);
+    __m256 m13 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, yw)), sx);
+    __m256 m21 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, zw)), sy);
+    __m256 m22 = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy);
+    __m256 m23 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, xw)), sy);
+    __m256 m31 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, yw)), sz);
+    __m256 m32 = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, xw)), sz);
+    __m256 m33 = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz);
+
+    XMFLOAT4X4* out = &localMatrices[index];
+    StoreRows8(out, 0, m11, m12, m13, zero);
+    StoreRows8(out, 1, m21, m22, m23, zero);
+    StoreRows8(out, 2, m31, m32, m33, zero);
+    StoreRows8(out, 3, _mm256_loadu_ps(&positionX[index]), _mm256_loadu_ps(&positionY[index]),
+        _mm256_loadu_ps(&positionZ[index]), one);
+}
+#endif
@@ -0,0 +1,100 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include "SimdConfig.h"
+
+// --------------------------------------------------------
+// Structure-of-arrays storage for large numbers of transforms
+//
+// Positions, quaternions and scales live in contiguous per-component
+// arrays so the local matrices of every dirty transform can be built
+// 4 (SSE) or 8 (AVX2) at a time in a single pass.  Callers hold a
+// Handle, which stays valid while other transforms are created or
+// destroyed (the dense arrays are kept packed with swap-remove).
+//
+// Transforms can be parented to each other.  The arrays are kept in
+// depth-first order (every parent before its children), so world
+// matrices are resolved in one linear pass that only touches dirty
+// subtrees.
+// --------------------------------------------------------
+class TransformSystem
+{
+public:
+	typedef unsigned int Handle;
+	static const Handle InvalidHandle = 0xFFFFFFFF;
+
+	TransformSystem(size_t initialCapacity = 1024);
+
+	//creation and removal
+	Handle Create();
+	void Destroy(Handle handle);
+	bool IsValid(Handle handle);
+	size_t GetCount();
+
+	//setters - all of these mark the transform dirty
+	void SetPosition(Handle handle, float x, float y, float z);
+	void SetRotation(Handle handle, float pitch, float yaw, float roll);
+	void SetRotation(Handle handle, DirectX::XMFLOAT4 quaternion);
+	void SetScale(Handle handle, float x, float y, float z);
+	void MoveAbsolute(Handle handle, float x, float y, float z);
+	void Rotate(Handle handle, float pitch, float yaw, float roll);
+
+	//hierarchy - pass InvalidHandle as the parent to detach
+	bool SetParent(Handle child, Handle parent);
+	Handle GetParent(Handle handle);
+
+	//getters
+	DirectX::XMFLOAT3 GetPosition(Handle handle);
+	DirectX::XMFLOAT4 GetQuaternion(Handle handle);
+	DirectX::XMFLOAT3 GetScale(Handle handle);
+	DirectX::XMFLOAT4X4 GetWorldMatrix(Handle handle);
+
+	//local right/up/forward for many transforms at once, derived straight from
+	//the quaternions (any output array can be null)
+	void GetBasisVectors(const Handle* handles, size_t handleCount,
+		DirectX::XMFLOAT3* rights, DirectX::XMFLOAT3* ups, DirectX::XMFLOAT3* forwards);
+
+	//rebuilds the world matrix of every dirty transform (and its subtree) in one batched pass
+	void UpdateWorldMatrices();
+	unsigned int GetMatricesRebuilt();
+	//the transforms whose world matrix the last UpdateWorldMatrices() rebuilt (new ones included),
+	//so callers can refresh whatever they derive from them without visiting the rest
+	const std::vector<Handle>& GetUpdatedHandles();
+
+private:
+	//SoA component arrays, all indexed by dense index
+	std::vector<float> positionX, positionY, positionZ;
+	std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+	std::vector<float> scaleX, scaleY, scaleZ;
+	std::vector<unsigned char> dirty;
+	std::vector<DirectX::XMFLOAT4X4> localMatrices;
+	std::vector<DirectX::XMFLOAT4X4> worldMatrices;
+
+	//hierarchy links; parentIndex is only trusted while the order is valid
+	std::vector<Handle> parentHandle;
+	std::vector<unsigned int> parentIndex;
+	std::vector<unsigned int> childCount;
+	size_t linkCount;
+	bool hierarchyDirty;
+
+	//handle <-> dense index indirection
+	std::vector<unsigned int> handleToIndex;
+	std::vector<Handle> indexToHandle;
+	std::vector<Handle> freeHandles;
+
+	size_t count;
+	unsigned int matricesRebuilt;
+	std::vector<Handle> updatedHandles;
+
+	void SortHierarchy();
+	bool IsChainDirty(size_t index);
+	DirectX::XMMATRIX ComputeWorld(size_t index);
+	void ComposeScalar(size_t start, size_t end);
+#if defined(SIMD_SSE)
+	void ComposeSSE(size_t index);
+#endif
+#if defined(SIMD_AVX2)
+	void ComposeAVX2(size_t index);
+#endif
+};
+
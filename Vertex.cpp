@@ -0,0 +1,16 @@
+#include "Vertex.h"
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+void PackVertex(const Vertex& source, PackedVertex& destination)
+{
+	destination.Position = source.Position;
+	XMStoreUByteN4(&destination.Color, XMLoadFloat4(&source.Color));
+}
+
+void PackVertex(const Vertex& source, HalfVertex& destination)
+{
+	XMStoreHalf4(&destination.Position, XMVectorSetW(XMLoadFloat3(&source.Position), 1.0f));
+	XMStoreUByteN4(&destination.Color, XMLoadFloat4(&source.Color));
+}
@@ -1,14 +1,58 @@
 #pragma once
 
-#include <DirectXMath.h>
+#include <vector>
+#include "VertexLayout.h"
 
 // --------------------------------------------------------
 // A custom vertex definition
 //
 // You will eventually ADD TO this, and/or make more of these!
+// (Each element becomes a member, and the input layout the
+// shaders read it with - see VertexLayout.h)
 // --------------------------------------------------------
-struct Vertex
+#define VERTEX_ELEMENTS(ELEMENT) \
+	ELEMENT(Position, "POSITION", 0, FormatFloat3)	/* The local position of the vertex */ \
+	ELEMENT(Color,    "COLOR",    0, FormatFloat4)	/* The color of the vertex */
+DEFINE_VERTEX(Vertex, VERTEX_ELEMENTS)
+#undef VERTEX_ELEMENTS
+
+// --------------------------------------------------------
+// Smaller versions of Vertex for the GPU.  Meshes are always
+// built from Vertex arrays, then packed into whichever of
+// these their vertex type is.  The shaders read them just
+// the same - the input assembler widens them to floats.
+// --------------------------------------------------------
+
+//16 bytes - color as 8-bit UNORM
+#define PACKED_VERTEX_ELEMENTS(ELEMENT) \
+	ELEMENT(Position, "POSITION", 0, FormatFloat3) \
+	ELEMENT(Color,    "COLOR",    0, FormatUnorm8x4)
+DEFINE_VERTEX(PackedVertex, PACKED_VERTEX_ELEMENTS)
+#undef PACKED_VERTEX_ELEMENTS
+
+//12 bytes - position as halfs too (w is 1).  Halfs keep about
+//three significant digits, so keep these meshes small in local space
+#define HALF_VERTEX_ELEMENTS(ELEMENT) \
+	ELEMENT(Position, "POSITION", 0, FormatHalf4) \
+	ELEMENT(Color,    "COLOR",    0, FormatUnorm8x4)
+DEFINE_VERTEX(HalfVertex, HALF_VERTEX_ELEMENTS)
+#undef HALF_VERTEX_ELEMENTS
+
+//converts one authored vertex to a GPU vertex type
+void PackVertex(const Vertex& source, PackedVertex& destination);
+void PackVertex(const Vertex& source, HalfVertex& destination);
+
+//converts a whole array, using storage for the result - Vertex arrays are returned as they are
+template<typename VertexType>
+const VertexType* PackVertices(const Vertex* vertices, unsigned long long vertexCount, std::vector<VertexType>& storage)
+{
+	storage.resize((size_t)vertexCount);
+	for (size_t i = 0; i < storage.size(); i++)
+		PackVertex(vertices[i], storage[i]);
+	return storage.data();
+}
+
+inline const Vertex* PackVertices(const Vertex* vertices, unsigned long long vertexCount, std::vector<Vertex>& storage)
 {
-	DirectX::XMFLOAT3 Position;	    // The local position of the vertex
-	DirectX::XMFLOAT4 Color;        // The color of the vertex
-};
\ No newline at end of file
+	return vertices;
+}
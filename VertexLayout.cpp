@@ -0,0 +1,25 @@
+#include "VertexLayout.h"
+#include <vector>
+
+// Most vertex types a program can declare
+static const unsigned int MaxVertexLayouts = 64;
+
+static std::vector<VertexLayoutInfo>& GetVertexLayoutInfos()
+{
+	static std::vector<VertexLayoutInfo> infos;
+	return infos;
+}
+
+unsigned int RegisterVertexLayout(const VertexLayoutInfo& info)
+{
+	// Reserved up front so references handed out by GetVertexLayoutInfo() stay put
+	std::vector<VertexLayoutInfo>& infos = GetVertexLayoutInfos();
+	infos.reserve(MaxVertexLayouts);
+	infos.push_back(info);
+	return (unsigned int)infos.size() - 1;
+}
+
+const VertexLayoutInfo& GetVertexLayoutInfo(unsigned int layoutId)
+{
+	return GetVertexLayoutInfos()[layoutId];
+}
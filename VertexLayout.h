@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include "RenderDevice.h"
+
+// --------------------------------------------------------
+// Compile-time vertex layouts
+//
+// A vertex type is declared once, as a macro listing its
+// elements - ELEMENT(member name, semantic, semantic index,
+// format) each - handed to DEFINE_VERTEX (see Vertex.h).
+// That gives the struct (members typed to match their
+// formats), and VertexLayout<TheVertex> with its element
+// array and stride as constants.  The struct's size and
+// every member's offset are static_asserted against the
+// layout, so the two can't drift apart.  Elements are
+// packed back to back in slot 0, like
+// D3D11_APPEND_ALIGNED_ELEMENT.
+// --------------------------------------------------------
+
+// The C++ type an element of each format is stored as
+template<VertexElementFormat Format> struct VertexElementType;
+template<> struct VertexElementType<FormatFloat2> { typedef DirectX::XMFLOAT2 Type; };
+template<> struct VertexElementType<FormatFloat3> { typedef DirectX::XMFLOAT3 Type; };
+template<> struct VertexElementType<FormatFloat4> { typedef DirectX::XMFLOAT4 Type; };
+template<> struct VertexElementType<FormatUnorm8x4> { typedef DirectX::PackedVector::XMUBYTEN4 Type; };
+template<> struct VertexElementType<FormatHalf4> { typedef DirectX::PackedVector::XMHALF4 Type; };
+
+// A fixed-size element list a constexpr function can return
+template<unsigned int Count>
+struct VertexElementArray
+{
+	VertexElement elements[Count];
+};
+
+constexpr bool SemanticNamesMatch(const char* a, const char* b)
+{
+	while (*a && *a == *b)
+	{
+		a++;
+		b++;
+	}
+	return *a == *b;
+}
+
+constexpr unsigned int SumVertexElementSizes(const VertexElement* elements, unsigned int count)
+{
+	unsigned int size = 0;
+	for (unsigned int i = 0; i < count; i++)
+		size += GetVertexElementSize(elements[i].format);
+	return size;
+}
+
+template<typename VertexType>
+struct VertexLayout
+{
+	static constexpr unsigned int ElementCount = VertexType::ElementCount;
+	static constexpr VertexElementArray<ElementCount> Elements = VertexType::DescribeElements();
+	static constexpr unsigned int Stride = SumVertexElementSizes(Elements.elements, ElementCount);
+
+	//byte offset of the element with this semantic (the stride if there's none)
+	static constexpr unsigned int GetOffset(const char* semanticName, unsigned int semanticIndex)
+	{
+		unsigned int offset = 0;
+		for (unsigned int i = 0; i < ElementCount; i++)
+		{
+			if (SemanticNamesMatch(Elements.elements[i].semanticName, semanticName) && Elements.elements[i].semanticIndex == semanticIndex)
+				return offset;
+			offset += GetVertexElementSize(Elements.elements[i].format);
+		}
+		return offset;
+	}
+};
+
+template<typename VertexType> constexpr unsigned int VertexLayout<VertexType>::ElementCount;
+template<typename VertexType> constexpr VertexElementArray<VertexLayout<VertexType>::ElementCount> VertexLayout<VertexType>::Elements;
+template<typename VertexType> constexpr unsigned int VertexLayout<VertexType>::Stride;
+
+#define VERTEX_LAYOUT_MEMBER(name, semantic, index, format)		VertexElementType<format>::Type name;
+#define VERTEX_LAYOUT_COUNT(name, semantic, index, format)		+ 1
+#define VERTEX_LAYOUT_ELEMENT(name, semantic, index, format)	{ semantic, index, format, 0, false },
+#define VERTEX_LAYOUT_CHECK(name, semantic, index, format) \
+	static_assert(offsetof(Self, name) == VertexLayout<Self>::GetOffset(semantic, index), #name " isn't where its layout puts it");
+
+// The checks live in a member function so they see the finished struct
+#define DEFINE_VERTEX(Name, ELEMENTS) \
+	struct Name \
+	{ \
+		ELEMENTS(VERTEX_LAYOUT_MEMBER) \
+		static const unsigned int ElementCount = 0 ELEMENTS(VERTEX_LAYOUT_COUNT); \
+		static constexpr VertexElementArray<ElementCount> DescribeElements() { return { { ELEMENTS(VERTEX_LAYOUT_ELEMENT) } }; } \
+		static void CheckLayout() \
+		{ \
+			typedef Name Self; \
+			static_assert(sizeof(Self) == VertexLayout<Self>::Stride, #Name " is padded differently from its layout"); \
+			ELEMENTS(VERTEX_LAYOUT_CHECK) \
+		} \
+	};
+
+// --------------------------------------------------------
+// Vertex types get small ids in first-use order, so code
+// that only holds a Mesh can still find (and cache things
+// per) its layout
+// --------------------------------------------------------
+struct VertexLayoutInfo
+{
+	const VertexElement* elements;
+	unsigned int elementCount;
+	unsigned int stride;
+};
+
+unsigned int RegisterVertexLayout(const VertexLayoutInfo& info);
+const VertexLayoutInfo& GetVertexLayoutInfo(unsigned int layoutId);
+
+template<typename VertexType>
+unsigned int GetVertexLayoutId()
+{
+	typedef VertexLayout<VertexType> Layout;
+	static const unsigned int id = RegisterVertexLayout({ Layout::Elements.elements, Layout::ElementCount, Layout::Stride });
+	return id;
+}
@@ -1,10 +1,15 @@
 
-cbuffer ExternalData : register(b0) 
+// Camera data, set once per frame
+cbuffer PerFrame : register(b0)
+{
+	matrix viewProjection;
+}
+
+// Data for the object being drawn
+cbuffer ExternalData : register(b1) 
 { 
 	float4 colorTint;  
 	matrix world; 
-	matrix view;
-	matrix projection;
 }
 
 // Struct representing a single vertex worth of data
@@ -59,8 +64,8 @@ VertexToPixel main( VertexShaderInput input )
 	// - Each of these components is then automatically divided by the W component, 
 	//   which we're leaving at 1.0 for now (this is more useful when dealing with 
 	//   a perspective projection matrix, which we'll get to in the future).
-	matrix wvp = mul(projection, mul(view, world));
-	output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
+	float4 worldPosition = mul(world, float4(input.localPosition, 1.0f));
+	output.screenPosition = mul(viewProjection, worldPosition);
 
 	// Pass the color through 
 	// - The values will be interpolated per-pixel by the rasterizer
@@ -0,0 +1,255 @@
+#include "Win32Platform.h"
+#include "Input.h"
+
+#include <WindowsX.h>
+
+// Define the static instance variable so our OS-level 
+// message handling function below can talk to our object
+Win32Platform* Win32Platform::instance = 0;
+
+// --------------------------------------------------------
+// The global callback function for handling windows OS-level messages.
+//
+// This needs to be a global function (not part of a class), but we want
+// to forward the parameters to our class to properly handle them.
+// --------------------------------------------------------
+LRESULT Win32Platform::WindowProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+	return instance->ProcessMessage(hWnd, uMsg, wParam, lParam);
+}
+
+// --------------------------------------------------------
+// Constructor - Set up fields and timer
+//
+// hInstance	- The application's OS-level handle (unique ID)
+// --------------------------------------------------------
+Win32Platform::Win32Platform(HINSTANCE hInstance)
+{
+	// Save a static reference to this object, since the
+	// OS-level message function must be a non-member function
+	instance = this;
+
+	this->hInstance = hInstance;
+	this->hWnd = 0;
+	this->exitCode = 0;
+
+	// Query performance counter for accurate timing information
+	__int64 perfFreq;
+	QueryPerformanceFrequency((LARGE_INTEGER*)&perfFreq);
+	perfCounterSeconds = 1.0 / (double)perfFreq;
+}
+
+// --------------------------------------------------------
+// Created the actual window for our application
+// --------------------------------------------------------
+bool Win32Platform::CreateAppWindow(const std::string& title, unsigned int width, unsigned int height)
+{
+	// Start window creation by filling out the
+	// appropriate window class struct
+	WNDCLASS wndClass		= {}; // Zero out the memory
+	wndClass.style			= CS_HREDRAW | CS_VREDRAW;	// Redraw on horizontal or vertical movement/adjustment
+	wndClass.lpfnWndProc	= Win32Platform::WindowProc;
+	wndClass.cbClsExtra		= 0;
+	wndClass.cbWndExtra		= 0;
+	wndClass.hInstance		= hInstance;						// Our app's handle
+	wndClass.hIcon			= LoadIcon(NULL, IDI_APPLICATION);	// Default icon
+	wndClass.hCursor		= LoadCursor(NULL, IDC_ARROW);		// Default arrow cursor
+	wndClass.hbrBackground	= (HBRUSH)GetStockObject(BLACK_BRUSH);
+	wndClass.lpszMenuName	= NULL;
+	wndClass.lpszClassName	= "Direct3DWindowClass";
+
+	// Attempt to register the window class we've defined
+	if (!RegisterClass(&wndClass))
+	{
+		// If the class exists, that's actually fine.  Otherwise,
+		// we can't proceed with the next step.
+		if (GetLastError() != ERROR_CLASS_ALREADY_EXISTS)
+			return false;
+	}
+
+	// Adjust the width and height so the "client size" matches
+	// the width and height given (the inner-area of the window)
+	RECT clientRect;
+	SetRect(&clientRect, 0, 0, width, height);
+	AdjustWindowRect(
+		&clientRect,
+		WS_OVERLAPPEDWINDOW,	// Has a title bar, border, min and max buttons, etc.
+		false);					// No menu bar
+
+	// Center the window to the screen
+	RECT desktopRect;
+	GetClientRect(GetDesktopWindow(), &desktopRect);
+	int centeredX = (desktopRect.right / 2) - (clientRect.right / 2);
+	int centeredY = (desktopRect.bottom / 2) - (clientRect.bottom / 2);
+
+	// Actually ask Windows to create the window itself
+	// using our settings so far.  This will return the
+	// handle of the window, which we'll keep around for later
+	hWnd = CreateWindow(
+		wndClass.lpszClassName,
+		title.c_str(),
+		WS_OVERLAPPEDWINDOW,
+		centeredX,
+		centeredY,
+		clientRect.right - clientRect.left,	// Calculated width
+		clientRect.bottom - clientRect.top,	// Calculated height
+		0,			// No parent window
+		0,			// No menu
+		hInstance,	// The app's handle
+		0);			// No other windows in our application
+
+	// Ensure the window was created properly
+	if (hWnd == NULL)
+		return false;
+
+	// The window exists but is not visible yet
+	// We need to tell Windows to show it, and how to show it
+	ShowWindow(hWnd, SW_SHOW);
+	return true;
+}
+
+bool Win32Platform::HasWindow()
+{
+	return hWnd != 0;
+}
+
+void* Win32Platform::GetNativeWindowHandle()
+{
+	return hWnd;
+}
+
+void Win32Platform::SetWindowTitle(const std::string& title)
+{
+	SetWindowText(hWnd, title.c_str());
+}
+
+// --------------------------------------------------------
+// Translates and dispatches every waiting message to our
+// WindowProc.  Returns false once WM_QUIT shows up, which
+// usually comes from the user closing the window.
+// --------------------------------------------------------
+bool Win32Platform::PumpMessages()
+{
+	MSG msg = {};
+	while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+	{
+		if (msg.message == WM_QUIT)
+		{
+			exitCode = (int)msg.wParam;
+			return false;
+		}
+
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Sends an OS-level window close message to our process, which
+// will be handled by our message processing function
+// --------------------------------------------------------
+void Win32Platform::RequestQuit()
+{
+	PostMessage(hWnd, WM_CLOSE, 0, 0);
+}
+
+int Win32Platform::GetExitCode()
+{
+	return exitCode;
+}
+
+double Win32Platform::GetTimeSeconds()
+{
+	__int64 now;
+	QueryPerformanceCounter((LARGE_INTEGER*)&now);
+	return now * perfCounterSeconds;
+}
+
+// --------------------------------------------------------------------------
+// Gets the actual path to this executable
+//
+// - As it turns out, the relative path for a program is different when 
+//    running through VS and when running the .exe directly, which makes 
+//    it a pain to properly load external files (like textures)
+//    - Running through VS: Current Dir is the *project folder*
+//    - Running from .exe:  Current Dir is the .exe's folder
+// --------------------------------------------------------------------------
+std::string Win32Platform::GetExePath()
+{
+	// Assume the path is just the "current directory" for now
+	std::string path = ".";
+
+	// Get the real, full path to this executable
+	char currentDir[1024] = {};
+	GetModuleFileName(0, currentDir, 1024);
+
+	// Find the location of the last slash character and
+	// chop off the exe's file name there
+	char* lastSlash = strrchr(currentDir, '\\');
+	if (lastSlash)
+	{
+		*lastSlash = 0;
+		path = currentDir;
+	}
+
+	return path;
+}
+
+char Win32Platform::GetPathSeparator()
+{
+	return '\\';
+}
+
+// --------------------------------------------------------
+// Handles messages that are sent to our window by the
+// operating system.  Ignoring these messages would cause
+// our program to hang and Windows would think it was
+// unresponsive.
+// --------------------------------------------------------
+LRESULT Win32Platform::ProcessMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+	// Check the incoming message and handle any we care about
+	switch (uMsg)
+	{
+	// This is the message that signifies the window closing
+	case WM_DESTROY:
+		PostQuitMessage(0); // Send a quit message to our own program
+		return 0;
+
+	// Prevent beeping when we "alt-enter" into fullscreen
+	case WM_MENUCHAR: 
+		return MAKELRESULT(0, MNC_CLOSE);
+
+	// Prevent the overall window from becoming too small
+	case WM_GETMINMAXINFO:
+		((MINMAXINFO*)lParam)->ptMinTrackSize.x = 200;
+		((MINMAXINFO*)lParam)->ptMinTrackSize.y = 200;
+		return 0;
+
+	// Sent when the window size changes
+	case WM_SIZE:
+		// Don't adjust anything when minimizing,
+		// since we end up with a width/height of zero
+		// and that doesn't play well with the GPU
+		if (wParam == SIZE_MINIMIZED)
+			return 0;
+
+		if (listener)
+			listener->OnWindowResized(LOWORD(lParam), HIWORD(lParam));
+		return 0;
+
+	// Has the mouse wheel been scrolled?
+	case WM_MOUSEWHEEL:
+		Input::GetInstance().SetWheelDelta(GET_WHEEL_DELTA_WPARAM(wParam) / (float)WHEEL_DELTA);
+		return 0;
+	
+	// Is our focus state changing?
+	case WM_SETFOCUS:	if (listener) listener->OnFocusChanged(true);	return 0;
+	case WM_KILLFOCUS:	if (listener) listener->OnFocusChanged(false);	return 0;
+	case WM_ACTIVATE:	if (listener) listener->OnFocusChanged(LOWORD(wParam) != WA_INACTIVE); return 0;
+	}
+
+	// Let Windows handle any messages we're not touching
+	return DefWindowProc(hWnd, uMsg, wParam, lParam);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Windows.h>
+#include "Platform.h"
+
+// --------------------------------------------------------
+// Window, message pump and timing through the Win32 API
+// --------------------------------------------------------
+class Win32Platform : public Platform
+{
+public:
+	Win32Platform(HINSTANCE hInstance);
+
+	bool CreateAppWindow(const std::string& title, unsigned int width, unsigned int height);
+	bool HasWindow();
+	void* GetNativeWindowHandle();
+	void SetWindowTitle(const std::string& title);
+
+	bool PumpMessages();
+	void RequestQuit();
+	int GetExitCode();
+
+	double GetTimeSeconds();
+
+	std::string GetExePath();
+	char GetPathSeparator();
+
+	// Static requirements for OS-level message processing
+	static LRESULT CALLBACK WindowProc(
+		HWND hWnd,		// Window handle
+		UINT uMsg,		// Message
+		WPARAM wParam,	// Message's first parameter
+		LPARAM lParam	// Message's second parameter
+	);
+
+private:
+	static Win32Platform* instance;
+
+	HINSTANCE	hInstance;		// The handle to the application
+	HWND		hWnd;			// The handle to the window itself
+	double		perfCounterSeconds;
+	int			exitCode;
+
+	// Internal method for message handling
+	LRESULT ProcessMessage(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+};